@@ -0,0 +1,242 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Benchmark.h"
+
+#include <algorithm> // sort
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QThread>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GitVersion.h"
+#include "Global/JSONUtils.h"
+#include "Global/MemoryInfo.h"
+
+#include "Engine/FStreamsSupport.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+std::vector<BenchmarkFactory>&
+getRegistry()
+{
+    //Constructed on first use, since benchmarks register themselves during static initialization
+    static std::vector<BenchmarkFactory> registry;
+
+    return registry;
+}
+
+void
+writeResultsJSON(std::ostream& os,
+                 const std::vector<BenchmarkResult>& results)
+{
+    //Enough digits so that timings of a few nanoseconds are not rounded
+    os.precision(9);
+    os << "{\n";
+    os << "  \"version\": " << NATRON_BENCHMARK_JSON_VERSION << ",\n";
+    os << "  \"natronVersion\": \"" << JSONUtils::escape(NATRON_VERSION_STRING) << "\",\n";
+    os << "  \"gitCommit\": \"" << JSONUtils::escape(GIT_COMMIT) << "\",\n";
+    os << "  \"gitBranch\": \"" << JSONUtils::escape(GIT_BRANCH) << "\",\n";
+    os << "  \"date\": \"" << QDateTime::currentDateTime().toUTC().toString(Qt::ISODate).toStdString() << "\",\n";
+    os << "  \"host\": {\n";
+    os << "    \"idealThreadCount\": " << QThread::idealThreadCount() << ",\n";
+    os << "    \"totalRAM\": " << getSystemTotalRAM() << "\n";
+    os << "  },\n";
+    os << "  \"benchmarks\": [";
+    for (std::size_t i = 0; i < results.size(); ++i) {
+        const BenchmarkResult& r = results[i];
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    {\n";
+        os << "      \"name\": \"" << JSONUtils::escape(r.name) << "\",\n";
+        os << "      \"iterations\": " << r.iterations << ",\n";
+        os << "      \"totalSeconds\": " << r.totalSeconds << ",\n";
+        os << "      \"minSeconds\": " << r.minSeconds << ",\n";
+        os << "      \"maxSeconds\": " << r.maxSeconds << ",\n";
+        os << "      \"meanSeconds\": " << r.meanSeconds << ",\n";
+        os << "      \"medianSeconds\": " << r.medianSeconds << ",\n";
+        os << "      \"stdDevSeconds\": " << r.stdDevSeconds << ",\n";
+        os << "      \"itemsPerIteration\": " << r.itemsPerIteration << ",\n";
+        os << "      \"itemsPerSecond\": " << r.getItemsPerSecond() << ",\n";
+        os << "      \"unit\": \"" << JSONUtils::escape(r.unit) << "\"\n";
+        os << "    }";
+    }
+    os << "\n  ]\n";
+    os << "}\n";
+}
+} // anon namespace
+
+bool
+BenchmarkRegistry::registerBenchmark(BenchmarkFactory factory)
+{
+    getRegistry().push_back(factory);
+
+    return true;
+}
+
+const std::vector<BenchmarkFactory>&
+BenchmarkRegistry::getBenchmarks()
+{
+    return getRegistry();
+}
+
+BenchmarkRunner::BenchmarkRunner()
+    : _filter()
+    , _minTime(NATRON_BENCHMARK_MIN_TIME_SECONDS)
+    , _verbose(true)
+    , _results()
+{
+}
+
+void
+BenchmarkRunner::setFilter(const std::string& filter)
+{
+    _filter = filter;
+}
+
+void
+BenchmarkRunner::setMinTime(double seconds)
+{
+    _minTime = seconds;
+}
+
+void
+BenchmarkRunner::setVerbose(bool verbose)
+{
+    _verbose = verbose;
+}
+
+BenchmarkResult
+BenchmarkRunner::runBenchmark(Benchmark* benchmark) const
+{
+    BenchmarkResult ret;
+
+    ret.name = benchmark->getName();
+    ret.unit = benchmark->getItemsUnit();
+    ret.itemsPerIteration = benchmark->getItemsPerIteration();
+
+    benchmark->setUp();
+
+    //The first iteration warms up the caches and lazily initialized tables (e.g: the Lut), it is not measured
+    benchmark->prepareIteration();
+    benchmark->run();
+
+    std::vector<double> samples;
+    QElapsedTimer timer;
+    while ( ( (int)samples.size() < NATRON_BENCHMARK_MIN_SAMPLES ) || (ret.totalSeconds < _minTime) ) {
+        benchmark->prepareIteration();
+        timer.start();
+        benchmark->run();
+        double elapsed = timer.nsecsElapsed() * 1e-9;
+        samples.push_back(elapsed);
+        ret.totalSeconds += elapsed;
+    }
+
+    benchmark->tearDown();
+
+    ret.iterations = (int)samples.size();
+    std::sort( samples.begin(), samples.end() );
+    ret.minSeconds = samples.front();
+    ret.maxSeconds = samples.back();
+    ret.meanSeconds = ret.totalSeconds / ret.iterations;
+    if (ret.iterations % 2) {
+        ret.medianSeconds = samples[ret.iterations / 2];
+    } else {
+        ret.medianSeconds = (samples[ret.iterations / 2 - 1] + samples[ret.iterations / 2]) / 2.;
+    }
+    double variance = 0.;
+    for (std::size_t i = 0; i < samples.size(); ++i) {
+        variance += (samples[i] - ret.meanSeconds) * (samples[i] - ret.meanSeconds);
+    }
+    ret.stdDevSeconds = std::sqrt( variance / ret.iterations );
+
+    return ret;
+} // BenchmarkRunner::runBenchmark
+
+void
+BenchmarkRunner::runAll()
+{
+    const std::vector<BenchmarkFactory>& benchmarks = BenchmarkRegistry::getBenchmarks();
+
+    for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+        boost::scoped_ptr<Benchmark> benchmark( benchmarks[i]() );
+        if ( !_filter.empty() && (benchmark->getName().find(_filter) == std::string::npos) ) {
+            continue;
+        }
+        BenchmarkResult result;
+        try {
+            result = runBenchmark( benchmark.get() );
+        } catch (const std::exception& e) {
+            std::cerr << benchmark->getName() << " failed: " << e.what() << std::endl;
+            continue;
+        }
+        _results.push_back(result);
+        if (_verbose) {
+            std::cout << std::left << std::setw(40) << result.name << std::right
+                      << std::setw(8) << result.iterations << " iterations "
+                      << std::fixed << std::setprecision(3) << std::setw(12) << result.medianSeconds * 1e6 << " us (median) "
+                      << std::scientific << std::setprecision(4) << result.getItemsPerSecond() << ' ' << result.unit << "/s"
+                      << std::endl;
+            std::cout.unsetf(std::ios_base::floatfield);
+        }
+    }
+}
+
+bool
+BenchmarkRunner::writeJSON(const std::string& filename,
+                           std::string* error) const
+{
+    if (filename == "-") {
+        writeResultsJSON(std::cout, _results);
+
+        return true;
+    }
+
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open(&ofile, filename);
+    if (!ofile) {
+        *error = "Failed to open " + filename + " for writing";
+
+        return false;
+    }
+    writeResultsJSON(ofile, _results);
+    if (!ofile) {
+        *error = "Failed to write " + filename;
+
+        return false;
+    }
+
+    return true;
+}
+
+NATRON_NAMESPACE_EXIT;
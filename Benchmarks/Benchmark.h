@@ -0,0 +1,213 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+#include <vector>
+
+#include "Global/Macros.h"
+
+#include <QtCore/QtGlobal>
+
+#include "Engine/EngineFwd.h"
+
+///Each benchmark is run at least this number of times, after one warm-up iteration
+#define NATRON_BENCHMARK_MIN_SAMPLES 5
+
+///Each benchmark is run until it took at least this many seconds, unless overriden on the command-line
+#define NATRON_BENCHMARK_MIN_TIME_SECONDS 1.
+
+///The version of the JSON output, increment it when its layout changes
+#define NATRON_BENCHMARK_JSON_VERSION 1
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A benchmark of an engine hot path. Derived classes implement run() which performs one iteration of the
+ * measured work and is timed. Work that should not be measured goes in setUp() and tearDown(), called once,
+ * and prepareIteration(), called before each iteration.
+ * Benchmarks are registered with NATRON_REGISTER_BENCHMARK so that the harness finds them.
+ **/
+class Benchmark
+{
+public:
+
+    Benchmark()
+    {
+    }
+
+    virtual ~Benchmark()
+    {
+    }
+
+    /**
+     * @brief The name of the benchmark, formatted as Group.Name (e.g: Image.pasteFrom)
+     **/
+    virtual std::string getName() const = 0;
+
+    /**
+     * @brief The number of items (pixels, hashes, lookups...) processed by one iteration, used to report a throughput.
+     **/
+    virtual double getItemsPerIteration() const
+    {
+        return 1.;
+    }
+
+    /**
+     * @brief The unit of the items counted by getItemsPerIteration()
+     **/
+    virtual std::string getItemsUnit() const
+    {
+        return "items";
+    }
+
+    virtual void setUp()
+    {
+    }
+
+    virtual void prepareIteration()
+    {
+    }
+
+    virtual void run() = 0;
+
+    virtual void tearDown()
+    {
+    }
+};
+
+/**
+ * @brief The timings of a benchmark, in seconds per iteration.
+ **/
+struct BenchmarkResult
+{
+    std::string name;
+    std::string unit;
+    int iterations;
+    double itemsPerIteration;
+    double totalSeconds;
+    double minSeconds;
+    double maxSeconds;
+    double meanSeconds;
+    double medianSeconds;
+    double stdDevSeconds;
+
+    BenchmarkResult()
+        : name()
+        , unit()
+        , iterations(0)
+        , itemsPerIteration(1.)
+        , totalSeconds(0.)
+        , minSeconds(0.)
+        , maxSeconds(0.)
+        , meanSeconds(0.)
+        , medianSeconds(0.)
+        , stdDevSeconds(0.)
+    {
+    }
+
+    ///Throughput computed from the median, which is less sensitive to outliers than the mean
+    double getItemsPerSecond() const
+    {
+        return medianSeconds > 0 ? itemsPerIteration / medianSeconds : 0.;
+    }
+};
+
+typedef Benchmark* (*BenchmarkFactory)();
+
+class BenchmarkRegistry
+{
+public:
+
+    /**
+     * @brief Registers a benchmark, called by NATRON_REGISTER_BENCHMARK during static initialization.
+     **/
+    static bool registerBenchmark(BenchmarkFactory factory);
+
+    static const std::vector<BenchmarkFactory>& getBenchmarks();
+};
+
+/**
+ * @brief Runs the registered benchmarks and reports their timings.
+ **/
+class BenchmarkRunner
+{
+public:
+
+    BenchmarkRunner();
+
+    /**
+     * @brief Only the benchmarks whose name contains filter are run.
+     **/
+    void setFilter(const std::string& filter);
+
+    void setMinTime(double seconds);
+
+    void setVerbose(bool verbose);
+
+    /**
+     * @brief Runs all the benchmarks matching the filter, printing a summary of each on stdout if verbose.
+     * A benchmark throwing an exception is reported on stderr and left out of the results.
+     **/
+    void runAll();
+
+    /**
+     * @brief Runs a single benchmark until it ran for the minimum time and at least NATRON_BENCHMARK_MIN_SAMPLES times.
+     **/
+    BenchmarkResult runBenchmark(Benchmark* benchmark) const;
+
+    const std::vector<BenchmarkResult>& getResults() const
+    {
+        return _results;
+    }
+
+    /**
+     * @brief Writes the results in JSON to filename, or to stdout if filename is "-".
+     * @returns True on success, otherwise error is set.
+     **/
+    bool writeJSON(const std::string& filename, std::string* error) const;
+
+private:
+
+    std::string _filter;
+    double _minTime;
+    bool _verbose;
+    std::vector<BenchmarkResult> _results;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#define NATRON_BENCHMARK_CONCAT_(a, b) a ## b
+#define NATRON_BENCHMARK_CONCAT(a, b) NATRON_BENCHMARK_CONCAT_(a, b)
+
+/**
+ * @brief Registers the benchmark class Type, which must be default-constructible.
+ **/
+#define NATRON_REGISTER_BENCHMARK(Type) \
+    static NATRON_NAMESPACE::Benchmark* NATRON_BENCHMARK_CONCAT(create_, Type)() { return new Type; } \
+    static const bool NATRON_BENCHMARK_CONCAT(registered_, Type) = NATRON_NAMESPACE::BenchmarkRegistry::registerBenchmark( &NATRON_BENCHMARK_CONCAT(create_, Type) );
+
+#endif // BENCHMARK_H
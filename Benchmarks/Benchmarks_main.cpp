@@ -0,0 +1,118 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstdlib> // atof
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/AppManager.h"
+#include "Engine/CLArgs.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+static void
+printUsage(const char* programName)
+{
+    std::cout << "Usage: " << programName << " [options]\n"
+              << "Runs the benchmarks of the engine hot paths.\n\n"
+              << "Options:\n"
+              << "  --list                Lists the benchmarks and exits.\n"
+              << "  --filter <string>     Only runs the benchmarks whose name contains <string>.\n"
+              << "  --min-time <seconds>  Runs each benchmark for at least <seconds> (default: " << NATRON_BENCHMARK_MIN_TIME_SECONDS << ").\n"
+              << "  --json <file>         Writes the results in JSON to <file>, or to stdout if <file> is -.\n"
+              << "  --help                Prints this message.\n";
+}
+
+int
+main(int argc,
+     char *argv[])
+{
+    std::string filter;
+    std::string jsonFile;
+    double minTime = NATRON_BENCHMARK_MIN_TIME_SECONDS;
+    bool list = false;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--list") {
+            list = true;
+        } else if ( (arg == "--filter") && (i + 1 < argc) ) {
+            filter = argv[++i];
+        } else if ( (arg == "--min-time") && (i + 1 < argc) ) {
+            minTime = std::atof(argv[++i]);
+        } else if ( (arg == "--json") && (i + 1 < argc) ) {
+            jsonFile = argv[++i];
+        } else if ( (arg == "--help") || (arg == "-h") ) {
+            printUsage(argv[0]);
+
+            return 0;
+        } else {
+            std::cerr << "Unknown option: " << arg << std::endl;
+            printUsage(argv[0]);
+
+            return 1;
+        }
+    }
+
+    if (list) {
+        const std::vector<BenchmarkFactory>& benchmarks = BenchmarkRegistry::getBenchmarks();
+        for (std::size_t i = 0; i < benchmarks.size(); ++i) {
+            boost::scoped_ptr<Benchmark> benchmark( benchmarks[i]() );
+            std::cout << benchmark->getName() << std::endl;
+        }
+
+        return 0;
+    }
+
+    ///The cache and roto benchmarks need the application, it is loaded the same way as for the unit tests
+    AppManager manager;
+    int appArgc = 0;
+    CLArgs cl;
+    manager.load(appArgc, 0, cl);
+
+    BenchmarkRunner runner;
+    runner.setFilter(filter);
+    runner.setMinTime(minTime);
+    //Do not mix the summary with the JSON output
+    runner.setVerbose(jsonFile != "-");
+    runner.runAll();
+
+    if ( !jsonFile.empty() ) {
+        std::string error;
+        if ( !runner.writeJSON(jsonFile, &error) ) {
+            std::cerr << error << std::endl;
+
+            return 1;
+        }
+    }
+
+    return 0;
+} // main
@@ -0,0 +1,151 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <algorithm> // max
+#include <vector>
+
+#include <QtCore/QThread>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/AppManager.h"
+#include "Engine/Image.h"
+#include "Engine/ImageComponents.h"
+#include "Engine/ImageKey.h"
+#include "Engine/ImageParams.h"
+#include "Engine/ViewIdx.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+///The number of distinct images looked-up by the threads: most look-ups hit an existing entry
+#define CACHE_BENCHMARK_KEYS 64
+#define CACHE_BENCHMARK_LOOKUPS_PER_THREAD 2000
+#define CACHE_BENCHMARK_IMAGE_SIZE 64
+
+namespace {
+
+class CacheLookupThread
+    : public QThread
+{
+public:
+
+    CacheLookupThread(int index,
+                      const boost::shared_ptr<ImageParams>& params)
+        : QThread()
+        , _index(index)
+        , _params(params)
+    {
+    }
+
+    virtual ~CacheLookupThread()
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        for (int i = 0; i < CACHE_BENCHMARK_LOOKUPS_PER_THREAD; ++i) {
+            ///Each thread walks the keys in a different order so that threads contend on the same entries
+            U64 nodeHash = 1 + ( (U64)i * (2 * _index + 1) ) % CACHE_BENCHMARK_KEYS;
+            ImageKey key(0, nodeHash, false, 0, ViewIdx(0), 1., false, false);
+            boost::shared_ptr<Image> image;
+            if ( !appPTR->getImageOrCreate(key, _params, &image) && image ) {
+                image->allocateMemory();
+            }
+        }
+    }
+
+    int _index;
+    boost::shared_ptr<ImageParams> _params;
+};
+} // anon namespace
+
+class CacheGetOrCreateBenchmark
+    : public Benchmark
+{
+public:
+
+    CacheGetOrCreateBenchmark()
+        : Benchmark()
+        , _nThreads( std::max(2, QThread::idealThreadCount() ) )
+        , _params()
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Cache.getOrCreate";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)_nThreads * CACHE_BENCHMARK_LOOKUPS_PER_THREAD;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "lookups";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        appPTR->clearNodeCache();
+        RectD rod(0, 0, CACHE_BENCHMARK_IMAGE_SIZE, CACHE_BENCHMARK_IMAGE_SIZE);
+        _params = Image::makeParams(0, rod, 1., 0, false, ImageComponents::getRGBAComponents(), eImageBitDepthFloat,
+                                    eImagePremultiplicationPremultiplied, eImageFieldingOrderNone);
+    }
+
+    virtual void run() OVERRIDE
+    {
+        std::vector<boost::shared_ptr<CacheLookupThread> > threads;
+
+        for (int i = 0; i < _nThreads; ++i) {
+            threads.push_back( boost::shared_ptr<CacheLookupThread>( new CacheLookupThread(i, _params) ) );
+        }
+        for (int i = 0; i < _nThreads; ++i) {
+            threads[i]->start();
+        }
+        for (int i = 0; i < _nThreads; ++i) {
+            threads[i]->wait();
+        }
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        _params.reset();
+        appPTR->clearNodeCache();
+    }
+
+private:
+
+    int _nThreads;
+    boost::shared_ptr<ImageParams> _params;
+};
+
+NATRON_REGISTER_BENCHMARK(CacheGetOrCreateBenchmark)
@@ -0,0 +1,102 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <vector>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/Curve.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+#define CURVE_BENCHMARK_KEYFRAMES 100
+#define CURVE_BENCHMARK_LOOKUPS 100000
+
+class CurveGetValueAtBenchmark
+    : public Benchmark
+{
+public:
+
+    CurveGetValueAtBenchmark()
+        : Benchmark()
+        , _curve()
+        , _sum(0.)
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Curve.getValueAt";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return CURVE_BENCHMARK_LOOKUPS;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "lookups";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        _curve.reset(new Curve);
+        std::vector<KeyFrame> keys;
+        for (int i = 0; i < CURVE_BENCHMARK_KEYFRAMES; ++i) {
+            keys.push_back( KeyFrame( i * 10., (i % 7) * 1.5 - (i % 3) ) );
+        }
+        _curve->addKeyFrames(keys);
+    }
+
+    virtual void run() OVERRIDE
+    {
+        double sum = 0.;
+        double range = CURVE_BENCHMARK_KEYFRAMES * 10.;
+
+        ///Fractional times spread over the whole curve, plus a few outside of it
+        for (int i = 0; i < CURVE_BENCHMARK_LOOKUPS; ++i) {
+            double t = -10. + (range + 20.) * i / CURVE_BENCHMARK_LOOKUPS;
+            sum += _curve->getValueAt(t);
+        }
+        ///Keep the result so that the loop is not optimized out
+        _sum += sum;
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        _curve.reset();
+    }
+
+private:
+
+    boost::scoped_ptr<Curve> _curve;
+    double _sum;
+};
+
+NATRON_REGISTER_BENCHMARK(CurveGetValueAtBenchmark)
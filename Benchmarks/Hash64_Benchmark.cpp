@@ -0,0 +1,79 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Engine/Hash64.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+///About the number of values appended for a node with a few dozens of knobs
+#define HASH64_BENCHMARK_VALUES 256
+#define HASH64_BENCHMARK_HASHES 1000
+
+class Hash64ComputeHashBenchmark
+    : public Benchmark
+{
+public:
+
+    Hash64ComputeHashBenchmark()
+        : Benchmark()
+        , _result(0)
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Hash64.computeHash";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return HASH64_BENCHMARK_HASHES;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "hashes";
+    }
+
+    virtual void run() OVERRIDE
+    {
+        for (int i = 0; i < HASH64_BENCHMARK_HASHES; ++i) {
+            Hash64 hash;
+            for (int j = 0; j < HASH64_BENCHMARK_VALUES; ++j) {
+                hash.append<double>(i * 0.5 + j);
+            }
+            hash.computeHash();
+            ///Keep the result so that the loop is not optimized out
+            _result ^= hash.value();
+        }
+    }
+
+private:
+
+    U64 _result;
+};
+
+NATRON_REGISTER_BENCHMARK(Hash64ComputeHashBenchmark)
@@ -0,0 +1,276 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <list>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/Image.h"
+#include "Engine/ImageComponents.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+///Benchmarks run on HD frames
+#define IMAGE_BENCHMARK_WIDTH 1920
+#define IMAGE_BENCHMARK_HEIGHT 1080
+
+static Image*
+createImage(const ImageComponents& components,
+            ImageBitDepthEnum depth,
+            int width,
+            int height,
+            unsigned int mipMapLevel)
+{
+    RectI bounds(0, 0, width, height);
+    RectD rod(0, 0, width << mipMapLevel, height << mipMapLevel);
+
+    return new Image(components, rod, bounds, mipMapLevel, 1., depth, eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, false);
+}
+
+///Fills a float image with a gradient so that the conversions do not work on constant data
+static void
+fillImage(Image* image)
+{
+    const RectI& bounds = image->getBounds();
+    int nComps = (int)image->getComponentsCount();
+    Image::WriteAccess acc(image);
+    float* pix = (float*)acc.pixelAt(bounds.x1, bounds.y1);
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        for (int x = bounds.x1; x < bounds.x2; ++x) {
+            for (int c = 0; c < nComps; ++c, ++pix) {
+                *pix = (float)( (x + y * (c + 1)) % 1024 ) / 1023.f;
+            }
+        }
+    }
+}
+
+class ImageBenchmarkBase
+    : public Benchmark
+{
+public:
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)IMAGE_BENCHMARK_WIDTH * IMAGE_BENCHMARK_HEIGHT;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "pixels";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        _src.reset( createImage(ImageComponents::getRGBAComponents(), eImageBitDepthFloat, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT, 0) );
+        fillImage( _src.get() );
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        _src.reset();
+        _dst.reset();
+    }
+
+protected:
+
+    boost::scoped_ptr<Image> _src;
+    boost::scoped_ptr<Image> _dst;
+};
+
+class ImageConvertToFormatBenchmark
+    : public ImageBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Image.convertToFormat";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        ImageBenchmarkBase::setUp();
+        ///Float linear to 8-bit sRGB, as done when displaying an image
+        _dst.reset( createImage(ImageComponents::getRGBAComponents(), eImageBitDepthByte, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT, 0) );
+    }
+
+    virtual void run() OVERRIDE
+    {
+        _src->convertToFormat(_src->getBounds(), eViewerColorSpaceLinear, eViewerColorSpaceSRGB, 3, false, false, _dst.get() );
+    }
+};
+
+NATRON_REGISTER_BENCHMARK(ImageConvertToFormatBenchmark)
+
+class ImagePasteFromBenchmark
+    : public ImageBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Image.pasteFrom";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        ImageBenchmarkBase::setUp();
+        _dst.reset( createImage(ImageComponents::getRGBAComponents(), eImageBitDepthFloat, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT, 0) );
+    }
+
+    virtual void run() OVERRIDE
+    {
+        _dst->pasteFrom(*_src, _src->getBounds(), false);
+    }
+};
+
+NATRON_REGISTER_BENCHMARK(ImagePasteFromBenchmark)
+
+///Halving the image is the path the mipmaps are built with (halveRoI, which is private)
+class ImageDownscaleMipMapBenchmark
+    : public ImageBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Image.downscaleMipMap";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        ImageBenchmarkBase::setUp();
+        _dst.reset( createImage(ImageComponents::getRGBAComponents(), eImageBitDepthFloat, IMAGE_BENCHMARK_WIDTH / 2, IMAGE_BENCHMARK_HEIGHT / 2, 1) );
+    }
+
+    virtual void run() OVERRIDE
+    {
+        _src->downscaleMipMap(_src->getRoD(), _src->getBounds(), 0, 1, false, _dst.get() );
+    }
+};
+
+NATRON_REGISTER_BENCHMARK(ImageDownscaleMipMapBenchmark)
+
+class ImageApplyMaskMixBenchmark
+    : public ImageBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Image.applyMaskMix";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        ImageBenchmarkBase::setUp();
+        _dst.reset( createImage(ImageComponents::getRGBAComponents(), eImageBitDepthFloat, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT, 0) );
+        _dst->pasteFrom(*_src, _src->getBounds(), false);
+        _mask.reset( createImage(ImageComponents::getAlphaComponents(), eImageBitDepthFloat, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT, 0) );
+        fillImage( _mask.get() );
+    }
+
+    virtual void run() OVERRIDE
+    {
+        ///Masked and mixed, which is the most expensive path
+        _dst->applyMaskMix(_dst->getBounds(), _mask.get(), _src.get(), true, false, 0.5f);
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        ImageBenchmarkBase::tearDown();
+        _mask.reset();
+    }
+
+private:
+
+    boost::scoped_ptr<Image> _mask;
+};
+
+NATRON_REGISTER_BENCHMARK(ImageApplyMaskMixBenchmark)
+
+class BitmapMinimalNonMarkedRectsBenchmark
+    : public Benchmark
+{
+public:
+
+    BitmapMinimalNonMarkedRectsBenchmark()
+        : Benchmark()
+        , _bounds(0, 0, IMAGE_BENCHMARK_WIDTH, IMAGE_BENCHMARK_HEIGHT)
+        , _bitmap()
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Bitmap.minimalNonMarkedRects";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)_bounds.area();
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "pixels";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        _bitmap.reset( new Bitmap(_bounds) );
+        ///A partially rendered image: some tiles already rendered, with edges that do not fall on tile boundaries
+        for (int i = 0; i < 8; ++i) {
+            RectI rendered(37 + i * 223, 11 + i * 97, 37 + i * 223 + 201, 11 + i * 97 + 301);
+            RectI clipped;
+            if ( rendered.intersect(_bounds, &clipped) ) {
+                _bitmap->markForRendered(clipped);
+            }
+        }
+    }
+
+    virtual void run() OVERRIDE
+    {
+        std::list<RectI> rects;
+
+        _bitmap->minimalNonMarkedRects(_bounds, rects);
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        _bitmap.reset();
+    }
+
+private:
+
+    RectI _bounds;
+    boost::scoped_ptr<Bitmap> _bitmap;
+};
+
+NATRON_REGISTER_BENCHMARK(BitmapMinimalNonMarkedRectsBenchmark)
@@ -0,0 +1,167 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <vector>
+
+#include "Engine/Lut.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+#define LUT_BENCHMARK_WIDTH 1920
+#define LUT_BENCHMARK_HEIGHT 1080
+
+class LutBenchmarkBase
+    : public Benchmark
+{
+public:
+
+    LutBenchmarkBase()
+        : Benchmark()
+        , _lut(0)
+        , _bounds(0, 0, LUT_BENCHMARK_WIDTH, LUT_BENCHMARK_HEIGHT)
+        , _floatPixels()
+        , _bytePixels()
+    {
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)_bounds.area();
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "pixels";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        _lut = Color::LutManager::sRGBLut();
+        _lut->validate();
+        _floatPixels.resize(_bounds.area() * 4);
+        _bytePixels.resize(_bounds.area() * 4);
+        for (std::size_t i = 0; i < _floatPixels.size(); ++i) {
+            _floatPixels[i] = (float)(i % 4096) / 4095.f;
+            _bytePixels[i] = (unsigned char)(i % 256);
+        }
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        _floatPixels.clear();
+        _bytePixels.clear();
+    }
+
+protected:
+
+    const Color::Lut* _lut;
+    RectI _bounds;
+    std::vector<float> _floatPixels;
+    std::vector<unsigned char> _bytePixels;
+};
+
+class LutToBytePackedBenchmark
+    : public LutBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Lut.to_byte_packed";
+    }
+
+    virtual void run() OVERRIDE
+    {
+        ///Linear float RGBA to sRGB 8-bit BGRA, with error diffusion, as done for the viewer
+        _lut->to_byte_packed(&_bytePixels.front(), &_floatPixels.front(), _bounds, _bounds, _bounds,
+                             Color::ePixelPackingRGBA, Color::ePixelPackingBGRA, false, false);
+    }
+};
+
+NATRON_REGISTER_BENCHMARK(LutToBytePackedBenchmark)
+
+class LutFromBytePlanarBenchmark
+    : public LutBenchmarkBase
+{
+public:
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Lut.from_byte_planar";
+    }
+
+    virtual void run() OVERRIDE
+    {
+        ///sRGB 8-bit to linear float, as done when reading 8-bit images
+        _lut->from_byte_planar(&_floatPixels.front(), &_bytePixels.front(), _bounds.area() * 4);
+    }
+};
+
+NATRON_REGISTER_BENCHMARK(LutFromBytePlanarBenchmark)
+
+class LutToColorSpaceFloatBenchmark
+    : public LutBenchmarkBase
+{
+public:
+
+    LutToColorSpaceFloatBenchmark()
+        : LutBenchmarkBase()
+        , _sum(0.)
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Lut.toColorSpaceFloatFromLinearFloat";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)_bounds.area() * 4;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "values";
+    }
+
+    virtual void run() OVERRIDE
+    {
+        float sum = 0.f;
+
+        for (std::size_t i = 0; i < _floatPixels.size(); ++i) {
+            sum += _lut->toColorSpaceFloatFromLinearFloat(_floatPixels[i]);
+        }
+        ///Keep the result so that the loop is not optimized out
+        _sum += sum;
+    }
+
+private:
+
+    double _sum;
+};
+
+NATRON_REGISTER_BENCHMARK(LutToColorSpaceFloatBenchmark)
@@ -0,0 +1,123 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <stdexcept>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Bezier.h"
+#include "Engine/EffectInstance.h"
+#include "Engine/Image.h"
+#include "Engine/ImageComponents.h"
+#include "Engine/KnobTypes.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/RotoContext.h"
+#include "Engine/ViewIdx.h"
+
+#include "Benchmark.h"
+
+NATRON_NAMESPACE_USING
+
+///The diameter of the shape, in pixels
+#define ROTO_BENCHMARK_SHAPE_SIZE 800
+
+class RotoRenderMaskBenchmark
+    : public Benchmark
+{
+public:
+
+    RotoRenderMaskBenchmark()
+        : Benchmark()
+        , _node()
+        , _shape()
+    {
+    }
+
+    virtual std::string getName() const OVERRIDE
+    {
+        return "Roto.renderMaskFromStroke";
+    }
+
+    virtual double getItemsPerIteration() const OVERRIDE
+    {
+        return (double)ROTO_BENCHMARK_SHAPE_SIZE * ROTO_BENCHMARK_SHAPE_SIZE;
+    }
+
+    virtual std::string getItemsUnit() const OVERRIDE
+    {
+        return "pixels";
+    }
+
+    virtual void setUp() OVERRIDE
+    {
+        AppInstance* app = appPTR->getTopLevelInstance();
+        if (!app) {
+            throw std::runtime_error("No application instance");
+        }
+        CreateNodeArgs args(QString::fromUtf8(PLUGINID_NATRON_ROTO), eCreateNodeReasonInternal, app->getProject());
+        _node = app->createNode(args);
+        boost::shared_ptr<RotoContext> context = _node ? _node->getRotoContext() : boost::shared_ptr<RotoContext>();
+        if (!context) {
+            throw std::runtime_error("Could not create a Roto node");
+        }
+        _shape = context->makeEllipse(100, 100, ROTO_BENCHMARK_SHAPE_SIZE, false, 0);
+        ///A feathered shape, which is the most expensive to rasterize
+        _shape->getFeatherKnob()->setValue(20.);
+    }
+
+    virtual void prepareIteration() OVERRIDE
+    {
+        ///The mask is cached, remove it so that it is rendered again
+        appPTR->removeAllCacheEntriesForHolder(_shape.get(), true);
+    }
+
+    virtual void run() OVERRIDE
+    {
+        _node->getRotoContext()->renderMaskFromStroke(_shape, ImageComponents::getAlphaComponents(), 0, ViewIdx(0), eImageBitDepthFloat, 0);
+    }
+
+    virtual void tearDown() OVERRIDE
+    {
+        if (_shape) {
+            appPTR->removeAllCacheEntriesForHolder(_shape.get(), true);
+        }
+        _shape.reset();
+        if (_node) {
+            _node->destroyNode(false);
+        }
+        _node.reset();
+    }
+
+private:
+
+    NodePtr _node;
+    boost::shared_ptr<Bezier> _shape;
+};
+
+NATRON_REGISTER_BENCHMARK(RotoRenderMaskBenchmark)
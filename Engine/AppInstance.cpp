@@ -29,13 +29,16 @@
 #include <cassert>
 #include <stdexcept>
 
+#include <QtCore/QCoreApplication>
 #include <QtCore/QDir>
 #include <QtCore/QTextStream>
 #include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
 #include <QtCore/QUrl>
 #include <QtCore/QFileInfo>
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QEventLoop>
 #include <QtCore/QSettings>
+#include <QtCore/QThread>
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
@@ -55,6 +58,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/Node.h"
 #include "Engine/NodeSerialization.h"
 #include "Engine/OfxHost.h"
+#include "Engine/PerfReport.h"
 #include "Engine/Plugin.h"
 #include "Engine/Project.h"
 #include "Engine/ProcessHandler.h"
@@ -124,6 +128,24 @@ struct AppInstancePrivate
     mutable QMutex renderQueueMutex;
     std::list<RenderQueueItem> renderQueue, activeRenders;
     
+    //The errors of the renders that failed since the last call to takeRenderFailures(), protected by renderQueueMutex
+    std::list<std::string> renderFailures;
+    
+    //Protects all batch* members
+    mutable QMutex batchMutex;
+    
+    //Recursion count of beginBatch()/endBatch()
+    int batchCount;
+    
+    //The holders on which beginChanges() was called by the outermost beginBatch()
+    std::list<NodeWPtr> batchNodes;
+    
+    //The viewers which asked for a render during the batch, with whether the render is significant
+    std::list<std::pair<NodeWPtr, bool> > batchViewers;
+    
+    //True if a node asked to refresh its preview during the batch
+    bool batchPreviewsDirty;
+    
     AppInstancePrivate(int appID,
                        AppInstance* app)
     : _publicInterface(app)
@@ -136,6 +158,12 @@ struct AppInstancePrivate
     , _creatingTree(0)
     , renderQueueMutex()
     , renderQueue()
+    , renderFailures()
+    , batchMutex()
+    , batchCount(0)
+    , batchNodes()
+    , batchViewers()
+    , batchPreviewsDirty(false)
     {
     }
     
@@ -212,6 +240,138 @@ AppInstance::setIsCreatingNodeTree(bool b)
     }
 }
 
+void
+AppInstance::beginBatch()
+{
+    assert(QThread::currentThread() == qApp->thread());
+    {
+        QMutexLocker k(&_imp->batchMutex);
+        ++_imp->batchCount;
+        if (_imp->batchCount > 1) {
+            return;
+        }
+    }
+    
+    NodesList nodes;
+    _imp->_currentProject->getNodes_recursive(nodes, false);
+    
+    std::list<NodeWPtr> blocked;
+    for (NodesList::iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        EffectInstPtr effect = (*it)->getEffectInstance();
+        if (effect) {
+            effect->beginChanges();
+            blocked.push_back(*it);
+        }
+    }
+    _imp->_currentProject->beginChanges();
+    
+    QMutexLocker k(&_imp->batchMutex);
+    _imp->batchNodes = blocked;
+}
+
+void
+AppInstance::endBatch()
+{
+    assert(QThread::currentThread() == qApp->thread());
+    std::list<NodeWPtr> blocked;
+    {
+        QMutexLocker k(&_imp->batchMutex);
+        if (_imp->batchCount == 0) {
+            return;
+        }
+        if (_imp->batchCount > 1) {
+            --_imp->batchCount;
+            return;
+        }
+        blocked.swap(_imp->batchNodes);
+    }
+    
+    // Close the changes blocks while the batch is still active: each holder runs its
+    // knobChanged handlers and refreshes its own hash, but hash propagation and renders are only recorded.
+    for (std::list<NodeWPtr>::iterator it = blocked.begin(); it != blocked.end(); ++it) {
+        NodePtr node = it->lock();
+        if (!node) {
+            continue;
+        }
+        EffectInstPtr effect = node->getEffectInstance();
+        if (effect) {
+            effect->endChanges();
+        }
+    }
+    _imp->_currentProject->endChanges();
+    
+    std::list<std::pair<NodeWPtr, bool> > viewers;
+    bool refreshPreviews;
+    {
+        QMutexLocker k(&_imp->batchMutex);
+        _imp->batchCount = 0;
+        viewers.swap(_imp->batchViewers);
+        refreshPreviews = _imp->batchPreviewsDirty;
+        _imp->batchPreviewsDirty = false;
+    }
+    
+    // One hash propagation over the whole graph, upstream nodes first
+    NodesList nodes;
+    _imp->_currentProject->getNodes_recursive(nodes, false);
+    Node::computeHashOfNodes(nodes);
+    
+    // One render request per viewer
+    for (std::list<std::pair<NodeWPtr, bool> >::iterator it = viewers.begin(); it != viewers.end(); ++it) {
+        NodePtr node = it->first.lock();
+        if (!node) {
+            continue;
+        }
+        ViewerInstance* viewer = dynamic_cast<ViewerInstance*>(node->getEffectInstance().get());
+        if (!viewer) {
+            continue;
+        }
+        if (it->second) {
+            viewer->renderCurrentFrame(true);
+        } else {
+            viewer->redrawViewer();
+        }
+    }
+    if (refreshPreviews) {
+        refreshAllPreviews();
+    }
+}
+
+bool
+AppInstance::isBatchingChanges() const
+{
+    QMutexLocker k(&_imp->batchMutex);
+    return _imp->batchCount > 0;
+}
+
+bool
+AppInstance::deferViewerRenderDuringBatch(ViewerInstance* viewer, bool isSignificant)
+{
+    QMutexLocker k(&_imp->batchMutex);
+    if (!_imp->batchCount) {
+        return false;
+    }
+    NodePtr node = viewer->getNode();
+    for (std::list<std::pair<NodeWPtr, bool> >::iterator it = _imp->batchViewers.begin(); it != _imp->batchViewers.end(); ++it) {
+        if (it->first.lock() == node) {
+            it->second |= isSignificant;
+            return true;
+        }
+    }
+    _imp->batchViewers.push_back(std::make_pair(NodeWPtr(node), isSignificant));
+    return true;
+}
+
+bool
+AppInstance::deferPreviewsRefreshDuringBatch()
+{
+    QMutexLocker k(&_imp->batchMutex);
+    if (!_imp->batchCount) {
+        return false;
+    }
+    _imp->batchPreviewsDirty = true;
+    return true;
+}
+
 void
 AppInstance::checkForNewVersion() const
 {
@@ -501,101 +661,17 @@ AppInstance::load(const CLArgs& cl,bool makeEmptyInstance)
     
     const QString& extraOnProjectCreatedScript = cl.getDefaultOnProjectLoadedScript();
     
-    _imp->executeCommandLinePythonCommands(cl);
-
-    
     ///if the app is a background project autorun and the project name is empty just throw an exception.
     if ( (appPTR->getAppType() == AppManager::eAppTypeBackgroundAutoRun ||
           appPTR->getAppType() == AppManager::eAppTypeBackgroundAutoRunLaunchedFromGui)) {
         
-        if (cl.getScriptFilename().isEmpty()) {
-            // cannot start a background process without a file
-            throw std::invalid_argument(tr("Project file name empty").toStdString());
-        }
-        
-
-        QFileInfo info(cl.getScriptFilename());
-        if (!info.exists()) {
-            throw std::invalid_argument(tr("Specified project file does not exist").toStdString());
-        }
-        
-        std::list<AppInstance::RenderWork> writersWork;
-        
-        
-        if (info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT)) {
-            
-            ///Load the project
-            if ( !_imp->_currentProject->loadProject(info.path(),info.fileName()) ) {
-                throw std::invalid_argument(tr("Project file loading failed.").toStdString());
-            }
-            
-        } else if (info.suffix() == QString::fromUtf8("py")) {
-            
-            ///Load the python script
-            loadPythonScript(info);
-
-        } else {
-            throw std::invalid_argument(tr(NATRON_APPLICATION_NAME " only accepts python scripts or .ntp project files").toStdString());
-        }
-        
-        
-        ///exec the python script specified via --onload
-        if (!extraOnProjectCreatedScript.isEmpty()) {
-            QFileInfo cbInfo(extraOnProjectCreatedScript);
-            if (cbInfo.exists()) {
-                loadPythonScript(cbInfo);
-            }
-        }
-        
-        
-        getWritersWorkForCL(cl, writersWork);
-
-        
-        ///Set reader parameters if specified from the command-line
-        const std::list<CLArgs::ReaderArg>& readerArgs = cl.getReaderArgs();
-        for (std::list<CLArgs::ReaderArg>::const_iterator it = readerArgs.begin(); it!=readerArgs.end(); ++it) {
-            std::string readerName = it->name.toStdString();
-            NodePtr readNode = getNodeByFullySpecifiedName(readerName);
-            
-            if (!readNode) {
-                std::string exc(readerName);
-                exc.append(tr(" does not belong to the project file. Please enter a valid Read node script-name.").toStdString());
-                throw std::invalid_argument(exc);
-            } else {
-                if (!readNode->getEffectInstance()->isReader()) {
-                    std::string exc(readerName);
-                    exc.append(tr(" is not a Read node! It cannot render anything.").toStdString());
-                    throw std::invalid_argument(exc);
-                }
-            }
-            
-            if (it->filename.isEmpty()) {
-                std::string exc(readerName);
-                exc.append(tr(": Filename specified is empty but [-i] or [--reader] was passed to the command-line").toStdString());
-                throw std::invalid_argument(exc);
-            }
-            KnobPtr fileKnob = readNode->getKnobByName(kOfxImageEffectFileParamName);
-            if (fileKnob) {
-                KnobFile* outFile = dynamic_cast<KnobFile*>(fileKnob.get());
-                if (outFile) {
-                    outFile->setValue(it->filename.toStdString());
-                }
-            }
-
-        }
-       
-        ///launch renders
-        if (!writersWork.empty()) {
-            startWritersRendering(false, writersWork);
-        } else {
-            std::list<std::string> writers;
-            startWritersRenderingFromNames(cl.areRenderStatsEnabled(), false, writers, cl.getFrameRanges());
-        }
-       
-        
+        loadScriptFromCL(cl);
         
+        renderFromCL(cl);
         
     } else if (appPTR->getAppType() == AppManager::eAppTypeInterpreter) {
+        _imp->executeCommandLinePythonCommands(cl);
+        
         QFileInfo info(cl.getScriptFilename());
         if (info.exists()) {
             
@@ -618,6 +694,8 @@ AppInstance::load(const CLArgs& cl,bool makeEmptyInstance)
         
         appPTR->launchPythonInterpreter();
     } else {
+        _imp->executeCommandLinePythonCommands(cl);
+        
         execOnProjectCreatedCallback();
         
         if (!extraOnProjectCreatedScript.isEmpty()) {
@@ -630,6 +708,99 @@ AppInstance::load(const CLArgs& cl,bool makeEmptyInstance)
     }
 }
 
+void
+AppInstance::loadScriptFromCL(const CLArgs& cl)
+{
+    _imp->executeCommandLinePythonCommands(cl);
+    
+    if (cl.getScriptFilename().isEmpty()) {
+        // cannot start a background process without a file
+        throw std::invalid_argument(tr("Project file name empty").toStdString());
+    }
+    
+    
+    QFileInfo info(cl.getScriptFilename());
+    if (!info.exists()) {
+        throw std::invalid_argument(tr("Specified project file does not exist").toStdString());
+    }
+    
+    if (info.suffix() == QString::fromUtf8(NATRON_PROJECT_FILE_EXT)) {
+        
+        ///Load the project
+        if ( !_imp->_currentProject->loadProject(info.path(),info.fileName()) ) {
+            throw std::invalid_argument(tr("Project file loading failed.").toStdString());
+        }
+        
+    } else if (info.suffix() == QString::fromUtf8("py")) {
+        
+        ///Load the python script
+        loadPythonScript(info);
+
+    } else {
+        throw std::invalid_argument(tr(NATRON_APPLICATION_NAME " only accepts python scripts or .ntp project files").toStdString());
+    }
+    
+    
+    ///exec the python script specified via --onload
+    const QString& extraOnProjectCreatedScript = cl.getDefaultOnProjectLoadedScript();
+    if (!extraOnProjectCreatedScript.isEmpty()) {
+        QFileInfo cbInfo(extraOnProjectCreatedScript);
+        if (cbInfo.exists()) {
+            loadPythonScript(cbInfo);
+        }
+    }
+}
+
+void
+AppInstance::renderFromCL(const CLArgs& cl)
+{
+    std::list<AppInstance::RenderWork> writersWork;
+    
+    getWritersWorkForCL(cl, writersWork);
+
+    
+    ///Set reader parameters if specified from the command-line
+    const std::list<CLArgs::ReaderArg>& readerArgs = cl.getReaderArgs();
+    for (std::list<CLArgs::ReaderArg>::const_iterator it = readerArgs.begin(); it!=readerArgs.end(); ++it) {
+        std::string readerName = it->name.toStdString();
+        NodePtr readNode = getNodeByFullySpecifiedName(readerName);
+        
+        if (!readNode) {
+            std::string exc(readerName);
+            exc.append(tr(" does not belong to the project file. Please enter a valid Read node script-name.").toStdString());
+            throw std::invalid_argument(exc);
+        } else {
+            if (!readNode->getEffectInstance()->isReader()) {
+                std::string exc(readerName);
+                exc.append(tr(" is not a Read node! It cannot render anything.").toStdString());
+                throw std::invalid_argument(exc);
+            }
+        }
+        
+        if (it->filename.isEmpty()) {
+            std::string exc(readerName);
+            exc.append(tr(": Filename specified is empty but [-i] or [--reader] was passed to the command-line").toStdString());
+            throw std::invalid_argument(exc);
+        }
+        KnobPtr fileKnob = readNode->getKnobByName(kOfxImageEffectFileParamName);
+        if (fileKnob) {
+            KnobFile* outFile = dynamic_cast<KnobFile*>(fileKnob.get());
+            if (outFile) {
+                outFile->setValue(it->filename.toStdString());
+            }
+        }
+
+    }
+   
+    ///launch renders
+    if (!writersWork.empty()) {
+        startWritersRendering(false, writersWork);
+    } else {
+        std::list<std::string> writers;
+        startWritersRenderingFromNames(cl.areRenderStatsEnabled(), false, writers, cl.getFrameRanges());
+    }
+}
+
 bool
 AppInstance::loadPythonScript(const QFileInfo& file)
 {
@@ -1425,7 +1596,12 @@ AppInstance::startWritersRendering(bool doBlockingRender, const std::list<Render
     
     if (appPTR->isBackground() || doBlockingRender) {
         //blocking call, we don't want this function to return pre-maturely, in which case it would kill the app
+        QElapsedTimer renderTimer;
+        renderTimer.start();
         QtConcurrent::blockingMap( itemsToQueue,boost::bind(&AppInstancePrivate::startRenderingFullSequence,_imp.get(),true, _1) );
+        if ( PerfReport::isEnabled() ) {
+            PerfReport::addRenderWallTime(renderTimer.nsecsElapsed() * 1e-9);
+        }
     } else {
         
         bool isQueuingEnabled = appPTR->getCurrentSettings()->isRenderQueuingEnabled();
@@ -1567,6 +1743,28 @@ AppInstance::removeRenderFromQueue(OutputEffectInstance* writer)
     }
 }
 
+void
+AppInstance::notifyRenderFailure(const std::string& errorMessage)
+{
+    QMutexLocker k(&_imp->renderQueueMutex);
+    _imp->renderFailures.push_back(errorMessage);
+}
+
+std::string
+AppInstance::takeRenderFailures()
+{
+    std::string ret;
+    QMutexLocker k(&_imp->renderQueueMutex);
+    for (std::list<std::string>::iterator it = _imp->renderFailures.begin(); it!=_imp->renderFailures.end(); ++it) {
+        if (!ret.empty()) {
+            ret.append("\n");
+        }
+        ret.append(it->empty() ? tr("Render failed").toStdString() : *it);
+    }
+    _imp->renderFailures.clear();
+    return ret;
+}
+
 void
 AppInstance::startNextQueuedRender(OutputEffectInstance* finishedWriter)
 {
@@ -180,6 +180,19 @@ public:
     
     virtual void load(const CLArgs& cl,bool makeEmptyInstance);
 
+    /**
+     * @brief Executes the Python commands given on the command-line, then loads the project or Python script
+     * and executes the --onload script. Throws an exception on failure.
+     **/
+    void loadScriptFromCL(const CLArgs& cl);
+
+    /**
+     * @brief Sets the Read nodes file names given on the command-line and renders the writers with the
+     * frame ranges given on the command-line. The project must have been loaded with loadScriptFromCL().
+     * Throws an exception on failure.
+     **/
+    void renderFromCL(const CLArgs& cl);
+
     int getAppID() const;
 
     /** @brief Create a new node  in the node graph.
@@ -358,6 +371,29 @@ public:
     
     void setIsCreatingNodeTree(bool b);
     
+    /**
+     * @brief Starts a batch of changes over the whole project: the changes made to the knobs of all nodes
+     * and of the project, keyframes and connections are coalesced until the matching endBatch() call, which
+     * propagates the hash through the graph once and issues one render request per viewer.
+     * Calls can be nested, only the outermost endBatch() has an effect.
+     * Must be called on the main-thread.
+     **/
+    void beginBatch();
+    void endBatch();
+    bool isBatchingChanges() const;
+    
+    /**
+     * @brief If a batch is in progress, records that the given viewer must render (or just redraw if not significant)
+     * when the batch ends and returns true. Returns false otherwise.
+     **/
+    bool deferViewerRenderDuringBatch(ViewerInstance* viewer, bool isSignificant);
+    
+    /**
+     * @brief If a batch is in progress, records that previews must be refreshed when the batch ends and returns true.
+     * Returns false otherwise.
+     **/
+    bool deferPreviewsRefreshDuringBatch();
+    
     virtual void appendToScriptEditor(const std::string& str);
     
     virtual void printAutoDeclaredVariable(const std::string& str);
@@ -443,6 +479,17 @@ public:
     
     void removeRenderFromQueue(OutputEffectInstance* writer);
     
+    /**
+     * @brief Called by the render engine of a writer when its render fails in background mode. This is thread-safe.
+     **/
+    void notifyRenderFailure(const std::string& errorMessage);
+    
+    /**
+     * @brief Returns the errors of the renders that failed since the last call, separated by new lines,
+     * or an empty string if none failed.
+     **/
+    std::string takeRenderFailures();
+    
 public Q_SLOTS:
     
     void quit();
@@ -28,6 +28,7 @@
 #include <clocale>
 #include <csignal>
 #include <cstddef>
+#include <cstring> // memcpy, memset
 #include <cassert>
 #include <stdexcept>
 
@@ -81,13 +82,16 @@
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxHost.h"
 #include "Engine/OneViewNode.h"
+#include "Engine/PerfReport.h"
 #include "Engine/ProcessHandler.h" // ProcessInputChannel
 #include "Engine/Project.h"
 #include "Engine/PrecompNode.h"
 #include "Engine/ReadNode.h"
+#include "Engine/RenderDaemon.h"
 #include "Engine/RotoPaint.h"
 #include "Engine/RotoSmear.h"
 #include "Engine/StandardPaths.h"
+#include "Engine/TraceRecorder.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h" // RenderStatsMap
 #include "Engine/WriteNode.h"
@@ -360,6 +364,22 @@ AppManager::~AppManager()
     ///Caches may have launched some threads to delete images, wait for them to be done
     QThreadPool::globalInstance()->waitForDone();
     
+    if ( !_imp->traceFilename.isEmpty() ) {
+        TraceRecorder::setEnabled(false);
+        std::string error;
+        if ( !TraceRecorder::writeChromeTrace(_imp->traceFilename.toStdString(), &error) ) {
+            std::cerr << error << std::endl;
+        }
+    }
+    
+    if ( !_imp->perfReportFilename.isEmpty() ) {
+        PerfReport::setEnabled(false);
+        std::string error;
+        if ( !PerfReport::writeJSON(_imp->perfReportFilename.toStdString(), &error) ) {
+            std::cerr << error << std::endl;
+        }
+    }
+    
     ///Kill caches now because decreaseNCacheFilesOpened can be called
     _imp->_nodeCache->waitForDeleterThread();
     _imp->_diskCache->waitForDeleterThread();
@@ -570,8 +590,22 @@ AppManager::initGui(const CLArgs& cl)
 bool
 AppManager::loadInternalAfterInitGui(const CLArgs& cl)
 {
+    if ( !cl.getTraceFilename().isEmpty() ) {
+        _imp->traceFilename = cl.getTraceFilename();
+        TraceRecorder::setEnabled(true);
+    }
+    
+    if ( !cl.getPerfReportFilename().isEmpty() ) {
+        _imp->perfReportFilename = cl.getPerfReportFilename();
+        PerfReport::setEnabled(true);
+    }
+    
+    if (cl.getRenderThreadsCount() > 0) {
+        setNumberOfThreads( cl.getRenderThreadsCount() );
+    }
+    
     try {
-        size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * getSystemTotalRAM();
+        size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * _imp->memoryGovernor->getTotalRAM() * _imp->memoryGovernor->getBudgetFactor();
         U64 maxViewerDiskCache = _imp->_settings->getMaximumViewerDiskCacheSize();
         U64 playbackSize = maxCacheRAM * _imp->_settings->getRamPlaybackMaximumPercent();
         U64 viewerCacheSize = maxViewerDiskCache + playbackSize;
@@ -625,6 +659,28 @@ AppManager::loadInternalAfterInitGui(const CLArgs& cl)
         _imp->initProcessInputChannel(cl.getIPCPipeName());
     }
     
+    if ( isBackground() && !cl.getFrameChannelName().isEmpty() ) {
+        _imp->initSharedFrameChannel( cl.getFrameChannelName() );
+    }
+    
+    if ( isBackground() && !cl.getDaemonServerName().isEmpty() ) {
+        ///The projects are loaded by the daemon in their own instance for each job, the main instance stays empty
+        _imp->_appType = eAppTypeBackground;
+        AppInstance* mainInstance = newBackgroundInstance(cl, true);
+        if (!mainInstance) {
+            return false;
+        }
+        onLoadCompleted();
+        
+        bool ret = runRenderDaemon(cl.getDaemonServerName());
+        try {
+            mainInstance->quit();
+        } catch (std::logic_error) {
+            // ignore
+        }
+        return ret;
+    }
+    
     
     if (cl.isInterpreterMode()) {
         _imp->_appType = eAppTypeInterpreter;
@@ -827,6 +883,7 @@ AppManager::clearAllCaches()
     
     clearDiskCache();
     clearNodeCache();
+    _imp->persistentActionsCache->clear();
 
  
     ///for each app instance clear all its nodes cache
@@ -896,6 +953,10 @@ bool
 AppManager::writeToOutputPipe(const QString & longMessage,
                               const QString & shortMessage)
 {
+    if (_imp->renderDaemon) {
+        _imp->renderDaemon->writeToClient(shortMessage);
+        return true;
+    }
     if (!_imp->_backgroundIPC) {
         
         QMutexLocker k(&_imp->errorLogMutex);
@@ -908,6 +969,16 @@ AppManager::writeToOutputPipe(const QString & longMessage,
     return true;
 }
 
+bool
+AppManager::runRenderDaemon(const QString& serverName)
+{
+    RenderDaemon daemon(serverName);
+    _imp->renderDaemon = &daemon;
+    bool ret = daemon.exec();
+    _imp->renderDaemon = 0;
+    return ret;
+}
+
 void
 AppManager::registerAppInstance(AppInstance* app)
 {
@@ -923,7 +994,7 @@ AppManager::registerAppInstance(AppInstance* app)
 void
 AppManager::setApplicationsCachesMaximumMemoryPercent(double p)
 {
-    size_t maxCacheRAM = p * getSystemTotalRAM_conditionnally();
+    size_t maxCacheRAM = p * _imp->memoryGovernor->getTotalRAM() * _imp->memoryGovernor->getBudgetFactor();
     U64 playbackSize = maxCacheRAM * _imp->_settings->getRamPlaybackMaximumPercent();
 
     _imp->_nodeCache->setMaximumCacheSize(maxCacheRAM - playbackSize);
@@ -935,7 +1006,7 @@ AppManager::setApplicationsCachesMaximumMemoryPercent(double p)
 void
 AppManager::setApplicationsCachesMaximumViewerDiskSpace(unsigned long long size)
 {
-    size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * getSystemTotalRAM_conditionnally();
+    size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * _imp->memoryGovernor->getTotalRAM() * _imp->memoryGovernor->getBudgetFactor();
     U64 playbackSize = maxCacheRAM * _imp->_settings->getRamPlaybackMaximumPercent();
 
     _imp->_viewerCache->setMaximumCacheSize(size);
@@ -951,7 +1022,7 @@ AppManager::setApplicationsCachesMaximumDiskSpace(unsigned long long size)
 void
 AppManager::setPlaybackCacheMaximumSize(double p)
 {
-    size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * getSystemTotalRAM_conditionnally();
+    size_t maxCacheRAM = _imp->_settings->getRamMaximumPercent() * _imp->memoryGovernor->getTotalRAM() * _imp->memoryGovernor->getBudgetFactor();
     U64 playbackSize = maxCacheRAM * p;
 
     _imp->_nodeCache->setMaximumCacheSize(maxCacheRAM - playbackSize);
@@ -1770,21 +1841,22 @@ AppManager::getMemoryStatsForCacheEntryHolder(const CacheEntryHolder* holder,
 }
 
 void
-AppManager::removeAllImagesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion)
+AppManager::removeAllImagesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion,
+                                                                   const std::vector<U64>& retainedTreeVersions)
 {
-    _imp->_nodeCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion);
+    _imp->_nodeCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion, retainedTreeVersions);
 }
 
 void
 AppManager::removeAllImagesFromDiskCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion)
 {
-    _imp->_diskCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion);
+    _imp->_diskCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion, std::vector<U64>());
 }
 
 void
 AppManager::removeAllTexturesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion)
 {
-    _imp->_viewerCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion);
+    _imp->_viewerCache->removeAllEntriesWithDifferentNodeHashForHolderPublic(holder, treeVersion, std::vector<U64>());
 }
 
 void
@@ -1873,6 +1945,16 @@ AppManager::isAggressiveCachingEnabled() const
     return _imp->_settings->isAggressiveCachingEnabled();
 }
 
+PersistentActionsCache*
+AppManager::getPersistentActionsCache() const
+{
+    if ( !_imp->_settings->isActionsCachePersistent() ) {
+        return 0;
+    }
+
+    return _imp->persistentActionsCache.get();
+}
+
 U64
 AppManager::getCachesTotalMemorySize() const
 {
@@ -2149,11 +2231,25 @@ AppManager::isNodeCacheAlmostFull() const
 void
 AppManager::checkCacheFreeMemoryIsGoodEnough()
 {
+    if ( _imp->memoryGovernor->refresh() ) {
+        ///The memory pressure changed: resize the caches and evict what no longer fits
+        setPlaybackCacheMaximumSize( _imp->_settings->getRamPlaybackMaximumPercent() );
+        _imp->_nodeCache->clearExceedingEntries();
+        _imp->_viewerCache->clearExceedingEntries();
+        _imp->pluginMemoryPool->trim();
+    }
+
     ///Before allocating the memory check that there's enough space to fit in memory
-    size_t systemRAMToKeepFree = getSystemTotalRAM() * appPTR->getCurrentSettings()->getUnreachableRamPercent();
-    size_t totalFreeRAM = getAmountFreePhysicalRAM();
+    size_t systemRAMToKeepFree = _imp->memoryGovernor->getTotalRAM() * appPTR->getCurrentSettings()->getUnreachableRamPercent();
+    size_t totalFreeRAM = _imp->memoryGovernor->getFreeRAM();
     
 
+    if ( (totalFreeRAM <= systemRAMToKeepFree) && (_imp->pluginMemoryPool->getIdleBytes() > 0) ) {
+        ///The blocks kept for the plug-ins are cheaper to give back than cached images, the pool accounts for them
+        _imp->pluginMemoryPool->trim(0);
+        totalFreeRAM = _imp->memoryGovernor->getFreeRAM();
+    }
+
     double playbackRAMPercent = appPTR->getCurrentSettings()->getRamPlaybackMaximumPercent();
     while (totalFreeRAM <= systemRAMToKeepFree) {
         
@@ -2181,12 +2277,162 @@ AppManager::checkCacheFreeMemoryIsGoodEnough()
                 break;
             }
         }
-        
-        totalFreeRAM = getAmountFreePhysicalRAM();
+
+        ///The cgroup usage is not read again here, account for what was evicted
+        size_t cachesSize = _imp->_nodeCache->getMemoryCacheSize() + _imp->_viewerCache->getMemoryCacheSize();
+        if (cachesSize < nodeCacheSize + viewerRamCacheSize) {
+            _imp->memoryGovernor->registerFreedMemory(nodeCacheSize + viewerRamCacheSize - cachesSize);
+        }
+        totalFreeRAM = _imp->memoryGovernor->getFreeRAM();
+    }
+
+}
+
+MemoryGovernor*
+AppManager::getMemoryGovernor() const
+{
+    return _imp->memoryGovernor.get();
+}
+
+PluginMemoryPool*
+AppManager::getPluginMemoryPool() const
+{
+    return _imp->pluginMemoryPool.get();
+}
+
+const CpuTopology*
+AppManager::getCpuTopology() const
+{
+    return _imp->cpuTopology.get();
+}
+
+void
+AppManager::getMemoryStats(MemoryStats* stats) const
+{
+    _imp->memoryGovernor->getStats(stats);
+    stats->pluginMemoryPoolSize = _imp->pluginMemoryPool->getIdleBytes();
+    stats->nodeCacheSize = _imp->_nodeCache->getMemoryCacheSize();
+    stats->nodeCacheBudget = _imp->_nodeCache->getMaximumMemorySize();
+    stats->viewerCacheSize = _imp->_viewerCache->getMemoryCacheSize();
+    stats->viewerCacheBudget = _imp->_viewerCache->getMaximumMemorySize();
+}
+
+SharedFrameChannel*
+AppManager::getSharedFrameChannel()
+{
+    if ( !isBackground() ) {
+        _imp->initSharedFrameChannel( QString() );
+    }
+    QMutexLocker k(&_imp->sharedFrameChannelMutex);
+
+    return _imp->sharedFrameChannel.get();
+}
+
+void
+AppManager::publishImageToSharedFrameChannel(const ImagePtr & image) const
+{
+    SharedFrameChannel* channel;
+    {
+        QMutexLocker k(&_imp->sharedFrameChannelMutex);
+        channel = _imp->sharedFrameChannel.get();
+    }
+    if ( !channel || !image || !image->getComponents().isColorPlane() ) {
+        return;
     }
 
+    RectI bounds = image->getBounds();
+    std::list<RectI> restToRender;
+    image->getRestToRender(bounds, restToRender);
+    if ( !restToRender.empty() ) {
+        return;
+    }
+
+    const ImageKey & key = image->getKey();
+    const RectD & rod = image->getRoD();
+    SharedFrameInfo info;
+    std::memset( &info, 0, sizeof(SharedFrameInfo) );
+    info.keyHash = key.getHash();
+    info.nodeHash = key.getTreeVersion();
+    info.time = key.getTime();
+    info.view = key._view;
+    info.mipMapLevel = image->getMipMapLevel();
+    info.rod[0] = rod.x1;
+    info.rod[1] = rod.y1;
+    info.rod[2] = rod.x2;
+    info.rod[3] = rod.y2;
+    info.bounds[0] = bounds.x1;
+    info.bounds[1] = bounds.y1;
+    info.bounds[2] = bounds.x2;
+    info.bounds[3] = bounds.y2;
+    info.pixelAspect = image->getPixelAspectRatio();
+    info.isRodProjectFormat = image->getParams()->isRodProjectFormat();
+    info.nComps = image->getComponentsCount();
+    info.bitDepth = (int)image->getBitDepth();
+    info.premult = (int)image->getPremultiplication();
+    info.fielding = (int)image->getFieldingOrder();
+    info.dataSize = (std::size_t)bounds.area() * info.nComps * getSizeOfForBitDepth( image->getBitDepth() );
+
+    Image::ReadAccess acc = image->getReadRights();
+    channel->publish( info, acc.pixelAt(bounds.x1, bounds.y1) );
 }
 
+bool
+AppManager::getImageFromSharedFrameChannel(const ImageKey & key,
+                                           unsigned int mipMapLevel,
+                                           const ImageComponents & components,
+                                           ImageBitDepthEnum bitdepth,
+                                           ImagePtr* image) const
+{
+    SharedFrameChannel* channel;
+    {
+        QMutexLocker k(&_imp->sharedFrameChannelMutex);
+        channel = _imp->sharedFrameChannel.get();
+    }
+    if ( !channel || !components.isColorPlane() ) {
+        return false;
+    }
+
+    SharedFramePtr frame = channel->acquire(key.getHash(), mipMapLevel);
+    if (!frame) {
+        return false;
+    }
+    const SharedFrameInfo & info = frame->getInfo();
+    RectI bounds(info.bounds[0], info.bounds[1], info.bounds[2], info.bounds[3]);
+    if ( (info.nodeHash != key.getTreeVersion()) || (info.view != key._view) ||
+         (info.nComps != components.getNumComponents()) || (info.bitDepth != (int)bitdepth) ||
+         ( info.dataSize != (std::size_t)bounds.area() * info.nComps * getSizeOfForBitDepth(bitdepth) ) ) {
+        return false;
+    }
+
+    RectD rod(info.rod[0], info.rod[1], info.rod[2], info.rod[3]);
+    boost::shared_ptr<ImageParams> params = Image::makeParams(0,
+                                                              rod,
+                                                              bounds,
+                                                              info.pixelAspect,
+                                                              mipMapLevel,
+                                                              info.isRodProjectFormat,
+                                                              components,
+                                                              bitdepth,
+                                                              (ImagePremultiplicationEnum)info.premult,
+                                                              (ImageFieldingOrderEnum)info.fielding);
+    ImagePtr img;
+    bool created = !getImageFromCacheOrCreate(key, params, &img);
+    if (!img) {
+        return false;
+    }
+    img->allocateMemory();
+    if (created) {
+        {
+            Image::WriteAccess acc = img->getWriteRights();
+            std::memcpy(acc.pixelAt(bounds.x1, bounds.y1), frame->getData(), info.dataSize);
+        }
+        img->markForRendered(bounds);
+    }
+    *image = img;
+
+    return true;
+} // AppManager::getImageFromSharedFrameChannel
+
 void
 AppManager::onOCIOConfigPathChanged(const std::string& path)
 {
@@ -29,6 +29,7 @@
 
 #include <list>
 #include <string>
+#include <vector>
 #include "Global/GlobalDefines.h"
 CLANG_DIAG_OFF(deprecated)
 // /usr/include/qt5/QtCore/qgenericatomic.h:177:13: warning: 'register' storage class specifier is deprecated [-Wdeprecated]
@@ -272,8 +273,10 @@ public:
     /**
      * @brief Given the following tree version, removes all images from the node cache with a matching
      * tree version. This is useful to wipe the cache for one particular node.
+     * The images with one of the retained tree versions are kept in the node cache.
      **/
-    void  removeAllImagesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion);
+    void  removeAllImagesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion,
+                                                                const std::vector<U64>& retainedTreeVersions);
     void  removeAllImagesFromDiskCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion);
     void  removeAllTexturesFromCacheWithMatchingIDAndDifferentKey(const CacheEntryHolder* holder, U64 treeVersion);
     
@@ -299,6 +302,13 @@ public:
      **/
     bool writeToOutputPipe(const QString & longMessage,const QString & shortMessage);
 
+    /**
+     * @brief Renders the jobs sent by clients to a local server with the given name until a client asks to quit,
+     * see RenderDaemon. While it runs, writeToOutputPipe() writes to the client of the job being rendered.
+     * Returns false if the server could not be created.
+     **/
+    bool runRenderDaemon(const QString& serverName);
+
     /**
      * @brief Abort any processing on all AppInstance. It is called in some very rare cases
      * such as when changing the number of threads used by the application or when a background render
@@ -372,9 +382,47 @@ public:
 
     /**
      * @brief Called by the caches to check that there's enough free memory on the computer to perform the allocation.
+     * The memory available is the one given by the MemoryGovernor: when the memory pressure changed, the caches are resized.
      * WARNING: This functin may remove some entries from the caches.
      **/
     void checkCacheFreeMemoryIsGoodEnough();
+
+    MemoryGovernor* getMemoryGovernor() const;
+
+    PluginMemoryPool* getPluginMemoryPool() const;
+
+    /**
+     * @brief The CPUs and NUMA nodes the process may run on
+     **/
+    const CpuTopology* getCpuTopology() const;
+
+    /**
+     * @brief Returns the memory budgets and the memory used by the caches and the plug-ins.
+     **/
+    void getMemoryStats(MemoryStats* stats) const;
+
+    /**
+     * @brief The channel through which this process and the render processes it launched exchange their frames,
+     * or NULL if there is none. The GUI process creates it the first time this is called, a background process
+     * returns the one given with --frameChannel.
+     **/
+    SharedFrameChannel* getSharedFrameChannel();
+
+    /**
+     * @brief Publishes a fully rendered image of the color plane to the shared frame channel, if any, so that the
+     * other processes can put it in their cache.
+     **/
+    void publishImageToSharedFrameChannel(const boost::shared_ptr<Image>& image) const;
+
+    /**
+     * @brief Copies the image with the given key published by another process to the node cache.
+     * Returns false if there is no such image with the given mipmap level, components and bit depth.
+     **/
+    bool getImageFromSharedFrameChannel(const ImageKey & key,
+                                        unsigned int mipMapLevel,
+                                        const ImageComponents & components,
+                                        ImageBitDepthEnum bitdepth,
+                                        boost::shared_ptr<Image>* image) const;
     
     void onCheckerboardSettingsChanged() { Q_EMIT  checkerboardSettingsChanged(); }
     
@@ -444,6 +492,11 @@ public:
     bool isNodeCacheAlmostFull() const;
     
     bool isAggressiveCachingEnabled() const;
+
+    /**
+     * @brief Returns the cache of the nodes RoD and frame range kept across sessions, or NULL if it is disabled in the settings.
+     **/
+    PersistentActionsCache* getPersistentActionsCache() const;
     
     void setDiskCacheLocation(const QString& path);
     const QString& getDiskCacheLocation() const;
@@ -82,14 +82,24 @@ AppManagerPrivate::AppManagerPrivate()
 , _settings()
 , _formats()
 , _plugins()
+, cpuTopology( new CpuTopology() )
 , ofxHost( new OfxHost() )
 , _knobFactory( new KnobFactory() )
 , _nodeCache()
 , _diskCache()
 , _viewerCache()
+, persistentActionsCache( new PersistentActionsCache() )
+, memoryGovernor( new MemoryGovernor() )
+, pluginMemoryPool( new PluginMemoryPool( memoryGovernor.get(), 0, cpuTopology->getNumaNodesCount() ) )
 , diskCachesLocationMutex()
 , diskCachesLocation()
 ,_backgroundIPC(0)
+,sharedFrameChannelMutex()
+,sharedFrameChannel()
+,sharedFrameChannelInitialized(false)
+,renderDaemon(0)
+,traceFilename()
+,perfReportFilename()
 ,_loaded(false)
 ,_binaryPath()
 ,_nodesGlobalMemoryUse(0)
@@ -200,6 +210,32 @@ AppManagerPrivate::initProcessInputChannel(const QString & mainProcessServerName
     _backgroundIPC = new ProcessInputChannel(mainProcessServerName);
 }
 
+void
+AppManagerPrivate::initSharedFrameChannel(const QString & name)
+{
+    QMutexLocker k(&sharedFrameChannelMutex);
+
+    if (sharedFrameChannelInitialized) {
+        return;
+    }
+    sharedFrameChannelInitialized = true;
+
+    boost::scoped_ptr<SharedFrameChannel> channel( new SharedFrameChannel() );
+    bool ok;
+    if ( name.isEmpty() ) {
+        ///The frames published by the render processes go to the node cache: only let them use a part of it
+        ok = channel->create( _nodeCache->getMaximumMemorySize() * NATRON_SHARED_FRAME_CHANNEL_CACHE_FRACTION );
+    } else {
+        ok = channel->attach( name.toStdString() );
+    }
+    if (!ok) {
+        qDebug() << "Could not open the shared frame channel, the frames will not be exchanged with the render processes";
+
+        return;
+    }
+    sharedFrameChannel.swap(channel);
+}
+
 
 
 void
@@ -300,6 +336,9 @@ AppManagerPrivate::saveCaches()
 {
     saveCache<FrameEntry>(_viewerCache.get());
     saveCache<Image>(_diskCache.get());
+    if (!appPTR->isBackground()) {
+        persistentActionsCache->save( getPersistentActionsCacheFilePath() );
+    }
 } // saveCaches
 
 template <typename T>
@@ -346,9 +385,24 @@ AppManagerPrivate::restoreCaches()
     if (!appPTR->isBackground()) {
         restoreCache<FrameEntry>(this, _viewerCache.get());
         restoreCache<Image>(this, _diskCache.get());
+        persistentActionsCache->restore( getPersistentActionsCacheFilePath() );
     }
 } // restoreCaches
 
+std::string
+AppManagerPrivate::getPersistentActionsCacheFilePath() const
+{
+    QString filePath;
+    {
+        QMutexLocker k(&diskCachesLocationMutex);
+        filePath = diskCachesLocation;
+    }
+    Global::ensureLastPathSeparator(filePath);
+    filePath.append( QString::fromUtf8("ActionsCache." NATRON_CACHE_FILE_EXT) );
+
+    return filePath.toStdString();
+}
+
 bool
 AppManagerPrivate::checkForCacheDiskStructure(const QString & cachePath)
 {
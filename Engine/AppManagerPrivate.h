@@ -48,6 +48,11 @@
 #include "Engine/Cache.h"
 #include "Engine/FrameEntry.h"
 #include "Engine/Image.h"
+#include "Engine/CpuTopology.h"
+#include "Engine/MemoryGovernor.h"
+#include "Engine/PluginMemoryPool.h"
+#include "Engine/PersistentActionsCache.h"
+#include "Engine/SharedFrameChannel.h"
 #include "Engine/EngineFwd.h"
 #include "Engine/TLSHolder.h"
 
@@ -67,17 +72,27 @@ struct AppManagerPrivate
     boost::shared_ptr<Settings> _settings; //< app settings
     std::vector<Format*> _formats; //<a list of the "base" formats available in the application
     PluginsMap _plugins; //< list of the plugins
+    boost::scoped_ptr<CpuTopology> cpuTopology; //< the CPUs the process may run on, must be declared before ofxHost which threads use it
     boost::scoped_ptr<OfxHost> ofxHost; //< OpenFX host
     boost::scoped_ptr<KnobFactory> _knobFactory; //< knob maker
     boost::shared_ptr<Cache<Image> >  _nodeCache; //< Images cache
     boost::shared_ptr<Cache<Image> >  _diskCache; //< Images disk cache (used by DiskCache nodes)
     boost::shared_ptr<Cache<FrameEntry> > _viewerCache; //< Viewer textures cache
+    boost::scoped_ptr<PersistentActionsCache> persistentActionsCache; //< RoD and frame range of the nodes, kept across sessions
+    boost::scoped_ptr<MemoryGovernor> memoryGovernor; //< memory available according to the cgroup limits and memory pressure
+    boost::scoped_ptr<PluginMemoryPool> pluginMemoryPool; //< recycles the memory allocated by the plug-ins, must be declared after memoryGovernor
     
     mutable QMutex diskCachesLocationMutex;
     QString diskCachesLocation;
     
     ProcessInputChannel* _backgroundIPC; //< object used to communicate with the main app
+    mutable QMutex sharedFrameChannelMutex; //< protects sharedFrameChannel and sharedFrameChannelInitialized
+    boost::scoped_ptr<SharedFrameChannel> sharedFrameChannel; //< frames exchanged with the render processes, see ProcessHandler
+    bool sharedFrameChannelInitialized; //< true once the channel was created or attached, even if that failed
     //if this app is background, see the ProcessInputChannel def
+    RenderDaemon* renderDaemon; //< non-null while runRenderDaemon() runs
+    QString traceFilename; //< the file given with --trace, where the trace is written on exit
+    QString perfReportFilename; //< the file given with --perf-report, where the report is written on exit
     bool _loaded; //< true when the first instance is completly loaded.
     QString _binaryPath; //< the path to the application's binary
     U64 _nodesGlobalMemoryUse; //< how much memory all the nodes are using (besides the cache)
@@ -144,12 +159,19 @@ struct AppManagerPrivate
 
     void initProcessInputChannel(const QString & mainProcessServerName);
 
+    /**
+     * @brief Attaches to the shared frame channel with the given name or creates a new one if the name is empty.
+     **/
+    void initSharedFrameChannel(const QString & name);
+
     void loadBuiltinFormats();
 
     void saveCaches();
 
     void restoreCaches();
 
+    std::string getPersistentActionsCacheFilePath() const;
+
     bool checkForCacheDiskStructure(const QString & cachePath);
 
     void cleanUpCacheDiskStructure(const QString & cachePath);
@@ -58,6 +58,8 @@ struct CLArgsPrivate
     
     QString ipcPipe;
     
+    QString frameChannel;
+    
     int error;
     
     bool isInterpreterMode;
@@ -67,6 +69,12 @@ struct CLArgsPrivate
     
     bool enableRenderStats;
     
+    QString traceFilename;
+    
+    QString perfReportFilename;
+    
+    int renderThreadsCount;
+    
     bool isEmpty;
     
     mutable QString imageFilename;
@@ -80,6 +88,14 @@ struct CLArgsPrivate
     
     qint64 breakpadProcessPID;
     
+    int renderWorkersCount;
+    
+    int renderChunkSize;
+    
+    QStringList renderWorkerArgs;
+    
+    QString daemonServerName;
+    
     CLArgsPrivate()
     : args()
     , filename()
@@ -90,11 +106,15 @@ struct CLArgsPrivate
     , pythonCommands()
     , isBackground(false)
     , ipcPipe()
+    , frameChannel()
     , error(0)
     , isInterpreterMode(false)
     , frameRanges()
     , rangeSet(false)
     , enableRenderStats(false)
+    , traceFilename()
+    , perfReportFilename()
+    , renderThreadsCount(0)
     , isEmpty(true)
     , imageFilename()
     , breakpadPipeFilePath()
@@ -102,6 +122,10 @@ struct CLArgsPrivate
     , breakpadPipeClientID(-1)
     , breakpadProcessFilePath()
     , breakpadProcessPID(-1)
+    , renderWorkersCount(0)
+    , renderChunkSize(0)
+    , renderWorkerArgs()
+    , daemonServerName()
     {
         
     }
@@ -115,6 +139,10 @@ struct CLArgsPrivate
     
     QStringList::iterator findFileNameWithExtension(const QString& extension);
     
+    bool parsePositiveIntOption(const QString& longName, int* value);
+    
+    void makeRenderWorkerArgs();
+    
 };
 
 CLArgs::CLArgs()
@@ -187,13 +215,21 @@ CLArgs::operator=(const CLArgs& other)
     _imp->pythonCommands = other._imp->pythonCommands;
     _imp->isBackground = other._imp->isBackground;
     _imp->ipcPipe = other._imp->ipcPipe;
+    _imp->frameChannel = other._imp->frameChannel;
     _imp->error = other._imp->error;
     _imp->isInterpreterMode = other._imp->isInterpreterMode;
     _imp->frameRanges = other._imp->frameRanges;
     _imp->rangeSet = other._imp->rangeSet;
     _imp->enableRenderStats = other._imp->enableRenderStats;
+    _imp->traceFilename = other._imp->traceFilename;
+    _imp->perfReportFilename = other._imp->perfReportFilename;
+    _imp->renderThreadsCount = other._imp->renderThreadsCount;
     _imp->isEmpty = other._imp->isEmpty;
     _imp->imageFilename = other._imp->imageFilename;
+    _imp->renderWorkersCount = other._imp->renderWorkersCount;
+    _imp->renderChunkSize = other._imp->renderChunkSize;
+    _imp->renderWorkerArgs = other._imp->renderWorkerArgs;
+    _imp->daemonServerName = other._imp->daemonServerName;
 }
 
 bool
@@ -263,6 +299,8 @@ CLArgs::printUsage(const std::string& programName)
                               "      1-10:1,20-30:2,40-50\n"
                               "      Individual frames can also be specified:\n"
                               "      1329,2450,123,1-10:2\n"
+                              "      Frames may be negative:\n"
+                              "      -10--1,-20\n"
                               "    Note that several -w options can be set to specify multiple Write nodes\n"
                               "    to render.\n"
                               "    Note that if specified, the frame range is the same for all Write nodes\n"
@@ -285,7 +323,42 @@ CLArgs::printUsage(const std::string& programName)
                               "     breakdown contains informations about each nodes, render times etc...\n"
                               "     This option is useful for debugging purposes or to control that a render\n"
                               "     is working correctly.\n"
-                              "     **Please note** that it does not work when writing video files."
+                              "     **Please note** that it does not work when writing video files.\n"
+                              "  --trace <filename> :\n"
+                              "    Record the time spent by each thread in the render, plug-in actions,\n"
+                              "    cache lookups and waits, and write it to the given file when %1\n"
+                              "    exits, in the Chrome trace format. The file can be opened with\n"
+                              "    chrome://tracing or https://ui.perfetto.dev\n"
+                              "    This also works with the graphical user interface.\n"
+                              "  --perf-report <filename> :\n"
+                              "    Write to the given file, when %1 exits, the time spent by each node\n"
+                              "    summed over all the frames rendered, the wall-clock time of the renders\n"
+                              "    and the peak memory used by the process, in JSON. This is meant to compare\n"
+                              "    the performance of renders across versions. Not forwarded to --workers.\n"
+                              "  --threads <number of threads> :\n"
+                              "    Render with the given number of threads instead of the number of render\n"
+                              "    threads set in the preferences. The preferences are not modified.\n"
+                              "  --workers <number of processes> :\n"
+                              "    Only with %1Renderer. Split the frame range in chunks and render them\n"
+                              "    with the given number of %1Renderer processes running in parallel,\n"
+                              "    instead of rendering everything in this process. This is useful with\n"
+                              "    plug-ins that are not thread-safe. Chunks of a failing or crashing\n"
+                              "    process are rendered again (at most twice per frame) and the remaining\n"
+                              "    frames of slow processes are given to idle ones.\n"
+                              "    A frame range and at least one -w or -o option are required. If no\n"
+                              "    frame-step is given, a frame-step of 1 is used.\n"
+                              "    The exit code is 0 only if all frames were rendered. The summary printed\n"
+                              "    at the end gives the render time per frame of all the processes.\n"
+                              "  --chunk-size <number of frames> :\n"
+                              "    The number of frames given to a process at once with --workers.\n"
+                              "    By default, each process gets about 4 chunks.\n"
+                              "  --daemon <server name> :\n"
+                              "    Only with %1Renderer. Load the plug-ins once and wait for render jobs\n"
+                              "    on a local server with the given name, instead of rendering a project\n"
+                              "    given on the command-line. Each job is a line made of \"-j\" followed\n"
+                              "    by the options of a render (project, -w, -o, -i, frame range...), each\n"
+                              "    preceded by a tabulation. Projects are kept loaded between jobs and are\n"
+                              "    reloaded when their file changes. The line \"-q\" stops the daemon.\n"
                               "Sample uses:\n"
                               "  %1 /Users/Me/MyNatronProjects/MyProject.ntp\n"
                               "  %1 -b -w MyWriter /Users/Me/MyNatronProjects/MyProject.ntp\n"
@@ -293,6 +366,7 @@ CLArgs::printUsage(const std::string& programName)
                               "  %1Renderer -w MyWriter /FastDisk/Pictures/sequence'###'.exr 1-100 /Users/Me/MyNatronProjects/MyProject.ntp\n"
                               "  %1Renderer -w MyWriter -w MySecondWriter 1-10 /Users/Me/MyNatronProjects/MyProject.ntp\n"
                               "  %1Renderer -w MyWriter 1-10 -l /Users/Me/Scripts/onProjectLoaded.py /Users/Me/MyNatronProjects/MyProject.ntp\n"
+                              "  %1Renderer --workers 8 -w MyWriter 1-1000 /Users/Me/MyNatronProjects/MyProject.ntp\n"
                               "\n"
                               /* Text must hold in 80 columns ************************************************/
                               "Options for the execution of Python scripts:\n"
@@ -443,12 +517,36 @@ CLArgs::getIPCPipeName() const
     return _imp->ipcPipe;
 }
 
+const QString&
+CLArgs::getFrameChannelName() const
+{
+    return _imp->frameChannel;
+}
+
 bool
 CLArgs::areRenderStatsEnabled() const
 {
     return _imp->enableRenderStats;
 }
 
+const QString&
+CLArgs::getTraceFilename() const
+{
+    return _imp->traceFilename;
+}
+
+const QString&
+CLArgs::getPerfReportFilename() const
+{
+    return _imp->perfReportFilename;
+}
+
+int
+CLArgs::getRenderThreadsCount() const
+{
+    return _imp->renderThreadsCount;
+}
+
 bool
 CLArgs::isPythonScript() const
 {
@@ -485,6 +583,87 @@ CLArgs::getBreakpadComPipeFilePath() const
     return _imp->breakpadComPipeFilePath;
 }
 
+int
+CLArgs::getRenderWorkersCount() const
+{
+    return _imp->renderWorkersCount;
+}
+
+int
+CLArgs::getRenderChunkSize() const
+{
+    return _imp->renderChunkSize;
+}
+
+const QStringList&
+CLArgs::getRenderWorkerArgs() const
+{
+    return _imp->renderWorkerArgs;
+}
+
+const QString&
+CLArgs::getDaemonServerName() const
+{
+    return _imp->daemonServerName;
+}
+
+bool
+CLArgsPrivate::parsePositiveIntOption(const QString& longName, int* value)
+{
+    QStringList::iterator it = hasToken(longName, QString());
+    if (it == args.end()) {
+        return true;
+    }
+    QStringList::iterator next = it;
+    ++next;
+    bool ok = false;
+    if (next != args.end()) {
+        *value = next->toInt(&ok);
+    }
+    if (!ok || *value < 1) {
+        std::cout << QObject::tr("--%1 must be followed by a strictly positive number").arg(longName).toStdString() << std::endl;
+        error = 1;
+        return false;
+    }
+    ++next;
+    args.erase(it, next);
+    return true;
+}
+
+void
+CLArgsPrivate::makeRenderWorkerArgs()
+{
+    //Rebuild the command line from what was parsed: the frame range of each worker is appended by the caller
+    renderWorkerArgs.clear();
+    if (enableRenderStats) {
+        renderWorkerArgs << QString::fromUtf8("--render-stats");
+    }
+    if (renderThreadsCount > 0) {
+        renderWorkerArgs << QString::fromUtf8("--threads") << QString::number(renderThreadsCount);
+    }
+    if (!defaultOnProjectLoadedScript.isEmpty()) {
+        renderWorkerArgs << QString::fromUtf8("--onload") << defaultOnProjectLoadedScript;
+    }
+    for (std::list<std::string>::const_iterator it = pythonCommands.begin(); it != pythonCommands.end(); ++it) {
+        renderWorkerArgs << QString::fromUtf8("--cmd") << QString::fromUtf8(it->c_str());
+    }
+    for (std::list<CLArgs::ReaderArg>::const_iterator it = readers.begin(); it != readers.end(); ++it) {
+        renderWorkerArgs << QString::fromUtf8("--reader") << it->name << it->filename;
+    }
+    for (std::list<CLArgs::WriterArg>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        if (it->mustCreate) {
+            //The name is Output<index>, see the parsing of the -o option
+            renderWorkerArgs << QString::fromUtf8("--output") + it->name.mid(6) << it->filename;
+        } else {
+            renderWorkerArgs << QString::fromUtf8("--writer") << it->name;
+            if (!it->filename.isEmpty()) {
+                renderWorkerArgs << it->filename;
+            }
+        }
+    }
+    renderWorkerArgs << filename;
+}
+
 QStringList::iterator
 CLArgsPrivate::findFileNameWithExtension(const QString& extension)
 {
@@ -582,10 +761,22 @@ static bool tryParseFrameRange(const QString& arg,std::pair<int,int>& range, int
         frameStep = INT_MIN;
         return true;
     }
-    QStringList strRange = arg.split(QChar::fromLatin1('-'));
-    if (strRange.size() != 2) {
+    ///The separator is the first '-' after the first frame, which may be negative as well as the last frame
+    int foundSeparator = -1;
+    for (int i = 1; i < arg.size(); ++i) {
+        if (arg[i] == QChar::fromLatin1('-')) {
+            QString firstFrameStr = arg.left(i).trimmed();
+            if ( !firstFrameStr.isEmpty() && (firstFrameStr != QString::fromUtf8("-")) ) {
+                foundSeparator = i;
+                break;
+            }
+        }
+    }
+    if (foundSeparator == -1) {
         return false;
     }
+    QStringList strRange;
+    strRange << arg.left(foundSeparator) << arg.mid(foundSeparator + 1);
     for (int i = 0; i < strRange.size(); ++i) {
         //whitespace removed from the start and the end.
         strRange[i] = strRange[i].trimmed();
@@ -685,6 +876,56 @@ CLArgsPrivate::parse()
         }
     }
     
+    //Must be parsed before the -o option and the frame range, which could be mistaken with the file name
+    {
+        QStringList::iterator it = hasToken(QString::fromUtf8("trace"), QString());
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end()) {
+                std::cout << QObject::tr("--trace must be followed by the name of the file to write").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            traceFilename = *next;
+#ifdef __NATRON_UNIX__
+            traceFilename = AppManager::qt_tildeExpansion(traceFilename);
+#endif
+            ++next;
+            args.erase(it, next);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken(QString::fromUtf8("perf-report"), QString());
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end()) {
+                std::cout << QObject::tr("--perf-report must be followed by the name of the file to write").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            perfReportFilename = *next;
+#ifdef __NATRON_UNIX__
+            perfReportFilename = AppManager::qt_tildeExpansion(perfReportFilename);
+#endif
+            ++next;
+            args.erase(it, next);
+        }
+    }
+    
+    //Must be parsed before the frame range, which would otherwise be mistaken with their value
+    if (!parsePositiveIntOption(QString::fromUtf8("workers"), &renderWorkersCount)) {
+        return;
+    }
+    if (!parsePositiveIntOption(QString::fromUtf8("threads"), &renderThreadsCount)) {
+        return;
+    }
+    if (!parsePositiveIntOption(QString::fromUtf8("chunk-size"), &renderChunkSize)) {
+        return;
+    }
+    
     {
         QStringList::iterator it = hasToken(QString::fromUtf8(NATRON_BREAKPAD_PROCESS_PID), QString());
         if (it != args.end()) {
@@ -776,6 +1017,38 @@ CLArgsPrivate::parse()
         }
     }
     
+    {
+        QStringList::iterator it = hasToken(QString::fromUtf8("frameChannel"), QString());
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end()) {
+                std::cout << QObject::tr("You must specify the shared frame channel name").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            frameChannel = *next;
+            ++next;
+            args.erase(it, next);
+        }
+    }
+    
+    {
+        QStringList::iterator it = hasToken(QString::fromUtf8("daemon"), QString());
+        if (it != args.end()) {
+            QStringList::iterator next = it;
+            ++next;
+            if (next == args.end() || !isBackground || isInterpreterMode) {
+                std::cout << QObject::tr("--daemon must be followed by a server name and can only be used in background mode").toStdString() << std::endl;
+                error = 1;
+                return;
+            }
+            daemonServerName = *next;
+            ++next;
+            args.erase(it, next);
+        }
+    }
+    
     {
         QStringList::iterator it = hasToken(QString::fromUtf8("onload"), QString::fromUtf8("l"));
         if (it != args.end()) {
@@ -812,7 +1085,7 @@ CLArgsPrivate::parse()
         QStringList::iterator it = findFileNameWithExtension(QString::fromUtf8(NATRON_PROJECT_FILE_EXT));
         if (it == args.end()) {
             it = findFileNameWithExtension(QString::fromUtf8("py"));
-            if (it == args.end() && !isInterpreterMode && isBackground) {
+            if (it == args.end() && !isInterpreterMode && isBackground && daemonServerName.isEmpty()) {
                 std::cout << QObject::tr("You must specify the filename of a script or %1 project. (.%2)").arg(QString::fromUtf8(NATRON_APPLICATION_NAME)).arg(QString::fromUtf8(NATRON_PROJECT_FILE_EXT)).toStdString() << std::endl;
                 error = 1;
                 return;
@@ -1050,6 +1323,15 @@ CLArgsPrivate::parse()
         error = 1;
         return;
     }
+    
+    if (renderWorkersCount > 0) {
+        if (!isBackground || isInterpreterMode || filename.isEmpty() || writers.empty() || !rangeSet) {
+            std::cout << QObject::tr("The --workers option requires a project or script, a frame range and at least one -w or -o option").toStdString() << std::endl;
+            error = 1;
+            return;
+        }
+        makeRenderWorkerArgs();
+    }
 }
 
 NATRON_NAMESPACE_EXIT;
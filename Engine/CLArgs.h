@@ -116,10 +116,34 @@ public:
     
     const QString& getIPCPipeName() const;
     
+    /**
+     * @brief Returns the name of the shared frame channel given by the process which launched this one with
+     * --frameChannel, or an empty string. See SharedFrameChannel.
+     **/
+    const QString& getFrameChannelName() const;
+    
     bool isPythonScript() const;
     
     bool areRenderStatsEnabled() const;
     
+    /**
+     * @brief Returns the file given with the --trace option, where the trace of the renders should be
+     * written on exit, or an empty string if tracing was not requested.
+     **/
+    const QString& getTraceFilename() const;
+    
+    /**
+     * @brief Returns the file given with the --perf-report option, where the render statistics of all the frames
+     * rendered should be written on exit, or an empty string if no report was requested.
+     **/
+    const QString& getPerfReportFilename() const;
+    
+    /**
+     * @brief Returns the number of render threads given with the --threads option, or 0 if the number of threads
+     * of the preferences should be used.
+     **/
+    int getRenderThreadsCount() const;
+    
     const QString& getBreakpadProcessExecutableFilePath() const;
     
     qint64 getBreakpadProcessPID() const;
@@ -130,6 +154,30 @@ public:
     
     const QString& getBreakpadComPipeFilePath() const;
     
+    /**
+     * @brief Returns the number of worker processes given with the --workers option, or 0 if rendering
+     * should happen in this process.
+     **/
+    int getRenderWorkersCount() const;
+    
+    /**
+     * @brief Returns the number of frames per chunk given with the --chunk-size option, or 0 if
+     * the chunk size should be computed from the frame range and the number of workers.
+     **/
+    int getRenderChunkSize() const;
+    
+    /**
+     * @brief Returns the arguments to pass to each worker process when --workers is set: the script, writers,
+     * readers and options, but neither the frame range nor -b, --workers, --chunk-size, --IPCpipe and --frameChannel.
+     **/
+    const QStringList& getRenderWorkerArgs() const;
+    
+    /**
+     * @brief Returns the name of the local server given with the --daemon option, or an empty string if
+     * this process is not a render daemon.
+     **/
+    const QString& getDaemonServerName() const;
+    
 private:
     
     boost::scoped_ptr<CLArgsPrivate> _imp;
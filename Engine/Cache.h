@@ -34,7 +34,7 @@
 #include <list>
 #include <cstddef>
 #include <utility>
-#include <algorithm> // min, max
+#include <algorithm> // min, max, find
 
 #include "Global/GlobalDefines.h"
 #include "Global/MemoryInfo.h"
@@ -55,6 +55,7 @@ GCC_DIAG_ON(deprecated)
 #include "Engine/Settings.h"
 #include "Engine/CacheEntry.h"
 #include "Engine/LRUHashTable.h"
+#include "Engine/MemoryGovernor.h"
 #include "Engine/StandardPaths.h"
 #include "Engine/ImageLocker.h"
 #include "Global/MemoryInfo.h"
@@ -201,6 +202,7 @@ class CacheCleanerThread
     {
         std::string holderID;
         U64 nodeHash;
+        std::vector<U64> retainedNodeHashes;
         bool removeAll;
     };
 
@@ -232,6 +234,7 @@ public:
 
     void appendToQueue(const std::string & holderID,
                        U64 nodeHash,
+                       const std::vector<U64> & retainedNodeHashes,
                        bool removeAll)
     {
         {
@@ -239,6 +242,7 @@ public:
             CleanRequest r;
             r.holderID = holderID;
             r.nodeHash = nodeHash;
+            r.retainedNodeHashes = retainedNodeHashes;
             r.removeAll = removeAll;
             _requestsQueues.push_back(r);
         }
@@ -309,7 +313,7 @@ private:
                     front = _requestsQueues.front();
                     _requestsQueues.pop_front();
                 }
-                cache->removeAllEntriesWithDifferentNodeHashForHolderPrivate(front.holderID, front.nodeHash, front.removeAll);
+                cache->removeAllEntriesWithDifferentNodeHashForHolderPrivate(front.holderID, front.nodeHash, front.retainedNodeHashes, front.removeAll);
             }
         }
     }
@@ -1017,6 +1021,9 @@ public:
         _memoryCacheSize += size;
         _signalEmitter->emitAddedEntry(time);
 
+        ///Until the cgroup usage is read again, AppManager::checkCacheFreeMemoryIsGoodEnough() accounts for the evictions
+        appPTR->getMemoryGovernor()->registerAllocatedMemory(size);
+
         if (storage == eStorageModeDisk) {
             appPTR->increaseNCacheFilesOpened();
         }
@@ -1085,6 +1092,7 @@ public:
         } else if (oldStorage == eStorageModeDisk) {
             _memoryCacheSize += size;
             _diskCacheSize = size > _diskCacheSize ? 0 : _diskCacheSize - size;
+            appPTR->getMemoryGovernor()->registerAllocatedMemory(size);
 #ifdef NATRON_DEBUG_CACHE
             qDebug() << cacheName().c_str() << " memory size: " << printAsRAM(_memoryCacheSize);
             qDebug() << cacheName().c_str() << " disk size: " << printAsRAM(_diskCacheSize);
@@ -1094,6 +1102,7 @@ public:
         } else {
             if (newStorage == eStorageModeRAM) {
                 _memoryCacheSize += size;
+                appPTR->getMemoryGovernor()->registerAllocatedMemory(size);
             } else if (newStorage == eStorageModeDisk) {
                 _diskCacheSize += size;
             }
@@ -1277,18 +1286,23 @@ public:
     /*Restores the cache from disk.*/
     void restore(const CacheTOC & tableOfContents);
 
+    /**
+     * @brief Removes in a separate thread all the entries of the holder with a node hash other than nodeHash and
+     * not in retainedNodeHashes.
+     **/
     void removeAllEntriesWithDifferentNodeHashForHolderPublic(const CacheEntryHolder* holder,
-                                                              U64 nodeHash)
+                                                              U64 nodeHash,
+                                                              const std::vector<U64> & retainedNodeHashes)
     {
-        _cleanerThread.appendToQueue(holder->getCacheID(), nodeHash, false);
+        _cleanerThread.appendToQueue(holder->getCacheID(), nodeHash, retainedNodeHashes, false);
     }
 
     void removeAllEntriesForHolderPublic(const CacheEntryHolder* holder, bool blocking)
     {
         if (blocking) {
-            removeAllEntriesWithDifferentNodeHashForHolderPrivate(holder->getCacheID(), 0, true);
+            removeAllEntriesWithDifferentNodeHashForHolderPrivate(holder->getCacheID(), 0, std::vector<U64>(), true);
         } else {
-            _cleanerThread.appendToQueue(holder->getCacheID(), 0, true);
+            _cleanerThread.appendToQueue(holder->getCacheID(), 0, std::vector<U64>(), true);
         }
     }
     
@@ -1336,6 +1350,7 @@ private:
 
     virtual void removeAllEntriesWithDifferentNodeHashForHolderPrivate(const std::string & holderID,
                                                                        U64 nodeHash,
+                                                                       const std::vector<U64> & retainedNodeHashes,
                                                                        bool removeAll) OVERRIDE FINAL
     {
         std::list<EntryTypePtr> toDelete;
@@ -1349,7 +1364,7 @@ private:
                     const EntryTypePtr & front = entries.front();
 
                     if ( (front->getKey().getCacheHolderID() == holderID) &&
-                         ( ( front->getKey().getTreeVersion() != nodeHash) || removeAll ) ) {
+                         ( removeAll || !isNodeHashRetained(front->getKey().getTreeVersion(), nodeHash, retainedNodeHashes) ) ) {
                         for (typename std::list<EntryTypePtr>::iterator it = entries.begin(); it != entries.end(); ++it) {
                             toDelete.push_back(*it);
                         }
@@ -1366,7 +1381,7 @@ private:
                     const EntryTypePtr & front = entries.front();
 
                     if ( (front->getKey().getCacheHolderID() == holderID) &&
-                         ( ( front->getKey().getTreeVersion() != nodeHash) || removeAll ) ) {
+                         ( removeAll || !isNodeHashRetained(front->getKey().getTreeVersion(), nodeHash, retainedNodeHashes) ) ) {
                         for (typename std::list<EntryTypePtr>::iterator it = entries.begin(); it != entries.end(); ++it) {
                             toDelete.push_back(*it);
                         }
@@ -1390,6 +1405,14 @@ private:
         }
     } // removeAllEntriesWithDifferentNodeHashForHolderPrivate
 
+    static bool isNodeHashRetained(U64 entryNodeHash,
+                                   U64 nodeHash,
+                                   const std::vector<U64> & retainedNodeHashes)
+    {
+        return entryNodeHash == nodeHash ||
+               std::find(retainedNodeHashes.begin(), retainedNodeHashes.end(), entryNodeHash) != retainedNodeHashes.end();
+    }
+
     bool getInternal(const typename EntryType::key_type & key,
                      std::list<EntryTypePtr>* returnValue) const
     {
@@ -404,9 +404,11 @@ public:
     
     /**
      * @brief Remove from the cache all entries that matches the holderID and have a different nodeHash than the given one.
+     * @param retainedNodeHashes Entries with one of these node hashes are not removed either
      * @param removeAll If true, remove even entries that match the nodeHash
      **/
-    virtual void removeAllEntriesWithDifferentNodeHashForHolderPrivate(const std::string& holderID, U64 nodeHash, bool removeAll) = 0;
+    virtual void removeAllEntriesWithDifferentNodeHashForHolderPrivate(const std::string& holderID, U64 nodeHash,
+                                                                       const std::vector<U64>& retainedNodeHashes, bool removeAll) = 0;
     
     
 #ifdef DEBUG
@@ -0,0 +1,356 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "CpuTopology.h"
+
+#include <algorithm> // sort, min_element
+#include <map>
+#include <sstream>
+
+#ifdef __NATRON_LINUX__
+#include <sched.h>
+#include <pthread.h>
+#endif
+
+#include <QtCore/QThread>
+#include <QtCore/QThreadStorage>
+
+#include "Engine/FStreamsSupport.h"
+
+///The cache/indexN directories of a CPU are looked up to this index
+#define NATRON_CPU_TOPOLOGY_MAX_CACHE_INDEX 8
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+QThreadStorage<int> currentThreadNumaNode;
+
+bool
+readLine(const std::string& filename,
+         std::string* line)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, filename);
+    if (!ifile) {
+        return false;
+    }
+    std::getline(ifile, *line);
+
+    return !line->empty();
+}
+
+bool
+readInt(const std::string& filename,
+        int* value)
+{
+    std::string line;
+
+    if ( !readLine(filename, &line) ) {
+        return false;
+    }
+    std::istringstream ss(line);
+
+    return (bool)(ss >> *value);
+}
+
+std::string
+toString(int i)
+{
+    std::ostringstream ss;
+
+    ss << i;
+
+    return ss.str();
+}
+
+bool
+compareCpus(const CpuInfo& a,
+            const CpuInfo& b)
+{
+    if (a.numaNode != b.numaNode) {
+        return a.numaNode < b.numaNode;
+    }
+    if (a.smtIndex != b.smtIndex) {
+        return a.smtIndex < b.smtIndex;
+    }
+    if (a.package != b.package) {
+        return a.package < b.package;
+    }
+    if (a.cacheGroup != b.cacheGroup) {
+        return a.cacheGroup < b.cacheGroup;
+    }
+    if (a.core != b.core) {
+        return a.core < b.core;
+    }
+
+    return a.cpu < b.cpu;
+}
+} // anon namespace
+
+CpuTopology::CpuTopology(const std::string& sysfsRoot,
+                         bool useAffinityMask)
+    : _cpus()
+    , _numaNodesCount(1)
+{
+    readSysfs(sysfsRoot, useAffinityMask);
+}
+
+CpuTopology::~CpuTopology()
+{
+}
+
+void
+CpuTopology::setDefaultTopology()
+{
+    int nCpus = std::max(1, QThread::idealThreadCount());
+
+    _cpus.resize(nCpus);
+    for (int i = 0; i < nCpus; ++i) {
+        _cpus[i] = CpuInfo();
+        _cpus[i].cpu = i;
+        _cpus[i].core = i;
+        _cpus[i].cacheGroup = 0;
+    }
+    _numaNodesCount = 1;
+}
+
+void
+CpuTopology::readSysfs(const std::string& sysfsRoot,
+                       bool useAffinityMask)
+{
+    std::string cpuDir = sysfsRoot + "/cpu";
+    std::string line;
+    std::vector<int> cpuIds;
+
+    if ( !readLine(cpuDir + "/online", &line) || !parseCpuList(line, &cpuIds) || cpuIds.empty() ) {
+        setDefaultTopology();
+
+        return;
+    }
+
+#ifdef __NATRON_LINUX__
+    if (useAffinityMask) {
+        cpu_set_t mask;
+        CPU_ZERO(&mask);
+        if (sched_getaffinity(0, sizeof(mask), &mask) == 0) {
+            std::vector<int> allowed;
+            for (std::size_t i = 0; i < cpuIds.size(); ++i) {
+                if ( (cpuIds[i] < CPU_SETSIZE) && CPU_ISSET(cpuIds[i], &mask) ) {
+                    allowed.push_back(cpuIds[i]);
+                }
+            }
+            if ( !allowed.empty() ) {
+                cpuIds.swap(allowed);
+            }
+        }
+    }
+#else
+    Q_UNUSED(useAffinityMask);
+#endif
+
+    ///The NUMA nodes, absent if the kernel was built without NUMA support
+    std::map<int, int> nodeOfCpu;
+    std::vector<int> nodeIds;
+    if ( readLine(sysfsRoot + "/node/online", &line) && parseCpuList(line, &nodeIds) ) {
+        for (std::size_t i = 0; i < nodeIds.size(); ++i) {
+            std::vector<int> nodeCpus;
+            if ( readLine(sysfsRoot + "/node/node" + toString(nodeIds[i]) + "/cpulist", &line) && parseCpuList(line, &nodeCpus) ) {
+                for (std::size_t j = 0; j < nodeCpus.size(); ++j) {
+                    nodeOfCpu[nodeCpus[j]] = nodeIds[i];
+                }
+            }
+        }
+    }
+
+    ///Node ids may have holes and some nodes may have no allowed CPU: number the nodes in use from 0
+    std::map<int, int> nodeIndexes;
+    for (std::size_t i = 0; i < cpuIds.size(); ++i) {
+        std::map<int, int>::const_iterator found = nodeOfCpu.find(cpuIds[i]);
+        nodeIndexes[found == nodeOfCpu.end() ? -1 : found->second] = 0;
+    }
+    int nextNodeIndex = 0;
+    for (std::map<int, int>::iterator it = nodeIndexes.begin(); it != nodeIndexes.end(); ++it) {
+        it->second = nextNodeIndex++;
+    }
+    _numaNodesCount = nextNodeIndex;
+
+    std::map<std::pair<int, int>, int> threadsPerCore;
+    _cpus.resize( cpuIds.size() );
+    for (std::size_t i = 0; i < cpuIds.size(); ++i) {
+        CpuInfo& info = _cpus[i];
+        int cpu = cpuIds[i];
+        std::string dir = cpuDir + "/cpu" + toString(cpu);
+
+        info.cpu = cpu;
+        std::map<int, int>::const_iterator foundNode = nodeOfCpu.find(cpu);
+        info.numaNode = nodeIndexes[foundNode == nodeOfCpu.end() ? -1 : foundNode->second];
+        if ( !readInt(dir + "/topology/physical_package_id", &info.package) ) {
+            info.package = 0;
+        }
+        if ( !readInt(dir + "/topology/core_id", &info.core) ) {
+            info.core = cpu;
+        }
+
+        ///The last level cache is the one with the highest level
+        info.cacheGroup = cpu;
+        int lastLevel = 0;
+        for (int index = 0; index < NATRON_CPU_TOPOLOGY_MAX_CACHE_INDEX; ++index) {
+            std::string cacheDir = dir + "/cache/index" + toString(index);
+            int level;
+            if ( !readInt(cacheDir + "/level", &level) ) {
+                break;
+            }
+            std::vector<int> sharedCpus;
+            if ( (level > lastLevel) && readLine(cacheDir + "/shared_cpu_list", &line) && parseCpuList(line, &sharedCpus) && !sharedCpus.empty() ) {
+                lastLevel = level;
+                info.cacheGroup = *std::min_element( sharedCpus.begin(), sharedCpus.end() );
+            }
+        }
+
+        ///cpuIds is sorted, so the first hardware thread of a core is the one with the lowest id
+        info.smtIndex = threadsPerCore[std::make_pair(info.package, info.core)]++;
+    }
+
+    std::sort(_cpus.begin(), _cpus.end(), compareCpus);
+} // CpuTopology::readSysfs
+
+int
+CpuTopology::getPhysicalCoresCount() const
+{
+    int ret = 0;
+
+    for (std::size_t i = 0; i < _cpus.size(); ++i) {
+        if (_cpus[i].smtIndex == 0) {
+            ++ret;
+        }
+    }
+
+    return ret;
+}
+
+int
+CpuTopology::getNodeOfCpu(int cpu) const
+{
+    for (std::size_t i = 0; i < _cpus.size(); ++i) {
+        if (_cpus[i].cpu == cpu) {
+            return _cpus[i].numaNode;
+        }
+    }
+
+    return -1;
+}
+
+void
+CpuTopology::getCpusOfNode(int node,
+                           std::vector<int>* cpus) const
+{
+    cpus->clear();
+    for (std::size_t i = 0; i < _cpus.size(); ++i) {
+        if (_cpus[i].numaNode == node) {
+            cpus->push_back(_cpus[i].cpu);
+        }
+    }
+}
+
+bool
+CpuTopology::parseCpuList(const std::string& list,
+                          std::vector<int>* cpus)
+{
+    cpus->clear();
+    std::istringstream ss(list);
+    std::string range;
+    while ( std::getline(ss, range, ',') ) {
+        if ( range.empty() || (range == "\n") ) {
+            continue;
+        }
+        std::istringstream rangeStream(range);
+        int first;
+        if ( !(rangeStream >> first) || (first < 0) ) {
+            return false;
+        }
+        int last = first;
+        char dash;
+        if ( (rangeStream >> dash) && ( (dash != '-') || !(rangeStream >> last) || (last < first) ) ) {
+            return false;
+        }
+        for (int cpu = first; cpu <= last; ++cpu) {
+            cpus->push_back(cpu);
+        }
+    }
+    std::sort( cpus->begin(), cpus->end() );
+    cpus->erase( std::unique( cpus->begin(), cpus->end() ), cpus->end() );
+
+    return true;
+}
+
+int
+CpuTopology::getCurrentCpu()
+{
+#ifdef __NATRON_LINUX__
+
+    return sched_getcpu();
+#else
+
+    return -1;
+#endif
+}
+
+bool
+CpuTopology::setCurrentThreadAffinity(const std::vector<int>& cpus)
+{
+#ifdef __NATRON_LINUX__
+    if ( cpus.empty() ) {
+        return false;
+    }
+    cpu_set_t mask;
+    CPU_ZERO(&mask);
+    for (std::size_t i = 0; i < cpus.size(); ++i) {
+        if (cpus[i] < CPU_SETSIZE) {
+            CPU_SET(cpus[i], &mask);
+        }
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(mask), &mask) == 0;
+#else
+    Q_UNUSED(cpus);
+
+    return false;
+#endif
+}
+
+int
+CpuTopology::getCurrentThreadNumaNode()
+{
+    return currentThreadNumaNode.hasLocalData() ? currentThreadNumaNode.localData() : -1;
+}
+
+void
+CpuTopology::setCurrentThreadNumaNode(int node)
+{
+    currentThreadNumaNode.setLocalData(node);
+}
+
+NATRON_NAMESPACE_EXIT;
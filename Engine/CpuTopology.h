@@ -0,0 +1,167 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef CPUTOPOLOGY_H
+#define CPUTOPOLOGY_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+#include <vector>
+
+#include "Global/Macros.h"
+
+#include "Global/GlobalDefines.h"
+#include "Engine/EngineFwd.h"
+
+///Where the kernel describes the CPUs and NUMA nodes
+#define NATRON_SYSFS_SYSTEM_ROOT "/sys/devices/system"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief How the threads of the multi-thread suite are bound to the CPUs
+ **/
+enum CpuAffinityModeEnum
+{
+    eCpuAffinityModeNone = 0, //< the threads may run on any CPU
+    eCpuAffinityModeNumaNode, //< each thread runs on the CPUs of one NUMA node
+    eCpuAffinityModeCpu //< each thread runs on a single CPU
+};
+
+/**
+ * @brief A logical CPU the process may run on
+ **/
+struct CpuInfo
+{
+    //The id of the CPU for the operating system
+    int cpu;
+
+    //The index of the NUMA node of the CPU, from 0 to CpuTopology::getNumaNodesCount() - 1
+    int numaNode;
+
+    //The physical package (socket) of the CPU
+    int package;
+
+    //The id of the core of the CPU in its package
+    int core;
+
+    //The lowest CPU sharing the last level cache with this one
+    int cacheGroup;
+
+    //The rank of this CPU among the hardware threads of its core, 0 for the first one
+    int smtIndex;
+
+    CpuInfo()
+        : cpu(0)
+        , numaNode(0)
+        , package(0)
+        , core(0)
+        , cacheGroup(0)
+        , smtIndex(0)
+    {
+    }
+};
+
+/**
+ * @brief The layout of the CPUs the process may run on: NUMA nodes, packages, cores and shared caches.
+ * On Linux it is read from sysfs and restricted to the affinity mask of the process (e.g: when run with taskset
+ * or in a cpuset). Elsewhere, or when sysfs cannot be read, all the CPUs are assumed to be on a single node.
+ *
+ * The CPUs are sorted by NUMA node, then the first hardware thread of every core comes before the second ones,
+ * so that taking the first CPUs of a node spreads the work over its physical cores.
+ **/
+class CpuTopology
+{
+public:
+
+    /**
+     * @brief The topology is read under sysfsRoot. If useAffinityMask is false, the CPUs the process may not
+     * run on are kept (e.g: to read a fake sysfs tree).
+     **/
+    CpuTopology(const std::string& sysfsRoot = std::string(NATRON_SYSFS_SYSTEM_ROOT),
+                bool useAffinityMask = true);
+
+    ~CpuTopology();
+
+    const std::vector<CpuInfo>& getCpus() const
+    {
+        return _cpus;
+    }
+
+    int getCpusCount() const
+    {
+        return (int)_cpus.size();
+    }
+
+    int getNumaNodesCount() const
+    {
+        return _numaNodesCount;
+    }
+
+    int getPhysicalCoresCount() const;
+
+    /**
+     * @brief Returns the index of the NUMA node of the given CPU, or -1 if the process may not run on it
+     **/
+    int getNodeOfCpu(int cpu) const;
+
+    /**
+     * @brief The CPUs of the given NUMA node, in the order of getCpus()
+     **/
+    void getCpusOfNode(int node, std::vector<int>* cpus) const;
+
+    /**
+     * @brief Parses a list of CPUs in the sysfs format, e.g: "0-3,8,10-11"
+     **/
+    static bool parseCpuList(const std::string& list, std::vector<int>* cpus);
+
+    /**
+     * @brief The CPU the calling thread is running on, or -1 if unknown
+     **/
+    static int getCurrentCpu();
+
+    /**
+     * @brief Restricts the calling thread to the given CPUs.
+     * Returns false if it is not supported on this system or if it failed.
+     **/
+    static bool setCurrentThreadAffinity(const std::vector<int>& cpus);
+
+    /**
+     * @brief The NUMA node the calling thread was bound to with setCurrentThreadNumaNode(), or -1
+     **/
+    static int getCurrentThreadNumaNode();
+    static void setCurrentThreadNumaNode(int node);
+
+private:
+
+    void readSysfs(const std::string& sysfsRoot, bool useAffinityMask);
+
+    void setDefaultTopology();
+
+    std::vector<CpuInfo> _cpus;
+    int _numaNodesCount;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // CPUTOPOLOGY_H
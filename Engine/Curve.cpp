@@ -26,7 +26,9 @@
 
 #include <algorithm>
 #include <cassert>
+#include <list>
 #include <stdexcept>
+#include <vector>
 
 #if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
 GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
@@ -304,6 +306,7 @@ Curve::clearKeyFrames()
     QMutexLocker l(&_imp->_lock);
 
     _imp->keyFrames.clear();
+    _imp->onKeyFramesChanged();
 }
 
 bool
@@ -417,9 +420,163 @@ Curve::addKeyFrame(KeyFrame key)
     return it.second;
 }
 
+/**
+ * @brief Sets the automatic derivatives of keys[index] from its neighbours in keys, the same way
+ * Curve::refreshDerivatives does for a keyframe of the set.
+ **/
+static void
+refreshDerivativesInSortedKeys(std::vector<KeyFrame>& keys,
+                               std::size_t index)
+{
+    KeyFrame& key = keys[index];
+    KeyframeTypeEnum interp = key.getInterpolation();
+    if ( (interp == eKeyframeTypeNone) || (interp == eKeyframeTypeBroken) || (interp == eKeyframeTypeFree) ) {
+        return;
+    }
+    double tcur = key.getTime();
+    double vcur = key.getValue();
+    double tprev, vprev, tnext, vnext, vprevDerivRight, vnextDerivLeft;
+    KeyframeTypeEnum prevType, nextType;
+    
+    if (index == 0) {
+        tprev = tcur;
+        vprev = vcur;
+        vprevDerivRight = 0.;
+        prevType = eKeyframeTypeNone;
+    } else {
+        const KeyFrame& prev = keys[index - 1];
+        tprev = prev.getTime();
+        vprev = prev.getValue();
+        vprevDerivRight = prev.getRightDerivative();
+        prevType = prev.getInterpolation();
+        //if prev is the first keyframe, and not edited by the user then interpolate linearly
+        if ( (index - 1 == 0) && (prevType != eKeyframeTypeFree) && (prevType != eKeyframeTypeBroken) ) {
+            prevType = eKeyframeTypeLinear;
+        }
+    }
+    
+    if (index + 1 == keys.size()) {
+        tnext = tcur;
+        vnext = vcur;
+        vnextDerivLeft = 0.;
+        nextType = eKeyframeTypeNone;
+    } else {
+        const KeyFrame& next = keys[index + 1];
+        tnext = next.getTime();
+        vnext = next.getValue();
+        vnextDerivLeft = next.getLeftDerivative();
+        nextType = next.getInterpolation();
+        //if next is the last keyframe, and not edited by the user then interpolate linearly
+        if ( (index + 2 == keys.size()) && (nextType != eKeyframeTypeFree) && (nextType != eKeyframeTypeBroken) ) {
+            nextType = eKeyframeTypeLinear;
+        }
+    }
+    
+    double vcurDerivLeft, vcurDerivRight;
+    Interpolation::autoComputeDerivatives(prevType, interp, nextType,
+                                          tprev, vprev,
+                                          tcur, vcur,
+                                          tnext, vnext,
+                                          vprevDerivRight,
+                                          vnextDerivLeft,
+                                          &vcurDerivLeft, &vcurDerivRight);
+    key.setLeftDerivative(vcurDerivLeft);
+    key.setRightDerivative(vcurDerivRight);
+}
+
+void
+Curve::addKeyFrames(const std::vector<KeyFrame>& keys,
+                    std::list<double>* keysAdded)
+{
+    if ( keys.empty() ) {
+        return;
+    }
+    
+    // The keys are expected to be sorted by time, sort a copy if they are not
+    const std::vector<KeyFrame>* sortedKeys = &keys;
+    std::vector<KeyFrame> sortedCopy;
+    for (std::size_t i = 1; i < keys.size(); ++i) {
+        if (keys[i].getTime() < keys[i - 1].getTime()) {
+            sortedCopy = keys;
+            std::stable_sort( sortedCopy.begin(), sortedCopy.end(), KeyFrame_compare_time() );
+            sortedKeys = &sortedCopy;
+            break;
+        }
+    }
+    
+    QMutexLocker l(&_imp->_lock);
+    
+    bool forceConstant = ( (_imp->type == CurvePrivate::eCurveTypeBool) || (_imp->type == CurvePrivate::eCurveTypeString) ||
+                           ( _imp->type == CurvePrivate::eCurveTypeIntConstantInterp) );
+    
+    if (_imp->isParametric) {
+        // Keyframes of parametric curves are matched with a tolerance, insert them one by one
+        for (std::vector<KeyFrame>::const_iterator it = sortedKeys->begin(); it != sortedKeys->end(); ++it) {
+            KeyFrame key = *it;
+            if (forceConstant) {
+                key.setInterpolation(eKeyframeTypeConstant);
+            }
+            std::pair<KeyFrameSet::iterator,bool> ret = addKeyFrameNoUpdate(key);
+            ignore_result( evaluateCurveChanged(eCurveChangedReasonKeyframeChanged, ret.first) );
+            if (ret.second && keysAdded) {
+                keysAdded->push_back( key.getTime() );
+            }
+        }
+        
+        return;
+    }
+    
+    // Merge the existing keyframes with the new ones in a single pass. A new keyframe replaces the existing one at the
+    // same time and if several new keyframes have the same time, the last one wins.
+    std::vector<KeyFrame> merged;
+    merged.reserve( _imp->keyFrames.size() + sortedKeys->size() );
+    KeyFrameSet::const_iterator itExisting = _imp->keyFrames.begin();
+    std::size_t firstNew = 0, lastNew = 0;
+    bool hasNew = false;
+    const std::size_t nKeys = sortedKeys->size();
+    for (std::size_t i = 0; i < nKeys; ++i) {
+        if ( (i + 1 < nKeys) && ( (*sortedKeys)[i + 1].getTime() == (*sortedKeys)[i].getTime() ) ) {
+            continue;
+        }
+        KeyFrame key = (*sortedKeys)[i];
+        if (forceConstant) {
+            key.setInterpolation(eKeyframeTypeConstant);
+        }
+        while ( itExisting != _imp->keyFrames.end() && itExisting->getTime() < key.getTime() ) {
+            merged.push_back(*itExisting);
+            ++itExisting;
+        }
+        if ( itExisting != _imp->keyFrames.end() && itExisting->getTime() == key.getTime() ) {
+            ++itExisting;
+        } else if (keysAdded) {
+            keysAdded->push_back( key.getTime() );
+        }
+        if (!hasNew) {
+            firstNew = merged.size();
+            hasNew = true;
+        }
+        lastNew = merged.size();
+        merged.push_back(key);
+    }
+    merged.insert( merged.end(), itExisting, KeyFrameSet::const_iterator( _imp->keyFrames.end() ) );
+    
+    // Refresh the derivatives of the new keyframes and of their neighbours in one sweep: this is the range of keyframes
+    // whose derivatives addKeyFrame would have refreshed
+    std::size_t sweepBegin = firstNew > 0 ? firstNew - 1 : 0;
+    std::size_t sweepEnd = std::min(lastNew + 2, merged.size());
+    for (std::size_t i = sweepBegin; i < sweepEnd; ++i) {
+        refreshDerivativesInSortedKeys(merged, i);
+    }
+    
+    // The range constructor of std::set is linear when the input is sorted
+    _imp->keyFrames = KeyFrameSet( merged.begin(), merged.end() );
+    onCurveChanged();
+}
+
 std::pair<KeyFrameSet::iterator,bool> Curve::addKeyFrameNoUpdate(const KeyFrame & cp)
 {
     // PRIVATE - should not lock
+    _imp->onKeyFramesChanged();
     if (!_imp->isParametric) { //< if keyframes are clamped to integers
         std::pair<KeyFrameSet::iterator,bool> newKey = _imp->keyFrames.insert(cp);
         // keyframe at this time exists, erase and insert again
@@ -782,6 +939,88 @@ interParams(const KeyFrameSet &keyFrames,
     }
 }
 
+void
+Curve::ensureEvaluationCache() const
+{
+    // PRIVATE - should not lock
+    if (_imp->evaluationCacheValid) {
+        return;
+    }
+    const KeyFrameSet& keys = _imp->keyFrames;
+    _imp->keyTimes.resize( keys.size() );
+    _imp->segments.resize(keys.size() + 1);
+
+    // the same parameters as those computed by interParams for each segment
+    double tcur,tnext;
+    double vcurDerivRight,vnextDerivLeft,vcur,vnext;
+    KeyframeTypeEnum interp,interpNext;
+    int i = 0;
+    KeyFrameSet::const_iterator prev = keys.end();
+    for (KeyFrameSet::const_iterator it = keys.begin(); it != keys.end(); ++it, ++i) {
+        _imp->keyTimes[i] = it->getTime();
+        tnext = it->getTime();
+        vnext = it->getValue();
+        vnextDerivLeft = it->getLeftDerivative();
+        interpNext = it->getInterpolation();
+        if ( prev == keys.end() ) {
+            // before the first keyframe
+            tcur = tnext - 1.;
+            vcur = vnext;
+            vcurDerivRight = 0.;
+            interp = eKeyframeTypeNone;
+        } else {
+            tcur = prev->getTime();
+            vcur = prev->getValue();
+            vcurDerivRight = prev->getRightDerivative();
+            interp = prev->getInterpolation();
+        }
+        CurveSegment& seg = _imp->segments[i];
+        Interpolation::cubicCoeffs(tcur, vcur, vcurDerivRight, vnextDerivLeft, tnext, vnext, interp, interpNext,
+                                   &seg.tstart, &seg.tend, &seg.c0, &seg.c1, &seg.c2, &seg.c3);
+        prev = it;
+    }
+    if ( prev != keys.end() ) {
+        // after the last keyframe
+        tcur = prev->getTime();
+        vcur = prev->getValue();
+        vcurDerivRight = prev->getRightDerivative();
+        interp = prev->getInterpolation();
+        CurveSegment& seg = _imp->segments[i];
+        Interpolation::cubicCoeffs(tcur, vcur, vcurDerivRight, 0., tcur + 1., vcur, interp, eKeyframeTypeNone,
+                                   &seg.tstart, &seg.tend, &seg.c0, &seg.c1, &seg.c2, &seg.c3);
+    }
+    _imp->evaluationCacheValid = true;
+}
+
+int
+Curve::findSegment(double t) const
+{
+    // PRIVATE - should not lock
+    // the segment index is the number of keyframes with time <= t, i.e. the index of the upper bound
+    return (int)( std::upper_bound(_imp->keyTimes.begin(), _imp->keyTimes.end(), t) - _imp->keyTimes.begin() );
+}
+
+double
+Curve::roundValueToCurveType(double v) const
+{
+    // PRIVATE - should not lock
+    switch (_imp->type) {
+    case CurvePrivate::eCurveTypeString:
+    case CurvePrivate::eCurveTypeInt:
+
+        return std::floor(v + 0.5);
+    case CurvePrivate::eCurveTypeDouble:
+
+        return v;
+    case CurvePrivate::eCurveTypeBool:
+
+        return v >= 0.5 ? 1. : 0.;
+    default:
+
+        return v;
+    }
+}
+
 double
 Curve::getValueAt(double t,bool doClamp) const
 {
@@ -800,36 +1039,9 @@ Curve::getValueAt(double t,bool doClamp) const
 #endif
     {
         // even when there is only one keyframe, there may be tangents!
-        //if (_imp->keyFrames.size() == 1) {
-        //    //if there's only 1 keyframe, don't bother interpolating
-        //    return (*_imp->keyFrames.begin()).getValue();
-        //}
-        double tcur,tnext;
-        double vcurDerivRight,vnextDerivLeft,vcur,vnext;
-        KeyframeTypeEnum interp,interpNext;
-        KeyFrame k(t,0.);
-        // find the first keyframe with time greater than t
-        KeyFrameSet::const_iterator itup;
-        itup = _imp->keyFrames.upper_bound(k);
-        interParams(_imp->keyFrames,
-                    t,
-                    itup,
-                    &tcur,
-                    &vcur,
-                    &vcurDerivRight,
-                    &interp,
-                    &tnext,
-                    &vnext,
-                    &vnextDerivLeft,
-                    &interpNext);
-        
-        v = Interpolation::interpolate(tcur,vcur,
-                                vcurDerivRight,
-                                vnextDerivLeft,
-                                tnext,vnext,
-                                t,
-                                interp,
-                                interpNext);
+        ensureEvaluationCache();
+        const CurveSegment& seg = _imp->segments[findSegment(t)];
+        v = Interpolation::cubicEvalAt(seg.tstart, seg.tend, seg.c0, seg.c1, seg.c2, seg.c3, t);
 #ifdef NATRON_CURVE_USE_CACHE
         _imp->resultCache[t] = v;
 #endif
@@ -839,22 +1051,64 @@ Curve::getValueAt(double t,bool doClamp) const
         v = clampValueToCurveYRange(v);
     }
 
-    switch (_imp->type) {
-    case CurvePrivate::eCurveTypeString:
-    case CurvePrivate::eCurveTypeInt:
+    return roundValueToCurveType(v);
+} // getValueAt
 
-        return std::floor(v + 0.5);
-    case CurvePrivate::eCurveTypeDouble:
+/// returns true if the segment at index (as returned by Curve::findSegment) contains t
+static bool
+segmentContainsTime(const std::vector<double>& keyTimes,
+                    int index,
+                    double t)
+{
+    return ( (index == 0) || (keyTimes[index - 1] <= t) ) &&
+           ( ( index == (int)keyTimes.size() ) || (t < keyTimes[index]) );
+}
 
-        return v;
-    case CurvePrivate::eCurveTypeBool:
+void
+Curve::getValuesAt(const double* times,
+                   double* values,
+                   int count,
+                   bool doClamp) const
+{
+    assert( (times && values) || count == 0 );
+    QMutexLocker l(&_imp->_lock);
 
-        return v >= 0.5 ? 1. : 0.;
-    default:
+    if ( _imp->keyFrames.empty() ) {
+        throw std::runtime_error("Curve has no control points!");
+    }
+    ensureEvaluationCache();
 
-        return v;
+    const bool clamp = doClamp && mustClamp();
+    std::pair<double,double> minmax(0., 0.);
+    if (clamp) {
+        minmax = getCurveYRange();
     }
-} // getValueAt
+
+    const std::vector<double>& keyTimes = _imp->keyTimes;
+    const int nKeys = (int)keyTimes.size();
+    int segIndex = -1;
+    for (int i = 0; i < count; ++i) {
+        const double t = times[i];
+        // times are usually increasing: only search when t is neither in the segment of the previous sample nor in the next one
+        if ( (segIndex == -1) || !segmentContainsTime(keyTimes, segIndex, t) ) {
+            if ( (segIndex != -1) && (segIndex < nKeys) && segmentContainsTime(keyTimes, segIndex + 1, t) ) {
+                ++segIndex;
+            } else {
+                segIndex = findSegment(t);
+            }
+        }
+        const CurveSegment& seg = _imp->segments[segIndex];
+        double v = Interpolation::cubicEvalAt(seg.tstart, seg.tend, seg.c0, seg.c1, seg.c2, seg.c3, t);
+        if (clamp) {
+            if (v > minmax.second) {
+                v = minmax.second;
+            } else if (v < minmax.first) {
+                v = minmax.first;
+            }
+        }
+        values[i] = roundValueToCurveType(v);
+    }
+} // getValuesAt
 
 double
 Curve::getDerivativeAt(double t) const
@@ -1093,6 +1347,14 @@ std::pair<double,double> Curve::getXRange() const
     return std::make_pair(_imp->xMin, _imp->xMax);
 }
 
+U64
+Curve::getKeyFramesAge() const
+{
+    QMutexLocker l(&_imp->_lock);
+
+    return _imp->keyFramesAge;
+}
+
 int
 Curve::getKeyFramesCount() const
 {
@@ -1409,6 +1671,7 @@ Curve::refreshDerivatives(Curve::CurveChangedReasonEnum reason,
     newKey.setLeftDerivative(vcurDerivLeft);
     newKey.setRightDerivative(vcurDerivRight);
 
+    _imp->onKeyFramesChanged();
     std::pair<KeyFrameSet::iterator,bool> newKeyIt = _imp->keyFrames.insert(newKey);
 
     // keyframe at this time exists, erase and insert again
@@ -1580,6 +1843,7 @@ void
 Curve::onCurveChanged()
 {
     // PRIVATE - should not lock
+    _imp->onKeyFramesChanged();
     if (_imp->owner) {
         _imp->owner->clearExpressionsResults(_imp->dimensionInOwner);
     }
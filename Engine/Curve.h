@@ -27,6 +27,7 @@
 
 #include "Global/Macros.h"
 
+#include <list>
 #include <vector>
 #include <map>
 #include <set>
@@ -193,6 +194,15 @@ public:
     ///existing key at this time.
     bool addKeyFrame(KeyFrame key);
 
+    /**
+     * @brief Adds all the given keyframes at once, replacing the existing keyframes at the same times.
+     * The keys should be sorted by increasing time. Instead of one set insertion and one derivatives
+     * update per key, the keyframes storage is rebuilt in one pass and the derivatives of the keys
+     * are computed in one sweep. The times of the keyframes which did not replace an existing one are
+     * appended to keysAdded if not NULL.
+     **/
+    void addKeyFrames(const std::vector<KeyFrame>& keys, std::list<double>* keysAdded = NULL);
+
     void removeKeyFrameWithTime(double time);
 
     void removeKeyFrameWithIndex(int index);
@@ -224,12 +234,26 @@ public:
 
     int getKeyFramesCount() const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Returns a number incremented each time the keyframes of the curve are modified,
+     * so that anything derived from the keyframes can be cached by its user.
+     **/
+    U64 getKeyFramesAge() const WARN_UNUSED_RETURN;
+
     double getMinimumTimeCovered() const WARN_UNUSED_RETURN;
 
     double getMaximumTimeCovered() const WARN_UNUSED_RETURN;
 
     double getValueAt(double t,bool clamp = true) const WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Evaluates the curve at the count given times and writes the results in values.
+     * This gives the same results as calling getValueAt for each time, but the lock is taken only once
+     * and consecutive times falling in the same segment of the curve do not need any lookup:
+     * prefer this when sampling a curve many times (curve editor, tessellation, motion blur).
+     **/
+    void getValuesAt(const double* times, double* values, int count, bool clamp = true) const;
+
     double getDerivativeAt(double t) const WARN_UNUSED_RETURN;
 
     double getIntegrateFromTo(double t1, double t2) const WARN_UNUSED_RETURN;
@@ -300,6 +324,17 @@ private:
 
     double clampValueToCurveYRange(double v) const WARN_UNUSED_RETURN;
 
+    double roundValueToCurveType(double v) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Rebuilds the flat keyframe times and the per-segment cubic coefficients used
+     * to evaluate the curve if the keyframes changed since the last call.
+     **/
+    void ensureEvaluationCache() const;
+
+    ///Returns the index in _imp->segments of the segment containing t
+    int findSegment(double t) const WARN_UNUSED_RETURN;
+
     ///returns an iterator to the new keyframe in the keyframe set and
     ///a boolean indicating whether it removed a keyframe already existing at this time or not
     std::pair<KeyFrameSet::iterator,bool> addKeyFrameNoUpdate(const KeyFrame & cp) WARN_UNUSED_RETURN;
@@ -30,6 +30,8 @@
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
 #endif
+#include <vector>
+
 #include <QMutex>
 
 #include "Engine/Variant.h"
@@ -42,6 +44,16 @@
 
 NATRON_NAMESPACE_ENTER;
 
+/**
+ * @brief A piece of the curve ready to be evaluated with Interpolation::cubicEvalAt():
+ * the cubic coefficients are computed once from the two keyframes bounding it.
+ **/
+struct CurveSegment
+{
+    double tstart, tend;
+    double c0, c1, c2, c3;
+};
+
 struct CurvePrivate
 {
     enum CurveTypeEnum
@@ -55,6 +67,14 @@ struct CurvePrivate
     };
 
     KeyFrameSet keyFrames;
+
+    ///Flat copy of keyFrames used by getValueAt: keyTimes is sorted and segments holds the
+    ///keyTimes.size() + 1 pieces of the curve (before the first keyframe, between each pair, after the last).
+    ///It is rebuilt lazily by Curve::ensureEvaluationCache() when evaluationCacheValid is false.
+    mutable std::vector<double> keyTimes;
+    mutable std::vector<CurveSegment> segments;
+    mutable bool evaluationCacheValid;
+    U64 keyFramesAge; //< incremented each time keyFrames is modified
     
 #ifdef NATRON_CURVE_USE_CACHE
     std::map<double,double> resultCache; //< a cache for interpolations
@@ -72,6 +92,10 @@ struct CurvePrivate
 
     CurvePrivate()
     : keyFrames()
+    , keyTimes()
+    , segments()
+    , evaluationCacheValid(false)
+    , keyFramesAge(0)
 #ifdef NATRON_CURVE_USE_CACHE
     , resultCache()
 #endif
@@ -89,7 +113,9 @@ struct CurvePrivate
     }
 
     CurvePrivate(const CurvePrivate & other)
-        : _lock(QMutex::Recursive)
+        : evaluationCacheValid(false)
+        , keyFramesAge(0)
+        , _lock(QMutex::Recursive)
     {
         *this = other;
     }
@@ -97,6 +123,7 @@ struct CurvePrivate
     void operator=(const CurvePrivate & other)
     {
         keyFrames = other.keyFrames;
+        onKeyFramesChanged();
         owner = other.owner;
         dimensionInOwner = other.dimensionInOwner;
         isParametric = other.isParametric;
@@ -107,6 +134,13 @@ struct CurvePrivate
         yMax = other.yMax;
         hasYRange = other.hasYRange;
     }
+
+    ///Must be called whenever keyFrames is modified
+    void onKeyFramesChanged()
+    {
+        evaluationCacheValid = false;
+        ++keyFramesAge;
+    }
     
 };
 
@@ -0,0 +1,368 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "DamageHistory.h"
+
+#include <QtCore/QMutex>
+
+NATRON_NAMESPACE_ENTER;
+
+DamageRegion::DamageRegion()
+    : _set(false)
+    , _unknown(false)
+    , _region()
+    , _allTimes(true)
+    , _time(0)
+{
+}
+
+bool
+DamageRegion::isEmpty() const
+{
+    return !_set && !_unknown;
+}
+
+bool
+DamageRegion::isUnknown() const
+{
+    return _unknown;
+}
+
+void
+DamageRegion::setUnknown()
+{
+    _unknown = true;
+}
+
+void
+DamageRegion::clear()
+{
+    _set = false;
+    _unknown = false;
+    _region.clear();
+    _allTimes = true;
+    _time = 0;
+}
+
+void
+DamageRegion::merge(const RectD & region,
+                    bool allTimes,
+                    double time)
+{
+    if (_unknown) {
+        return;
+    }
+    if (!_set) {
+        _set = true;
+        _region = region;
+        _allTimes = allTimes;
+        _time = time;
+
+        return;
+    }
+    if (!allTimes) {
+        if (!_allTimes && (_time != time) ) {
+            ///The damage is only known at a single time
+            _unknown = true;
+
+            return;
+        }
+        _allTimes = false;
+        _time = time;
+    }
+    if ( _region.isNull() ) {
+        _region = region;
+    } else if ( !region.isNull() ) {
+        _region.merge(region);
+    }
+}
+
+void
+DamageRegion::merge(const DamageRegion & other)
+{
+    if (other._unknown) {
+        _unknown = true;
+    } else if (other._set) {
+        merge(other._region, other._allTimes, other._time);
+    }
+}
+
+bool
+DamageRegion::getRegionAtTime(double time,
+                              RectD* region) const
+{
+    if ( _unknown || !_set || (!_allTimes && (_time != time) ) ) {
+        return false;
+    }
+    *region = _region;
+
+    return true;
+}
+
+struct DamageHistoryPrivate
+{
+    mutable QMutex lock;
+
+    //The last changes, the oldest first
+    std::list<DamageRecord> records;
+
+    //The reports made before the knobs age is incremented
+    DamageRegion report;
+
+    //True between beginChange() and endChange()
+    bool changeBegun;
+
+    //The changes of the knobs since the hash was last computed
+    bool knobsChanged;
+    DamageRegion knobsDamage;
+
+    //The inputs when the hash was last computed
+    bool hasInputs;
+    std::vector<DamageInputState> inputs;
+
+    DamageHistoryPrivate()
+        : lock()
+        , records()
+        , report()
+        , changeBegun(false)
+        , knobsChanged(false)
+        , knobsDamage()
+        , hasInputs(false)
+        , inputs()
+    {
+    }
+
+    ///True if the record can be expressed as a region, now or once its change ended
+    static bool mayBeResolved(const DamageRecord & record)
+    {
+        return record.known && ( !record.knobsChanged || !record.knobsDamage.isUnknown() );
+    }
+
+    static bool isResolved(const DamageRecord & record)
+    {
+        return mayBeResolved(record) && !record.open && ( !record.knobsChanged || !record.knobsDamage.isEmpty() );
+    }
+
+    ///Must be called with lock held
+    void closeRecords()
+    {
+        if ( records.empty() || !records.back().open ) {
+            return;
+        }
+        DamageRecord & last = records.back();
+        last.open = false;
+        if ( last.knobsChanged && last.knobsDamage.isEmpty() ) {
+            ///Nothing was reported for this change
+            last.knobsDamage.setUnknown();
+        }
+    }
+};
+
+DamageHistory::DamageHistory()
+    : _imp( new DamageHistoryPrivate() )
+{
+}
+
+DamageHistory::~DamageHistory()
+{
+}
+
+void
+DamageHistory::reportDamagedRegion(const RectD & region,
+                                   bool allTimes,
+                                   double time)
+{
+    DamageRegion damage;
+
+    damage.merge(region, allTimes, time);
+    reportDamagedRegion(damage);
+}
+
+void
+DamageHistory::reportDamagedRegion(const DamageRegion & damage)
+{
+    QMutexLocker k(&_imp->lock);
+
+    if (_imp->changeBegun) {
+        if (_imp->knobsChanged) {
+            ///The knobs age was incremented but the hash not computed yet
+            _imp->knobsDamage.merge(damage);
+
+            return;
+        }
+        if ( !_imp->records.empty() && _imp->records.back().open ) {
+            _imp->records.back().knobsDamage.merge(damage);
+
+            return;
+        }
+    }
+    _imp->report.merge(damage);
+}
+
+void
+DamageHistory::reportUnknownDamage()
+{
+    DamageRegion damage;
+
+    damage.setUnknown();
+    reportDamagedRegion(damage);
+}
+
+void
+DamageHistory::beginChange()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->closeRecords();
+    _imp->changeBegun = true;
+}
+
+void
+DamageHistory::endChange()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->changeBegun = false;
+    _imp->closeRecords();
+    _imp->report.clear();
+    if ( _imp->knobsChanged && _imp->knobsDamage.isEmpty() ) {
+        _imp->knobsDamage.setUnknown();
+    }
+}
+
+void
+DamageHistory::onKnobsAgeIncremented()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->knobsChanged = true;
+    if ( !_imp->report.isEmpty() ) {
+        _imp->knobsDamage.merge(_imp->report);
+    } else if (!_imp->changeBegun) {
+        ///Nobody will report the damage of this change
+        _imp->knobsDamage.setUnknown();
+    }
+    _imp->report.clear();
+}
+
+void
+DamageHistory::onHashChanged(U64 oldHash,
+                             U64 newHash,
+                             const std::vector<DamageInputState> & inputs)
+{
+    QMutexLocker k(&_imp->lock);
+    DamageRecord record;
+
+    record.oldHash = oldHash;
+    record.newHash = newHash;
+    record.known = _imp->hasInputs && _imp->inputs.size() == inputs.size();
+    record.knobsChanged = _imp->knobsChanged;
+    record.knobsDamage = _imp->knobsDamage;
+    record.open = _imp->changeBegun && _imp->knobsChanged;
+
+    for (std::size_t i = 0; record.known && i < inputs.size(); ++i) {
+        const DamageInputState & prev = _imp->inputs[i];
+        const DamageInputState & cur = inputs[i];
+        if (prev.node != cur.node) {
+            ///An input was connected or disconnected
+            record.known = false;
+        } else if ( cur.node && (prev.hash != cur.hash) ) {
+            DamagedInput input;
+            input.inputNb = (int)i;
+            input.node = cur.node;
+            input.oldHash = prev.hash;
+            input.newHash = cur.hash;
+            record.inputs.push_back(input);
+        }
+    }
+    if ( !record.knobsChanged && record.inputs.empty() ) {
+        ///Neither the knobs nor the inputs changed: e.g the script-name changed
+        record.known = false;
+    }
+
+    _imp->closeRecords();
+    _imp->records.push_back(record);
+    if (_imp->records.size() > NATRON_DAMAGE_HISTORY_SIZE) {
+        _imp->records.pop_front();
+    }
+
+    _imp->hasInputs = true;
+    _imp->inputs = inputs;
+    _imp->knobsChanged = false;
+    _imp->knobsDamage.clear();
+}
+
+void
+DamageHistory::getOlderHashes(U64 hash,
+                              std::vector<U64>* hashes) const
+{
+    QMutexLocker k(&_imp->lock);
+    U64 cur = hash;
+
+    for (std::list<DamageRecord>::const_reverse_iterator it = _imp->records.rbegin(); it != _imp->records.rend(); ++it) {
+        if ( (it->newHash != cur) || (it->oldHash == hash) || !DamageHistoryPrivate::mayBeResolved(*it) ) {
+            break;
+        }
+        hashes->push_back(it->oldHash);
+        cur = it->oldHash;
+    }
+}
+
+bool
+DamageHistory::getChanges(U64 oldHash,
+                          U64 newHash,
+                          std::list<DamageRecord>* records) const
+{
+    QMutexLocker k(&_imp->lock);
+    U64 cur = newHash;
+
+    for (std::list<DamageRecord>::const_reverse_iterator it = _imp->records.rbegin(); it != _imp->records.rend(); ++it) {
+        if ( (it->newHash != cur) || !DamageHistoryPrivate::isResolved(*it) ) {
+            return false;
+        }
+        records->push_back(*it);
+        cur = it->oldHash;
+        if (cur == oldHash) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+DamageHistory::clear()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->records.clear();
+    _imp->report.clear();
+    _imp->changeBegun = false;
+    _imp->knobsChanged = false;
+    _imp->knobsDamage.clear();
+    _imp->hasInputs = false;
+    _imp->inputs.clear();
+}
+
+NATRON_NAMESPACE_EXIT;
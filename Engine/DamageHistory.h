@@ -0,0 +1,227 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef DAMAGEHISTORY_H
+#define DAMAGEHISTORY_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <list>
+#include <vector>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/RectD.h"
+#include "Engine/EngineFwd.h"
+
+///The number of changes of the hash of a node remembered: images rendered before older changes cannot be re-used
+#define NATRON_DAMAGE_HISTORY_SIZE 8
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The region of the output of a node, in canonical coordinates, which may differ after a change.
+ * The region is either known at all times or at a single time only, in which case the damage at other times is unknown.
+ * An empty DamageRegion means nothing was reported.
+ **/
+class DamageRegion
+{
+public:
+
+    DamageRegion();
+
+    ///Nothing was reported
+    bool isEmpty() const;
+
+    ///Something which may have changed the whole output was reported
+    bool isUnknown() const;
+
+    void setUnknown();
+
+    void clear();
+
+    /**
+     * @brief Adds a region to the damage. If allTimes is false, the region only changed at the given time.
+     **/
+    void merge(const RectD & region, bool allTimes, double time);
+
+    void merge(const DamageRegion & other);
+
+    /**
+     * @brief Returns in region the damage at the given time, possibly null if nothing changed.
+     * Returns false if it is unknown at this time or if nothing was reported.
+     **/
+    bool getRegionAtTime(double time, RectD* region) const;
+
+private:
+
+    bool _set;
+    bool _unknown;
+    RectD _region;
+    bool _allTimes;
+    double _time;
+};
+
+/**
+ * @brief The hash of an input of a node when the hash of the node was computed
+ **/
+struct DamageInputState
+{
+    //The input node, only compared: it is never dereferenced
+    const Node* node;
+    U64 hash;
+
+    DamageInputState()
+        : node(0)
+        , hash(0)
+    {
+    }
+
+    DamageInputState(const Node* node,
+                     U64 hash)
+        : node(node)
+        , hash(hash)
+    {
+    }
+};
+
+/**
+ * @brief An input of which the hash changed along with the hash of the node
+ **/
+struct DamagedInput
+{
+    int inputNb;
+    const Node* node;
+    U64 oldHash;
+    U64 newHash;
+};
+
+/**
+ * @brief A change of the hash of a node
+ **/
+struct DamageRecord
+{
+    U64 oldHash;
+    U64 newHash;
+
+    //False if the change cannot be expressed as a region: the whole output may differ
+    bool known;
+
+    //True if the knobs changed, knobsDamage is then the region they affect
+    bool knobsChanged;
+    DamageRegion knobsDamage;
+
+    //The inputs whose hash changed: their damage may spread to the output
+    std::vector<DamagedInput> inputs;
+
+    //True while the knobs damage may still be reported, see DamageHistory::beginChange()
+    bool open;
+};
+
+/**
+ * @brief Remembers the last changes of the hash of a node and what caused them, so that an image rendered by the node
+ * before a change can be re-used after it, with only the region affected by the change rendered again.
+ *
+ * A change of the hash is caused either by a change of the knobs of the node, which must be reported with
+ * reportDamagedRegion(), or by a change of the hash of its inputs, in which case the damage is that of the inputs
+ * spread through the effect by its regions of interest (see Node::getDamagedRegion()). Any other cause, or a change of
+ * the knobs which was not reported, makes the whole output damaged.
+ *
+ * A change of the knobs can be reported:
+ * - before the knobs age is incremented: the report applies to that increment;
+ * - between beginChange() and endChange(), after the knobs age was incremented: this is used by the plug-ins, which
+ * report the damage from their instance changed action, called once the hash of the node already changed.
+ * A change between beginChange() and endChange() is only known once all reports were made, i.e after endChange().
+ * All functions are thread-safe.
+ **/
+struct DamageHistoryPrivate;
+class DamageHistory
+{
+public:
+
+    DamageHistory();
+
+    ~DamageHistory();
+
+    /**
+     * @brief Reports the region of the output affected by the change of the knobs being made
+     **/
+    void reportDamagedRegion(const RectD & region, bool allTimes, double time);
+
+    void reportDamagedRegion(const DamageRegion & damage);
+
+    /**
+     * @brief Reports that the change of the knobs being made may affect the whole output
+     **/
+    void reportUnknownDamage();
+
+    /**
+     * @brief Starts a change of the knobs which damage is reported after the knobs age is incremented
+     **/
+    void beginChange();
+
+    /**
+     * @brief Ends the change started by beginChange(): the reports made after are ignored
+     **/
+    void endChange();
+
+    /**
+     * @brief Must be called when the knobs age of the node is incremented
+     **/
+    void onKnobsAgeIncremented();
+
+    /**
+     * @brief Must be called when the hash of the node changed with the state of its inputs used to compute the new hash.
+     **/
+    void onHashChanged(U64 oldHash, U64 newHash, const std::vector<DamageInputState> & inputs);
+
+    /**
+     * @brief Returns the hashes of the node before the changes leading to the given hash which may still be resolved
+     * as a region, the most recent first. The images rendered with these hashes may be re-used.
+     **/
+    void getOlderHashes(U64 hash, std::vector<U64>* hashes) const;
+
+    /**
+     * @brief Returns in records the changes from oldHash to newHash, the most recent first.
+     * Returns false if one of them cannot be resolved as a region or if they were not all remembered.
+     **/
+    bool getChanges(U64 oldHash, U64 newHash, std::list<DamageRecord>* records) const;
+
+    /**
+     * @brief Forgets all changes
+     **/
+    void clear();
+
+private:
+
+    boost::scoped_ptr<DamageHistoryPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // DAMAGEHISTORY_H
@@ -26,6 +26,7 @@
 #include "EffectInstancePrivate.h"
 
 #include <map>
+#include <set>
 #include <sstream>
 #include <algorithm> // min, max
 #include <fstream>
@@ -56,6 +57,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/DiskCacheNode.h"
 #include "Engine/Image.h"
 #include "Engine/ImageParams.h"
+#include "Engine/ImageResampler.h"
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/Log.h"
@@ -64,6 +66,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxImageEffectInstance.h"
 #include "Engine/OutputSchedulerThread.h"
+#include "Engine/PersistentActionsCache.h"
 #include "Engine/PluginMemory.h"
 #include "Engine/Project.h"
 #include "Engine/RenderStats.h"
@@ -71,6 +74,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
+#include "Engine/TraceRecorder.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
@@ -1329,6 +1333,113 @@ getOrCreateFromCacheInternal(const ImageKey & key,
     }
 }
 
+/**
+ * @brief Looks in the cache for an image rendered by the node before the last changes of its hash and copies it to a
+ * new image for the given key, with only the region damaged by the changes marked as to be rendered in its bitmap.
+ **/
+static void
+getImageFromOlderHashes(const NodePtr & node,
+                        const ImageKey & key,
+                        unsigned int mipMapLevel,
+                        const RectI & bounds,
+                        const RectD & rod,
+                        ImageBitDepthEnum nodePrefDepth,
+                        const ImageComponents & nodePrefComps,
+                        ImagePtr* image)
+{
+    std::vector<U64> olderHashes;
+    node->getDamagedOlderHashes(key.getTreeVersion(), &olderHashes);
+
+    for (std::vector<U64>::const_iterator it = olderHashes.begin(); it != olderHashes.end(); ++it) {
+        ImageKey oldKey = key;
+        oldKey._nodeHashKey = *it;
+        oldKey.resetHash();
+
+        ImageList cachedImages;
+        if ( !AppManager::getImageFromCache(oldKey, &cachedImages) ) {
+            continue;
+        }
+        ImagePtr oldImage;
+        for (ImageList::iterator it2 = cachedImages.begin(); it2 != cachedImages.end(); ++it2) {
+            if ( ( (*it2)->getMipMapLevel() == mipMapLevel ) && ( (*it2)->getComponents() == nodePrefComps ) &&
+                 ( (*it2)->getBitDepth() == nodePrefDepth ) &&
+                 ( !(*it2)->getParams()->isRodProjectFormat() || ( (*it2)->getRoD() == rod ) ) ) {
+                oldImage = *it2;
+                break;
+            }
+        }
+        if (!oldImage) {
+            continue;
+        }
+
+        RectD damage;
+        RenderScale scale( Image::getScaleFromMipMapLevel(mipMapLevel) );
+        if ( !node->getDamagedRegion(*it, key.getTreeVersion(), key.getTime(), ViewIdx(key._view), scale, &damage) ) {
+            ///The older hashes are the most recent first: the damage of the next ones cannot be known either
+            return;
+        }
+
+        boost::shared_ptr<ImageParams> oldParams = oldImage->getParams();
+        RectI oldBounds = oldImage->getBounds();
+
+        ///Keep the pixels of the old image which are still in the region of definition
+        RectI pixelRod;
+        rod.toPixelEnclosing(mipMapLevel, oldParams->getPixelAspectRatio(), &pixelRod);
+        RectI newBounds = bounds;
+        RectI keptBounds;
+        if ( oldBounds.intersect(pixelRod, &keptBounds) ) {
+            newBounds.merge(keptBounds);
+        }
+
+        boost::shared_ptr<ImageParams> params = Image::makeParams(oldParams->getCost(),
+                                                                  rod,
+                                                                  newBounds,
+                                                                  oldParams->getPixelAspectRatio(),
+                                                                  mipMapLevel,
+                                                                  oldParams->isRodProjectFormat(),
+                                                                  oldParams->getComponents(),
+                                                                  oldParams->getBitDepth(),
+                                                                  oldParams->getPremultiplication(),
+                                                                  oldParams->getFieldingOrder());
+        ImagePtr img;
+        bool created = !AppManager::getImageFromCacheOrCreate(key, params, &img);
+        if (!img) {
+            return;
+        }
+        img->allocateMemory();
+        if (!created) {
+            ///Another thread created the image in the meantime
+            img->ensureBounds(bounds);
+            *image = img;
+
+            return;
+        }
+
+        oldImage->allocateMemory();
+        RectI pastedBounds;
+        if ( oldBounds.intersect(newBounds, &pastedBounds) ) {
+            img->pasteFrom(*oldImage, pastedBounds);
+#if NATRON_ENABLE_TRIMAP
+            ///The pixels that were being rendered in the old image will not be rendered in this one
+            img->clearUnavailableBitmap(pastedBounds);
+#endif
+        }
+
+        RectD canonicalBounds;
+        newBounds.toCanonical_noClipping(mipMapLevel, oldParams->getPixelAspectRatio(), &canonicalBounds);
+        RectD damageInBounds;
+        if ( damage.intersect(canonicalBounds, &damageInBounds) ) {
+            RectI damagedPixels;
+            damageInBounds.toPixelEnclosing(mipMapLevel, oldParams->getPixelAspectRatio(), &damagedPixels);
+            img->clearBitmap(damagedPixels);
+        }
+
+        *image = img;
+
+        return;
+    }
+} // getImageFromOlderHashes
+
 void
 EffectInstance::getImageFromCacheAndConvertIfNeeded(bool useCache,
                                                     bool useDiskCache,
@@ -1344,6 +1455,7 @@ EffectInstance::getImageFromCacheAndConvertIfNeeded(bool useCache,
                                                     const boost::shared_ptr<RenderStats> & stats,
                                                     boost::shared_ptr<Image>* image)
 {
+    TraceScope trace("getImageFromCache", "cache", this);
     ImageList cachedImages;
     bool isCached = false;
 
@@ -1522,6 +1634,21 @@ EffectInstance::getImageFromCacheAndConvertIfNeeded(bool useCache,
             }
         }
     } // isCached
+
+    if ( !*image && useCache && !useDiskCache ) {
+        ///The image may have been rendered by a render process launched by this one, see ProcessHandler
+        appPTR->getImageFromSharedFrameChannel(key, mipMapLevel, nodePrefComps, nodePrefDepth, image);
+        if ( *image && (*image)->getParams()->isRodProjectFormat() && rodParam && ( (*image)->getRoD() != *rodParam ) ) {
+            ///The project format is not the same as in the render process
+            appPTR->removeFromNodeCache(*image);
+            image->reset();
+        }
+    }
+
+    if ( !*image && useCache && !useDiskCache && boundsParam && rodParam ) {
+        ///Re-use an image rendered before the last changes: only the region they damaged has to be rendered again
+        getImageFromOlderHashes(getNode(), key, mipMapLevel, *boundsParam, *rodParam, nodePrefDepth, nodePrefComps, image);
+    }
 } // EffectInstance::getImageFromCacheAndConvertIfNeeded
 
 void
@@ -2109,6 +2236,64 @@ EffectInstance::Implementation::tiledRenderingFunctor(const RectToRender & rectT
     }
 } // EffectInstance::tiledRenderingFunctor
 
+namespace {
+///The image a plane is resampled from, the part of it that was rendered and the transform to apply to it
+struct ResampleSource
+{
+    ImagePtr image;
+    RectI roi;
+    Transform::Matrix3x3 srcToDst;
+};
+} // anon namespace
+
+bool
+EffectInstance::Implementation::resampleConcatenatedTransforms(const RenderActionArgs & args,
+                                                               ResampleFilterEnum filter)
+{
+    Transform::Matrix3x3 thisNodeTransform;
+    EffectInstPtr inputToTransform;
+
+    ///If the transform cannot be expressed as a matrix (e.g: motion blur), the effect renders it
+    if ( (_publicInterface->getTransform_public(args.time, args.mappedScale, args.view, &inputToTransform, &thisNodeTransform) != eStatusOK) ||
+         !inputToTransform ) {
+        return false;
+    }
+    int inputNb = _publicInterface->getInputNumber( inputToTransform.get() );
+    if (inputNb < 0) {
+        return false;
+    }
+
+    ///Fetch the source of each plane first so that nothing is written if one of them cannot be resampled
+    std::list<ResampleSource> sources;
+    for (std::list<std::pair<ImageComponents, ImagePtr> >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it) {
+        RectI inputRoI;
+        boost::shared_ptr<Transform::Matrix3x3> cat;
+        ImagePtr inputImage = _publicInterface->getImage(inputNb, args.time, args.mappedScale, args.view, NULL, &it->first, true, false, &inputRoI, &cat);
+        if ( !inputImage || (inputImage->getBitDepth() != eImageBitDepthFloat) || ( inputImage->getComponentsCount() != it->second->getComponentsCount() ) ||
+             ( inputImage->getMipMapLevel() != it->second->getMipMapLevel() ) ) {
+            return false;
+        }
+
+        ///The matrix of the transforms upstream that were concatenated, from the image of the upstream effect to our input
+        Transform::Matrix3x3 srcToDst = cat ? Transform::matMul(thisNodeTransform, *cat) : thisNodeTransform;
+        ///Only the RoI of the input image was rendered, the rest of its bounds is not read
+        ResampleSource source;
+        source.image = inputImage;
+        source.roi = inputRoI;
+        source.srcToDst = srcToDst;
+        sources.push_back(source);
+    }
+
+    std::list<ResampleSource>::const_iterator itSource = sources.begin();
+    for (std::list<std::pair<ImageComponents, ImagePtr> >::const_iterator it = args.outputPlanes.begin(); it != args.outputPlanes.end(); ++it, ++itSource) {
+        if ( !ImageResampler::resample(*itSource->image, itSource->roi, itSource->srcToDst, filter, args.roi, it->second.get()) ) {
+            return false;
+        }
+    }
+
+    return true;
+} // EffectInstance::Implementation::resampleConcatenatedTransforms
+
 EffectInstance::RenderingFunctorRetEnum
 EffectInstance::Implementation::renderHandler(const EffectDataTLSPtr& tls,
                                               const unsigned int mipMapLevel,
@@ -2352,6 +2537,12 @@ EffectInstance::Implementation::renderHandler(const EffectDataTLSPtr& tls,
         planesLists.push_back(tmpPlanes);
     }
 
+    ///Transform effects may let the host apply the concatenated transforms with its own resampler
+    ResampleFilterEnum hostFilter = eResampleFilterBilinear;
+    bool useHostResampler = _publicInterface->getNode()->getCurrentCanTransform() &&
+                            appPTR->getCurrentSettings()->isTransformConcatenationEnabled() &&
+                            appPTR->getCurrentSettings()->getConcatenatedTransformsFilter(&hostFilter);
+
     bool renderAborted = false;
     std::map<ImageComponents, EffectInstance::PlaneToRender> outputPlanes;
     for (std::list<std::list<std::pair<ImageComponents, ImagePtr> > >::iterator it = planesLists.begin(); it != planesLists.end(); ++it) {
@@ -2361,7 +2552,10 @@ EffectInstance::Implementation::renderHandler(const EffectDataTLSPtr& tls,
         }
         actionArgs.outputPlanes = *it;
 
-        StatusEnum st = _publicInterface->render_public(actionArgs);
+        StatusEnum st = eStatusOK;
+        if ( !useHostResampler || !resampleConcatenatedTransforms(actionArgs, hostFilter) ) {
+            st = _publicInterface->render_public(actionArgs);
+        }
 
         renderAborted = aborted(tls);
 
@@ -2698,6 +2892,9 @@ EffectInstance::onSignificantEvaluateAboutToBeCalled(KnobI* knob)
     if (isMT) {
         node->refreshIdentityState();
         
+        //The damage of the change may be reported by the plug-in until evaluate() is called
+        node->beginDamageReport();
+
         //Increments the knobs age following a change
         node->incrementKnobsAge();
     }
@@ -2712,6 +2909,8 @@ EffectInstance::evaluate(bool isSignificant,
   
     NodePtr node = getNode();
 
+    //The damage of the change is now known, see onSignificantEvaluateAboutToBeCalled()
+    node->endDamageReport();
 
     if (refreshMetadatas && node->isNodeCreated()) {
         refreshMetaDatas_public(true);
@@ -2730,16 +2929,21 @@ EffectInstance::evaluate(bool isSignificant,
     double time = getCurrentTime();
     std::list<ViewerInstance* > viewers;
     node->hasViewersConnected(&viewers);
+    AppInstance* app = getApp();
     for (std::list<ViewerInstance* >::iterator it = viewers.begin();
          it != viewers.end();
          ++it) {
+        //Within a batch, the render is issued once when the batch ends
+        if (app->deferViewerRenderDuringBatch(*it, isSignificant)) {
+            continue;
+        }
         if (isSignificant) {
             (*it)->renderCurrentFrame(true);
         } else {
             (*it)->redrawViewer();
         }
     }
-    if (isSignificant) {
+    if (isSignificant && !app->deferPreviewsRefreshDuringBatch()) {
         node->refreshPreviewsRecursivelyDownstream(time);
     }
 } // evaluate
@@ -3226,6 +3430,7 @@ StatusEnum
 EffectInstance::render_public(const RenderActionArgs & args)
 {
     NON_RECURSIVE_ACTION();
+    TraceScope trace("render", "action", this);
     return render(args);
 }
 
@@ -3286,6 +3491,7 @@ EffectInstance::isIdentity_public(bool useIdentityCache, // only set to true whe
         if (getSequentialPreference() != eSequentialPreferenceOnlySequential) {
             try {
                 *inputView = view;
+                TraceScope trace("isIdentity", "action", this);
                 ret = isIdentity(time, scale, renderWindow, view, inputTime, inputView, inputNb);
             } catch (...) {
                 throw;
@@ -3334,6 +3540,50 @@ EffectInstance::getRegionOfDefinitionFromCache(U64 hash,
     return eStatusFailed;
 }
 
+/**
+ * @brief Returns true if the effect or an effect upstream is a reader. The content of the files they read is not part
+ * of the node hash, so the results of the actions of the effects downstream cannot be kept across sessions either.
+ **/
+static bool
+isReaderUpstream(const EffectInstance* effect,
+                 std::set<const EffectInstance*>* visited)
+{
+    if ( effect->isReader() ) {
+        return true;
+    }
+    if ( !visited->insert(effect).second ) {
+        return false;
+    }
+    int maxInputs = effect->getMaxInputCount();
+    for (int i = 0; i < maxInputs; ++i) {
+        EffectInstPtr input = effect->getInput(i);
+        if ( input && isReaderUpstream(input.get(), visited) ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Returns the persistent actions cache if the results of the actions of the effect may be kept in it
+ **/
+static PersistentActionsCache*
+getPersistentActionsCacheFor(const EffectInstance* effect)
+{
+    PersistentActionsCache* persistentCache = appPTR->getPersistentActionsCache();
+
+    if (!persistentCache) {
+        return 0;
+    }
+    std::set<const EffectInstance*> visited;
+    if ( isReaderUpstream(effect, &visited) ) {
+        return 0;
+    }
+
+    return persistentCache;
+}
+
 StatusEnum
 EffectInstance::getRegionOfDefinition_public(U64 hash,
                                              double time,
@@ -3370,12 +3620,23 @@ EffectInstance::getRegionOfDefinition_public(U64 hash,
                 return eStatusOK;
             }
         }
+
+        ///Readers and the effects downstream are excluded since their RoD depends on the content of the files read
+        ///and not only on their hash
+        PersistentActionsCache* persistentCache = getPersistentActionsCacheFor(this);
+        if ( persistentCache && persistentCache->getRoDResult(hash, time, view, mipMapLevel, rod) ) {
+            _imp->actionsCache.setRoDResult(hash, time, view, mipMapLevel, *rod);
+            if (isProjectFormat) {
+                *isProjectFormat = false;
+            }
+            return eStatusOK;
+        }
         
         StatusEnum ret;
         RenderScale scaleOne(1.);
         {
             RECURSIVE_ACTION();
-            
+            TraceScope trace("getRegionOfDefinition", "action", this);
             
             ret = getRegionOfDefinition(hash, time, supportsRenderScaleMaybe() == eSupportsNo ? scaleOne : scale, view, rod);
             
@@ -3406,6 +3667,9 @@ EffectInstance::getRegionOfDefinition_public(U64 hash,
         
         //if (!isDuringStrokeCreation) {
         _imp->actionsCache.setRoDResult(hash, time, view,  mipMapLevel, *rod);
+        if (persistentCache) {
+            persistentCache->setRoDResult(hash, time, view, mipMapLevel, *rod);
+        }
         
         //}
         return ret;
@@ -3425,6 +3689,7 @@ EffectInstance::getRegionsOfInterest_public(double time,
     assert(outputRoD.x2 >= outputRoD.x1 && outputRoD.y2 >= outputRoD.y1);
     assert(renderWindow.x2 >= renderWindow.x1 && renderWindow.y2 >= renderWindow.y1);
 
+    TraceScope trace("getRegionsOfInterest", "action", this);
     getRegionsOfInterest(time, scale, outputRoD, renderWindow, view, ret);
 }
 
@@ -3442,6 +3707,7 @@ EffectInstance::getFramesNeeded_public(U64 hash,
     }
 
     try {
+        TraceScope trace("getFramesNeeded", "action", this);
         framesNeeded = getFramesNeeded(time, view);
     } catch (std::exception &e) {
         if (!hasPersistentMessage()) { // plugin may already have set a message
@@ -3453,6 +3719,81 @@ EffectInstance::getFramesNeeded_public(U64 hash,
     return framesNeeded;
 }
 
+bool
+EffectInstance::getOutputDamageFromInput(int inputNb,
+                                         const RectD & inputDamage,
+                                         double time,
+                                         ViewIdx view,
+                                         const RenderScale & scale,
+                                         RectD* outputDamage)
+{
+    outputDamage->clear();
+
+    ///A transform moves the damage and the regions of interest do not tell where to
+    std::list<int> inputsHoldingTransform;
+    if ( getNode()->getCurrentCanTransform() || getInputsHoldingTransform(&inputsHoldingTransform) ) {
+        return false;
+    }
+
+    EffectInstPtr input = getInput(inputNb);
+    if (!input) {
+        return false;
+    }
+
+    U64 hash = getHash();
+    unsigned int mipMapLevel = Image::getLevelFromScale(scale.x);
+
+    ///The output at this time must only depend on the input at the same time and view
+    FramesNeededMap framesNeeded = getFramesNeeded_public(hash, time, view, mipMapLevel);
+    FramesNeededMap::const_iterator foundInput = framesNeeded.find(inputNb);
+    if ( foundInput == framesNeeded.end() ) {
+        return false;
+    }
+    for (FrameRangesMap::const_iterator it = foundInput->second.begin(); it != foundInput->second.end(); ++it) {
+        if (it->first != view) {
+            return false;
+        }
+        for (std::vector<RangeD>::const_iterator it2 = it->second.begin(); it2 != it->second.end(); ++it2) {
+            if ( (it2->min != time) || (it2->max != time) ) {
+                return false;
+            }
+        }
+    }
+
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = getRegionOfDefinition_public(hash, time, scale, view, &rod, &isProjectFormat);
+    if ( (stat == eStatusFailed) || rod.isNull() ) {
+        return false;
+    }
+
+    RoIMap rois;
+    getRegionsOfInterest_public(time, scale, rod, inputDamage, view, &rois);
+    RoIMap::const_iterator foundRoI = rois.find(input);
+    if ( foundRoI == rois.end() ) {
+        return false;
+    }
+    const RectD & roi = foundRoI->second;
+    if ( roi.isInfinite() || !roi.contains(inputDamage) ) {
+        return false;
+    }
+
+    /*
+     * The input pixels read to render a pixel of the output spread around it by the margins of the region of interest
+     * around the region: the output pixels which read the damaged input pixels are around the damage by the same
+     * margins, mirrored.
+     */
+    RectD damage(inputDamage.x1 - (roi.x2 - inputDamage.x2),
+                 inputDamage.y1 - (roi.y2 - inputDamage.y2),
+                 inputDamage.x2 + (inputDamage.x1 - roi.x1),
+                 inputDamage.y2 + (inputDamage.y1 - roi.y1));
+    if ( !damage.intersect(rod, outputDamage) ) {
+        outputDamage->clear();
+    }
+
+    return true;
+} // EffectInstance::getOutputDamageFromInput
+
 void
 EffectInstance::getFrameRange_public(U64 hash,
                                      double *first,
@@ -3480,9 +3821,21 @@ EffectInstance::getFrameRange_public(U64 hash,
             }
         }
 
+        PersistentActionsCache* persistentCache = getPersistentActionsCacheFor(this);
+        if ( !bypasscache && persistentCache && persistentCache->getTimeDomainResult(hash, &fFirst, &fLast) ) {
+            _imp->actionsCache.setTimeDomainResult(hash, fFirst, fLast);
+            *first = std::floor(fFirst + 0.5);
+            *last = std::floor(fLast + 0.5);
+
+            return;
+        }
+
         NON_RECURSIVE_ACTION();
         getFrameRange(first, last);
         _imp->actionsCache.setTimeDomainResult(hash, *first, *last);
+        if (persistentCache) {
+            persistentCache->setTimeDomainResult(hash, *first, *last);
+        }
     }
 }
 
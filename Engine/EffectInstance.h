@@ -1025,6 +1025,19 @@ public:
 
     FramesNeededMap getFramesNeeded_public(U64 hash, double time, ViewIdx view, unsigned int mipMapLevel) WARN_UNUSED_RETURN;
 
+    /**
+     * @brief Returns in outputDamage the region of the output, in canonical coordinates, which may differ after the
+     * given region of the input inputNb changed. The damage is spread by the margins of the region of interest of
+     * the input around it, and clipped to the region of definition.
+     * Returns false if it cannot be known, e.g: if the effect transforms or reads other frames of the input.
+     **/
+    bool getOutputDamageFromInput(int inputNb,
+                                  const RectD & inputDamage,
+                                  double time,
+                                  ViewIdx view,
+                                  const RenderScale & scale,
+                                  RectD* outputDamage) WARN_UNUSED_RETURN;
+
     void getFrameRange_public(U64 hash, double *first, double *last, bool bypasscache = false);
 
     /**
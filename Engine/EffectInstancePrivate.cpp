@@ -24,20 +24,21 @@
 
 #include "EffectInstancePrivate.h"
 
+#include <algorithm> // find
 #include <cassert>
 #include <stdexcept>
 
 #include "Engine/AppInstance.h"
 #include "Engine/Node.h"
 #include "Engine/NodeGroup.h"
+#include "Engine/TraceRecorder.h"
 #include "Engine/ViewIdx.h"
 
 
 NATRON_NAMESPACE_ENTER;
 
 ActionsCache::ActionsCacheInstance::ActionsCacheInstance()
-    : _hash(0)
-    , _timeDomain()
+    : _timeDomain()
     , _timeDomainSet(false)
     , _identityCache()
     , _rodCache()
@@ -46,42 +47,60 @@ ActionsCache::ActionsCacheInstance::ActionsCacheInstance()
 }
 
 
-std::list<ActionsCache::ActionsCacheInstance>::iterator
+ActionsCache::ActionsCacheInstance &
 ActionsCache::createActionCacheInternal(U64 newHash)
 {
-    if (_instances.size() >= _maxInstances) {
-        _instances.pop_front();
+    ActionsCacheInstancesMap::iterator found = _instances.find(newHash);
+    if ( found != _instances.end() ) {
+        ///Start again from an empty cache for this hash
+        found->second = ActionsCacheInstance();
+        std::list<U64>::iterator it = std::find(_instancesOrder.begin(), _instancesOrder.end(), newHash);
+        if ( it != _instancesOrder.end() ) {
+            _instancesOrder.erase(it);
+        }
+        _instancesOrder.push_back(newHash);
+
+        return found->second;
     }
-    ActionsCacheInstance cache;
-    cache._hash = newHash;
 
-    return _instances.insert(_instances.end(), cache);
+    if ( !_instancesOrder.empty() && (_instances.size() >= _maxInstances) ) {
+        _instances.erase( _instancesOrder.front() );
+        _instancesOrder.pop_front();
+    }
+    _instancesOrder.push_back(newHash);
+
+    return _instances[newHash];
 }
 
 
 ActionsCache::ActionsCacheInstance &
 ActionsCache::getOrCreateActionCache(U64 newHash)
 {
-    std::list<ActionsCacheInstance>::iterator found = _instances.end();
-
-    for (std::list<ActionsCacheInstance>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
-        if (it->_hash == newHash) {
-            found = it;
-            break;
-        }
+    ActionsCacheInstancesMap::iterator found = _instances.find(newHash);
+    if ( found != _instances.end() ) {
+        return found->second;
     }
+
+    return createActionCacheInternal(newHash);
+}
+
+
+const ActionsCache::ActionsCacheInstance*
+ActionsCache::findActionCache(U64 hash) const
+{
+    ActionsCacheInstancesMap::const_iterator found = _instances.find(hash);
     if ( found == _instances.end() ) {
-        found = createActionCacheInternal(newHash);
+        return 0;
     }
-    assert( found != _instances.end() );
 
-    return *found;
+    return &found->second;
 }
 
 
 ActionsCache::ActionsCache(int maxAvailableHashes)
         : _cacheMutex()
         , _instances()
+        , _instancesOrder()
         , _maxInstances((std::size_t)maxAvailableHashes)
 {
 }
@@ -90,16 +109,17 @@ ActionsCache::ActionsCache(int maxAvailableHashes)
 void
 ActionsCache::clearAll()
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
 
     _instances.clear();
+    _instancesOrder.clear();
 }
 
 
 void
 ActionsCache::invalidateAll(U64 newHash)
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
 
     createActionCacheInternal(newHash);
 }
@@ -113,25 +133,25 @@ ActionsCache::getIdentityResult(U64 hash,
                                 ViewIdx *inputView,
                                 double* identityTime)
 {
-    QMutexLocker l(&_cacheMutex);
-
-    for (std::list<ActionsCacheInstance>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
-        if (it->_hash == hash) {
-            ActionKey key;
-            key.time = time;
-            key.view = view;
-            key.mipMapLevel = 0;
-
-            IdentityCacheMap::const_iterator found = it->_identityCache.find(key);
-            if ( found != it->_identityCache.end() ) {
-                *inputNbIdentity = found->second.inputIdentityNb;
-                *identityTime = found->second.inputIdentityTime;
-                *inputView = found->second.inputView;
-                return true;
-            }
-
-            return false;
-        }
+    QReadLocker l(&_cacheMutex);
+    const ActionsCacheInstance* cache = findActionCache(hash);
+
+    if (!cache) {
+        return false;
+    }
+
+    ActionKey key;
+    key.time = time;
+    key.view = view;
+    key.mipMapLevel = 0;
+
+    IdentityCacheMap::const_iterator found = cache->_identityCache.find(key);
+    if ( found != cache->_identityCache.end() ) {
+        *inputNbIdentity = found->second.inputIdentityNb;
+        *identityTime = found->second.inputIdentityTime;
+        *inputView = found->second.inputView;
+
+        return true;
     }
 
     return false;
@@ -146,7 +166,7 @@ ActionsCache::setIdentityResult(U64 hash,
                                 ViewIdx inputView,
                                 double identityTime)
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
     ActionsCacheInstance & cache = getOrCreateActionCache(hash);
     ActionKey key;
 
@@ -168,24 +188,23 @@ ActionsCache::getRoDResult(U64 hash,
                            unsigned int mipMapLevel,
                            RectD* rod)
 {
-    QMutexLocker l(&_cacheMutex);
+    QReadLocker l(&_cacheMutex);
+    const ActionsCacheInstance* cache = findActionCache(hash);
 
-    for (std::list<ActionsCacheInstance>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
-        if (it->_hash == hash) {
-            ActionKey key;
-            key.time = time;
-            key.view = view;
-            key.mipMapLevel = mipMapLevel;
+    if (!cache) {
+        return false;
+    }
 
-            RoDCacheMap::const_iterator found = it->_rodCache.find(key);
-            if ( found != it->_rodCache.end() ) {
-                *rod = found->second;
+    ActionKey key;
+    key.time = time;
+    key.view = view;
+    key.mipMapLevel = mipMapLevel;
 
-                return true;
-            }
+    RoDCacheMap::const_iterator found = cache->_rodCache.find(key);
+    if ( found != cache->_rodCache.end() ) {
+        *rod = found->second;
 
-            return false;
-        }
+        return true;
     }
 
     return false;
@@ -199,7 +218,7 @@ ActionsCache::setRoDResult(U64 hash,
                            unsigned int mipMapLevel,
                            const RectD & rod)
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
     ActionsCacheInstance & cache = getOrCreateActionCache(hash);
     ActionKey key;
 
@@ -218,24 +237,23 @@ ActionsCache::getFramesNeededResult(U64 hash,
                                     unsigned int mipMapLevel,
                                     FramesNeededMap* framesNeeded)
 {
-    QMutexLocker l(&_cacheMutex);
+    QReadLocker l(&_cacheMutex);
+    const ActionsCacheInstance* cache = findActionCache(hash);
 
-    for (std::list<ActionsCacheInstance>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
-        if (it->_hash == hash) {
-            ActionKey key;
-            key.time = time;
-            key.view = view;
-            key.mipMapLevel = mipMapLevel;
+    if (!cache) {
+        return false;
+    }
 
-            FramesNeededCacheMap::const_iterator found = it->_framesNeededCache.find(key);
-            if ( found != it->_framesNeededCache.end() ) {
-                *framesNeeded = found->second;
+    ActionKey key;
+    key.time = time;
+    key.view = view;
+    key.mipMapLevel = mipMapLevel;
 
-                return true;
-            }
+    FramesNeededCacheMap::const_iterator found = cache->_framesNeededCache.find(key);
+    if ( found != cache->_framesNeededCache.end() ) {
+        *framesNeeded = found->second;
 
-            return false;
-        }
+        return true;
     }
 
     return false;
@@ -249,7 +267,7 @@ ActionsCache::setFramesNeededResult(U64 hash,
                                     unsigned int mipMapLevel,
                                     const FramesNeededMap & framesNeeded)
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
     ActionsCacheInstance & cache = getOrCreateActionCache(hash);
     ActionKey key;
 
@@ -266,18 +284,17 @@ ActionsCache::getTimeDomainResult(U64 hash,
                                   double *first,
                                   double* last)
 {
-    QMutexLocker l(&_cacheMutex);
-
-    for (std::list<ActionsCacheInstance>::iterator it = _instances.begin(); it != _instances.end(); ++it) {
-        if ( (it->_hash == hash) && it->_timeDomainSet ) {
-            *first = it->_timeDomain.min;
-            *last = it->_timeDomain.max;
+    QReadLocker l(&_cacheMutex);
+    const ActionsCacheInstance* cache = findActionCache(hash);
 
-            return true;
-        }
+    if (!cache || !cache->_timeDomainSet) {
+        return false;
     }
 
-    return false;
+    *first = cache->_timeDomain.min;
+    *last = cache->_timeDomain.max;
+
+    return true;
 }
 
 
@@ -286,7 +303,7 @@ ActionsCache::setTimeDomainResult(U64 hash,
                                   double first,
                                   double last)
 {
-    QMutexLocker l(&_cacheMutex);
+    QWriteLocker l(&_cacheMutex);
     ActionsCacheInstance & cache = getOrCreateActionCache(hash);
 
     cache._timeDomainSet = true;
@@ -492,6 +509,7 @@ EffectInstance::Implementation::waitForImageBeingRenderedElsewhereAndUnmark(cons
 
     bool ab = _publicInterface->aborted();
     {
+        TraceScope trace("waitForImageBeingRenderedElsewhere", "wait", _publicInterface);
         QMutexLocker kk(&ibr->lock);
         while (!ab && isBeingRenderedElseWhere && !ibr->renderFailed && ibr->refCount > 1) {
             ibr->cond.wait(&ibr->lock);
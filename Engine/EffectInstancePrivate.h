@@ -33,10 +33,12 @@
 
 #include <QtCore/QWaitCondition>
 #include <QtCore/QMutex>
+#include <QtCore/QReadWriteLock>
 
 #include "Global/GlobalDefines.h"
 
 #include "Engine/Image.h"
+#include "Engine/ImageResampler.h"
 #include "Engine/TLSHolder.h"
 #include "Engine/NodeMetadata.h"
 #include "Engine/ViewIdx.h"
@@ -122,10 +124,11 @@ public:
     void setTimeDomainResult(U64 hash, double first, double last);
 
 private:
-    mutable QMutex _cacheMutex; //< protects everything in the cache
+    ///Protects everything in the cache. Lookups, which are by far the most frequent operations
+    ///(once per node for every tile of every frame), only take it for reading so render threads do not serialize on it.
+    mutable QReadWriteLock _cacheMutex;
     struct ActionsCacheInstance
     {
-        U64 _hash;
         OfxRangeD _timeDomain;
         bool _timeDomainSet;
         IdentityCacheMap _identityCache;
@@ -135,11 +138,16 @@ private:
         ActionsCacheInstance();
     };
 
-    //In  a list to track the LRU
-    std::list<ActionsCacheInstance> _instances;
+    typedef std::map<U64, ActionsCacheInstance> ActionsCacheInstancesMap;
+
+    ///The instances indexed by hash
+    ActionsCacheInstancesMap _instances;
+    ///The hashes of the instances in creation order, the first one is the next to be evicted
+    std::list<U64> _instancesOrder;
     std::size_t _maxInstances;
-    std::list<ActionsCacheInstance>::iterator createActionCacheInternal(U64 newHash);
+    ActionsCacheInstance & createActionCacheInternal(U64 newHash);
     ActionsCacheInstance & getOrCreateActionCache(U64 newHash);
+    const ActionsCacheInstance* findActionCache(U64 hash) const;
 };
 
 
@@ -359,6 +367,13 @@ struct EffectInstance::Implementation
                                           const ImagePremultiplicationEnum originalImagePremultiplication,
                                           ImagePlanesToRender & planes);
     
+    /**
+     * @brief Renders the output planes of a transform effect by resampling the image upstream of the concatenated
+     * transforms with the ImageResampler. Returns false if the effect must render them itself: its transform
+     * cannot be expressed as a matrix or the images cannot be handled by the resampler.
+     **/
+    bool resampleConcatenatedTransforms(const RenderActionArgs & args, ResampleFilterEnum filter);
+
     bool aborted(const EffectDataTLSPtr& tls) const WARN_UNUSED_RETURN;
     
     void checkMetadata(NodeMetadata &metadata);
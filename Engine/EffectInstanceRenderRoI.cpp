@@ -72,6 +72,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/RotoDrawableItem.h"
 #include "Engine/Settings.h"
 #include "Engine/Timer.h"
+#include "Engine/TraceRecorder.h"
 #include "Engine/Transform.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/ViewerInstance.h"
@@ -216,6 +217,8 @@ EffectInstance::RenderRoIRetCode
 EffectInstance::renderRoI(const RenderRoIArgs & args,
                           std::map<ImageComponents,ImagePtr>* outputPlanes)
 {
+    TraceScope trace("renderRoI", "render", this);
+    
     //Do nothing if no components were requested
     if (args.components.empty()) {
         qDebug() << getScriptName_mt_safe().c_str() << "renderRoi: Early bail-out components requested empty";
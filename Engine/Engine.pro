@@ -82,8 +82,10 @@ SOURCES += \
     Cache.cpp \
     CLArgs.cpp \
     CoonsRegularization.cpp \
+    CpuTopology.cpp \
     Curve.cpp \
     CurveSerialization.cpp \
+    DamageHistory.cpp \
     DiskCacheNode.cpp \
     Dot.cpp \
     EffectInstance.cpp \
@@ -108,6 +110,7 @@ SOURCES += \
     ImageKey.cpp \
     ImageMaskMix.cpp \
     ImageParamsSerialization.cpp \
+    ImageResampler.cpp \
     Interpolation.cpp \
     JoinViewsNode.cpp \
     Knob.cpp \
@@ -119,6 +122,7 @@ SOURCES += \
     Log.cpp \
     Lut.cpp \
     MemoryFile.cpp \
+    MemoryGovernor.cpp \
     Node.cpp \
     NodeGroup.cpp \
     NodeMetadata.cpp \
@@ -134,18 +138,24 @@ SOURCES += \
     OfxMemory.cpp \
     OfxOverlayInteract.cpp \
     OfxParamInstance.cpp \
+    OfxPluginCacheFile.cpp \
+    OfxThreadPool.cpp \
     OneViewNode.cpp \
     OutputEffectInstance.cpp \
     OutputSchedulerThread.cpp \
     ParallelRenderArgs.cpp \
+    PerfReport.cpp \
+    PersistentActionsCache.cpp \
     Plugin.cpp \
     PluginMemory.cpp \
+    PluginMemoryPool.cpp \
     PrecompNode.cpp \
     ProcessHandler.cpp \
     Project.cpp \
     ProjectPrivate.cpp \
     ProjectSerialization.cpp \
     PyAppInstance.cpp \
+    PyImageBuffer.cpp \
     PyNodeGroup.cpp \
     PyNode.cpp \
     PyParameter.cpp \
@@ -154,6 +164,8 @@ SOURCES += \
     ReadNode.cpp \
     RectD.cpp \
     RectI.cpp \
+    RenderCoordinator.cpp \
+    RenderDaemon.cpp \
     RenderStats.cpp \
     RotoContext.cpp \
     RotoDrawableItem.cpp \
@@ -164,12 +176,14 @@ SOURCES += \
     RotoStrokeItem.cpp \
     ScriptObject.cpp \
     Settings.cpp \
+    SharedFrameChannel.cpp \
     StandardPaths.cpp \
     StringAnimationManager.cpp \
     TextureRect.cpp \
     TimeLine.cpp \
     Timer.cpp \
     TLSHolder.cpp \
+    TraceRecorder.cpp \
     Transform.cpp \
     ViewerInstance.cpp \
     WriteNode.cpp \
@@ -235,9 +249,11 @@ HEADERS += \
     CacheEntryHolder.h \
     CacheSerialization.h \
     CoonsRegularization.h \
+    CpuTopology.h \
     Curve.h \
     CurveSerialization.h \
     CurvePrivate.h \
+    DamageHistory.h \
     DockablePanelI.h \
     Dot.h \
     DiskCacheNode.h \
@@ -270,6 +286,7 @@ HEADERS += \
     ImageSerialization.h \
     ImageParams.h \
     ImageParamsSerialization.h \
+    ImageResampler.h \
     Interpolation.h \
     JoinViewsNode.h \
     KeyHelper.h \
@@ -285,6 +302,7 @@ HEADERS += \
     LRUHashTable.h \
     Lut.h \
     MemoryFile.h \
+    MemoryGovernor.h \
     MergingEnum.h \
     Node.h \
     NodeGroup.h \
@@ -303,14 +321,19 @@ HEADERS += \
     OfxOverlayInteract.h \
     OfxMemory.h \
     OfxParamInstance.h \
+    OfxPluginCacheFile.h \
+    OfxThreadPool.h \
     OneViewNode.h \
     OpenGLViewerI.h \
     OutputEffectInstance.h \
     OutputSchedulerThread.h \
     OverlaySupport.h \
     ParallelRenderArgs.h \
+    PerfReport.h \
+    PersistentActionsCache.h \
     Plugin.h \
     PluginMemory.h \
+    PluginMemoryPool.h \
     PrecompNode.h \
     ProcessHandler.h \
     Project.h \
@@ -318,6 +341,7 @@ HEADERS += \
     ProjectSerialization.h \
     PyAppInstance.h \
     PyGlobalFunctions.h \
+    PyImageBuffer.h \
     PyNodeGroup.h \
     PyNode.h \
     PyParameter.h \
@@ -328,6 +352,8 @@ HEADERS += \
     RectDSerialization.h \
     RectI.h \
     RectISerialization.h \
+    RenderCoordinator.h \
+    RenderDaemon.h \
     RenderStats.h \
     RotoContext.h \
     RotoContextPrivate.h \
@@ -345,6 +371,7 @@ HEADERS += \
     RotoStrokeItemSerialization.h \
     ScriptObject.h \
     Settings.h \
+    SharedFrameChannel.h \
     Singleton.h \
     StandardPaths.h \
     StringAnimationManager.h \
@@ -356,6 +383,7 @@ HEADERS += \
     Timer.h \
     TLSHolder.h \
     TLSHolderImpl.h \
+    TraceRecorder.h \
     Transform.h \
     UpdateViewerParams.h \
     Variant.h \
@@ -368,6 +396,7 @@ HEADERS += \
     ../Global/GitVersion.h \
     ../Global/GLIncludes.h \
     ../Global/GlobalDefines.h \
+    ../Global/JSONUtils.h \
     ../Global/KeySymbols.h \
     ../Global/Macros.h \
     ../Global/MemoryInfo.h \
@@ -112,7 +112,10 @@ struct CreateNodeArgs;
 class ChoiceExtraData;
 class ChoiceParam;
 class ColorParam;
+class CpuTopology;
 class Curve;
+class DamageHistory;
+class DamageRegion;
 class Dimension;
 class DockablePanelI;
 class Double2DParam;
@@ -134,6 +137,7 @@ class ImageComponents;
 class ImageKey;
 class ImageLayer;
 class ImageParams;
+class ImageResampler;
 class Int2DParam;
 class Int3DParam;
 class IntParam;
@@ -158,20 +162,26 @@ class KnobSeparator;
 class KnobSerialization;
 class KnobString;
 class LibraryBinary;
+class MemoryGovernor;
+struct MemoryStats;
 class Node;
 class NodeCollection;
 class NodeGroup;
 class NodeGraphI;
 class NodeGuiI;
 class NodeMetadata;
+class NodeRenderStats;
 class NodeSerialization;
 class NodeSettingsPanel;
 class OfxClipInstance;
 class OfxEffectInstance;
 class OfxHost;
+class OfxThreadPool;
 class OfxImage;
 class OfxImageEffectInstance;
 class OfxOverlayInteract;
+class OfxPluginCacheFile;
+class OfxPluginCacheFileHandler;
 class OfxParamOverlayInteract;
 class OfxParamToKnob;
 class OfxStringInstance;
@@ -184,9 +194,12 @@ class ParallelRenderArgsSetter;
 class Param;
 class ParametricParam;
 class PathParam;
+class PerfReport;
+class PersistentActionsCache;
 class Plugin;
 class PluginGroupNode;
 class PluginMemory;
+class PluginMemoryPool;
 class PrecompNode;
 class ProcessHandler;
 class ProcessInputChannel;
@@ -194,6 +207,7 @@ class Project;
 class ProjectSerialization;
 class RectD;
 class RectI;
+class RenderDaemon;
 class RenderEngine;
 class RenderStats;
 class RenderingFlagSetter;
@@ -209,6 +223,9 @@ class RotoPoint;
 class RotoStrokeItem;
 class SeparatorParam;
 class Settings;
+class SharedFrame;
+class SharedFrameChannel;
+struct SharedFrameInfo;
 class StringAnimationManager;
 class StringParam;
 class TLSHolderBase;
@@ -30,16 +30,34 @@
 
 #include <QMutex>
 #include <QWaitCondition>
+#include <QtCore/QThreadPool>
+#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
+#if !defined(SBK_RUN) && !defined(Q_MOC_RUN)
+#include <boost/weak_ptr.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
+#include <boost/bind.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+#endif
 
 #include "Engine/Image.h"
 
+///Number of pixels of a row whose bin indices are computed at once
+#define NATRON_HISTOGRAM_BINNING_BATCH 256
+
+///A tile is not split in chunks of less rows than this when binned in parallel
+#define NATRON_HISTOGRAM_MIN_ROWS_PER_CHUNK 32
+
+///Each final bin is computed from this number of bins, which are then smoothed and downsampled
+#define NATRON_HISTOGRAM_UPSCALE 5
+
 NATRON_NAMESPACE_ENTER;
 
 struct HistogramRequest
 {
     int binsCount;
     int mode;
-    boost::shared_ptr<Image> image;
+    std::list<boost::shared_ptr<Image> > tiles;
     RectI rect;
     double vmin;
     double vmax;
@@ -48,7 +66,7 @@ struct HistogramRequest
     HistogramRequest()
         : binsCount(0)
           , mode(0)
-          , image()
+          , tiles()
           , rect()
           , vmin(0)
           , vmax(0)
@@ -58,14 +76,14 @@ struct HistogramRequest
 
     HistogramRequest(int binsCount,
                      int mode,
-                     const boost::shared_ptr<Image> & image,
+                     const std::list<boost::shared_ptr<Image> > & tiles,
                      const RectI & rect,
                      double vmin,
                      double vmax,
                      int smoothingKernelSize)
         : binsCount(binsCount)
           , mode(mode)
-          , image(image)
+          , tiles(tiles)
           , rect(rect)
           , vmin(vmin)
           , vmax(vmax)
@@ -99,6 +117,26 @@ struct FinishedHistogram
     }
 };
 
+/**
+ * @brief The upscaled bins of the portion of a viewer tile covered by a request.
+ * They remain valid as long as the tile is not re-rendered and the histogram parameters do not change.
+ **/
+struct HistogramTileBins
+{
+    boost::weak_ptr<Image> image;
+    U64 hashKey;
+    RectI rect;
+    std::vector<unsigned int> bins;
+
+    HistogramTileBins()
+        : image()
+          , hashKey(0)
+          , rect()
+          , bins()
+    {
+    }
+};
+
 struct HistogramCPUPrivate
 {
     QWaitCondition requestCond;
@@ -110,6 +148,13 @@ struct HistogramCPUPrivate
     QMutex mustQuitMutex;
     bool mustQuit;
 
+    ///The partial histograms of the fully rendered tiles of the last request, along with the
+    ///parameters they were computed with. Only accessed by the histogram thread.
+    std::list<HistogramTileBins> tilesBins;
+    int tilesBinsMode;
+    int tilesBinsCount;
+    double tilesBinsVmin, tilesBinsVmax;
+
     HistogramCPUPrivate()
         : requestCond()
           , requestMutex()
@@ -119,8 +164,15 @@ struct HistogramCPUPrivate
           , mustQuitCond()
           , mustQuitMutex()
           , mustQuit(false)
+          , tilesBins()
+          , tilesBinsMode(-1)
+          , tilesBinsCount(0)
+          , tilesBinsVmin(0)
+          , tilesBinsVmax(0)
     {
     }
+
+    void computeTilesBins(const HistogramRequest & request, std::vector<unsigned int>* bins, int* pixelsCount);
 };
 
 HistogramCPU::HistogramCPU()
@@ -136,7 +188,7 @@ HistogramCPU::~HistogramCPU()
 
 void
 HistogramCPU::computeHistogram(int mode,      //< corresponds to the enum Histogram::DisplayModeEnum
-                               const boost::shared_ptr<Image> & image,
+                               const std::list<boost::shared_ptr<Image> > & tiles,
                                const RectI & rect,
                                int binsCount,
                                double vmin,
@@ -147,10 +199,11 @@ HistogramCPU::computeHistogram(int mode,      //< corresponds to the enum Histog
     QMutexLocker quitLocker(&_imp->mustQuitMutex);
     QMutexLocker locker(&_imp->requestMutex);
 
-    _imp->requests.push_back( HistogramRequest(binsCount,mode,image,rect,vmin,vmax,smoothingKernelSize) );
+    _imp->requests.push_back( HistogramRequest(binsCount,mode,tiles,rect,vmin,vmax,smoothingKernelSize) );
     if (!isRunning() && !_imp->mustQuit) {
         quitLocker.unlock();
-        start(HighestPriority);
+        ///The histogram must not compete with the renders for the CPU, e.g during playback
+        start(LowPriority);
     } else {
         quitLocker.unlock();
         _imp->requestCond.wakeOne();
@@ -167,7 +220,7 @@ HistogramCPU::quitAnyComputation()
 
         ///post a fake request to wakeup the thread
         l.unlock();
-        computeHistogram(0, boost::shared_ptr<Image>(), RectI(), 0,0,0,0);
+        computeHistogram(0, std::list<boost::shared_ptr<Image> >(), RectI(), 0,0,0,0);
         l.relock();
         while (_imp->mustQuit) {
             _imp->mustQuitCond.wait(&_imp->mustQuitMutex);
@@ -217,77 +270,253 @@ HistogramCPU::getMostRecentlyProducedHistogram(std::vector<float>* histogram1,
     return true;
 }
 
-///putting these in an anonymous namespace will yield this error on gcc 4.2:
-///"function has not external linkage"
-struct pix_red
+/// keep the mode parameter in sync with Histogram::DisplayModeEnum
+static int
+getHistogramsCount(int mode)
 {
-    static float val(const float *pix)
-    {
-        return pix[0];
-    }
-};
+    return mode == 0 ? 3 : 1;
+}
 
-struct pix_green
+/**
+ * @brief Returns the index of the component read by the given single channel mode (1 = A, 3 = R, 4 = G, 5 = B)
+ * in an image with nComps components, or -1 if the image does not have this channel.
+ **/
+static int
+getChannelIndex(int mode,
+                int nComps)
 {
-    static float val(const float *pix)
-    {
-        return pix[1];
+    if (nComps == 1) {
+        return mode == 1 ? 0 : -1;
     }
-};
+    switch (mode) {
+    case 1:
+        return nComps == 4 ? 3 : -1;
+    case 3:
+        return 0;
+    case 4:
+        return 1;
+    case 5:
+        return nComps >= 3 ? 2 : -1;
+    default:
+        return -1;
+    }
+}
 
-struct pix_blue
+/**
+ * @brief Adds count values to the bins of one histogram. The bin indices are first computed in a
+ * branch-free loop that the compiler can vectorize: values outside of [vmin,vmax) (and NaNs) are sent
+ * to the extra bin at index binsCount, which is discarded afterwards.
+ **/
+static void
+binValues(const float* values,
+          int count,
+          float vmin,
+          float scale,
+          int binsCount,
+          unsigned int* bins)
 {
-    static float val(const float *pix)
-    {
-        return pix[2];
+    int indices[NATRON_HISTOGRAM_BINNING_BATCH];
+    const float range = (float)binsCount;
+
+    assert(count <= NATRON_HISTOGRAM_BINNING_BATCH);
+    for (int i = 0; i < count; ++i) {
+        float f = (values[i] - vmin) * scale;
+        f = (f >= 0.f && f < range) ? f : range;
+        indices[i] = (int)f;
+    }
+    for (int i = 0; i < count; ++i) {
+        ++bins[indices[i]];
     }
+}
+
+struct HistogramBinningArgs
+{
+    int mode;
+    int binsCount; //< upscaled bins count, not including the extra bin
+    float vmin;
+    float scale;
 };
 
-struct pix_alpha
+struct HistogramChunk
 {
-    static float val(const float *pix)
-    {
-        return pix[3];
-    }
+    boost::shared_ptr<Image> image;
+    RectI rect;
+    int tileIndex;
 };
 
-struct pix_lum
+/**
+ * @brief Computes the upscaled bins of a chunk of a tile. The bins of each histogram are stored one after the other,
+ * each histogram having an extra bin for the out of range values.
+ **/
+static std::vector<unsigned int>
+binChunk(const HistogramBinningArgs & args,
+         const HistogramChunk & chunk)
 {
-    static float val(const float *pix)
-    {
-        return 0.299 * pix[0] + 0.587 * pix[1] + 0.114 * pix[2];
+    const int nHistos = getHistogramsCount(args.mode);
+    const int stride = args.binsCount + 1;
+    std::vector<unsigned int> bins(nHistos * stride, 0);
+
+    ///Images come from the viewer which is in float.
+    assert(chunk.image->getBitDepth() == eImageBitDepthFloat);
+    if (chunk.image->getBitDepth() != eImageBitDepthFloat) {
+        return bins;
     }
-};
 
+    const int nComps = (int)chunk.image->getComponentsCount();
+    int channels[3];
+    for (int h = 0; h < nHistos; ++h) {
+        ///if the mode is RGB, each histogram reads R, G or B
+        channels[h] = args.mode == 2 ? -1 : getChannelIndex(nHistos == 3 ? h + 3 : args.mode, nComps);
+    }
+    const bool lum = args.mode == 2;
+    if (lum && nComps < 3) {
+        return bins;
+    }
+
+    float values[NATRON_HISTOGRAM_BINNING_BATCH];
+    Image::ReadAccess acc = chunk.image->getReadRights();
+    for (int y = chunk.rect.bottom(); y < chunk.rect.top(); ++y) {
+        for (int x = chunk.rect.left(); x < chunk.rect.right(); x += NATRON_HISTOGRAM_BINNING_BATCH) {
+            const int count = std::min(NATRON_HISTOGRAM_BINNING_BATCH, chunk.rect.right() - x);
+            const float *pix = (const float*)acc.pixelAt(x, y);
+            assert(pix);
+            for (int h = 0; h < nHistos; ++h) {
+                if (lum) {
+                    for (int i = 0; i < count; ++i) {
+                        const float* p = pix + i * nComps;
+                        values[i] = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+                    }
+                } else {
+                    const int c = channels[h];
+                    if (c < 0) {
+                        continue;
+                    }
+                    for (int i = 0; i < count; ++i) {
+                        values[i] = pix[i * nComps + c];
+                    }
+                }
+                binValues(values, count, args.vmin, args.scale, args.binsCount, &bins[h * stride]);
+            }
+        }
+    }
+
+    return bins;
+} // binChunk
 
-template <float pix_func(const float*)>
 void
-computeHisto(const HistogramRequest & request,
-             int upscale,
-             std::vector<float> *histo)
+HistogramCPUPrivate::computeTilesBins(const HistogramRequest & request,
+                                      std::vector<unsigned int>* bins,
+                                      int* pixelsCount)
 {
-    assert(histo);
-    histo->resize(request.binsCount * upscale);
-    std::fill(histo->begin(), histo->end(), 0.f);
-    double binSize = (request.vmax - request.vmin) / histo->size();
+    HistogramBinningArgs args;
+    args.mode = request.mode;
+    args.binsCount = request.binsCount * NATRON_HISTOGRAM_UPSCALE;
+    args.vmin = request.vmin;
+    args.scale = request.vmax > request.vmin ? args.binsCount / (request.vmax - request.vmin) : 0.;
+
+    const int nHistos = getHistogramsCount(request.mode);
+    const int stride = args.binsCount + 1;
+    bins->assign(nHistos * stride, 0);
+    *pixelsCount = 0;
+
+    ///The partial histograms are only valid for the parameters they were computed with
+    if ( (tilesBinsMode != request.mode) || (tilesBinsCount != args.binsCount) ||
+         (tilesBinsVmin != request.vmin) || (tilesBinsVmax != request.vmax) ) {
+        tilesBins.clear();
+        tilesBinsMode = request.mode;
+        tilesBinsCount = args.binsCount;
+        tilesBinsVmin = request.vmin;
+        tilesBinsVmax = request.vmax;
+    }
 
-    ///Images come from the viewer which is in float.
-    assert(request.image->getBitDepth() == eImageBitDepthFloat);
+    ///The same image may be shared by several viewer tiles
+    std::vector<boost::shared_ptr<Image> > images;
+    for (std::list<boost::shared_ptr<Image> >::const_iterator it = request.tiles.begin(); it != request.tiles.end(); ++it) {
+        if ( *it && ( std::find(images.begin(), images.end(), *it) == images.end() ) ) {
+            images.push_back(*it);
+        }
+    }
 
-    Image::ReadAccess acc = request.image->getReadRights();
-    
-    for (int y = request.rect.bottom(); y < request.rect.top(); ++y) {
-        for (int x = request.rect.left(); x < request.rect.right(); ++x) {
-            const float *pix = (const float*)acc.pixelAt(x, y);
-            float v = pix_func(pix);
-            if ( (request.vmin <= v) && (v < request.vmax) ) {
-                int index = (int)( (v - request.vmin) / binSize );
-                assert( 0 <= index && index < (int)histo->size() );
-                (*histo)[index] += 1.f;
+    int availableThreads = QThreadPool::globalInstance()->maxThreadCount() - QThreadPool::globalInstance()->activeThreadCount();
+
+    std::vector<HistogramTileBins> newTilesBins( images.size() );
+    std::vector<bool> tileCacheable( images.size(), false );
+    std::vector<HistogramChunk> chunks;
+    for (std::size_t i = 0; i < images.size(); ++i) {
+        HistogramTileBins & tile = newTilesBins[i];
+        if ( !images[i]->getBounds().intersect(request.rect, &tile.rect) ) {
+            continue;
+        }
+        tile.image = images[i];
+        tile.hashKey = images[i]->getHashKey();
+        *pixelsCount += tile.rect.area();
+
+        for (std::list<HistogramTileBins>::iterator it = tilesBins.begin(); it != tilesBins.end(); ++it) {
+            if ( (it->image.lock() == images[i]) && (it->hashKey == tile.hashKey) && (it->rect == tile.rect) ) {
+                tile.bins.swap(it->bins);
+                tilesBins.erase(it);
+                break;
+            }
+        }
+        ///Only the tiles that are fully rendered will not change anymore
+        std::list<RectI> restToRender;
+        images[i]->getRestToRender(tile.rect, restToRender);
+        tileCacheable[i] = restToRender.empty();
+        if ( !tile.bins.empty() ) {
+            continue;
+        }
+
+        ///Split the tile in chunks that are binned concurrently by the idle threads of the pool
+        int nChunks = std::max( 1, std::min(availableThreads, tile.rect.height() / NATRON_HISTOGRAM_MIN_ROWS_PER_CHUNK) );
+        std::vector<RectI> splits = tile.rect.splitIntoSmallerRects(nChunks);
+        for (std::size_t c = 0; c < splits.size(); ++c) {
+            HistogramChunk chunk;
+            chunk.image = images[i];
+            chunk.rect = splits[c];
+            chunk.tileIndex = (int)i;
+            chunks.push_back(chunk);
+        }
+    }
+
+    std::vector<std::vector<unsigned int> > chunksBins;
+    if ( (chunks.size() > 1) && (availableThreads > 1) ) {
+        QFuture<std::vector<unsigned int> > future = QtConcurrent::mapped( chunks, boost::bind(&binChunk, boost::cref(args), _1) );
+        future.waitForFinished();
+        for (QFuture<std::vector<unsigned int> >::const_iterator it = future.begin(); it != future.end(); ++it) {
+            chunksBins.push_back(*it);
+        }
+    } else {
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            chunksBins.push_back( binChunk(args, chunks[c]) );
+        }
+    }
+    assert( chunksBins.size() == chunks.size() );
+    for (std::size_t c = 0; c < chunks.size(); ++c) {
+        std::vector<unsigned int> & tileBins = newTilesBins[chunks[c].tileIndex].bins;
+        if ( tileBins.empty() ) {
+            tileBins.swap(chunksBins[c]);
+        } else {
+            for (std::size_t b = 0; b < tileBins.size(); ++b) {
+                tileBins[b] += chunksBins[c][b];
             }
         }
     }
-}
+
+    tilesBins.clear();
+    for (std::size_t i = 0; i < newTilesBins.size(); ++i) {
+        const std::vector<unsigned int> & tileBins = newTilesBins[i].bins;
+        if ( tileBins.empty() ) {
+            continue;
+        }
+        assert( tileBins.size() == bins->size() );
+        for (std::size_t b = 0; b < tileBins.size(); ++b) {
+            (*bins)[b] += tileBins[b];
+        }
+        if (tileCacheable[i]) {
+            tilesBins.push_back(newTilesBins[i]);
+        }
+    }
+} // computeTilesBins
 
 /// IIR Gaussian filter: recursive implementation.
 
@@ -425,12 +654,16 @@ iir_1d_filter(SrcIterator src,
     }
 } // iir_1d_filter
 
+/**
+ * @brief Smooths the upscaled bins of the given histogram and downsamples them to obtain the final histogram.
+ **/
 static void
 computeHistogramStatic(const HistogramRequest & request,
+                       const std::vector<unsigned int> & bins,
                        boost::shared_ptr<FinishedHistogram> ret,
                        int histogramIndex)
 {
-    const int upscale = 5;
+    const int upscale = NATRON_HISTOGRAM_UPSCALE;
     std::vector<float> *histo = 0;
 
     switch (histogramIndex) {
@@ -451,39 +684,11 @@ computeHistogramStatic(const HistogramRequest & request,
         return;
     }
 
-    /// keep the mode parameter in sync with Histogram::DisplayModeEnum
-
-    int mode = request.mode;
-
-    ///if the mode is RGB, adjust the mode to either R,G or B depending on the histogram index
-    if (mode == 0) {
-        mode = histogramIndex + 2;
-    }
-
-    ret->pixelsCount = request.rect.area();
-    // a histogram with upscale more bins
-    std::vector<float> histo_upscaled;
-    switch (mode) {
-    case 1:     //< A
-        computeHisto<&pix_alpha::val>(request, upscale, &histo_upscaled);
-        break;
-    case 2:     //<Y
-        computeHisto<&pix_lum::val>(request, upscale, &histo_upscaled);
-        break;
-    case 3:     //< R
-        computeHisto<&pix_red::val>(request, upscale, &histo_upscaled);
-        break;
-    case 4:     //< G
-        computeHisto<&pix_green::val>(request, upscale, &histo_upscaled);
-        break;
-    case 5:     //< B
-        computeHisto<&pix_blue::val>(request, upscale, &histo_upscaled);
-        break;
+    // a histogram with upscale more bins, without the extra bin of the out of range values
+    const int upscaledCount = request.binsCount * upscale;
+    std::vector<unsigned int>::const_iterator first = bins.begin() + (histogramIndex - 1) * (upscaledCount + 1);
+    std::vector<float> histo_upscaled(first, first + upscaledCount);
 
-    default:
-        assert(false);
-        break;
-    }
     double sigma = upscale;
     if (request.smoothingKernelSize > 1) {
         sigma *= request.smoothingKernelSize;
@@ -543,25 +748,20 @@ HistogramCPU::run()
         ret->mode = request.mode;
         ret->vmin = request.vmin;
         ret->vmax = request.vmax;
-        ret->mipMapLevel = request.image->getMipMapLevel();
-
-
-        switch (request.mode) {
-        case 0:     //< RGB
-            computeHistogramStatic(request, ret, 1);
-            computeHistogramStatic(request, ret, 2);
-            computeHistogramStatic(request, ret, 3);
-            break;
-        case 1:
-        case 2:
-        case 3:
-        case 4:
-        case 5:
-            computeHistogramStatic(request, ret, 1);
-            break;
-        default:
+        ret->mipMapLevel = request.tiles.empty() ? 0 : request.tiles.front()->getMipMapLevel();
+
+        if ( (request.mode < 0) || (request.mode > 5) ) {
             assert(false);     //< unknown case.
-            break;
+            continue;
+        }
+        if (request.binsCount <= 0) {
+            continue;
+        }
+
+        std::vector<unsigned int> bins;
+        _imp->computeTilesBins(request, &bins, &ret->pixelsCount);
+        for (int i = 1; i <= getHistogramsCount(request.mode); ++i) {
+            computeHistogramStatic(request, bins, ret, i);
         }
 
 
@@ -26,6 +26,7 @@
 // ***** END PYTHON BLOCK *****
 
 #include <vector>
+#include <list>
 #include <QThread>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
@@ -51,8 +52,13 @@ public:
 
     virtual ~HistogramCPU();
 
+    /**
+     * @brief Requests a histogram of the given rectangle of the viewer tiles.
+     * The tiles are binned in parallel, and the partial histogram of each tile is kept so
+     * that the next request with the same parameters only has to bin the tiles that changed.
+     **/
     void computeHistogram(int mode, //< corresponds to the enum Histogram::DisplayModeEnum
-                          const boost::shared_ptr<Image> & image,
+                          const std::list<boost::shared_ptr<Image> > & tiles,
                           const RectI & rect,
                           int binsCount,
                           double vmin,
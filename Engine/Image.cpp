@@ -27,6 +27,7 @@
 #include <algorithm> // min, max
 #include <cassert>
 #include <stdexcept>
+#include <vector>
 
 #include <QDebug>
 
@@ -39,171 +40,323 @@ NATRON_NAMESPACE_ENTER;
 
 #define PIXEL_UNAVAILABLE 2
 
-template <int trimap>
-RectI minimalNonMarkedBbox_internal(const RectI& roi, const RectI& _bounds,const std::vector<char>& _map,
-                                    bool* isBeingRenderedElsewhere)
+// Tiles of the Bitmap are NATRON_BITMAP_TILE_SIZE x NATRON_BITMAP_TILE_SIZE pixels, aligned on the bottom-left corner of its bounds
+#define NATRON_BITMAP_TILE_SIZE_LOG2 6
+#define NATRON_BITMAP_TILE_SIZE (1 << NATRON_BITMAP_TILE_SIZE_LOG2)
+
+// State of a tile whose pixels do not all have the same value
+#define BITMAP_TILE_MIXED 3
+
+// Bit representing a pixel value in the masks used to scan the bitmap
+#define BM_BIT(v) ( 1 << (v) )
+
+void
+Bitmap::initializeTiles(char state)
 {
-    RectI bbox;
-    assert(_bounds.contains(roi));
-    bbox = roi;
-    
-    //find bottom
-    for (int i = bbox.bottom(); i < bbox.top(); ++i) {
-        const char* buf = BM_GET(i, bbox.left());
-        
-        if (trimap) {
-            
-            const char* lineEnd = buf + bbox.width();
-            bool metUnavailablePixel = false;
-            while (buf < lineEnd) {
-                if (!*buf) {
-                    buf = 0;
-                    break;
-                } else if (*buf == PIXEL_UNAVAILABLE) {
-                    metUnavailablePixel = true;
-                }
-                ++buf;
-            }
-            if (!buf) {
-                break;
-            } else if (metUnavailablePixel) {
-                *isBeingRenderedElsewhere = true; //< only flag if the whole row is not 0
-                ++bbox.y1;
-            } else {
-                ++bbox.y1;
+    if ( _bounds.isNull() ) {
+        _tilesPerRow = 0;
+        _tiles.clear();
+        return;
+    }
+    _tilesPerRow = ( _bounds.width() + NATRON_BITMAP_TILE_SIZE - 1 ) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int tilesPerColumn = ( _bounds.height() + NATRON_BITMAP_TILE_SIZE - 1 ) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    _tiles.assign(_tilesPerRow * tilesPerColumn, state);
+}
+
+RectI
+Bitmap::getTileRect(int tx, int ty) const
+{
+    RectI ret;
+    ret.x1 = _bounds.x1 + (tx << NATRON_BITMAP_TILE_SIZE_LOG2);
+    ret.y1 = _bounds.y1 + (ty << NATRON_BITMAP_TILE_SIZE_LOG2);
+    ret.x2 = std::min(ret.x1 + NATRON_BITMAP_TILE_SIZE, _bounds.x2);
+    ret.y2 = std::min(ret.y1 + NATRON_BITMAP_TILE_SIZE, _bounds.y2);
+    return ret;
+}
+
+char
+Bitmap::computeTileState(const RectI& tileRect) const
+{
+    const char* buf = BM_GET(tileRect.bottom(), tileRect.left());
+    const char state = *buf;
+    int w = _bounds.width();
+    int tilew = tileRect.width();
+    for (int i = tileRect.y1; i < tileRect.y2; ++i, buf += w) {
+        for (int j = 0; j < tilew; ++j) {
+            if (buf[j] != state) {
+                return BITMAP_TILE_MIXED;
             }
-        } else {
-            
-            const char* lineEnd = buf + bbox.width();
-            while (buf < lineEnd) {
-                if (!*buf || *buf == PIXEL_UNAVAILABLE) {
-                    buf = 0;
-                    break;
-                }
-                ++buf;
+        }
+    }
+    return state;
+}
+
+void
+Bitmap::setTilesState(const RectI& roi, char value)
+{
+    if ( roi.isNull() ) {
+        return;
+    }
+    int tx1 = (roi.x1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int tx2 = (roi.x2 - 1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty1 = (roi.y1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty2 = (roi.y2 - 1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    for (int ty = ty1; ty <= ty2; ++ty) {
+        for (int tx = tx1; tx <= tx2; ++tx) {
+            char& state = _tiles[ty * _tilesPerRow + tx];
+            RectI tileRect = getTileRect(tx, ty);
+            if ( roi.contains(tileRect) ) {
+                state = value;
+            } else if (state != value) {
+                ///The tile is partially covered, only its pixels can tell whether it became uniform
+                state = computeTileState(tileRect);
             }
-            if (!buf) {
-                break;
-            } else {
-                ++bbox.y1;
+        }
+    }
+}
+
+void
+Bitmap::refreshTilesState(const RectI& roi)
+{
+    RectI realRoi;
+    if ( !roi.intersect(_bounds, &realRoi) ) {
+        return;
+    }
+    int tx1 = (realRoi.x1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int tx2 = (realRoi.x2 - 1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty1 = (realRoi.y1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty2 = (realRoi.y2 - 1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    for (int ty = ty1; ty <= ty2; ++ty) {
+        for (int tx = tx1; tx <= tx2; ++tx) {
+            _tiles[ty * _tilesPerRow + tx] = computeTileState( getTileRect(tx, ty) );
+        }
+    }
+}
+
+int
+Bitmap::getMixedTilesCount() const
+{
+    return (int)std::count(_tiles.begin(), _tiles.end(), (char)BITMAP_TILE_MIXED);
+}
+
+/*
+ * The functions below scan a portion of the bitmap in a given order and stop on the first value which is in stopMask.
+ * Values met before are or'ed into *seen. Uniform tiles are handled at once, only mixed tiles are read pixel by pixel.
+ */
+
+bool
+Bitmap::areTilesFree(const RectI& rect, int stopMask, int* seen) const
+{
+    if ( rect.isNull() ) {
+        return true;
+    }
+    int tx1 = (rect.x1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int tx2 = (rect.x2 - 1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty1 = (rect.y1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int ty2 = (rect.y2 - 1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    for (int ty = ty1; ty <= ty2; ++ty) {
+        const char* tile = &_tiles[ty * _tilesPerRow + tx1];
+        for (int tx = tx1; tx <= tx2; ++tx, ++tile) {
+            if ( (*tile == BITMAP_TILE_MIXED) || (stopMask & BM_BIT(*tile)) ) {
+                return false;
             }
+            *seen |= BM_BIT(*tile);
         }
     }
-    
-    //find top (will do zero iteration if the bbox is already empty)
-    for (int i = bbox.top() - 1; i >= bbox.bottom(); --i) {
-        const char* buf = BM_GET(i, bbox.left());
-        
-        if (trimap) {
-            
-            const char* lineEnd = buf + bbox.width();
-            bool metUnavailablePixel = false;
-            while (buf < lineEnd) {
-                if (!*buf) {
-                    buf = 0;
-                    break;
-                } else if (*buf == PIXEL_UNAVAILABLE) {
-                    metUnavailablePixel = true;
+    return true;
+}
+
+int
+Bitmap::scanRow(int y, int x1, int x2, int stopMask, int* seen) const
+{
+    const char* tiles = &_tiles[( (y - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2 ) * _tilesPerRow];
+    int x = x1;
+    while (x < x2) {
+        int tx = (x - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+        int tileEnd = std::min(x2, _bounds.x1 + ( (tx + 1) << NATRON_BITMAP_TILE_SIZE_LOG2 ) );
+        char state = tiles[tx];
+        if (state != BITMAP_TILE_MIXED) {
+            if ( stopMask & BM_BIT(state) ) {
+                return state;
+            }
+            *seen |= BM_BIT(state);
+        } else {
+            const char* buf = BM_GET(y, x);
+            const char* end = buf + (tileEnd - x);
+            for (; buf < end; ++buf) {
+                if ( stopMask & BM_BIT(*buf) ) {
+                    return *buf;
                 }
-                ++buf;
+                *seen |= BM_BIT(*buf);
             }
-            if (!buf) {
-                break;
-            } else if (metUnavailablePixel) {
-                *isBeingRenderedElsewhere = true; //< only flag if the whole row is not 0
-                --bbox.y2;
-            } else {
-                --bbox.y2;
+        }
+        x = tileEnd;
+    }
+    return -1;
+}
+
+int
+Bitmap::scanColumn(int x, int y1, int y2, int stopMask, int* seen) const
+{
+    int tx = (x - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+    int w = _bounds.width();
+    int y = y1;
+    while (y < y2) {
+        int ty = (y - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+        int tileEnd = std::min(y2, _bounds.y1 + ( (ty + 1) << NATRON_BITMAP_TILE_SIZE_LOG2 ) );
+        char state = _tiles[ty * _tilesPerRow + tx];
+        if (state != BITMAP_TILE_MIXED) {
+            if ( stopMask & BM_BIT(state) ) {
+                return state;
             }
-            
+            *seen |= BM_BIT(state);
         } else {
-            
-            const char* lineEnd = buf + bbox.width();
-            while (buf < lineEnd) {
-                if (!*buf || *buf == PIXEL_UNAVAILABLE) {
-                    buf = 0;
-                    break;
+            const char* pix = BM_GET(y, x);
+            for (int i = y; i < tileEnd; ++i, pix += w) {
+                if ( stopMask & BM_BIT(*pix) ) {
+                    return *pix;
                 }
-                ++buf;
-            }
-            if (!buf) {
-                break;
-            } else {
-                --bbox.y2;
+                *seen |= BM_BIT(*pix);
             }
         }
+        y = tileEnd;
     }
-    
-    // avoid making bbox.width() iterations for nothing
-    if ( bbox.isNull() ) {
-        return bbox;
-    }
-    
-    //find left
-    for (int j = bbox.left(); j < bbox.right(); ++j) {
-        const char* pix = BM_GET(bbox.bottom(), j);
+    return -1;
+}
 
-        bool metUnavailablePixel = false;
+/**
+ * @brief Returns the number of consecutive rows of rect, starting from the bottom (or the top if fromTop is true),
+ * which do not contain any value of stopMask.
+ * If flagPassedUnavailable is true, isBeingRenderedElsewhere is set if one of these rows contains PIXEL_UNAVAILABLE.
+ * If flagStoppedUnavailable is true, isBeingRenderedElsewhere is set if the scan stopped on PIXEL_UNAVAILABLE.
+ * Whole bands of uniform tiles are skipped without reading any row.
+ **/
+int
+Bitmap::countFreeRows(const RectI& rect, bool fromTop, int stopMask,
+                      bool flagPassedUnavailable, bool flagStoppedUnavailable, bool* isBeingRenderedElsewhere) const
+{
+    int count = 0;
+    int nRows = rect.height();
+    while (count < nRows) {
+        // the band of rows up to the next tile boundary
+        int bandY1, bandY2;
+        if (!fromTop) {
+            bandY1 = rect.y1 + count;
+            int ty = (bandY1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+            bandY2 = std::min(rect.y2, _bounds.y1 + ( (ty + 1) << NATRON_BITMAP_TILE_SIZE_LOG2 ) );
+        } else {
+            bandY2 = rect.y2 - count;
+            int ty = (bandY2 - 1 - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+            bandY1 = std::max(rect.y1, _bounds.y1 + (ty << NATRON_BITMAP_TILE_SIZE_LOG2) );
+        }
 
-        for (int i = bbox.bottom(); i < bbox.top(); ++i, pix += _bounds.width()) {
-            if (!*pix) {
-                pix = 0;
-                break;
+        int seen = 0;
+        if ( areTilesFree(RectI(rect.x1, bandY1, rect.x2, bandY2), stopMask, &seen) ) {
+            if ( flagPassedUnavailable && (seen & BM_BIT(PIXEL_UNAVAILABLE)) ) {
+                *isBeingRenderedElsewhere = true;
             }
-            
-            else if (*pix == PIXEL_UNAVAILABLE) {
-                if (trimap) {
-                    metUnavailablePixel = true;
-                } else {
-                    pix = 0;
-                    break;
+            count += bandY2 - bandY1;
+            continue;
+        }
+
+        int bandHeight = bandY2 - bandY1;
+        for (int k = 0; k < bandHeight; ++k) {
+            int y = fromTop ? bandY2 - 1 - k : bandY1 + k;
+            seen = 0;
+            int stopValue = scanRow(y, rect.x1, rect.x2, stopMask, &seen);
+            if (stopValue != -1) {
+                if (flagStoppedUnavailable && stopValue == PIXEL_UNAVAILABLE) {
+                    *isBeingRenderedElsewhere = true;
                 }
+                return count;
             }
-            
-        }
-        if (pix) {
-            ++bbox.x1;
-            if (trimap && metUnavailablePixel) {
-                *isBeingRenderedElsewhere = true; //< only flag is the whole column is not 0
+            if ( flagPassedUnavailable && (seen & BM_BIT(PIXEL_UNAVAILABLE)) ) {
+                *isBeingRenderedElsewhere = true;
             }
-        } else {
-            break;
+            ++count;
         }
     }
-    
-    //find right
-    for (int j = bbox.right() - 1; j >= bbox.left(); --j) {
-        const char* pix = BM_GET(bbox.bottom(), j);
+    return count;
+}
 
-        bool metUnavailablePixel = false;
+///Same as countFreeRows for the columns of rect, starting from the left (or the right if fromRight is true)
+int
+Bitmap::countFreeColumns(const RectI& rect, bool fromRight, int stopMask,
+                         bool flagPassedUnavailable, bool flagStoppedUnavailable, bool* isBeingRenderedElsewhere) const
+{
+    int count = 0;
+    int nCols = rect.width();
+    while (count < nCols) {
+        // the band of columns up to the next tile boundary
+        int bandX1, bandX2;
+        if (!fromRight) {
+            bandX1 = rect.x1 + count;
+            int tx = (bandX1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+            bandX2 = std::min(rect.x2, _bounds.x1 + ( (tx + 1) << NATRON_BITMAP_TILE_SIZE_LOG2 ) );
+        } else {
+            bandX2 = rect.x2 - count;
+            int tx = (bandX2 - 1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+            bandX1 = std::max(rect.x1, _bounds.x1 + (tx << NATRON_BITMAP_TILE_SIZE_LOG2) );
+        }
 
-        for (int i = bbox.bottom(); i < bbox.top(); ++i, pix += _bounds.width()) {
-            if (!*pix) {
-                pix = 0;
-                break;
+        int seen = 0;
+        if ( areTilesFree(RectI(bandX1, rect.y1, bandX2, rect.y2), stopMask, &seen) ) {
+            if ( flagPassedUnavailable && (seen & BM_BIT(PIXEL_UNAVAILABLE)) ) {
+                *isBeingRenderedElsewhere = true;
             }
+            count += bandX2 - bandX1;
+            continue;
+        }
 
-            else if (*pix == PIXEL_UNAVAILABLE) {
-                if (trimap) {
-                    metUnavailablePixel = true;
-                } else {
-                    pix = 0;
-                    break;
+        int bandWidth = bandX2 - bandX1;
+        for (int k = 0; k < bandWidth; ++k) {
+            int x = fromRight ? bandX2 - 1 - k : bandX1 + k;
+            seen = 0;
+            int stopValue = scanColumn(x, rect.y1, rect.y2, stopMask, &seen);
+            if (stopValue != -1) {
+                if (flagStoppedUnavailable && stopValue == PIXEL_UNAVAILABLE) {
+                    *isBeingRenderedElsewhere = true;
                 }
+                return count;
             }
-
-        }
-        if (pix) {
-            --bbox.x2;
-            if (trimap && metUnavailablePixel) {
-                *isBeingRenderedElsewhere = true; //< only flag is the whole column is not 0
+            if ( flagPassedUnavailable && (seen & BM_BIT(PIXEL_UNAVAILABLE)) ) {
+                *isBeingRenderedElsewhere = true;
             }
-
-        } else {
-            break;
+            ++count;
         }
     }
-    
+    return count;
+}
+
+template <int trimap>
+RectI
+Bitmap::minimalNonMarkedBbox_internal(const RectI& roi, bool* isBeingRenderedElsewhere) const
+{
+    RectI bbox;
+    assert(_bounds.contains(roi));
+    bbox = roi;
+
+    // A row or a column is removed from the bbox if it is fully rendered. With the trimap, pixels being
+    // rendered elsewhere count as rendered, but we flag them.
+    const int stopMask = trimap ? BM_BIT(0) : ( BM_BIT(0) | BM_BIT(PIXEL_UNAVAILABLE) );
+
+    //find bottom
+    bbox.y1 += countFreeRows(bbox, false, stopMask, trimap, false, isBeingRenderedElsewhere);
+
+    //find top (will do zero iteration if the bbox is already empty)
+    bbox.y2 -= countFreeRows(bbox, true, stopMask, trimap, false, isBeingRenderedElsewhere);
+
+    // avoid making bbox.width() iterations for nothing
+    if ( bbox.isNull() ) {
+        return bbox;
+    }
+
+    //find left
+    bbox.x1 += countFreeColumns(bbox, false, stopMask, trimap, false, isBeingRenderedElsewhere);
+
+    //find right
+    bbox.x2 -= countFreeColumns(bbox, true, stopMask, trimap, false, isBeingRenderedElsewhere);
+
     return bbox;
 
 }
@@ -211,8 +364,7 @@ RectI minimalNonMarkedBbox_internal(const RectI& roi, const RectI& _bounds,const
 
 template <int trimap>
 void
-minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std::vector<char>& _map,
-                               std::list<RectI>& ret,bool* isBeingRenderedElsewhere)
+Bitmap::minimalNonMarkedRects_internal(const RectI & roi, std::list<RectI>& ret, bool* isBeingRenderedElsewhere) const
 {
     ///Any out of bounds portion is pushed to the rectangles to render
     RectI intersection;
@@ -247,7 +399,7 @@ minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std
         return;
     }
     
-    RectI bboxM = minimalNonMarkedBbox_internal<trimap>(intersection, _bounds, _map, isBeingRenderedElsewhere);
+    RectI bboxM = minimalNonMarkedBbox_internal<trimap>(intersection, isBeingRenderedElsewhere);
     assert((trimap && isBeingRenderedElsewhere) || (!trimap && !isBeingRenderedElsewhere));
     
     //#define NATRON_BITMAP_DISABLE_OPTIMIZATION
@@ -280,46 +432,18 @@ minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std
     // CXXXXXXXXXXDDD
     // CXXXXXXXXXXDDD
     // AAAAAAAAAAAAAA
-    
+
+    // A row or a column belongs to A, B, C or D if it has nothing rendered. With the trimap, we stop
+    // on pixels being rendered elsewhere and flag them.
+    const int stopMask = trimap ? ( BM_BIT(1) | BM_BIT(PIXEL_UNAVAILABLE) ) : BM_BIT(1);
+
     // First, find if there's an "A" rectangle, and push it to the result
     //find bottom
     RectI bboxX = bboxM;
     RectI bboxA = bboxX;
     bboxA.set_top( bboxX.bottom() );
-    for (int i = bboxX.bottom(); i < bboxX.top(); ++i) {
-        const char* buf = BM_GET(i, bboxX.left());
-        if (trimap) {
-            const char* lineEnd = buf + bboxX.width();
-            bool metUnavailablePixel = false;
-            while (buf < lineEnd) {
-                if (*buf == 1) {
-                    buf = 0;
-                    break;
-                } else if (*buf == PIXEL_UNAVAILABLE && trimap) {
-                    buf = 0;
-                    metUnavailablePixel = true;
-                    break;
-                }
-                ++buf;
-            }
-            if (buf) {
-                ++bboxX.y1;
-                bboxA.y2 = bboxX.y1;
-            } else {
-                if (metUnavailablePixel) {
-                    *isBeingRenderedElsewhere = true;
-                }
-                break;
-            }
-        } else {
-            if ( !memchr( buf, 1, bboxX.width() ) ) {
-                ++bboxX.y1;
-                bboxA.y2 = bboxX.y1;
-            } else {
-                break;
-            }
-        }
-    }
+    bboxX.y1 += countFreeRows(bboxX, false, stopMask, false, trimap, isBeingRenderedElsewhere);
+    bboxA.y2 = bboxX.y1;
     if ( !bboxA.isNull() ) { // empty boxes should not be pushed
         ret.push_back(bboxA);
     }
@@ -328,111 +452,31 @@ minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std
     //find top
     RectI bboxB = bboxX;
     bboxB.set_bottom( bboxX.top() );
-    for (int i = bboxX.top() - 1; i >= bboxX.bottom(); --i) {
-        const char* buf = BM_GET(i, bboxX.left());
-        
-        if (trimap) {
-            const char* lineEnd = buf + bboxX.width();
-            bool metUnavailablePixel = false;
-            while (buf < lineEnd) {
-                if (*buf == 1) {
-                    buf = 0;
-                    break;
-                } else if (*buf == PIXEL_UNAVAILABLE && trimap) {
-                    buf = 0;
-                    metUnavailablePixel = true;
-                    break;
-                }
-                ++buf;
-            }
-            if (buf) {
-                --bboxX.y2;
-                bboxB.y1 = bboxX.y2;
-            } else {
-                if (metUnavailablePixel) {
-                    *isBeingRenderedElsewhere = true;
-                }
-                break;
-            }
-        } else {
-            if ( !memchr( buf, 1, bboxX.width() ) ) {
-                --bboxX.y2;
-                bboxB.y1 = bboxX.y2;
-            } else {
-                break;
-            }
-            
-        }
-    }
+    bboxX.y2 -= countFreeRows(bboxX, true, stopMask, false, trimap, isBeingRenderedElsewhere);
+    bboxB.y1 = bboxX.y2;
     if ( !bboxB.isNull() ) { // empty boxes should not be pushed
         ret.push_back(bboxB);
     }
     
-	//find left
-	RectI bboxC = bboxX;
-	bboxC.set_right( bboxX.left() );
-	if (bboxX.bottom() < bboxX.top()) {
-		for (int j = bboxX.left(); j < bboxX.right(); ++j) {
-			const char* pix = BM_GET(bboxX.bottom(), j);
-
-			bool metUnavailablePixel = false;
-
-			for (int i = bboxX.bottom(); i < bboxX.top(); ++i, pix += _bounds.width()) {
-				if (*pix == 1) {
-					pix = 0;
-					break;
-				} else if (trimap && *pix == PIXEL_UNAVAILABLE) {
-					pix = 0;
-					metUnavailablePixel = true;
-					break;
-				}
-			}
-			if (pix) {
-                ++bboxX.x1;
-                bboxC.x2 = bboxX.x1;
-			} else {
-				if (metUnavailablePixel) {
-					*isBeingRenderedElsewhere = true;
-				}
-				break;
-			}
-		}
-	}
+    //find left
+    RectI bboxC = bboxX;
+    bboxC.set_right( bboxX.left() );
+    if (bboxX.bottom() < bboxX.top()) {
+        bboxX.x1 += countFreeColumns(bboxX, false, stopMask, false, trimap, isBeingRenderedElsewhere);
+        bboxC.x2 = bboxX.x1;
+    }
     if ( !bboxC.isNull() ) { // empty boxes should not be pushed
         ret.push_back(bboxC);
     }
 
-	//find right
-	RectI bboxD = bboxX;
-	bboxD.set_left( bboxX.right() );
-	if (bboxX.bottom() < bboxX.top()) {
-		for (int j = bboxX.right() - 1; j >= bboxX.left(); --j) {
-			const char* pix = BM_GET(bboxX.bottom(), j);
-
-			bool metUnavailablePixel = false;
-
-			for (int i = bboxX.bottom(); i < bboxX.top(); ++i, pix += _bounds.width()) {
-				if (*pix == 1) {
-					pix = 0;
-					break;
-				} else if (trimap && *pix == PIXEL_UNAVAILABLE) {
-					pix = 0;
-					metUnavailablePixel = true;
-					break;
-				}
-			}
-			if (pix) {
-                --bboxX.x2;
-                bboxD.x1 = bboxX.x2;
-			} else {
-				if (metUnavailablePixel) {
-					*isBeingRenderedElsewhere = true;
-				}
-				break;
-			}
-		}
-	}
-	if ( !bboxD.isNull() ) { // empty boxes should not be pushed
+    //find right
+    RectI bboxD = bboxX;
+    bboxD.set_left( bboxX.right() );
+    if (bboxX.bottom() < bboxX.top()) {
+        bboxX.x2 -= countFreeColumns(bboxX, true, stopMask, false, trimap, isBeingRenderedElsewhere);
+        bboxD.x1 = bboxX.x2;
+    }
+    if ( !bboxD.isNull() ) { // empty boxes should not be pushed
         ret.push_back(bboxD);
     }
     
@@ -457,7 +501,7 @@ minimalNonMarkedRects_internal(const RectI & roi,const RectI& _bounds, const std
     assert( bboxD.bottom() == bboxX.bottom() );
     
     // get the bounding box of what's left (the X rectangle in the drawing above)
-    bboxX = minimalNonMarkedBbox_internal<trimap>(bboxX,_bounds,_map,isBeingRenderedElsewhere);
+    bboxX = minimalNonMarkedBbox_internal<trimap>(bboxX, isBeingRenderedElsewhere);
     
     if ( !bboxX.isNull() ) { // empty boxes should not be pushed
         ret.push_back(bboxX);
@@ -475,9 +519,9 @@ Bitmap::minimalNonMarkedBbox(const RectI & roi) const
         if (!roi.intersect(_dirtyZone, &realRoi)) {
             return RectI();
         }
-        return minimalNonMarkedBbox_internal<0>(realRoi, _bounds, _map, NULL);
+        return minimalNonMarkedBbox_internal<0>(realRoi, NULL);
     } else {
-        return minimalNonMarkedBbox_internal<0>(roi, _bounds, _map, NULL);
+        return minimalNonMarkedBbox_internal<0>(roi, NULL);
     }
 }
 
@@ -489,9 +533,9 @@ Bitmap::minimalNonMarkedRects(const RectI & roi,std::list<RectI>& ret) const
         if (!roi.intersect(_dirtyZone, &realRoi)) {
             return;
         }
-        minimalNonMarkedRects_internal<0>(realRoi, _bounds, _map,ret , NULL);
+        minimalNonMarkedRects_internal<0>(realRoi, ret, NULL);
     } else {
-        minimalNonMarkedRects_internal<0>(roi, _bounds, _map,ret , NULL);
+        minimalNonMarkedRects_internal<0>(roi, ret, NULL);
     }
 }
 
@@ -505,9 +549,9 @@ Bitmap::minimalNonMarkedBbox_trimap(const RectI & roi,bool* isBeingRenderedElsew
             *isBeingRenderedElsewhere = false;
             return RectI();
         }
-        return minimalNonMarkedBbox_internal<1>(realRoi, _bounds, _map, isBeingRenderedElsewhere);
+        return minimalNonMarkedBbox_internal<1>(realRoi, isBeingRenderedElsewhere);
     } else {
-        return minimalNonMarkedBbox_internal<1>(roi, _bounds, _map, isBeingRenderedElsewhere);
+        return minimalNonMarkedBbox_internal<1>(roi, isBeingRenderedElsewhere);
     }
 }
 
@@ -521,9 +565,9 @@ Bitmap::minimalNonMarkedRects_trimap(const RectI & roi,std::list<RectI>& ret,boo
             *isBeingRenderedElsewhere = false;
             return;
         }
-        minimalNonMarkedRects_internal<1>(realRoi, _bounds, _map ,ret , isBeingRenderedElsewhere);
+        minimalNonMarkedRects_internal<1>(realRoi, ret, isBeingRenderedElsewhere);
     } else {
-        minimalNonMarkedRects_internal<1>(roi, _bounds, _map ,ret , isBeingRenderedElsewhere);
+        minimalNonMarkedRects_internal<1>(roi, ret, isBeingRenderedElsewhere);
     }
 } 
 #endif
@@ -537,6 +581,7 @@ Bitmap::markForRendered(const RectI & roi)
     for (int i = roi.y1; i < roi.y2; ++i, buf += w) {
         memset( buf, 1, roiw);
     }
+    setTilesState(roi, 1);
 }
 
 #if NATRON_ENABLE_TRIMAP
@@ -549,6 +594,23 @@ Bitmap::markForRendering(const RectI & roi)
     for (int i = roi.y1; i < roi.y2; ++i, buf += w) {
         memset( buf, PIXEL_UNAVAILABLE , roiw );
     }
+    setTilesState(roi, PIXEL_UNAVAILABLE);
+}
+
+void
+Bitmap::clearUnavailable(const RectI& roi)
+{
+    char* buf = BM_GET(roi.bottom(), roi.left());
+    int w = _bounds.width();
+    int roiw = roi.width();
+    for (int i = roi.y1; i < roi.y2; ++i, buf += w) {
+        for (int j = 0; j < roiw; ++j) {
+            if (buf[j] == PIXEL_UNAVAILABLE) {
+                buf[j] = 0;
+            }
+        }
+    }
+    refreshTilesState(roi);
 }
 #endif
 
@@ -561,12 +623,15 @@ Bitmap::clear(const RectI& roi)
     for (int i = roi.y1; i < roi.y2; ++i, buf += w) {
         memset( buf, 0 , roiw );
     }
+    setTilesState(roi, 0);
 }
 
 void
 Bitmap::swap(Bitmap& other)
 {
     _map.swap(other._map);
+    _tiles.swap(other._tiles);
+    _tilesPerRow = other._tilesPerRow;
     _bounds = other._bounds;
     _dirtyZone.clear();//merge(other._dirtyZone);
     _dirtyZoneSet = false;
@@ -992,9 +1057,7 @@ Image::resizeInternal(const Image* srcImg,
             std::size_t memsize = a * pixelSize;
             memset(pix, 0, memsize);
             if (setBitmapTo1 && (*outputImage)->usesBitMap()) {
-                char* bm = wacc.bitmapAt(aRect.x1, aRect.y1);
-                assert(bm);
-                memset(bm, 1, a);
+                (*outputImage)->_bitmap.markForRendered(aRect);
             }
         }
         if (!cRect.isNull()) {
@@ -1004,9 +1067,7 @@ Image::resizeInternal(const Image* srcImg,
             std::size_t memsize = a * pixelSize;
             memset(pix, 0, memsize);
             if (setBitmapTo1 && (*outputImage)->usesBitMap()) {
-                char* bm = (char*)wacc.bitmapAt(cRect.x1, cRect.y1);
-                assert(bm);
-                memset(bm, 1, a);
+                (*outputImage)->_bitmap.markForRendered(cRect);
             }
         }
         if (!bRect.isNull()) {
@@ -1018,13 +1079,11 @@ Image::resizeInternal(const Image* srcImg,
             int bw = bRect.width();
             std::size_t rectRowSize = bw * pixelSize;
             
-            char* bm = (setBitmapTo1 && (*outputImage)->usesBitMap()) ? wacc.bitmapAt(bRect.x1, bRect.y1) : 0;
             for (int y = bRect.y1; y < bRect.y2; ++y, pix += rowsize) {
                 memset(pix, 0, rectRowSize);
-                if (bm) {
-                    memset(bm, 1, bw);
-                    bm += mw;
-                }
+            }
+            if (setBitmapTo1 && (*outputImage)->usesBitMap()) {
+                (*outputImage)->_bitmap.markForRendered(bRect);
             }
         }
         if (!dRect.isNull()) {
@@ -1036,13 +1095,11 @@ Image::resizeInternal(const Image* srcImg,
             int dw = dRect.width();
             std::size_t rectRowSize = dw * pixelSize;
             
-            char* bm = (setBitmapTo1 && (*outputImage)->usesBitMap()) ? wacc.bitmapAt(dRect.x1, dRect.y1) : 0;
             for (int y = dRect.y1; y < dRect.y2; ++y, pix += rowsize) {
                 memset(pix, 0, rectRowSize);
-                if (bm) {
-                    memset(bm, 1, dw);
-                    bm += mw;
-                }
+            }
+            if (setBitmapTo1 && (*outputImage)->usesBitMap()) {
+                (*outputImage)->_bitmap.markForRendered(dRect);
             }
         }
         
@@ -1070,6 +1127,45 @@ Image::resizeInternal(const Image* srcImg,
 
 }
 
+// When an image grows, its new bounds get an extra 1/NATRON_IMAGE_BOUNDS_HEADROOM_DIVISOR of their size
+// in each direction where they grew, so that the next slightly larger requests do not reallocate it again.
+#define NATRON_IMAGE_BOUNDS_HEADROOM_DIVISOR 4
+
+RectI
+Image::getGrownBounds(const RectI& newBounds, bool fillWithBlackAndTransparent) const
+{
+    RectI merge = newBounds;
+    merge.merge(_bounds);
+
+    ///When filling with black the grown area is also marked as rendered (for rotopaint), it must not go beyond what was asked
+    if (fillWithBlackAndTransparent) {
+        return merge;
+    }
+    if ( _rod.isNull() || _rod.isInfinite() ) {
+        return merge;
+    }
+
+    ///Never grow beyond the region of definition of the image
+    RectI pixelRod;
+    _rod.toPixelEnclosing(getMipMapLevel(), getPixelAspectRatio(), &pixelRod);
+
+    int padX = merge.width() / NATRON_IMAGE_BOUNDS_HEADROOM_DIVISOR;
+    int padY = merge.height() / NATRON_IMAGE_BOUNDS_HEADROOM_DIVISOR;
+    if (merge.x1 < _bounds.x1) {
+        merge.x1 = std::min( merge.x1, std::max(pixelRod.x1, merge.x1 - padX) );
+    }
+    if (merge.y1 < _bounds.y1) {
+        merge.y1 = std::min( merge.y1, std::max(pixelRod.y1, merge.y1 - padY) );
+    }
+    if (merge.x2 > _bounds.x2) {
+        merge.x2 = std::max( merge.x2, std::min(pixelRod.x2, merge.x2 + padX) );
+    }
+    if (merge.y2 > _bounds.y2) {
+        merge.y2 = std::max( merge.y2, std::min(pixelRod.y2, merge.y2 + padY) );
+    }
+    return merge;
+}
+
 bool
 Image::copyAndResizeIfNeeded(const RectI& newBounds, bool fillWithBlackAndTransparent, bool setBitmapTo1, boost::shared_ptr<Image>* output)
 {
@@ -1080,8 +1176,7 @@ Image::copyAndResizeIfNeeded(const RectI& newBounds, bool fillWithBlackAndTransp
     
     QReadLocker k(&_entryLock);
     
-    RectI merge = newBounds;
-    merge.merge(_bounds);
+    RectI merge = getGrownBounds(newBounds, fillWithBlackAndTransparent);
     
     resizeInternal(this, _bounds, merge, fillWithBlackAndTransparent, setBitmapTo1, usesBitMap(), output);
     return true;
@@ -1098,8 +1193,7 @@ Image::ensureBounds(const RectI& newBounds, bool fillWithBlackAndTransparent, bo
     
     QWriteLocker k(&_entryLock);
     
-    RectI merge = newBounds;
-    merge.merge(_bounds);
+    RectI merge = getGrownBounds(newBounds, fillWithBlackAndTransparent);
     
     ImagePtr tmpImg;
     resizeInternal(this, _bounds, merge, fillWithBlackAndTransparent, setBitmapTo1, false, &tmpImg);
@@ -1635,6 +1729,10 @@ Image::halveRoIForDepth(const RectI & roi,
         }
     }
 
+    if (copyBitMap) {
+        output->_bitmap.refreshTilesState(dstRoI);
+    }
+
 } // halveRoIForDepth
 
 // code proofread and fixed by @devernay on 8/8/2014
@@ -1745,7 +1843,7 @@ Image::halve1DImage(const RectI & roi,
 
 // code proofread and fixed by @devernay on 8/8/2014
 void
-Image::downscaleMipMap(const RectD& dstRod,
+Image::downscaleMipMap(const RectD& /*dstRod*/,
                        const RectI & roi,
                        unsigned int fromLevel,
                        unsigned int toLevel,
@@ -1757,29 +1855,21 @@ Image::downscaleMipMap(const RectD& dstRod,
 
     assert(_bounds.x1 <= roi.x1 && roi.x2 <= _bounds.x2 &&
            _bounds.y1 <= roi.y1 && roi.y2 <= _bounds.y2);
-    double par = getPixelAspectRatio();
-//    RectD roiCanonical;
-//    roi.toCanonical(fromLevel, par , dstRod, &roiCanonical);
-//    RectI dstRoI;
-//    roiCanonical.toPixelEnclosing(toLevel, par , &dstRoI);
     unsigned int downscaleLvls = toLevel - fromLevel;
 
     assert(!copyBitMap || _bitmap.getBitmap());
-    
-    RectI dstRoI  = roi.downscalePowerOfTwoSmallestEnclosing(downscaleLvls);
-    
-    ImagePtr tmpImg( new Image( getComponents(), dstRod, dstRoI, toLevel, par, getBitDepth(), getPremultiplication(), getFieldingOrder(), true) );
 
-    buildMipMapLevel( dstRod, roi, downscaleLvls, copyBitMap, tmpImg.get() );
+    RectI dstRoI  = roi.downscalePowerOfTwoSmallestEnclosing(downscaleLvls);
 
     // check that the downscaled mipmap is inside the output image (it may not be equal to it)
     assert(dstRoI.x1 >= output->_bounds.x1);
     assert(dstRoI.x2 <= output->_bounds.x2);
     assert(dstRoI.y1 >= output->_bounds.y1);
     assert(dstRoI.y2 <= output->_bounds.y2);
+    Q_UNUSED(dstRoI);
 
-    ///Now copy the result of tmpImg into the output image
-    output->pasteFrom(*tmpImg, dstRoI, copyBitMap);
+    ///The mipmap is written directly into the output image, no intermediate level is allocated
+    buildMipMapLevel(roi, downscaleLvls, copyBitMap, output);
 }
 
 
@@ -2173,66 +2263,142 @@ Image::scaleBox(const RectI & roi,
     }
 }
 
-// code proofread and fixed by @devernay on 8/8/2014
+template <typename PIX, int maxValue>
 void
-Image::buildMipMapLevel(const RectD& dstRoD,
-                        const RectI & roi,
-                        unsigned int level,
-                        bool copyBitMap,
-                        Image* output) const
+Image::buildMipMapLevelForDepth(const RectI & roi,
+                                unsigned int level,
+                                bool copyBitMap,
+                                Image* output) const
 {
-    ///The last mip map level we will make with closestPo2
-    RectI lastLevelRoI = roi.downscalePowerOfTwoSmallestEnclosing(level);
-
-    ///The output image must contain the last level roi
-    assert( output->getBounds().contains(lastLevelRoI) );
+    assert( (getBitDepth() == eImageBitDepthByte && sizeof(PIX) == 1) ||
+           (getBitDepth() == eImageBitDepthShort && sizeof(PIX) == 2) ||
+           (getBitDepth() == eImageBitDepthFloat && sizeof(PIX) == 4) );
+    assert(level > 0);
 
-    assert( output->getComponents() == getComponents() );
+    /// Take the lock for both bitmaps since we're about to read/write from them!
+    QWriteLocker k1(&output->_entryLock);
+    QReadLocker k2(&_entryLock);
 
-    if (level == 0) {
-        ///Just copy the roi and return
-        output->pasteFrom(*this, roi, copyBitMap);
+    assert(!copyBitMap || usesBitMap());
+    assert( getComponents() == output->getComponents() );
 
+    RectI srcRoI;
+    if ( !roi.intersect(_bounds, &srcRoI) ) {
         return;
     }
+    const RectI dstRoI = srcRoI.downscalePowerOfTwoSmallestEnclosing(level);
+    assert( output->_bounds.contains(dstRoI) );
+
+    /*
+     Each output pixel is the average of the block of 2^level x 2^level source pixels it covers,
+     clipped to the roi, which is what halving the image level times would give without the
+     intermediate images. The source rows of a block are first summed into a single row, the
+     loop runs over contiguous memory and is vectorized by the compiler, then each block of that
+     row is reduced to one pixel.
+     */
+    const int scale = 1 << level;
+    const int nComps = _nbComponents;
+    const int srcRowElements = srcRoI.width() * nComps;
+    std::vector<float> rowSum(srcRowElements);
+    std::vector<char> bmRow;
+    if (copyBitMap) {
+        bmRow.resize( srcRoI.width() );
+    }
 
-    const Image* srcImg = this;
-    Image* dstImg = NULL;
-    bool mustFreeSrc = false;
-    RectI previousRoI = roi;
-    ///Build all the mipmap levels until we reach the one we are interested in
-    for (unsigned int i = 1; i <= level; ++i) {
-        ///Halve the smallest enclosing po2 rect as we need to render a minimum of the renderWindow
-        RectI halvedRoI = previousRoI.downscalePowerOfTwoSmallestEnclosing(1);
-
-        ///Allocate an image with half the size of the source image
-        dstImg = new Image( getComponents(), dstRoD, halvedRoI, getMipMapLevel() + i, getPixelAspectRatio(),getBitDepth(), getPremultiplication(), getFieldingOrder(), true);
-
-        ///Half the source image into dstImg.
-        ///We pass the closestPo2 roi which might not be the entire size of the source image
-        ///If the source image'sroi was originally a po2.
-        srcImg->halveRoI(previousRoI, copyBitMap, dstImg);
+    for (int y = dstRoI.y1; y < dstRoI.y2; ++y) {
+        const int sy1 = std::max(y * scale, srcRoI.y1);
+        const int sy2 = std::min( (y + 1) * scale, srcRoI.y2 );
+        assert(sy1 < sy2);
 
-        ///Clean-up, we should use shared_ptrs for safety
-        if (mustFreeSrc) {
-            delete srcImg;
+        std::fill(rowSum.begin(), rowSum.end(), 0.f);
+        if (copyBitMap) {
+            std::fill(bmRow.begin(), bmRow.end(), 1);
+        }
+        for (int sy = sy1; sy < sy2; ++sy) {
+            const PIX* const src = (const PIX*)pixelAt(srcRoI.x1, sy);
+            float* const sum = &rowSum[0];
+            for (int i = 0; i < srcRowElements; ++i) {
+                sum[i] += src[i];
+            }
+            if (copyBitMap) {
+                ///A pixel of the mipmap is available only if all the pixels it covers are.
+                ///Pixels being rendered by another thread (trimap) are considered unavailable.
+                const char* const srcBm = _bitmap.getBitmapAt(srcRoI.x1, sy);
+                char* const bm = &bmRow[0];
+                for (int i = 0; i < (int)bmRow.size(); ++i) {
+                    bm[i] &= (srcBm[i] == 1);
+                }
+            }
         }
 
-        ///Switch for next pass
-        previousRoI = halvedRoI;
-        srcImg = dstImg;
-        mustFreeSrc = true;
+        PIX* dst = (PIX*)output->pixelAt(dstRoI.x1, y);
+        char* dstBm = copyBitMap ? output->_bitmap.getBitmapAt(dstRoI.x1, y) : NULL;
+        for (int x = dstRoI.x1; x < dstRoI.x2; ++x) {
+            const int sx1 = std::max(x * scale, srcRoI.x1);
+            const int sx2 = std::min( (x + 1) * scale, srcRoI.x2 );
+            assert(sx1 < sx2);
+            const float norm = 1.f / ( (sx2 - sx1) * (sy2 - sy1) );
+            const float* const sum = &rowSum[(sx1 - srcRoI.x1) * nComps];
+            const int blockElements = (sx2 - sx1) * nComps;
+            for (int k = 0; k < nComps; ++k) {
+                float v = 0.f;
+                for (int i = k; i < blockElements; i += nComps) {
+                    v += sum[i];
+                }
+                v *= norm;
+                // round to the nearest value for integer depths
+                dst[k] = maxValue == 1 ? PIX(v) : PIX(v + 0.5f);
+            }
+            dst += nComps;
+            if (copyBitMap) {
+                const char* const bm = &bmRow[sx1 - srcRoI.x1];
+                char available = 1;
+                for (int i = 0; i < sx2 - sx1; ++i) {
+                    available &= bm[i];
+                }
+                *dstBm++ = available;
+            }
+        }
+    }
 
+    if (copyBitMap) {
+        output->_bitmap.refreshTilesState(dstRoI);
     }
+} // buildMipMapLevelForDepth
 
-    assert(srcImg->getBounds() == lastLevelRoI);
+void
+Image::buildMipMapLevel(const RectI & roi,
+                        unsigned int level,
+                        bool copyBitMap,
+                        Image* output) const
+{
+    ///The output image must contain the last level roi
+    assert( output->getBounds().contains( roi.downscalePowerOfTwoSmallestEnclosing(level) ) );
 
-    ///Finally copy the last mipmap level into output.
-    output->pasteFrom( *srcImg, srcImg->getBounds() , copyBitMap);
+    assert( output->getComponents() == getComponents() );
+
+    if (level == 0) {
+        ///Just copy the roi and return
+        output->pasteFrom(*this, roi, copyBitMap);
+
+        return;
+    }
 
-    ///Clean-up, we should use shared_ptrs for safety
-    if (mustFreeSrc) {
-        delete srcImg;
+    switch ( getBitDepth() ) {
+    case eImageBitDepthByte:
+        buildMipMapLevelForDepth<unsigned char, 255>(roi, level, copyBitMap, output);
+        break;
+    case eImageBitDepthShort:
+        buildMipMapLevelForDepth<unsigned short, 65535>(roi, level, copyBitMap, output);
+        break;
+    case eImageBitDepthHalf:
+        assert(false);
+        break;
+    case eImageBitDepthFloat:
+        buildMipMapLevelForDepth<float, 1>(roi, level, copyBitMap, output);
+        break;
+    case eImageBitDepthNone:
+        break;
     }
 } // buildMipMapLevel
 
@@ -2269,12 +2435,24 @@ Bitmap::copyRowPortion(int x1,int x2,int y,const Bitmap& other)
     const char* srcBitmap = other.getBitmapAt(x1, y);
     char* dstBitmap = getBitmapAt(x1, y);
     const char* end = dstBitmap + (x2 - x1);
+    int writtenValues = 0;
     while (dstBitmap < end) {
         *dstBitmap = /**srcBitmap == PIXEL_UNAVAILABLE ? 0 : */*srcBitmap;
+        writtenValues |= BM_BIT(*srcBitmap);
         ++dstBitmap;
         ++srcBitmap;
     }
-    
+
+    ///This is called row by row: rather than reading back the tiles, just flag as mixed those that may no longer be uniform
+    if (x2 > x1) {
+        char* tiles = &_tiles[( (y - _bounds.y1) >> NATRON_BITMAP_TILE_SIZE_LOG2 ) * _tilesPerRow];
+        int tx2 = (x2 - 1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2;
+        for (int tx = (x1 - _bounds.x1) >> NATRON_BITMAP_TILE_SIZE_LOG2; tx <= tx2; ++tx) {
+            if ( (tiles[tx] != BITMAP_TILE_MIXED) && (writtenValues != BM_BIT(tiles[tx])) ) {
+                tiles[tx] = BITMAP_TILE_MIXED;
+            }
+        }
+    }
 }
 
 void
@@ -2309,6 +2487,7 @@ Bitmap::copyBitmapPortion(const RectI& roi, const Bitmap& other)
             ++dstCur;
         }
     }
+    refreshTilesState(roi);
 }
 
 template <typename PIX, bool doPremult>
@@ -61,12 +61,24 @@ public:
     }
 };
 
+/**
+ * @brief The render state of each pixel of an image: 0 if not rendered, 1 if rendered and
+ * PIXEL_UNAVAILABLE (2) if being rendered by another thread (trimap).
+ * On top of the per-pixel map, the bitmap keeps a summary of the state of each NATRON_BITMAP_TILE_SIZE x NATRON_BITMAP_TILE_SIZE
+ * tile: a tile is either uniform (all its pixels share the same state) or mixed. The minimalNonMarked* queries skip
+ * uniform tiles at once and only read the pixels of mixed tiles, so that their cost mostly depends on the number of
+ * tiles instead of the number of pixels.
+ * The per-pixel map remains the storage: the tiles are an index on top of it. They do not save memory, they add one
+ * byte per tile to the map (see getMemorySize()), and marking, clearing or copying a region still writes each of its pixels.
+ **/
 class Bitmap
 {
 public:
     Bitmap(const RectI & bounds)
     : _bounds(bounds)
     , _map( bounds.area() )
+    , _tiles()
+    , _tilesPerRow(0)
     , _dirtyZone()
     , _dirtyZoneSet(false)
     {
@@ -75,11 +87,14 @@ public:
         // "!!!Note that if isIdentity is true it will allocate an empty image object with 0 bytes of data."
         //assert(!rod.isNull());
         std::fill(_map.begin(), _map.end(), 0);
+        initializeTiles(0);
     }
 
     Bitmap()
     : _bounds()
     , _map()
+    , _tiles()
+    , _tilesPerRow(0)
     , _dirtyZone()
     , _dirtyZoneSet(false)
     {
@@ -91,6 +106,7 @@ public:
         _map.resize( _bounds.area() );
 
         std::fill(_map.begin(), _map.end(), 0);
+        initializeTiles(0);
     }
 
     ~Bitmap()
@@ -101,6 +117,7 @@ public:
     void setTo1()
     {
         std::fill(_map.begin(),_map.end(),1);
+        std::fill(_tiles.begin(),_tiles.end(),1);
     }
 
     const RectI & getBounds() const
@@ -108,6 +125,14 @@ public:
         return _bounds;
     }
 
+    /**
+     * @brief The memory used by the per-pixel map and the state of the tiles, in bytes.
+     **/
+    std::size_t getMemorySize() const
+    {
+        return _map.size() + _tiles.size();
+    }
+
 #if NATRON_ENABLE_TRIMAP
     void minimalNonMarkedRects_trimap(const RectI & roi,std::list<RectI>& ret,bool* isBeingRenderedElsewhere) const;
     RectI minimalNonMarkedBbox_trimap(const RectI & roi,bool* isBeingRenderedElsewhere) const;
@@ -123,12 +148,19 @@ public:
 #if NATRON_ENABLE_TRIMAP
     ///Fill with 2 the roi
     void markForRendering(const RectI & roi);
+
+    ///Replace the 2 by 0 in the roi
+    void clearUnavailable(const RectI & roi);
 #endif
 
     void clear(const RectI& roi);
 
     void swap(Bitmap& other);
 
+    /**
+     * @brief Direct access to the per-pixel map. If the map is modified through the returned pointers,
+     * refreshTilesState() must be called on the modified area afterwards.
+     **/
     const char* getBitmap() const
     {
         return &_map.front();
@@ -142,6 +174,16 @@ public:
     const char* getBitmapAt(int x,int y) const;
     char* getBitmapAt(int x,int y);
 
+    /**
+     * @brief Recomputes the state of the tiles intersecting roi from the per-pixel map.
+     **/
+    void refreshTilesState(const RectI& roi);
+
+    /**
+     * @brief Returns the number of tiles which are not uniform. Mostly useful for debugging.
+     **/
+    int getMixedTilesCount() const;
+
     void copyRowPortion(int x1,int x2,int y,const Bitmap& other);
 
     void copyBitmapPortion(const RectI& roi, const Bitmap& other);
@@ -152,9 +194,41 @@ public:
     }
 
 private:
+
+    void initializeTiles(char state);
+
+    RectI getTileRect(int tx, int ty) const;
+
+    char computeTileState(const RectI& tileRect) const;
+
+    ///Update the tiles state after the roi was filled with value
+    void setTilesState(const RectI& roi, char value);
+
+    bool areTilesFree(const RectI& rect, int stopMask, int* seen) const;
+
+    int scanRow(int y, int x1, int x2, int stopMask, int* seen) const;
+
+    int scanColumn(int x, int y1, int y2, int stopMask, int* seen) const;
+
+    int countFreeRows(const RectI& rect, bool fromTop, int stopMask,
+                      bool flagPassedUnavailable, bool flagStoppedUnavailable, bool* isBeingRenderedElsewhere) const;
+
+    int countFreeColumns(const RectI& rect, bool fromRight, int stopMask,
+                         bool flagPassedUnavailable, bool flagStoppedUnavailable, bool* isBeingRenderedElsewhere) const;
+
+    template <int trimap>
+    RectI minimalNonMarkedBbox_internal(const RectI& roi, bool* isBeingRenderedElsewhere) const;
+
+    template <int trimap>
+    void minimalNonMarkedRects_internal(const RectI & roi, std::list<RectI>& ret, bool* isBeingRenderedElsewhere) const;
+
     RectI _bounds;
     std::vector<char> _map;
 
+    ///The state of each tile, row by row: either the value shared by all the pixels of the tile or BITMAP_TILE_MIXED
+    std::vector<char> _tiles;
+    int _tilesPerRow;
+
     /**
      * This represents the zone that has potentially something to render. In minimalNonMarkedRects
      * we intersect the region of interest with the dirty zone. This is useful to optimize the bitmap checking
@@ -235,6 +309,8 @@ public:
     /**
      * @brief Resizes this image so it contains newBounds, copying all the content of the current bounds of the image into
      * a new buffer. This is not thread-safe and should be called only while under an ImageLocker
+     * Unless fillWithBlackAndTransparent is true, the image is grown a bit more than needed (within its RoD) so that
+     * successive requests for slightly larger regions (e.g: when panning the viewer) do not each reallocate the image.
      **/
     bool ensureBounds(const RectI& newBounds, bool fillWithBlackAndTransparent = false, bool setBitmapTo1 = false);
 
@@ -246,6 +322,9 @@ public:
 
 private:
 
+    ///Returns the bounds the image should have to contain newBounds, see ensureBounds()
+    RectI getGrownBounds(const RectI& newBounds, bool fillWithBlackAndTransparent) const;
+
     static void resizeInternal(const Image* srcImg,
                                const RectI& srcBounds,
                                const RectI& merge,
@@ -288,7 +367,7 @@ public:
         std::size_t dt = dataSize();
 
         bool got = _entryLock.tryLockForRead();
-        dt += _bitmap.getBounds().area();
+        dt += _bitmap.getMemorySize();
         if (got) {
             _entryLock.unlock();
         }
@@ -668,6 +747,18 @@ public:
         _bounds.intersect(roi, &intersection);
         _bitmap.markForRendering(intersection);
     }
+
+    ///Replace the 2 by 0 in the roi: the pixels being rendered in another image are not rendered in this one
+    void clearUnavailableBitmap(const RectI & roi)
+    {
+        if (!_useBitmap) {
+            return;
+        }
+        QWriteLocker locker(&_entryLock);
+        RectI intersection;
+        _bounds.intersect(roi, &intersection);
+        _bitmap.clearUnavailable(intersection);
+    }
 #endif
 
     void clearBitmap(const RectI& roi)
@@ -944,10 +1035,15 @@ private:
      * @brief Given the output buffer,the region of interest and the mip map level, this
      * function computes the mip map of this image in the given roi.
      * If roi is NOT a power of 2, then it will be rounded to the closest power of 2.
+     * The mipmap is computed in a single pass directly into output.
      **/
-    void buildMipMapLevel(const RectD& dstRoD,const RectI & roiCanonical, unsigned int level, bool copyBitMap,
+    void buildMipMapLevel(const RectI & roi, unsigned int level, bool copyBitMap,
                           Image* output) const;
 
+    template <typename PIX, int maxValue>
+    void buildMipMapLevelForDepth(const RectI & roi, unsigned int level, bool copyBitMap,
+                                  Image* output) const;
+
 
     /**
      * @brief Halve the given roi of this image into output.
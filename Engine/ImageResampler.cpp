@@ -0,0 +1,540 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "ImageResampler.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cmath>
+#include <cstring> // memcpy, memset
+#include <vector>
+
+#include "Engine/Image.h"
+
+///The filter is never evaluated on more than this many source pixels along each axis
+#define NATRON_IMAGE_RESAMPLER_MAX_TAPS 32
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+typedef double (*FilterFunc)(double);
+
+double
+bilinearFilter(double t)
+{
+    t = std::fabs(t);
+
+    return t < 1. ? 1. - t : 0.;
+}
+
+///Keys cubic with a = -0.5
+double
+cubicFilter(double t)
+{
+    t = std::fabs(t);
+    if (t < 1.) {
+        return (1.5 * t - 2.5) * t * t + 1.;
+    } else if (t < 2.) {
+        return ( (-0.5 * t + 2.5) * t - 4. ) * t + 2.;
+    }
+
+    return 0.;
+}
+
+double
+lanczosFilter(double t)
+{
+    t = std::fabs(t);
+    if (t < 1e-8) {
+        return 1.;
+    } else if (t < 3.) {
+        double pit = M_PI * t;
+
+        return 3. * std::sin(pit) * std::sin(pit / 3.) / (pit * pit);
+    }
+
+    return 0.;
+}
+
+FilterFunc
+getFilterFunc(ResampleFilterEnum filter)
+{
+    switch (filter) {
+    case eResampleFilterBilinear:
+
+        return bilinearFilter;
+    case eResampleFilterCubic:
+
+        return cubicFilter;
+    case eResampleFilterLanczos:
+
+        return lanczosFilter;
+    }
+
+    return bilinearFilter;
+}
+
+///Rounds towards minus infinity, unlike the integer division
+int
+floorDiv2(int x)
+{
+    return x >= 0 ? x / 2 : -( (-x + 1) / 2 );
+}
+
+/**
+ * @brief How much a source pixel step along u and v is covered by a destination pixel around (x, y), i.e: the norm
+ * of the rows of the jacobian of dstToSrc.
+ **/
+void
+getFootprint(const Transform::Matrix3x3& m,
+             double x,
+             double y,
+             double* su,
+             double* sv)
+{
+    double w = m.g * x + m.h * y + m.i;
+
+    if (w <= 0.) {
+        *su = *sv = 1.;
+
+        return;
+    }
+    double u = (m.a * x + m.b * y + m.c) / w;
+    double v = (m.d * x + m.e * y + m.f) / w;
+    double dudx = (m.a - u * m.g) / w;
+    double dudy = (m.b - u * m.h) / w;
+    double dvdx = (m.d - v * m.g) / w;
+    double dvdy = (m.e - v * m.h) / w;
+    *su = std::sqrt(dudx * dudx + dudy * dudy);
+    *sv = std::sqrt(dvdx * dvdx + dvdy * dvdy);
+}
+
+/**
+ * @brief Computes the weights of the source pixels first to first + *count - 1 for a filter centered on pos,
+ * stretched by scale. Returns the sum of the weights.
+ **/
+double
+computeWeights(FilterFunc func,
+               double support,
+               double pos,
+               double scale,
+               int* first,
+               int* count,
+               float* weights)
+{
+    double radius = support * scale;
+    int x1 = (int)std::ceil(pos - radius);
+    int x2 = (int)std::floor(pos + radius);
+    int n = x2 - x1 + 1;
+
+    if (n > NATRON_IMAGE_RESAMPLER_MAX_TAPS) {
+        ///Keep the filter centered when it is truncated
+        n = NATRON_IMAGE_RESAMPLER_MAX_TAPS;
+        x1 = (int)std::floor(pos) - n / 2 + 1;
+    }
+    double invScale = 1. / scale;
+    double sum = 0.;
+    for (int k = 0; k < n; ++k) {
+        double w = func( (x1 + k - pos) * invScale );
+        weights[k] = (float)w;
+        sum += w;
+    }
+    *first = x1;
+    *count = std::max(n, 0);
+
+    return sum;
+}
+
+/**
+ * @brief Box-filters src down by a factor of 2, pixels outside of the bounds of src are black.
+ **/
+template <int nComps>
+void
+downscaleHalf(const float* src,
+              const RectI& srcBounds,
+              float* dst,
+              const RectI& dstBounds)
+{
+    int srcRowElements = srcBounds.width() * nComps;
+
+    for (int y = dstBounds.y1; y < dstBounds.y2; ++y) {
+        float* dstPix = dst + (std::size_t)(y - dstBounds.y1) * dstBounds.width() * nComps;
+        for (int x = dstBounds.x1; x < dstBounds.x2; ++x, dstPix += nComps) {
+            float sum[nComps];
+            for (int c = 0; c < nComps; ++c) {
+                sum[c] = 0.f;
+            }
+            for (int j = 2 * y; j < 2 * y + 2; ++j) {
+                if ( (j < srcBounds.y1) || (j >= srcBounds.y2) ) {
+                    continue;
+                }
+                const float* srcRow = src + (std::size_t)(j - srcBounds.y1) * srcRowElements;
+                for (int i = 2 * x; i < 2 * x + 2; ++i) {
+                    if ( (i < srcBounds.x1) || (i >= srcBounds.x2) ) {
+                        continue;
+                    }
+                    const float* srcPix = srcRow + (i - srcBounds.x1) * nComps;
+                    for (int c = 0; c < nComps; ++c) {
+                        sum[c] += srcPix[c];
+                    }
+                }
+            }
+            for (int c = 0; c < nComps; ++c) {
+                dstPix[c] = sum[c] * 0.25f;
+            }
+        }
+    }
+}
+
+template <int nComps>
+void
+resampleForComponents(const float* srcPixels,
+                      const RectI& srcBounds,
+                      const Transform::Matrix3x3& m,
+                      ResampleFilterEnum filter,
+                      double su,
+                      double sv,
+                      const RectI& roi,
+                      float* dstPixels,
+                      const RectI& dstBounds)
+{
+    FilterFunc func = getFilterFunc(filter);
+    double support = ImageResampler::getFilterSupport(filter);
+    int srcRowElements = srcBounds.width() * nComps;
+    int dstRowElements = dstBounds.width() * nComps;
+    float wu[NATRON_IMAGE_RESAMPLER_MAX_TAPS];
+    float wv[NATRON_IMAGE_RESAMPLER_MAX_TAPS];
+
+    for (int y = roi.y1; y < roi.y2; ++y) {
+        float* dstPix = dstPixels + (std::size_t)(y - dstBounds.y1) * dstRowElements + (roi.x1 - dstBounds.x1) * nComps;
+        double Y = y + 0.5;
+        for (int x = roi.x1; x < roi.x2; ++x, dstPix += nComps) {
+            double X = x + 0.5;
+            double w = m.g * X + m.h * Y + m.i;
+            if (w <= 0.) {
+                ///Behind the camera
+                for (int c = 0; c < nComps; ++c) {
+                    dstPix[c] = 0.f;
+                }
+                continue;
+            }
+            ///The centers of the pixels are at +0.5, u and v are in pixel indexes
+            double u = (m.a * X + m.b * Y + m.c) / w - 0.5;
+            double v = (m.d * X + m.e * Y + m.f) / w - 0.5;
+            int u1, nu, v1, nv;
+            double sumU = computeWeights(func, support, u, su, &u1, &nu, wu);
+            double sumV = computeWeights(func, support, v, sv, &v1, &nv, wv);
+
+            float acc[nComps];
+            for (int c = 0; c < nComps; ++c) {
+                acc[c] = 0.f;
+            }
+
+            ///Pixels outside of the source bounds are black: they only count in the normalization
+            int i1 = std::max(u1, srcBounds.x1);
+            int i2 = std::min(u1 + nu, srcBounds.x2);
+            int j1 = std::max(v1, srcBounds.y1);
+            int j2 = std::min(v1 + nv, srcBounds.y2);
+            for (int j = j1; j < j2; ++j) {
+                const float* srcPix = srcPixels + (std::size_t)(j - srcBounds.y1) * srcRowElements + (i1 - srcBounds.x1) * nComps;
+                const float* weightU = wu + (i1 - u1);
+                float row[nComps];
+                for (int c = 0; c < nComps; ++c) {
+                    row[c] = 0.f;
+                }
+                for (int i = i1; i < i2; ++i, srcPix += nComps, ++weightU) {
+                    for (int c = 0; c < nComps; ++c) {
+                        row[c] += *weightU * srcPix[c];
+                    }
+                }
+                float weightV = wv[j - v1];
+                for (int c = 0; c < nComps; ++c) {
+                    acc[c] += weightV * row[c];
+                }
+            }
+
+            double sum = sumU * sumV;
+            float norm = sum != 0. ? (float)(1. / sum) : 0.f;
+            for (int c = 0; c < nComps; ++c) {
+                dstPix[c] = acc[c] * norm;
+            }
+        }
+    }
+} // resampleForComponents
+
+template <int nComps>
+void
+resampleWithMipMaps(const float* srcPixels,
+                    const RectI& srcBounds,
+                    const Transform::Matrix3x3& dstToSrc,
+                    ResampleFilterEnum filter,
+                    const RectI& roi,
+                    float* dstPixels,
+                    const RectI& dstBounds)
+{
+    ///An integer translation is a copy whatever the filter
+    if ( (dstToSrc.a == 1.) && (dstToSrc.b == 0.) && (dstToSrc.d == 0.) && (dstToSrc.e == 1.) &&
+         (dstToSrc.g == 0.) && (dstToSrc.h == 0.) && (dstToSrc.i == 1.) &&
+         ( dstToSrc.c == std::floor(dstToSrc.c) ) && ( dstToSrc.f == std::floor(dstToSrc.f) ) ) {
+        int dx = (int)dstToSrc.c;
+        int dy = (int)dstToSrc.f;
+        for (int y = roi.y1; y < roi.y2; ++y) {
+            float* dstRow = dstPixels + (std::size_t)(y - dstBounds.y1) * dstBounds.width() * nComps;
+            std::memset( dstRow + (roi.x1 - dstBounds.x1) * nComps, 0, roi.width() * nComps * sizeof(float) );
+            int sy = y + dy;
+            if ( (sy < srcBounds.y1) || (sy >= srcBounds.y2) ) {
+                continue;
+            }
+            int x1 = std::max(roi.x1, srcBounds.x1 - dx);
+            int x2 = std::min(roi.x2, srcBounds.x2 - dx);
+            if (x1 < x2) {
+                const float* srcRow = srcPixels + (std::size_t)(sy - srcBounds.y1) * srcBounds.width() * nComps;
+                std::memcpy( dstRow + (x1 - dstBounds.x1) * nComps, srcRow + (x1 + dx - srcBounds.x1) * nComps, (x2 - x1) * nComps * sizeof(float) );
+            }
+        }
+
+        return;
+    }
+
+    unsigned int level = ImageResampler::getMipMapLevel(dstToSrc, roi);
+    double levelScale = 1. / (1 << level);
+    Transform::Matrix3x3 m = dstToSrc;
+    if (level > 0) {
+        m = Transform::matMul(Transform::Matrix3x3(levelScale, 0, 0, 0, levelScale, 0, 0, 0, 1), dstToSrc);
+    }
+
+    double su, sv;
+    getFootprint(m, (roi.x1 + roi.x2) / 2., (roi.y1 + roi.y2) / 2., &su, &sv);
+    su = std::max(su, 1.);
+    sv = std::max(sv, 1.);
+
+    if (level == 0) {
+        resampleForComponents<nComps>(srcPixels, srcBounds, m, filter, su, sv, roi, dstPixels, dstBounds);
+
+        return;
+    }
+
+    ///Only the part of the source the roi may read from is downscaled: the bounding box of the corners of the roi,
+    ///which contains the whole mapped roi unless it crosses the horizon of a perspective transform
+    RectI region = srcBounds;
+    double corners[4][2] = {
+        { (double)roi.x1, (double)roi.y1 }, { (double)roi.x2, (double)roi.y1 },
+        { (double)roi.x1, (double)roi.y2 }, { (double)roi.x2, (double)roi.y2 }
+    };
+    bool allInFront = true;
+    double minU = 0., maxU = 0., minV = 0., maxV = 0.;
+    for (int k = 0; k < 4; ++k) {
+        double w = dstToSrc.g * corners[k][0] + dstToSrc.h * corners[k][1] + dstToSrc.i;
+        if (w <= 0.) {
+            allInFront = false;
+            break;
+        }
+        double u = (dstToSrc.a * corners[k][0] + dstToSrc.b * corners[k][1] + dstToSrc.c) / w;
+        double v = (dstToSrc.d * corners[k][0] + dstToSrc.e * corners[k][1] + dstToSrc.f) / w;
+        if ( (k == 0) || (u < minU) ) {
+            minU = u;
+        }
+        if ( (k == 0) || (u > maxU) ) {
+            maxU = u;
+        }
+        if ( (k == 0) || (v < minV) ) {
+            minV = v;
+        }
+        if ( (k == 0) || (v > maxV) ) {
+            maxV = v;
+        }
+    }
+    if (allInFront) {
+        double margin = ( ImageResampler::getFilterSupport(filter) * std::max(su, sv) + 2. ) / levelScale;
+        RectI needed( (int)std::floor(minU - margin), (int)std::floor(minV - margin),
+                      (int)std::ceil(maxU + margin), (int)std::ceil(maxV + margin) );
+        if ( !needed.intersect(srcBounds, &region) ) {
+            region.clear();
+        }
+    }
+
+    std::vector<float> levels[2];
+    const float* levelPixels = srcPixels;
+    RectI levelBounds = srcBounds;
+    for (unsigned int l = 0; l < level; ++l) {
+        RectI halfBounds;
+        if (l == 0) {
+            halfBounds.set( floorDiv2(region.x1), floorDiv2(region.y1), -floorDiv2(-region.x2), -floorDiv2(-region.y2) );
+        } else {
+            halfBounds.set( floorDiv2(levelBounds.x1), floorDiv2(levelBounds.y1), -floorDiv2(-levelBounds.x2), -floorDiv2(-levelBounds.y2) );
+        }
+        std::vector<float>& halfPixels = levels[l % 2];
+        halfPixels.resize( (std::size_t)halfBounds.width() * halfBounds.height() * nComps );
+        if ( !halfPixels.empty() ) {
+            downscaleHalf<nComps>(levelPixels, levelBounds, &halfPixels[0], halfBounds);
+        }
+        levelPixels = halfPixels.empty() ? 0 : &halfPixels[0];
+        levelBounds = halfBounds;
+    }
+
+    resampleForComponents<nComps>(levelPixels, levelBounds, m, filter, su, sv, roi, dstPixels, dstBounds);
+} // resampleWithMipMaps
+} // anon namespace
+
+double
+ImageResampler::getFilterSupport(ResampleFilterEnum filter)
+{
+    switch (filter) {
+    case eResampleFilterBilinear:
+
+        return 1.;
+    case eResampleFilterCubic:
+
+        return 2.;
+    case eResampleFilterLanczos:
+
+        return 3.;
+    }
+
+    return 1.;
+}
+
+unsigned int
+ImageResampler::getMipMapLevel(const Transform::Matrix3x3& dstToSrc,
+                               const RectI& roi)
+{
+    double su, sv;
+
+    getFootprint(dstToSrc, (roi.x1 + roi.x2) / 2., (roi.y1 + roi.y2) / 2., &su, &sv);
+
+    ///The level is chosen from the least shrunk axis so that the other one is not over-blurred, the filter is
+    ///stretched along the other one
+    double scale = std::min(su, sv);
+    unsigned int level = 0;
+    while ( (scale >= 2.) && (level < NATRON_IMAGE_RESAMPLER_MAX_MIPMAP_LEVEL) ) {
+        scale /= 2.;
+        ++level;
+    }
+
+    ///Rather than being truncated past NATRON_IMAGE_RESAMPLER_MAX_TAPS, the widest filter (Lanczos) gets a higher
+    ///level for very anisotropic transforms: the least shrunk axis gets more blur
+    double maxScale = std::max(su, sv) / (1 << level);
+    while ( (2. * getFilterSupport(eResampleFilterLanczos) * maxScale + 1. > NATRON_IMAGE_RESAMPLER_MAX_TAPS) && (level < NATRON_IMAGE_RESAMPLER_MAX_MIPMAP_LEVEL) ) {
+        maxScale /= 2.;
+        ++level;
+    }
+
+    return level;
+}
+
+void
+ImageResampler::resample(const float* srcPixels,
+                         const RectI& srcBounds,
+                         int nComps,
+                         const Transform::Matrix3x3& dstToSrc,
+                         ResampleFilterEnum filter,
+                         const RectI& roi,
+                         float* dstPixels,
+                         const RectI& dstBounds)
+{
+    RectI dstRoi;
+
+    if ( !roi.intersect(dstBounds, &dstRoi) ) {
+        return;
+    }
+    RectI srcRect = srcBounds;
+    if ( srcRect.isNull() ) {
+        ///Nothing to read from: every pixel is black
+        srcRect.clear();
+    }
+
+    switch (nComps) {
+    case 1:
+        resampleWithMipMaps<1>(srcPixels, srcRect, dstToSrc, filter, dstRoi, dstPixels, dstBounds);
+        break;
+    case 2:
+        resampleWithMipMaps<2>(srcPixels, srcRect, dstToSrc, filter, dstRoi, dstPixels, dstBounds);
+        break;
+    case 3:
+        resampleWithMipMaps<3>(srcPixels, srcRect, dstToSrc, filter, dstRoi, dstPixels, dstBounds);
+        break;
+    case 4:
+        resampleWithMipMaps<4>(srcPixels, srcRect, dstToSrc, filter, dstRoi, dstPixels, dstBounds);
+        break;
+    default:
+        assert(false);
+        break;
+    }
+}
+
+bool
+ImageResampler::resample(const Image& src,
+                         const RectI& srcRoI,
+                         const Transform::Matrix3x3& srcToDst,
+                         ResampleFilterEnum filter,
+                         const RectI& roi,
+                         Image* dst)
+{
+    assert(dst);
+    if ( (src.getBitDepth() != eImageBitDepthFloat) || (dst->getBitDepth() != eImageBitDepthFloat) ||
+         ( src.getComponentsCount() != dst->getComponentsCount() ) || (src.getComponentsCount() > 4) ||
+         ( src.getMipMapLevel() != dst->getMipMapLevel() ) ) {
+        return false;
+    }
+    double det = Transform::matDeterminant(srcToDst);
+    if (det == 0.) {
+        return false;
+    }
+    Transform::Matrix3x3 dstToSrc = Transform::matInverse(srcToDst, det);
+
+    ///Only the srcRoI was rendered, the rest of the bounds of src may hold anything
+    RectI srcBounds = src.getBounds();
+    RectI srcRect;
+    if ( !srcRoI.intersect(srcBounds, &srcRect) ) {
+        srcRect.clear();
+    }
+    int nComps = (int)src.getComponentsCount();
+    RectI dstBounds = dst->getBounds();
+    Image::ReadAccess srcAcc = src.getReadRights();
+    Image::WriteAccess dstAcc = dst->getWriteRights();
+    const float* srcPixels = srcRect.isNull() ? 0 : (const float*)srcAcc.pixelAt(srcRect.x1, srcRect.y1);
+    float* dstPixels = (float*)dstAcc.pixelAt(dstBounds.x1, dstBounds.y1);
+    if (!dstPixels) {
+        return false;
+    }
+
+    ///The rows of the packed source must hold the pixels of srcRect: when it is narrower than the bounds, the
+    ///window is copied
+    std::vector<float> window;
+    if ( srcPixels && ( srcRect.width() != srcBounds.width() ) ) {
+        std::size_t rowElements = (std::size_t)srcRect.width() * nComps;
+        window.resize(rowElements * srcRect.height());
+        for (int y = srcRect.y1; y < srcRect.y2; ++y) {
+            std::memcpy( &window[(std::size_t)(y - srcRect.y1) * rowElements], srcAcc.pixelAt(srcRect.x1, y), rowElements * sizeof(float) );
+        }
+        srcPixels = &window[0];
+    }
+
+    resample(srcPixels, srcRect, nComps, dstToSrc, filter, roi, dstPixels, dstBounds);
+
+    return true;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,113 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef IMAGERESAMPLER_H
+#define IMAGERESAMPLER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/RectI.h"
+#include "Engine/Transform.h"
+#include "Engine/EngineFwd.h"
+
+///Minification is never done with more than this many levels of mipmaps
+#define NATRON_IMAGE_RESAMPLER_MAX_MIPMAP_LEVEL 16
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The filters of the ImageResampler
+ **/
+enum ResampleFilterEnum
+{
+    eResampleFilterBilinear = 0, //< triangle filter, 2x2 pixels when magnifying
+    eResampleFilterCubic, //< Keys cubic (Catmull-Rom), 4x4 pixels when magnifying
+    eResampleFilterLanczos //< Lanczos with 3 lobes, 6x6 pixels when magnifying
+};
+
+/**
+ * @brief Applies a transform to an image in a single pass.
+ * This is used by the host to apply a chain of transforms concatenated by EffectInstance::tryConcatenateTransforms():
+ * the result of the whole chain is resampled once from the image upstream of the chain.
+ *
+ * The filter is separable and its weights are computed for each destination pixel around the position of its center
+ * in the source image, so that perspective transforms (e.g: CornerPin) are supported.
+ * When the transform shrinks the image, the filter is widened by the scale factor and, past a factor of 2, the source
+ * is first box-filtered down to the mipmap level matching the scale so that the number of pixels read per destination
+ * pixel stays bounded.
+ * Pixels outside of the source bounds, or of the part of the source image that was rendered, are black and
+ * transparent. The cubic and Lanczos filters may overshoot, the
+ * result is not clamped.
+ *
+ * Only float images are handled: the pixel loops are written over a fixed number of components so that the compiler
+ * vectorizes them.
+ **/
+class ImageResampler
+{
+public:
+
+    /**
+     * @brief Fills the roi of dst with src transformed by srcToDst.
+     * srcToDst maps the pixel coordinates of src to the pixel coordinates of dst, both images must have the same
+     * mipmap level, components and a float bit depth. Returns false if it is not the case or if srcToDst cannot be inverted.
+     * Only the pixels of src within srcRoI are read, i.e: the region of src that was rendered, which may be smaller
+     * than its bounds. The others are black.
+     **/
+    static bool resample(const Image& src,
+                         const RectI& srcRoI,
+                         const Transform::Matrix3x3& srcToDst,
+                         ResampleFilterEnum filter,
+                         const RectI& roi,
+                         Image* dst);
+
+    /**
+     * @brief Same as above on packed buffers of nComps floats per pixel (1 to 4), each row holding the pixels of the
+     * bounds. dstToSrc maps the pixel coordinates of dst to the pixel coordinates of src.
+     **/
+    static void resample(const float* srcPixels,
+                         const RectI& srcBounds,
+                         int nComps,
+                         const Transform::Matrix3x3& dstToSrc,
+                         ResampleFilterEnum filter,
+                         const RectI& roi,
+                         float* dstPixels,
+                         const RectI& dstBounds);
+
+    /**
+     * @brief The mipmap level of the source the roi is resampled from: 0 unless the transform shrinks the source by
+     * a factor of 2 or more around the center of the roi.
+     **/
+    static unsigned int getMipMapLevel(const Transform::Matrix3x3& dstToSrc, const RectI& roi);
+
+    /**
+     * @brief The distance from the center of the filter past which its weights are 0, in source pixels, when magnifying
+     **/
+    static double getFilterSupport(ResampleFilterEnum filter);
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // IMAGERESAMPLER_H
@@ -48,6 +48,26 @@ double interpolate(double tcur, const double vcur, //start control point
                    KeyframeTypeEnum interp,
                    KeyframeTypeEnum interpNext) WARN_UNUSED_RETURN;
 
+/**
+ * @brief Computes the coefficients of the cubic used by interpolate() on the segment [tcur,tnext], so that
+ * the segment can be evaluated many times with cubicEvalAt() without recomputing them.
+ * The actual bounds of the normalized segment are returned in tstart and tend: they differ from
+ * tcur and tnext before the first and after the last keyframe.
+ **/
+void cubicCoeffs(double tcur, const double vcur, //start control point
+                 const double vcurDerivRight, //being the derivative dv/dt at tcur
+                 const double vnextDerivLeft, //being the derivative dv/dt at tnext
+                 double tnext, const double vnext, //end control point
+                 KeyframeTypeEnum interp,
+                 KeyframeTypeEnum interpNext,
+                 double *tstart, double *tend,
+                 double *c0, double *c1, double *c2, double *c3);
+
+/// evaluate at currentTime the cubic computed by cubicCoeffs(). Gives the same result as interpolate().
+double cubicEvalAt(double tstart, double tend,
+                   double c0, double c1, double c2, double c3,
+                   double currentTime) WARN_UNUSED_RETURN;
+
 /// derive at currentTime. The derivative is with respect to currentTime
 double derive(double tcur, const double vcur, //start control point
               const double vcurDerivRight, //being the derivative dv/dt at tcur
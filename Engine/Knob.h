@@ -638,6 +638,12 @@ public:
     virtual bool onKeyFrameSet(double time, ViewSpec view, int dimension) = 0;
     virtual bool onKeyFrameSet(double time, ViewSpec view, const KeyFrame& key,int dimension) = 0;
     virtual bool setKeyFrame(const KeyFrame& key, ViewSpec view,  int dimension,ValueChangedReasonEnum reason) = 0;
+    
+    /**
+     * @brief Adds all the given keyframes at once to the animation curve of the given dimension (see Curve::addKeyFrames).
+     * Unlike calling setKeyFrame for each key, the knob is evaluated once and a single keyframes notification is emitted.
+     **/
+    virtual void setKeyFrames(const std::vector<KeyFrame>& keys, ViewSpec view, int dimension, ValueChangedReasonEnum reason) = 0;
 
     /**
      * @brief Called when the current time of the timeline changes.
@@ -1595,6 +1601,7 @@ public:
                                               bool hasChanged = false); //!< set to true if any previous dimension of the same knob have changed
 
     virtual bool setKeyFrame(const KeyFrame& key, ViewSpec view, int dimension,ValueChangedReasonEnum reason) OVERRIDE FINAL;
+    virtual void setKeyFrames(const std::vector<KeyFrame>& keys, ViewSpec view, int dimension, ValueChangedReasonEnum reason) OVERRIDE FINAL;
     
     /**
      * @brief Set the value of the knob in the given dimension with the given reason.
@@ -1682,6 +1689,17 @@ public:
                                   ViewSpec view,
                                   int dimension);
     
+    /**
+     * @brief Sets a keyframe at each of the given times with the value at the same index in values, as
+     * setValueAtTime would, but all keyframes are added at once with setKeyFrames.
+     * The times should be sorted in increasing order.
+     **/
+    void setValuesAtTimes(const std::vector<double>& times,
+                          const std::vector<T>& values,
+                          ViewSpec view,
+                          int dimension,
+                          ValueChangedReasonEnum reason);
+    
     void setValuesAtTime(double time,
                          const T& value0,
                          const T& value1,
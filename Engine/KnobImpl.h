@@ -1907,6 +1907,74 @@ Knob<T>::setKeyFrame(const KeyFrame& key,
     return ret;
 }
 
+template<typename T>
+void
+Knob<T>::setKeyFrames(const std::vector<KeyFrame>& keys,
+                      ViewSpec view,
+                      int dimension,
+                      ValueChangedReasonEnum reason)
+{
+    if ( keys.empty() ) {
+        return;
+    }
+    boost::shared_ptr<Curve> curve;
+    KnobHolder* holder = getHolder();
+    bool useGuiCurve = (!holder || !holder->isSetValueCurrentlyPossible()) && getKnobGuiPointer();
+    
+    if (!useGuiCurve) {
+        assert(holder);
+        curve = getCurve(view,dimension);
+    } else {
+        curve = getGuiCurve(view,dimension);
+        setGuiCurveHasChanged(view, dimension,true);
+    }
+    
+    std::list<double> keysAdded;
+    curve->addKeyFrames(keys, &keysAdded);
+    
+    if (holder) {
+        holder->setHasAnimation(true);
+    }
+    
+    if (!useGuiCurve) {
+        guiCurveCloneInternalCurve(eCurveChangeReasonInternal, view, dimension, reason);
+        if ( _signalSlotHandler && !keysAdded.empty() ) {
+            _signalSlotHandler->s_multipleKeyFramesSet(keysAdded, view, dimension, (int)reason);
+        }
+        evaluateValueChange(dimension, getCurrentTime(), view, reason);
+    }
+}
+
+template<typename T>
+void
+Knob<T>::setValuesAtTimes(const std::vector<double>& times,
+                          const std::vector<T>& values,
+                          ViewSpec view,
+                          int dimension,
+                          ValueChangedReasonEnum reason)
+{
+    assert( times.size() == values.size() );
+    assert(dimension >= 0 && dimension < getDimension());
+    if ( times.empty() ) {
+        return;
+    }
+    if (!canAnimate() || !isAnimationEnabled()) {
+        qDebug() << "WARNING: Attempting to call setValuesAtTimes on " << getName().c_str() << " which does not have animation enabled.";
+        KeyFrame k;
+        ignore_result( setValue(values.back(), view, dimension, reason, &k) );
+        
+        return;
+    }
+    
+    boost::shared_ptr<Curve> curve = getCurve(view, dimension, true);
+    assert(curve);
+    std::vector<KeyFrame> keys( times.size() );
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        makeKeyFrame(curve.get(), times[i], view, values[i], &keys[i]);
+    }
+    setKeyFrames(keys, view, dimension, reason);
+}
+
 template<typename T>
 bool
 Knob<T>::onKeyFrameSet(double /*time*/,
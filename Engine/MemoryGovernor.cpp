@@ -0,0 +1,505 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "MemoryGovernor.h"
+
+#include <algorithm> // min, max
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <list>
+#include <sstream>
+
+#include <QtCore/QMutex>
+
+#include "Global/MemoryInfo.h"
+
+#include "Engine/FStreamsSupport.h"
+#include "Engine/Timer.h"
+
+//Values at or above this are used by cgroup v1 to mean "no limit"
+#define NATRON_CGROUP_V1_UNLIMITED 0x4000000000000000ULL
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+bool
+readFirstToken(const std::string& filename,
+               std::string* token)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, filename);
+    if (!ifile) {
+        return false;
+    }
+    ifile >> *token;
+
+    return !token->empty();
+}
+
+bool
+fileExists(const std::string& filename)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, filename);
+
+    return (bool)ifile;
+}
+
+/**
+ * @brief Reads a size in bytes. A limit of "max" (cgroup v2) or a huge value (cgroup v1) is returned as 0.
+ **/
+bool
+readSize(const std::string& filename,
+         U64* value)
+{
+    std::string token;
+
+    if ( !readFirstToken(filename, &token) ) {
+        return false;
+    }
+    if (token == "max") {
+        *value = 0;
+
+        return true;
+    }
+    std::istringstream ss(token);
+    U64 v;
+    if ( !(ss >> v) ) {
+        return false;
+    }
+    *value = v >= NATRON_CGROUP_V1_UNLIMITED ? 0 : v;
+
+    return true;
+}
+
+/**
+ * @brief Reads the value of key in a file made of "key value" lines, such as memory.stat
+ **/
+bool
+readKeyValue(const std::string& filename,
+             const std::string& key,
+             U64* value)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, filename);
+    if (!ifile) {
+        return false;
+    }
+    std::string k;
+    U64 v;
+    while (ifile >> k >> v) {
+        if (k == key) {
+            *value = v >= NATRON_CGROUP_V1_UNLIMITED ? 0 : v;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/**
+ * @brief Reads the avg10 value of the "some" line of a PSI file, e.g:
+ * some avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ * full avg10=0.00 avg60=0.00 avg300=0.00 total=0
+ **/
+bool
+readPressureAvg10(const std::string& filename,
+                  double* pressure)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, filename);
+    if (!ifile) {
+        return false;
+    }
+    std::string line;
+    while ( std::getline(ifile, line) ) {
+        if (line.compare(0, 5, "some ") != 0) {
+            continue;
+        }
+        std::size_t found = line.find("avg10=");
+        if (found == std::string::npos) {
+            return false;
+        }
+
+        *pressure = std::atof( line.c_str() + found + 6 );
+
+        return true;
+    }
+
+    return false;
+}
+
+/**
+ * @brief Returns the path of the memory cgroup of the process relative to the root of the hierarchy, as listed
+ * in selfCgroupFile, or an empty string if not found.
+ **/
+std::string
+findCgroupPath(const std::string& selfCgroupFile,
+               bool v2)
+{
+    FStreamsSupport::ifstream ifile;
+
+    FStreamsSupport::open(&ifile, selfCgroupFile);
+    if (!ifile) {
+        return std::string();
+    }
+    std::string line;
+    while ( std::getline(ifile, line) ) {
+        //Lines are formatted as hierarchy-ID:controller-list:cgroup-path
+        std::size_t first = line.find(':');
+        std::size_t second = first == std::string::npos ? std::string::npos : line.find(':', first + 1);
+        if (second == std::string::npos) {
+            continue;
+        }
+        std::string controllers = line.substr(first + 1, second - first - 1);
+        std::string path = line.substr(second + 1);
+        if (v2) {
+            if ( controllers.empty() && (line.compare(0, first, "0") == 0) ) {
+                return path;
+            }
+        } else {
+            std::string list = "," + controllers + ",";
+            if (list.find(",memory,") != std::string::npos) {
+                return path;
+            }
+        }
+    }
+
+    return std::string();
+}
+
+double
+budgetFactorFromPressure(double pressure)
+{
+    if (pressure <= NATRON_MEMORY_PRESSURE_LOW) {
+        return 1.;
+    }
+    if (pressure >= NATRON_MEMORY_PRESSURE_HIGH) {
+        return NATRON_MEMORY_BUDGET_MIN_FACTOR;
+    }
+    double t = (pressure - NATRON_MEMORY_PRESSURE_LOW) / (NATRON_MEMORY_PRESSURE_HIGH - NATRON_MEMORY_PRESSURE_LOW);
+
+    return 1. - t * (1. - NATRON_MEMORY_BUDGET_MIN_FACTOR);
+}
+} // anon namespace
+
+struct MemoryGovernorPrivate
+{
+    //The following are set in the constructor and never change afterwards, they can be read without the lock
+    int version;
+
+    //The directory of the cgroup of the process
+    std::string cgroupDir;
+
+    //The directories from the cgroup of the process up to the root of the hierarchy: the effective limit is the lowest of their limits
+    std::list<std::string> limitDirs;
+    U64 systemTotalRAM;
+
+    //Protects all members below
+    mutable QMutex lock;
+    U64 limit;
+    U64 usage;
+    double pressure;
+    double budgetFactor;
+    qint64 pluginMemory;
+    bool refreshed;
+    timeval lastRefresh;
+
+    MemoryGovernorPrivate()
+        : version(0)
+        , cgroupDir()
+        , limitDirs()
+        , systemTotalRAM(0)
+        , lock()
+        , limit(0)
+        , usage(0)
+        , pressure(-1.)
+        , budgetFactor(1.)
+        , pluginMemory(0)
+        , refreshed(false)
+        , lastRefresh()
+    {
+    }
+
+    void findCgroup(const std::string& cgroupRoot, const std::string& selfCgroupFile);
+
+    U64 readLimit() const;
+
+    U64 readUsage() const;
+
+    double readPressure() const;
+
+    U64 getTotalRAM() const
+    {
+        return limit == 0 ? systemTotalRAM : std::min(limit, systemTotalRAM);
+    }
+};
+
+void
+MemoryGovernorPrivate::findCgroup(const std::string& cgroupRoot,
+                                  const std::string& selfCgroupFile)
+{
+    std::string root;
+
+    if ( fileExists(cgroupRoot + "/cgroup.controllers") ) {
+        version = 2;
+        root = cgroupRoot;
+    } else if ( fileExists(cgroupRoot + "/memory/memory.limit_in_bytes") ) {
+        version = 1;
+        root = cgroupRoot + "/memory";
+    } else {
+        return;
+    }
+
+    //In a container with its own cgroup namespace, the cgroup of the process is the root of the hierarchy and its path is "/".
+    //Otherwise the path may be one of the host that is not visible from here, in which case we fall back on the root.
+    std::string path = findCgroupPath(selfCgroupFile, version == 2);
+    while ( !path.empty() && (path[path.size() - 1] == '/') ) {
+        path.erase(path.size() - 1);
+    }
+    std::string usageFile = version == 2 ? "/memory.current" : "/memory.usage_in_bytes";
+    if ( path.empty() || !fileExists(root + path + usageFile) ) {
+        path.clear();
+    }
+    cgroupDir = root + path;
+
+    for (;;) {
+        limitDirs.push_back(root + path);
+        if ( path.empty() ) {
+            break;
+        }
+        std::size_t found = path.find_last_of('/');
+        path.erase(found == std::string::npos ? 0 : found);
+    }
+}
+
+U64
+MemoryGovernorPrivate::readLimit() const
+{
+    U64 ret = 0;
+
+    if (version == 0) {
+        return ret;
+    }
+    for (std::list<std::string>::const_iterator it = limitDirs.begin(); it != limitDirs.end(); ++it) {
+        std::list<std::string> files;
+        if (version == 2) {
+            files.push_back(*it + "/memory.max");
+            files.push_back(*it + "/memory.high");
+        } else {
+            files.push_back(*it + "/memory.limit_in_bytes");
+        }
+        for (std::list<std::string>::iterator it2 = files.begin(); it2 != files.end(); ++it2) {
+            U64 value;
+            if ( readSize(*it2, &value) && (value != 0) ) {
+                ret = ret == 0 ? value : std::min(ret, value);
+            }
+        }
+    }
+    if (version == 1) {
+        U64 value;
+        if ( readKeyValue(cgroupDir + "/memory.stat", "hierarchical_memory_limit", &value) && (value != 0) ) {
+            ret = ret == 0 ? value : std::min(ret, value);
+        }
+    }
+
+    return ret;
+}
+
+U64
+MemoryGovernorPrivate::readUsage() const
+{
+    U64 usage = 0;
+
+    if ( (version == 0) || !readSize(cgroupDir + (version == 2 ? "/memory.current" : "/memory.usage_in_bytes"), &usage) ) {
+        return 0;
+    }
+
+    //The usage includes the page cache: inactive file pages are reclaimed by the kernel before the cgroup runs out of memory
+    U64 inactiveFile;
+    if ( readKeyValue(cgroupDir + "/memory.stat", version == 2 ? "inactive_file" : "total_inactive_file", &inactiveFile) ) {
+        usage = inactiveFile < usage ? usage - inactiveFile : 0;
+    }
+
+    return usage;
+}
+
+double
+MemoryGovernorPrivate::readPressure() const
+{
+    double ret;
+
+    if ( (version != 2) || !readPressureAvg10(cgroupDir + "/memory.pressure", &ret) ) {
+        return -1.;
+    }
+
+    return ret;
+}
+
+MemoryGovernor::MemoryGovernor(const std::string& cgroupRoot,
+                               const std::string& selfCgroupFile,
+                               U64 systemTotalRAM)
+    : _imp( new MemoryGovernorPrivate() )
+{
+    _imp->systemTotalRAM = systemTotalRAM == 0 ? getSystemTotalRAM_conditionnally() : systemTotalRAM;
+    _imp->findCgroup(cgroupRoot, selfCgroupFile);
+    refresh(true);
+}
+
+MemoryGovernor::~MemoryGovernor()
+{
+}
+
+int
+MemoryGovernor::getCgroupVersion() const
+{
+    return _imp->version;
+}
+
+bool
+MemoryGovernor::refresh(bool force)
+{
+    timeval now;
+
+    gettimeofday(&now, 0);
+    {
+        QMutexLocker k(&_imp->lock);
+        if (!force && _imp->refreshed) {
+            double elapsedMS = (now.tv_sec - _imp->lastRefresh.tv_sec) * 1000. + (now.tv_usec - _imp->lastRefresh.tv_usec) / 1000.;
+            if (elapsedMS < NATRON_MEMORY_GOVERNOR_REFRESH_INTERVAL_MS) {
+                return false;
+            }
+        }
+        _imp->refreshed = true;
+        _imp->lastRefresh = now;
+    }
+
+    //Read the files without holding the lock
+    U64 limit = _imp->readLimit();
+    U64 usage = _imp->readUsage();
+    double pressure = _imp->readPressure();
+    double factor = budgetFactorFromPressure(pressure);
+
+    QMutexLocker k(&_imp->lock);
+    _imp->limit = limit;
+    _imp->usage = usage;
+    _imp->pressure = pressure;
+
+    //Avoid resizing the caches for insignificant changes of the pressure
+    if ( (factor == _imp->budgetFactor) ||
+         ( (std::abs(factor - _imp->budgetFactor) < 0.05) && (factor != 1.) && (factor != NATRON_MEMORY_BUDGET_MIN_FACTOR) ) ) {
+        return false;
+    }
+    _imp->budgetFactor = factor;
+
+    return true;
+}
+
+U64
+MemoryGovernor::getTotalRAM() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->getTotalRAM();
+}
+
+U64
+MemoryGovernor::getFreeRAM() const
+{
+    U64 systemFree = getAmountFreePhysicalRAM();
+    QMutexLocker k(&_imp->lock);
+
+    if (_imp->limit == 0) {
+        return systemFree;
+    }
+
+    return std::min(systemFree, _imp->usage < _imp->limit ? _imp->limit - _imp->usage : 0);
+}
+
+void
+MemoryGovernor::registerFreedMemory(U64 nBytes)
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->usage = nBytes < _imp->usage ? _imp->usage - nBytes : 0;
+}
+
+void
+MemoryGovernor::registerAllocatedMemory(U64 nBytes)
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->usage += nBytes;
+}
+
+double
+MemoryGovernor::getBudgetFactor() const
+{
+    QMutexLocker k(&_imp->lock);
+
+    return _imp->budgetFactor;
+}
+
+void
+MemoryGovernor::registerPluginMemory(qint64 nBytes)
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->pluginMemory += nBytes;
+    assert(_imp->pluginMemory >= 0);
+}
+
+bool
+MemoryGovernor::canAllocatePluginMemory(U64 nBytes) const
+{
+    QMutexLocker k(&_imp->lock);
+    U64 budget = _imp->getTotalRAM() * _imp->budgetFactor;
+
+    return (U64)_imp->pluginMemory + nBytes <= budget;
+}
+
+void
+MemoryGovernor::getStats(MemoryStats* stats) const
+{
+    stats->freeRAM = getFreeRAM();
+
+    QMutexLocker k(&_imp->lock);
+    stats->systemTotalRAM = _imp->systemTotalRAM;
+    stats->cgroupLimit = _imp->limit;
+    stats->cgroupUsage = _imp->usage;
+    stats->pressure = _imp->pressure;
+    stats->budgetFactor = _imp->budgetFactor;
+    stats->totalRAM = _imp->getTotalRAM();
+    stats->pluginMemorySize = _imp->pluginMemory;
+    stats->pluginMemoryBudget = stats->totalRAM * _imp->budgetFactor;
+}
+
+NATRON_NAMESPACE_EXIT;
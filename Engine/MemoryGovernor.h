@@ -0,0 +1,200 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef MEMORYGOVERNOR_H
+#define MEMORYGOVERNOR_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include <QtCore/QtGlobal>
+
+#include "Global/GlobalDefines.h"
+#include "Engine/EngineFwd.h"
+
+///Where the cgroup hierarchy is mounted
+#define NATRON_CGROUP_ROOT "/sys/fs/cgroup"
+
+///The file listing the cgroups of the process
+#define NATRON_PROC_SELF_CGROUP "/proc/self/cgroup"
+
+///The cgroup files are read at most once every NATRON_MEMORY_GOVERNOR_REFRESH_INTERVAL_MS milliseconds
+#define NATRON_MEMORY_GOVERNOR_REFRESH_INTERVAL_MS 250
+
+///Below this memory pressure (percentage of time stalled over the last 10 seconds) the memory budgets are not reduced
+#define NATRON_MEMORY_PRESSURE_LOW 10.
+
+///At or above this memory pressure the memory budgets are reduced to NATRON_MEMORY_BUDGET_MIN_FACTOR
+#define NATRON_MEMORY_PRESSURE_HIGH 60.
+
+///The lowest factor applied to the memory budgets
+#define NATRON_MEMORY_BUDGET_MIN_FACTOR 0.25
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief A snapshot of the memory budgets and of the memory in use, as seen by the MemoryGovernor.
+ * Sizes are in bytes.
+ **/
+struct MemoryStats
+{
+    //The RAM of the system
+    U64 systemTotalRAM;
+
+    //The memory limit of the cgroup of the process or 0 if there is none
+    U64 cgroupLimit;
+
+    //The memory used by the cgroup, without the file pages the kernel can reclaim
+    U64 cgroupUsage;
+
+    //The percentage of time some tasks of the cgroup were stalled on memory over the last 10 seconds, or -1 if unknown
+    double pressure;
+
+    //The factor applied to the budgets below, reduced when the memory pressure rises
+    double budgetFactor;
+
+    //The memory available to Natron: the smallest of the system RAM and the cgroup limit
+    U64 totalRAM;
+    U64 freeRAM;
+
+    U64 nodeCacheSize;
+    U64 nodeCacheBudget;
+    U64 viewerCacheSize;
+    U64 viewerCacheBudget;
+    U64 pluginMemorySize;
+    U64 pluginMemoryBudget;
+    //The part of pluginMemorySize kept free by the PluginMemoryPool for the next allocations
+    U64 pluginMemoryPoolSize;
+
+    MemoryStats()
+        : systemTotalRAM(0)
+        , cgroupLimit(0)
+        , cgroupUsage(0)
+        , pressure(-1.)
+        , budgetFactor(1.)
+        , totalRAM(0)
+        , freeRAM(0)
+        , nodeCacheSize(0)
+        , nodeCacheBudget(0)
+        , viewerCacheSize(0)
+        , viewerCacheBudget(0)
+        , pluginMemorySize(0)
+        , pluginMemoryBudget(0)
+        , pluginMemoryPoolSize(0)
+    {
+    }
+};
+
+/**
+ * @brief Determines how much memory Natron may use. When running in a container the cgroup (v1 or v2)
+ * memory limit is usually much smaller than the RAM of the host: it is read from the cgroup hierarchy, along with the
+ * memory currently used by the cgroup and its memory pressure (PSI, cgroup v2 only).
+ * The budgets of the caches and of the memory allocated by plug-ins are scaled by getBudgetFactor() which decreases
+ * as the memory pressure rises, so that Natron evicts cache entries before the kernel OOM-kills it.
+ * When there is no cgroup limit, the system RAM is used, as before.
+ * All functions are thread-safe.
+ **/
+struct MemoryGovernorPrivate;
+class MemoryGovernor
+{
+public:
+
+    /**
+     * @brief The cgroup of the process is looked up in selfCgroupFile (formatted as /proc/self/cgroup) and the cgroup files
+     * are read under cgroupRoot. If systemTotalRAM is 0, the RAM of the system is queried.
+     **/
+    MemoryGovernor(const std::string& cgroupRoot = std::string(NATRON_CGROUP_ROOT),
+                   const std::string& selfCgroupFile = std::string(NATRON_PROC_SELF_CGROUP),
+                   U64 systemTotalRAM = 0);
+
+    ~MemoryGovernor();
+
+    /**
+     * @brief Returns 1 or 2 depending on the cgroup version found, or 0 if no memory cgroup was found.
+     **/
+    int getCgroupVersion() const;
+
+    /**
+     * @brief Re-reads the cgroup limit, usage and memory pressure. Unless force is true, this does nothing if the
+     * last refresh was less than NATRON_MEMORY_GOVERNOR_REFRESH_INTERVAL_MS ago.
+     * @returns True if the budget factor changed: the caches maximum sizes should then be updated.
+     **/
+    bool refresh(bool force = false);
+
+    /**
+     * @brief The memory available to Natron: the smallest of the system RAM and the cgroup limit.
+     **/
+    U64 getTotalRAM() const;
+
+    /**
+     * @brief The memory that can still be allocated before reaching the cgroup limit or running out of system RAM.
+     * The cgroup usage is the one read by the last refresh(), plus the memory registered with registerAllocatedMemory()
+     * and minus the memory registered with registerFreedMemory() since: this is called before each allocation of the
+     * caches and of the plug-ins and must not read the cgroup files.
+     **/
+    U64 getFreeRAM() const;
+
+    /**
+     * @brief Accounts for memory freed by Natron, e.g: by evicting cache entries, until the cgroup usage is read again
+     * by the next refresh().
+     **/
+    void registerFreedMemory(U64 nBytes);
+
+    /**
+     * @brief Accounts for memory allocated by Natron, e.g: by the caches, until the cgroup usage is read again by the
+     * next refresh().
+     **/
+    void registerAllocatedMemory(U64 nBytes);
+
+    double getBudgetFactor() const;
+
+    /**
+     * @brief Accounts for memory allocated (positive) or freed (negative) by plug-ins.
+     **/
+    void registerPluginMemory(qint64 nBytes);
+
+    /**
+     * @brief Returns true if nBytes more can be allocated by plug-ins without exceeding their budget,
+     * which is the available memory scaled by the budget factor.
+     **/
+    bool canAllocatePluginMemory(U64 nBytes) const;
+
+    /**
+     * @brief Fills the fields of stats known to the governor, that is all but the caches and pool fields.
+     **/
+    void getStats(MemoryStats* stats) const;
+
+private:
+
+    boost::scoped_ptr<MemoryGovernorPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // MEMORYGOVERNOR_H
@@ -83,6 +83,29 @@ static PyObject* Sbk_AppFunc_addFormat(PyObject* self, PyObject* pyArg)
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_beginBatch(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // beginBatch()
+            cppSelf->beginBatch();
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject* Sbk_AppFunc_closeProject(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -213,6 +236,29 @@ static PyObject* Sbk_AppFunc_createNode(PyObject* self, PyObject* args, PyObject
         return 0;
 }
 
+static PyObject* Sbk_AppFunc_endBatch(PyObject* self)
+{
+    AppWrapper* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = (AppWrapper*)((::App*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_APP_IDX], (SbkObject*)self));
+
+    // Call function/method
+    {
+
+        if (!PyErr_Occurred()) {
+            // endBatch()
+            cppSelf->endBatch();
+        }
+    }
+
+    if (PyErr_Occurred()) {
+        return 0;
+    }
+    Py_RETURN_NONE;
+}
+
 static PyObject* Sbk_AppFunc_getAppID(PyObject* self)
 {
     AppWrapper* cppSelf = 0;
@@ -836,8 +882,10 @@ static PyObject* Sbk_AppFunc_writeToScriptEditor(PyObject* self, PyObject* pyArg
 
 static PyMethodDef Sbk_App_methods[] = {
     {"addFormat", (PyCFunction)Sbk_AppFunc_addFormat, METH_O},
+    {"beginBatch", (PyCFunction)Sbk_AppFunc_beginBatch, METH_NOARGS},
     {"closeProject", (PyCFunction)Sbk_AppFunc_closeProject, METH_NOARGS},
     {"createNode", (PyCFunction)Sbk_AppFunc_createNode, METH_VARARGS|METH_KEYWORDS},
+    {"endBatch", (PyCFunction)Sbk_AppFunc_endBatch, METH_NOARGS},
     {"getAppID", (PyCFunction)Sbk_AppFunc_getAppID, METH_NOARGS},
     {"getProjectParam", (PyCFunction)Sbk_AppFunc_getProjectParam, METH_O},
     {"getViewNames", (PyCFunction)Sbk_AppFunc_getViewNames, METH_NOARGS},
@@ -24,6 +24,7 @@ NATRON_NAMESPACE_USING
 #include <PyParameter.h>
 #include <PyRoto.h>
 #include <RectD.h>
+#include <RectI.h>
 #include <list>
 #include <map>
 #include <vector>
@@ -592,6 +593,84 @@ static PyObject* Sbk_EffectFunc_getFrameRate(PyObject* self)
     return pyResult;
 }
 
+static PyObject* Sbk_EffectFunc_getImage(PyObject* self, PyObject* args)
+{
+    ::Effect* cppSelf = 0;
+    SBK_UNUSED(cppSelf)
+    if (!Shiboken::Object::isValid(self))
+        return 0;
+    cppSelf = ((::Effect*)Shiboken::Conversions::cppPointer(SbkNatronEngineTypes[SBK_EFFECT_IDX], (SbkObject*)self));
+    PyObject* pyResult = 0;
+    int overloadId = -1;
+    PythonToCppFunc pythonToCpp[] = { 0, 0, 0, 0 };
+    SBK_UNUSED(pythonToCpp)
+    int numArgs = PyTuple_GET_SIZE(args);
+    PyObject* pyArgs[] = {0, 0, 0, 0};
+
+    // invalid argument lengths
+
+
+    if (!PyArg_UnpackTuple(args, "getImage", 4, 4, &(pyArgs[0]), &(pyArgs[1]), &(pyArgs[2]), &(pyArgs[3])))
+        return 0;
+
+
+    // Overloaded function decisor
+    // 0: getImage(double,int,RectI,ImageLayer)const
+    if (numArgs == 4
+        && (pythonToCpp[0] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<double>(), (pyArgs[0])))
+        && (pythonToCpp[1] = Shiboken::Conversions::isPythonToCppConvertible(Shiboken::Conversions::PrimitiveTypeConverter<int>(), (pyArgs[1])))
+        && (pythonToCpp[2] = Shiboken::Conversions::isPythonToCppReferenceConvertible((SbkObjectType*)SbkNatronEngineTypes[SBK_RECTI_IDX], (pyArgs[2])))
+        && (pythonToCpp[3] = Shiboken::Conversions::isPythonToCppReferenceConvertible((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], (pyArgs[3])))) {
+        overloadId = 0; // getImage(double,int,RectI,ImageLayer)const
+    }
+
+    // Function signature not found.
+    if (overloadId == -1) goto Sbk_EffectFunc_getImage_TypeError;
+
+    // Call function/method
+    {
+        double cppArg0;
+        pythonToCpp[0](pyArgs[0], &cppArg0);
+        int cppArg1;
+        pythonToCpp[1](pyArgs[1], &cppArg1);
+        if (!Shiboken::Object::isValid(pyArgs[2]))
+            return 0;
+        ::RectI* cppArg2;
+        pythonToCpp[2](pyArgs[2], &cppArg2);
+        if (!Shiboken::Object::isValid(pyArgs[3]))
+            return 0;
+        ::ImageLayer cppArg3_local = ::ImageLayer(::std::string(), ::std::string(), ::std::vector<std::string >());
+        ::ImageLayer* cppArg3 = &cppArg3_local;
+        if (Shiboken::Conversions::isImplicitConversion((SbkObjectType*)SbkNatronEngineTypes[SBK_IMAGELAYER_IDX], pythonToCpp[3]))
+            pythonToCpp[3](pyArgs[3], &cppArg3_local);
+        else
+            pythonToCpp[3](pyArgs[3], &cppArg3);
+
+
+        if (!PyErr_Occurred()) {
+            // getImage(double,int,RectI,ImageLayer)const
+            // Begin code injection
+
+            pyResult = cppSelf->getImage(cppArg0,cppArg1,*cppArg2,*cppArg3);
+
+            // End of code injection
+
+
+        }
+    }
+
+    if (PyErr_Occurred() || !pyResult) {
+        Py_XDECREF(pyResult);
+        return 0;
+    }
+    return pyResult;
+
+    Sbk_EffectFunc_getImage_TypeError:
+        const char* overloads[] = {"float, int, NatronEngine.RectI, NatronEngine.ImageLayer", 0};
+        Shiboken::setErrorAboutWrongArguments(args, "NatronEngine.Effect.getImage", overloads);
+        return 0;
+}
+
 static PyObject* Sbk_EffectFunc_getInput(PyObject* self, PyObject* pyArg)
 {
     ::Effect* cppSelf = 0;
@@ -1508,6 +1587,7 @@ static PyMethodDef Sbk_Effect_methods[] = {
     {"getColor", (PyCFunction)Sbk_EffectFunc_getColor, METH_NOARGS},
     {"getCurrentTime", (PyCFunction)Sbk_EffectFunc_getCurrentTime, METH_NOARGS},
     {"getFrameRate", (PyCFunction)Sbk_EffectFunc_getFrameRate, METH_NOARGS},
+    {"getImage", (PyCFunction)Sbk_EffectFunc_getImage, METH_VARARGS},
     {"getInput", (PyCFunction)Sbk_EffectFunc_getInput, METH_O},
     {"getInputLabel", (PyCFunction)Sbk_EffectFunc_getInputLabel, METH_O},
     {"getLabel", (PyCFunction)Sbk_EffectFunc_getLabel, METH_NOARGS},
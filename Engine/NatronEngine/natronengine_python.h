@@ -131,11 +131,12 @@ extern SbkConverter** SbkNatronEngineTypeConverters;
 #define SBK_NATRONENGINE_STD_LIST_EFFECTPTR_IDX                      7 // std::list<Effect * >
 #define SBK_NATRONENGINE_STD_LIST_STD_STRING_IDX                     8 // std::list<std::string >
 #define SBK_NATRONENGINE_STD_LIST_INT_IDX                            9 // const std::list<int > &
-#define SBK_NATRONENGINE_STD_MAP_IMAGELAYER_EFFECTPTR_IDX            10 // std::map<ImageLayer, Effect * >
-#define SBK_NATRONENGINE_QLIST_QVARIANT_IDX                          11 // QList<QVariant >
-#define SBK_NATRONENGINE_QLIST_QSTRING_IDX                           12 // QList<QString >
-#define SBK_NATRONENGINE_QMAP_QSTRING_QVARIANT_IDX                   13 // QMap<QString, QVariant >
-#define SBK_NatronEngine_CONVERTERS_IDX_COUNT                        14
+#define SBK_NATRONENGINE_STD_LIST_DOUBLE_IDX                         10 // const std::list<double > &
+#define SBK_NATRONENGINE_STD_MAP_IMAGELAYER_EFFECTPTR_IDX            11 // std::map<ImageLayer, Effect * >
+#define SBK_NATRONENGINE_QLIST_QVARIANT_IDX                          12 // QList<QVariant >
+#define SBK_NATRONENGINE_QLIST_QSTRING_IDX                           13 // QList<QString >
+#define SBK_NATRONENGINE_QMAP_QSTRING_QVARIANT_IDX                   14 // QMap<QString, QVariant >
+#define SBK_NatronEngine_CONVERTERS_IDX_COUNT                        15
 
 // Macros for type check
 
@@ -29,6 +29,7 @@
 #include <algorithm> // min, max
 #include <bitset>
 #include <cassert>
+#include <set>
 #include <stdexcept>
 
 #include <boost/scoped_ptr.hpp>
@@ -50,6 +51,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/AppInstance.h"
 #include "Engine/AppManager.h"
 #include "Engine/Backdrop.h"
+#include "Engine/DamageHistory.h"
 #include "Engine/DiskCacheNode.h"
 #include "Engine/Dot.h"
 #include "Engine/EffectInstance.h"
@@ -252,6 +254,7 @@ struct Node::Implementation
     , renderInstancesSharedMutex(QMutex::Recursive)
     , knobsAge(0)
     , knobsAgeMutex()
+    , damageHistory()
     , masterNodeMutex()
     , masterNode()
     , nodeLinks()
@@ -453,6 +456,7 @@ struct Node::Implementation
     U64 knobsAge; //< the age of the knobs in this effect. It gets incremented every times the effect has its evaluate() function called.
     mutable QReadWriteLock knobsAgeMutex; //< protects knobsAge and hash
     Hash64 hash; //< recomputed everytime knobsAge is changed.
+    DamageHistory damageHistory; //< the last changes of the hash, to re-use the images rendered before them
     
     mutable QMutex masterNodeMutex; //< protects masterNode and nodeLinks
     NodeWPtr masterNode; //< this points to the master when the node is a clone
@@ -718,8 +722,11 @@ Node::load(const CreateNodeArgs& args)
         assert(args.reason == eCreateNodeReasonCopyPaste || args.reason == eCreateNodeReasonProjectLoad);
         
         if (group && !group->isCacheIDAlreadyTaken(args.serialization->getCacheID())) {
-            QMutexLocker k(&_imp->nameMutex);
-            _imp->cacheID = args.serialization->getCacheID();
+            {
+                QMutexLocker k(&_imp->nameMutex);
+                _imp->cacheID = args.serialization->getCacheID();
+            }
+            group->onNodeCacheIDSet(this, args.serialization->getCacheID());
         }
         if (/*!dontLoadName && */!nameSet && args.fixedName.isEmpty()) {
             const std::string& baseName = args.serialization->getNodeScriptName();
@@ -1398,6 +1405,9 @@ Node::computeHashInternal()
     }
     
     U64 oldHash,newHash;
+    ///The inputs the hash depends on, to find out what caused a change of the hash
+    std::vector<DamageInputState> inputStates;
+    ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>(_imp->effect.get());
     {
         QWriteLocker l(&_imp->knobsAgeMutex);
         
@@ -1416,8 +1426,6 @@ Node::computeHashInternal()
             attachedStrokeContextNode = attachedStroke->getContext()->getNode();
         }
         {
-            ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>(_imp->effect.get());
-            
             if (isViewer) {
                 int activeInput[2];
                 isViewer->getActiveInputs(activeInput[0], activeInput[1]);
@@ -1429,6 +1437,7 @@ Node::computeHashInternal()
                     }
                 }
             } else {
+                inputStates.resize( _imp->inputs.size() );
                 for (U32 i = 0; i < _imp->inputs.size(); ++i) {
                     NodePtr input = getInput(i);
                     if (input) {
@@ -1437,10 +1446,12 @@ Node::computeHashInternal()
                         if (attachedStroke && input == attachedStrokeContextNode) {
                             continue;
                         }
+                        U64 inputHash = input->getHashValue();
+                        inputStates[i] = DamageInputState(input.get(), inputHash);
                         ///Add the index of the input to its hash.
                         ///Explanation: if we didn't add this, just switching inputs would produce a similar
                         ///hash.
-                        _imp->hash.append(input->getHashValue() + i);
+                        _imp->hash.append(inputHash + i);
                     }
                 }
             }
@@ -1474,12 +1485,21 @@ Node::computeHashInternal()
 
     if (hashChanged) {
         _imp->effect->onNodeHashChanged(newHash);
+
+        ///The viewer textures are never re-used after a change
+        std::vector<U64> retainedHashes;
+        if (!isViewer) {
+            _imp->damageHistory.onHashChanged(oldHash, newHash, inputStates);
+            _imp->damageHistory.getOlderHashes(newHash, &retainedHashes);
+        }
         if (_imp->nodeCreated && !getApp()->getProject()->isProjectClosing()) {
             /*
              * We changed the node hash. That means all cache entries for this node with a different hash
-             * are impossible to re-create again. Just discard them all. This is done in a separate thread.
+             * are impossible to re-create again, except the ones from before a change of which the damaged
+             * region is known: only that region needs to be rendered again. Discard all the others.
+             * This is done in a separate thread.
              */
-            removeAllImagesFromCacheWithMatchingIDAndDifferentKey(newHash);
+            removeAllImagesFromCacheWithMatchingIDAndDifferentKey(newHash, retainedHashes);
         }
     }
 
@@ -1531,13 +1551,13 @@ Node::computeHashRecursive(std::list<Node*>& marked)
 }
 
 void
-Node::removeAllImagesFromCacheWithMatchingIDAndDifferentKey(U64 nodeHashKey)
+Node::removeAllImagesFromCacheWithMatchingIDAndDifferentKey(U64 nodeHashKey, const std::vector<U64>& retainedNodeHashKeys)
 {
     boost::shared_ptr<Project> proj = getApp()->getProject();
     if (proj->isProjectClosing() || proj->isLoadingProject()) {
         return;
     }
-    appPTR->removeAllImagesFromCacheWithMatchingIDAndDifferentKey(this, nodeHashKey);
+    appPTR->removeAllImagesFromCacheWithMatchingIDAndDifferentKey(this, nodeHashKey, retainedNodeHashKeys);
     appPTR->removeAllImagesFromDiskCacheWithMatchingIDAndDifferentKey(this, nodeHashKey);
     ViewerInstance* isViewer = dynamic_cast<ViewerInstance*>(_imp->effect.get());
     if (isViewer) {
@@ -1570,11 +1590,59 @@ Node::computeHash()
         Q_EMIT mustComputeHashOnMainThread();
         return;
     }
+    if (getApp()->isBatchingChanges()) {
+        ///Only refresh our own hash, it will be propagated downstream once when the batch ends
+        ignore_result(computeHashInternal());
+        return;
+    }
     std::list<Node*> marked;
     computeHashRecursive(marked);
     
 } // computeHash
 
+static void
+sortNodesUpstreamFirst(const NodePtr& node,
+                       std::set<Node*>& visited,
+                       NodesList& sorted)
+{
+    if (!visited.insert(node.get()).second) {
+        return;
+    }
+    int maxInputs = node->getMaxInputCount();
+    for (int i = 0; i < maxInputs; ++i) {
+        NodePtr input = node->getInput(i);
+        if (input) {
+            sortNodesUpstreamFirst(input, visited, sorted);
+        }
+    }
+    sorted.push_back(node);
+}
+
+void
+Node::computeHashOfNodes(const NodesList& nodes)
+{
+    assert( QThread::currentThread() == qApp->thread() );
+    
+    NodesList toVisit = nodes;
+    for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        boost::shared_ptr<RotoContext> roto = (*it)->getRotoContext();
+        if (roto) {
+            roto->getRotoPaintTreeNodes(&toVisit);
+        }
+    }
+    
+    ///Each hash depends on the hash of the inputs, so compute them in topological order:
+    ///every node is visited exactly once instead of once per changed upstream node.
+    std::set<Node*> visited;
+    NodesList sorted;
+    for (NodesList::iterator it = toVisit.begin(); it != toVisit.end(); ++it) {
+        sortNodesUpstreamFirst(*it, visited, sorted);
+    }
+    for (NodesList::iterator it = sorted.begin(); it != sorted.end(); ++it) {
+        ignore_result((*it)->computeHashInternal());
+    }
+}
+
 void
 Node::setValuesFromSerialization(const std::list<boost::shared_ptr<KnobSerialization> >& paramValues)
 {
@@ -2178,6 +2246,7 @@ Node::setKnobsAge(U64 newAge)
         }
     }
     if (changed) {
+        _imp->damageHistory.onKnobsAgeIncremented();
         Q_EMIT knobsAgeChanged(newAge);
         computeHash();
     }
@@ -2197,6 +2266,7 @@ Node::incrementKnobsAge_internal()
             _imp->knobsAge = 0;
         }
     }
+    _imp->damageHistory.onKnobsAgeIncremented();
 }
 
 void
@@ -2215,6 +2285,7 @@ Node::incrementKnobsAge()
         }
         newAge = _imp->knobsAge;
     }
+    _imp->damageHistory.onKnobsAgeIncremented();
     Q_EMIT knobsAgeChanged(newAge);
     
     computeHash();
@@ -2228,6 +2299,103 @@ Node::getKnobsAge() const
     return _imp->knobsAge;
 }
 
+void
+Node::reportDamagedRegion(const RectD& region,
+                          bool allTimes,
+                          double time)
+{
+    _imp->damageHistory.reportDamagedRegion(region, allTimes, time);
+}
+
+void
+Node::reportDamagedRegion(const DamageRegion& damage)
+{
+    _imp->damageHistory.reportDamagedRegion(damage);
+}
+
+void
+Node::reportUnknownDamage()
+{
+    _imp->damageHistory.reportUnknownDamage();
+}
+
+void
+Node::beginDamageReport()
+{
+    _imp->damageHistory.beginChange();
+}
+
+void
+Node::endDamageReport()
+{
+    _imp->damageHistory.endChange();
+}
+
+bool
+Node::getDamagedRegion(U64 oldHash,
+                       U64 newHash,
+                       double time,
+                       ViewIdx view,
+                       const RenderScale & scale,
+                       RectD* damage) const
+{
+    damage->clear();
+    if (oldHash == newHash) {
+        return true;
+    }
+
+    std::list<DamageRecord> records;
+    if ( !_imp->damageHistory.getChanges(oldHash, newHash, &records) ) {
+        return false;
+    }
+
+    for (std::list<DamageRecord>::const_iterator it = records.begin(); it != records.end(); ++it) {
+        if (it->knobsChanged) {
+            RectD knobsDamage;
+            if ( !it->knobsDamage.getRegionAtTime(time, &knobsDamage) ) {
+                return false;
+            }
+            if ( damage->isNull() ) {
+                *damage = knobsDamage;
+            } else if ( !knobsDamage.isNull() ) {
+                damage->merge(knobsDamage);
+            }
+        }
+        for (std::vector<DamagedInput>::const_iterator it2 = it->inputs.begin(); it2 != it->inputs.end(); ++it2) {
+            NodePtr input = getInput(it2->inputNb);
+            if ( !input || (input.get() != it2->node) ) {
+                ///The input was changed since then
+                return false;
+            }
+            RectD inputDamage;
+            if ( !input->getDamagedRegion(it2->oldHash, it2->newHash, time, view, scale, &inputDamage) ) {
+                return false;
+            }
+            if ( inputDamage.isNull() ) {
+                continue;
+            }
+            RectD outputDamage;
+            if ( !_imp->effect->getOutputDamageFromInput(it2->inputNb, inputDamage, time, view, scale, &outputDamage) ) {
+                return false;
+            }
+            if ( damage->isNull() ) {
+                *damage = outputDamage;
+            } else if ( !outputDamage.isNull() ) {
+                damage->merge(outputDamage);
+            }
+        }
+    }
+
+    return true;
+} // Node::getDamagedRegion
+
+void
+Node::getDamagedOlderHashes(U64 hash,
+                            std::vector<U64>* hashes) const
+{
+    _imp->damageHistory.getOlderHashes(hash, hashes);
+}
+
 bool
 Node::isRenderingPreview() const
 {
@@ -2810,6 +2978,9 @@ Node::setNameInternal(const std::string& name, bool throwErrors, bool declareToP
             _imp->label = newName;
         }
     }
+    if (collection) {
+        collection->onNodeScriptNameChanged(this, oldName, newName);
+    }
     std::string fullySpecifiedName = getFullyQualifiedName();
 
     if (mustSetCacheID) {
@@ -2825,8 +2996,13 @@ Node::setNameInternal(const std::string& name, bool throwErrors, bool declareToP
             cacheID = ss.str();
             ++i;
         }
-        QMutexLocker l(&_imp->nameMutex);
-        _imp->cacheID = cacheID;
+        {
+            QMutexLocker l(&_imp->nameMutex);
+            _imp->cacheID = cacheID;
+        }
+        if (collection) {
+            collection->onNodeCacheIDSet(this, cacheID);
+        }
     }
     
     if (declareToPython && collection) {
@@ -6851,7 +7027,9 @@ Node::endInputEdition(bool triggerRender)
             std::list<ViewerInstance* > viewers;
             hasViewersConnected(&viewers);
             for (std::list<ViewerInstance* >::iterator it2 = viewers.begin(); it2 != viewers.end(); ++it2) {
-                (*it2)->renderCurrentFrame(true);
+                if (!getApp()->deferViewerRenderDuringBatch(*it2, true)) {
+                    (*it2)->renderCurrentFrame(true);
+                }
             }
         }
     }
@@ -811,6 +811,41 @@ public:
 
     U64 getKnobsAge() const;
 
+    /**
+     * @brief Reports the region of the output of the node, in canonical coordinates, affected by the change of the
+     * knobs being made. If allTimes is false, the output is only known to be unchanged outside of the region at the given time.
+     * The images rendered before the change are then re-used: only the damaged region is rendered again.
+     * See DamageHistory for when the report must be made.
+     **/
+    void reportDamagedRegion(const RectD& region, bool allTimes, double time);
+    void reportDamagedRegion(const DamageRegion& damage);
+
+    /**
+     * @brief Reports that the change of the knobs being made may affect the whole output of the node
+     **/
+    void reportUnknownDamage();
+
+    /**
+     * @brief Called around a change of the knobs which damage is reported once the knobs age was incremented,
+     * by the instance changed action of the plug-in.
+     **/
+    void beginDamageReport();
+    void endDamageReport();
+
+    /**
+     * @brief Returns in damage the region of the output at the given time and view which may differ between the images
+     * rendered with the hashes oldHash and newHash of the node. The damage of the inputs is spread to the output
+     * by the effect, see EffectInstance::getOutputDamageFromInput().
+     * Returns false if it is unknown.
+     **/
+    bool getDamagedRegion(U64 oldHash, U64 newHash, double time, ViewIdx view, const RenderScale & scale, RectD* damage) const WARN_UNUSED_RETURN;
+
+    /**
+     * @brief Returns the previous hashes of the node whose images may be re-used for the given hash by rendering
+     * again their damaged region, the most recent first.
+     **/
+    void getDamagedOlderHashes(U64 hash, std::vector<U64>* hashes) const;
+
     void onAllKnobsSlaved(bool isSlave,KnobHolder* master);
 
     void onKnobSlaved(KnobI* slave,KnobI* master,int dimension,bool isSlave);
@@ -1131,7 +1166,7 @@ public:
 
     double getHostMixingValue(double time, ViewIdx view) const;
     
-    void removeAllImagesFromCacheWithMatchingIDAndDifferentKey(U64 nodeHashKey);
+    void removeAllImagesFromCacheWithMatchingIDAndDifferentKey(U64 nodeHashKey, const std::vector<U64>& retainedNodeHashKeys);
     void removeAllImagesFromCache(bool blocking);
     
     bool isDraftModeUsed() const;
@@ -1348,6 +1383,14 @@ protected:
      **/
     void computeHash();
 
+public:
+    
+    /**
+     * @brief Recomputes the hash of all the given nodes once, inputs before their outputs.
+     * This is used to propagate at once the hash changes deferred during a batch (see AppInstance::beginBatch).
+     **/
+    static void computeHashOfNodes(const NodesList& nodes);
+
 private:
     
     
@@ -25,7 +25,9 @@
 #include "NodeGroup.h"
 
 #include <set>
+#include <map>
 #include <locale>
+#include <cstdlib> // atoi
 #include <cfloat>
 #include <algorithm> // min, max
 #include <cassert>
@@ -62,6 +64,8 @@
 
 NATRON_NAMESPACE_ENTER;
 
+typedef std::multimap<std::string, NodePtr> NodesNameIndex;
+
 struct NodeCollectionPrivate
 {
     AppInstance* app;
@@ -71,18 +75,97 @@ struct NodeCollectionPrivate
     mutable QMutex nodesMutex;
     NodesList nodes;
     
+    ///The nodes indexed by script-name and by cache ID, so that looking up a name does not scan all nodes.
+    ///Nodes without a script-name yet are indexed with an empty name. Protected by nodesMutex.
+    NodesNameIndex nodesByName;
+    std::map<std::string, NodePtr> nodesByCacheID;
+    
+    ///For a base-name, all the names made of the base-name followed by a number lower than this one are
+    ///known to be taken, so checkNodeName does not need to try them again. Protected by nodesMutex.
+    std::map<std::string, int> firstFreeDigit;
+    
     NodeCollectionPrivate(AppInstance* app)
     : app(app)
     , graph(0)
     , nodesMutex()
     , nodes()
+    , nodesByName()
+    , nodesByCacheID()
+    , firstFreeDigit()
     {
         
     }
     
     NodePtr findNodeInternal(const std::string& name,const std::string& recurseName) const;
+    
+    NodesNameIndex::iterator findIndexedNode(const std::string& name, const Node* node);
+    
+    NodePtr findNodeByNameNoLock(const std::string& name, const Node* caller) const;
+    
+    void unindexNodeName(const std::string& name, const Node* node);
 };
 
+NodesNameIndex::iterator
+NodeCollectionPrivate::findIndexedNode(const std::string& name, const Node* node)
+{
+    std::pair<NodesNameIndex::iterator, NodesNameIndex::iterator> range = nodesByName.equal_range(name);
+    for (NodesNameIndex::iterator it = range.first; it != range.second; ++it) {
+        if (it->second.get() == node) {
+            return it;
+        }
+    }
+    return nodesByName.end();
+}
+
+NodePtr
+NodeCollectionPrivate::findNodeByNameNoLock(const std::string& name, const Node* caller) const
+{
+    std::pair<NodesNameIndex::const_iterator, NodesNameIndex::const_iterator> range = nodesByName.equal_range(name);
+    for (NodesNameIndex::const_iterator it = range.first; it != range.second; ++it) {
+        if (it->second.get() != caller) {
+            return it->second;
+        }
+    }
+    return NodePtr();
+}
+
+void
+NodeCollectionPrivate::unindexNodeName(const std::string& name, const Node* node)
+{
+    NodesNameIndex::iterator found = findIndexedNode(name, node);
+    if (found == nodesByName.end()) {
+        ///The node was renamed concurrently, look for it everywhere
+        for (found = nodesByName.begin(); found != nodesByName.end(); ++found) {
+            if (found->second.get() == node) {
+                break;
+            }
+        }
+        if (found == nodesByName.end()) {
+            return;
+        }
+    }
+    
+    ///If the name is a base-name followed by a number, that number is free again.
+    ///The base-name may itself end with digits, so try each split of the trailing digits.
+    std::string freedName = found->first;
+    nodesByName.erase(found);
+    if ( freedName.empty() ) {
+        return;
+    }
+    std::size_t digitsStart = freedName.find_last_not_of("0123456789");
+    digitsStart = (digitsStart == std::string::npos) ? 1 : digitsStart + 1;
+    if (freedName.size() - digitsStart > 9) {
+        digitsStart = freedName.size() - 9;
+    }
+    for (std::size_t i = digitsStart; i < freedName.size(); ++i) {
+        std::map<std::string, int>::iterator hint = firstFreeDigit.find( freedName.substr(0, i) );
+        if (hint != firstFreeDigit.end()) {
+            int no = std::max( 1, std::atoi( freedName.c_str() + i ) );
+            hint->second = std::min(hint->second, no);
+        }
+    }
+}
+
 NodeCollection::NodeCollection(AppInstance* app)
 : _imp(new NodeCollectionPrivate(app))
 {
@@ -153,9 +236,15 @@ NodeCollection::getNodes_recursive(NodesList& nodes,bool onlyActive) const
 void
 NodeCollection::addNode(const NodePtr& node)
 {
+    std::string name = node->getScriptName_mt_safe();
+    std::string cacheID = node->getCacheID();
     {
         QMutexLocker k(&_imp->nodesMutex);
         _imp->nodes.push_back(node);
+        _imp->nodesByName.insert( std::make_pair(name, node) );
+        if ( !cacheID.empty() ) {
+            _imp->nodesByCacheID[cacheID] = node;
+        }
     }
 }
 
@@ -163,11 +252,45 @@ NodeCollection::addNode(const NodePtr& node)
 void
 NodeCollection::removeNode(const NodePtr& node)
 {
+    std::string name = node->getScriptName_mt_safe();
+    std::string cacheID = node->getCacheID();
     QMutexLocker k(&_imp->nodesMutex);
     NodesList::iterator found = std::find(_imp->nodes.begin(), _imp->nodes.end(), node);
     if (found != _imp->nodes.end()) {
         _imp->nodes.erase(found);
+        _imp->unindexNodeName(name, node.get());
+        std::map<std::string, NodePtr>::iterator foundID = _imp->nodesByCacheID.find(cacheID);
+        if ( (foundID != _imp->nodesByCacheID.end()) && (foundID->second == node) ) {
+            _imp->nodesByCacheID.erase(foundID);
+        }
+    }
+}
+
+void
+NodeCollection::onNodeScriptNameChanged(const Node* node, const std::string& oldName, const std::string& newName)
+{
+    QMutexLocker k(&_imp->nodesMutex);
+    NodesNameIndex::iterator found = _imp->findIndexedNode(oldName, node);
+    if (found == _imp->nodesByName.end()) {
+        ///The node is not in this collection
+        return;
+    }
+    NodePtr nodePtr = found->second;
+    _imp->unindexNodeName(oldName, node);
+    _imp->nodesByName.insert( std::make_pair(newName, nodePtr) );
+}
+
+void
+NodeCollection::onNodeCacheIDSet(const Node* node, const std::string& cacheID)
+{
+    std::string name = node->getScriptName_mt_safe();
+    QMutexLocker k(&_imp->nodesMutex);
+    NodesNameIndex::iterator found = _imp->findIndexedNode(name, node);
+    if (found == _imp->nodesByName.end()) {
+        ///The node is not in this collection
+        return;
     }
+    _imp->nodesByCacheID[cacheID] = found->second;
 }
 
 NodePtr
@@ -325,12 +448,7 @@ bool
 NodeCollection::isCacheIDAlreadyTaken(const std::string& name) const
 {
     QMutexLocker k(&_imp->nodesMutex);
-    for (NodesList::iterator it = _imp->nodes.begin(); it!=_imp->nodes.end(); ++it) {
-        if ((*it)->getCacheID() == name) {
-            return true;
-        }
-    }
-    return false;
+    return _imp->nodesByCacheID.find(name) != _imp->nodesByCacheID.end();
 }
 
 bool
@@ -467,6 +585,9 @@ NodeCollection::clearNodes(bool emitSignal)
     {
         QMutexLocker l(&_imp->nodesMutex);
         _imp->nodes.clear();
+        _imp->nodesByName.clear();
+        _imp->nodesByCacheID.clear();
+        _imp->firstFreeDigit.clear();
     }
     
     nodesToDelete.clear();
@@ -506,6 +627,14 @@ NodeCollection::checkNodeName(const Node* node, const std::string& baseName,bool
     bool foundNodeWithName = false;
     int no = 1;
 
+    QMutexLocker l(&_imp->nodesMutex);
+    
+    ///Start from the first number that may be free instead of trying all names from 1
+    std::map<std::string, int>::iterator hint = _imp->firstFreeDigit.end();
+    if (appendDigit) {
+        hint = _imp->firstFreeDigit.insert( std::make_pair(cpy, 1) ).first;
+        no = hint->second;
+    }
     {
         std::stringstream ss;
         ss << cpy;
@@ -515,14 +644,7 @@ NodeCollection::checkNodeName(const Node* node, const std::string& baseName,bool
         *nodeName = ss.str();
     }
     do {
-        foundNodeWithName = false;
-        QMutexLocker l(&_imp->nodesMutex);
-        for (NodesList::iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
-            if (it->get() != node && (*it)->getScriptName_mt_safe() == *nodeName) {
-                foundNodeWithName = true;
-                break;
-            }
-        }
+        foundNodeWithName = (bool)_imp->findNodeByNameNoLock(*nodeName, node);
         if (foundNodeWithName) {
             if (errorIfExists || !appendDigit) {
                 std::stringstream ss;
@@ -540,6 +662,11 @@ NodeCollection::checkNodeName(const Node* node, const std::string& baseName,bool
             }
         }
     } while (foundNodeWithName);
+    
+    ///All the numbers before no are taken. The name returned may not be used, so no itself may still be free.
+    if ( hint != _imp->firstFreeDigit.end() ) {
+        hint->second = no;
+    }
 }
 
 void
@@ -752,24 +879,24 @@ NodeCollection::autoConnectNodes(const NodePtr& selected,const NodePtr& created)
 NodePtr
 NodeCollectionPrivate::findNodeInternal(const std::string& name,const std::string& recurseName) const
 {
-    QMutexLocker k(&nodesMutex);
-    for (NodesList::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
-        if ((*it)->getScriptName_mt_safe() == name) {
-            if (!recurseName.empty()) {
-                NodeGroup* isGrp = (*it)->isEffectGroup();
-                if (isGrp) {
-                    return isGrp->getNodeByFullySpecifiedName(recurseName);
-                } else {
-                    NodesList children;
-                    (*it)->getChildrenMultiInstance(&children);
-                    for (NodesList::iterator it2 = children.begin(); it2 != children.end(); ++it2) {
-                        if ((*it2)->getScriptName_mt_safe() == recurseName) {
-                            return *it2;
-                        }
-                    }
-                }
-            } else {
-                return *it;
+    NodePtr found;
+    {
+        QMutexLocker k(&nodesMutex);
+        found = findNodeByNameNoLock(name, 0);
+    }
+    if (!found || recurseName.empty()) {
+        return found;
+    }
+    
+    NodeGroup* isGrp = found->isEffectGroup();
+    if (isGrp) {
+        return isGrp->getNodeByFullySpecifiedName(recurseName);
+    } else {
+        NodesList children;
+        found->getChildrenMultiInstance(&children);
+        for (NodesList::iterator it2 = children.begin(); it2 != children.end(); ++it2) {
+            if ((*it2)->getScriptName_mt_safe() == recurseName) {
+                return *it2;
             }
         }
     }
@@ -929,13 +1056,7 @@ bool
 NodeCollection::checkIfNodeNameExists(const std::string & n,const Node* caller) const
 {
     QMutexLocker k(&_imp->nodesMutex);
-    for (NodesList::const_iterator it = _imp->nodes.begin(); it != _imp->nodes.end(); ++it) {
-        if ( (it->get() != caller) && ( (*it)->getScriptName_mt_safe() == n ) ) {
-            return true;
-        }
-    }
-    
-    return false;
+    return (bool)_imp->findNodeByNameNoLock(n, caller);
 }
 
 static void recomputeFrameRangeForAllReadersInternal(NodeCollection* group, int* firstFrame,int* lastFrame, bool setFrameRange)
@@ -84,6 +84,16 @@ public:
      **/
     void removeNode(const NodePtr& node);
     
+    /**
+     * @brief Called by the node when its script-name changes, to keep the index of the node names up to date. MT-safe.
+     **/
+    void onNodeScriptNameChanged(const Node* node, const std::string& oldName, const std::string& newName);
+    
+    /**
+     * @brief Called by the node when its cache ID is set, to keep the index of the cache IDs up to date. MT-safe.
+     **/
+    void onNodeCacheIDSet(const Node* node, const std::string& cacheID);
+    
     /**
      * @brief Get the last node added with the given id
      **/
@@ -2307,7 +2307,24 @@ OfxEffectInstance::knobChanged(KnobI* k,
     /*if ( (stat != kOfxStatOK) && (stat != kOfxStatReplyDefault) ) {
         return;
     }*/
-    Q_UNUSED(stat);
+
+    ///Report the region of the output damaged by the change, if the plug-in told it
+    OFX::Host::Property::Set & props = effectInstance()->getProps();
+    int damagedRegionTimes = props.getIntProperty(kNatronOfxImageEffectPropDamagedRegionTimes);
+    if ( (stat == kOfxStatOK) && (damagedRegionTimes != 0) ) {
+        RectD damage( props.getDoubleProperty(kNatronOfxImageEffectPropDamagedRegion, 0),
+                      props.getDoubleProperty(kNatronOfxImageEffectPropDamagedRegion, 1),
+                      props.getDoubleProperty(kNatronOfxImageEffectPropDamagedRegion, 2),
+                      props.getDoubleProperty(kNatronOfxImageEffectPropDamagedRegion, 3) );
+        if ( (damage.x2 < damage.x1) || (damage.y2 < damage.y1) ) {
+            getNode()->reportUnknownDamage();
+        } else {
+            getNode()->reportDamagedRegion(damage, damagedRegionTimes == 2, time);
+        }
+    } else {
+        getNode()->reportUnknownDamage();
+    }
+    props.setIntProperty(kNatronOfxImageEffectPropDamagedRegionTimes, 0);
 } // knobChanged
 
 void
@@ -28,6 +28,7 @@
 #include <cstdarg>
 #include <memory>
 #include <fstream>
+#include <sstream>
 #include <new> // std::bad_alloc
 #include <stdexcept> // std::exception
 #include <cctype> // tolower
@@ -36,6 +37,7 @@
 
 CLANG_DIAG_OFF(deprecated-register) //'register' storage class specifier is deprecated
 #include <QtCore/QDir>
+#include <QtCore/QFile>
 #include <QtCore/QMutex>
 #include <QtCore/QThreadPool>
 #include <QtCore/QCoreApplication>
@@ -44,11 +46,6 @@ CLANG_DIAG_ON(deprecated-register)
 #ifdef OFX_SUPPORTS_MULTITHREAD
 #include <QtCore/QThread>
 #include <QtCore/QThreadStorage>
-#include <QtConcurrentMap> // QtCore on Qt4, QtConcurrent on Qt5
-GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
-// /usr/local/include/boost/bind/arg.hpp:37:9: warning: unused typedef 'boost_static_assert_typedef_37' [-Wunused-local-typedef]
-#include <boost/bind.hpp>
-GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #endif
 
 //ofx
@@ -90,11 +87,12 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Engine/KnobTypes.h"
 #include "Engine/LibraryBinary.h"
 #include "Engine/Node.h"
-#include "Engine/FStreamsSupport.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxImageEffectInstance.h"
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/OfxMemory.h"
+#include "Engine/OfxPluginCacheFile.h"
+#include "Engine/OfxThreadPool.h"
 #include "Engine/Plugin.h"
 #include "Engine/Project.h"
 #include "Engine/Settings.h"
@@ -146,6 +144,8 @@ struct OfxHostPrivate
     std::string loadingPluginID; // ID of the plugin being loaded
     int loadingPluginVersionMajor;
     int loadingPluginVersionMinor;
+    boost::scoped_ptr<OfxThreadPool> threadPool; // runs the multiThread calls, created on the first call
+    QMutex threadPoolMutex; // protects threadPool
 
     OfxHostPrivate()
     : imageEffectPluginCache()
@@ -157,6 +157,8 @@ struct OfxHostPrivate
     , loadingPluginID()
     , loadingPluginVersionMajor(0)
     , loadingPluginVersionMinor(0)
+    , threadPool()
+    , threadPoolMutex()
     {
         
     }
@@ -695,17 +697,43 @@ static QString getOFXCacheDirPath()
     return ofxCachePath;
 }
 
-///Return the xml cache file used after Natron 2 RC2
+///Return the cache file used after Natron 2 RC2, see OfxPluginCacheFile
 static QString getCacheFilePath()
 {
     QString ofxCachePath = getOFXCacheDirPath() + QLatin1Char('/');
     QString ofxCacheFilePath = ofxCachePath + QString::fromUtf8("OFXCache_") +
     QString::fromUtf8(NATRON_VERSION_STRING) + QString::fromUtf8("_") +
     QString::fromUtf8(NATRON_DEVELOPMENT_STATUS) + QString::fromUtf8("_") +
-    QString::number(NATRON_BUILD_NUMBER) + QString::fromUtf8(".xml");
+    QString::number(NATRON_BUILD_NUMBER) + QString::fromUtf8(".bin");
     return ofxCacheFilePath;
 }
 
+/**
+ * @brief Passes the elements of the binary cache to the plug-in cache, as its XML parser would
+ **/
+class OfxPluginCacheReader
+    : public OfxPluginCacheFileHandler
+{
+public:
+
+    virtual void elementBegin(const char* name,
+                              const char** attributes) OVERRIDE FINAL
+    {
+        OFX::Host::PluginCache::getPluginCache()->elementBeginCallback(0, name, attributes);
+    }
+
+    virtual void elementCharacters(const char* data,
+                                   int length) OVERRIDE FINAL
+    {
+        OFX::Host::PluginCache::getPluginCache()->elementCharCallback(0, data, length);
+    }
+
+    virtual void elementEnd(const char* name) OVERRIDE FINAL
+    {
+        OFX::Host::PluginCache::getPluginCache()->elementEndCallback(0, name);
+    }
+};
+
 void
 OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std::string,double> > >* readersMap,
                                 std::map<std::string,std::vector< std::pair<std::string,double> > >* writersMap)
@@ -749,14 +777,19 @@ OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std::string,
     // On OSX, it will be ~/Library/Caches/<organization>/<application>/OFXLoadCache/
     //on Linux ~/.cache/<organization>/<application>/OFXLoadCache/
     //on windows: C:\Users\<username>\App Data\Local\<organization>\<application>\Caches\OFXLoadCache
-    QString ofxCacheFilePath = getCacheFilePath();
+    std::string ofxCacheFilePath = getCacheFilePath().toStdString();
     
+    // The cache is mapped to memory and its elements are passed to the plug-in cache without parsing any XML.
+    // The bundles whose binary changed since the cache was written are left out: scanPluginFiles() loads them again.
+    U64 previousCacheHash = 0;
+    bool cacheFileUpToDate = false;
     {
-        FStreamsSupport::ifstream ifs;
-        FStreamsSupport::open(&ifs,ofxCacheFilePath.toStdString());
-        if (ifs) {
+        OfxPluginCacheFile cacheFile;
+        if ( cacheFile.open(ofxCacheFilePath) ) {
+            previousCacheHash = cacheFile.getXMLHash();
+            OfxPluginCacheReader reader;
             try {
-                OFX::Host::PluginCache::getPluginCache()->readCache(ifs);
+                cacheFileUpToDate = cacheFile.replay(&reader) == 0;
             } catch (const std::exception& e) {
                 appPTR->writeToErrorLog_mt_safe(QObject::tr("Failure to read OpenFX plug-ins cache: ") + QString::fromUtf8(e.what()));
             }
@@ -766,9 +799,12 @@ OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std::string,
     OFX::Host::PluginCache::getPluginCache()->scanPluginFiles();
     _imp->loadingPluginID.clear(); // finished loading plugins
 
-    // write the cache NOW (it won't change anyway)
-    /// flush out the current cache
-    writeOFXCache();
+    // write the cache NOW (it won't change anyway), unless every bundle was replayed from it and the scan
+    // did not find any bundle added or removed: then the XML is not even built
+    if ( !cacheFileUpToDate || OFX::Host::PluginCache::getPluginCache()->dirty() ) {
+        /// flush out the current cache
+        writeOFXCache(previousCacheHash);
+    }
 
     /*Filling node name list and plugin grouping*/
     typedef std::map<OFX::Host::ImageEffect::MajorPlugin,OFX::Host::ImageEffect::ImageEffectPlugin *> PMap;
@@ -910,19 +946,21 @@ OfxHost::loadOFXPlugins(std::map<std::string,std::vector< std::pair<std::string,
 } // loadOFXPlugins
 
 void
-OfxHost::writeOFXCache()
+OfxHost::writeOFXCache(U64 previousCacheHash)
 {
     /// and write a new cache, long version with everything in there
-    QString ofxCachePath = getOFXCacheDirPath();
-    QDir().mkpath(ofxCachePath);
-    QString ofxCacheFilePath = getCacheFilePath();
-    FStreamsSupport::ofstream ofile;
-    FStreamsSupport::open(&ofile, ofxCacheFilePath.toStdString());
-    if (!ofile) {
+    assert(OFX::Host::PluginCache::getPluginCache());
+    std::ostringstream oss;
+    OFX::Host::PluginCache::getPluginCache()->writePluginCache(oss);
+    std::string cache = oss.str();
+    if (OfxPluginCacheFile::hashXML(cache) == previousCacheHash) {
         return;
     }
-    assert(OFX::Host::PluginCache::getPluginCache());
-    OFX::Host::PluginCache::getPluginCache()->writePluginCache(ofile);
+    
+    QDir().mkpath( getOFXCacheDirPath() );
+    if ( !OfxPluginCacheFile::write( cache, getCacheFilePath().toStdString() ) ) {
+        appPTR->writeToErrorLog_mt_safe( QObject::tr("Failure to write OpenFX plug-ins cache") );
+    }
 }
 
 void
@@ -1005,49 +1043,11 @@ OfxHost::setThreadAsActionCaller(OfxImageEffectInstance* instance, bool actionCa
 
 namespace {
     
-///Using QtConcurrent doesn't work with The Foundry Furnace plug-ins because they expect fresh threads
-///to be created. As QtConcurrent's thread-pool recycles thread, it seems to make Furnace crash.
-///We think this is because Furnace must keep an internal thread-local state that becomes then dirty
-///if we re-use the same thread.
-
-static OfxStatus
-threadFunctionWrapper(OfxThreadFunctionV1 func,
-                      unsigned int threadIndex,
-                      unsigned int threadMax,
-                      const QThread* spawnerThread,
-                      void *customArg)
-{
-    assert(threadIndex < threadMax);
-    OfxHost::OfxHostDataTLSPtr tls = appPTR->getOFXHost()->getTLSData();
-    tls->threadIndexes.push_back((int)threadIndex);
-    
-    QThread* spawnedThread = QThread::currentThread();
-    if (spawnedThread != spawnerThread) {
-        appPTR->getAppTLS()->softCopy(spawnerThread, spawnedThread);
-    }
+///The threads of the OfxThreadPool are recycled, which doesn't work with The Foundry Furnace plug-ins because they expect
+///fresh threads to be created. We think this is because Furnace must keep an internal thread-local state that becomes then
+///dirty if we re-use the same thread. When the thread-pool is disabled in the settings, an OfxThread is created for each
+///thread index instead.
 
-    OfxStatus ret = kOfxStatOK;
-    try {
-        func(threadIndex, threadMax, customArg);
-    } catch (const std::bad_alloc & ba) {
-        ret =  kOfxStatErrMemory;
-    } catch (...) {
-        ret =  kOfxStatFailed;
-    }
-
-    ///reset back the index otherwise it could mess up the indexes if the same thread is re-used
-    tls->threadIndexes.pop_back();
-    
-    if (spawnedThread != spawnerThread) {
-        appPTR->getAppTLS()->cleanupTLSForThread();
-    }
-
-    return ret;
-}
-
-    
-
-    
 class OfxThread
     : public QThread
 {
@@ -1147,26 +1147,17 @@ OfxHost::multiThread(OfxThreadFunctionV1 func,
     bool useThreadPool = appPTR->getUseThreadPool();
     
     if (useThreadPool) {
-        
-        std::vector<unsigned int> threadIndexes(nThreads);
-        for (unsigned int i = 0; i < nThreads; ++i) {
-            threadIndexes[i] = i;
-        }
-        
-        /// DON'T set the maximum thread count, this is a global application setting, and see the documentation excerpt above
-        //QThreadPool::globalInstance()->setMaxThreadCount(nThreads);
-        QFuture<OfxStatus> future = QtConcurrent::mapped( threadIndexes, boost::bind(threadFunctionWrapper,func, _1, nThreads, spawnerThread, customArg) );
-        future.waitForFinished();
-        ///DON'T reset back to the original value the maximum thread count
-        //QThreadPool::globalInstance()->setMaxThreadCount(QThread::idealThreadCount());
-        
-        for (QFuture<OfxStatus>::const_iterator it = future.begin(); it != future.end(); ++it) {
-            OfxStatus stat = *it;
-            if (stat != kOfxStatOK) {
-                return stat;
+        OfxThreadPool* pool;
+        {
+            QMutexLocker k(&_imp->threadPoolMutex);
+            if (!_imp->threadPool) {
+                _imp->threadPool.reset( new OfxThreadPool( appPTR->getCpuTopology() ) );
             }
+            pool = _imp->threadPool.get();
         }
+        pool->setAffinityMode( appPTR->getCurrentSettings()->getMultiThreadAffinityMode() );
 
+        return pool->run(func, nThreads, maxConcurrentThread, customArg);
     } else {
         QVector<OfxStatus> status(nThreads); // vector for the return status of each thread
         status.fill(kOfxStatFailed); // by default, a thread fails
@@ -1253,7 +1244,8 @@ OfxHost::multiThreadNumCPUS(unsigned int *nCPUs) const
         if (nThreadsPerEffect == 0) {
             ///Simple heuristic: limit 1 effect to start at most 8 threads because otherwise it might spend too much
             ///time scheduling than just processing
-            int hwConcurrency = appPTR->getHardwareIdealThreadCount();
+            ///The CPUs the process may run on, which may be less than the CPUs of the machine (e.g: in a cpuset)
+            int hwConcurrency = appPTR->getCpuTopology()->getCpusCount();
             
             if (hwConcurrency <= 0) {
                 nThreadsPerEffect = 1;
@@ -26,6 +26,7 @@
 // ***** END PYTHON BLOCK *****
 
 #include <list>
+#include <string>
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
 #include <boost/scoped_ptr.hpp>
@@ -38,6 +39,7 @@ CLANG_DIAG_ON(tautological-undefined-compare)
 CLANG_DIAG_ON(unknown-pragmas)
 #include <ofxhImageEffectAPI.h>
 
+#include "Global/GlobalDefines.h"
 #include "Global/Enums.h"
 #include "Engine/EngineFwd.h"
 
@@ -183,8 +185,9 @@ public:
 private:
     
     /*Writes all plugins loaded and their descriptors to
-     the OFX plugin cache. (called by the destructor) */
-    void writeOFXCache();
+     the OFX plugin cache, unless it is the one that was read (see OfxPluginCacheFile::hashXML()).
+     This is only called when the cache file was not replayed entirely or when the plug-ins scan added or removed bundles. */
+    void writeOFXCache(U64 previousCacheHash);
 
     // get the virutals for viewport size, pixel scale, background colour
     const std::string &getStringProperty(const std::string &name, int n) const OFX_EXCEPTION_SPEC OVERRIDE;
@@ -99,6 +99,13 @@ OfxImageEffectInstance::OfxImageEffectInstance(OFX::Host::ImageEffect::ImageEffe
     : OFX::Host::ImageEffect::Instance(plugin, desc, context, interactive)
       , _ofxEffectInstance()
 {
+    static const OFX::Host::Property::PropSpec damageProps[] = {
+        { kNatronOfxImageEffectPropDamagedRegion,  OFX::Host::Property::eDouble,    4,    false,    "0" },
+        { kNatronOfxImageEffectPropDamagedRegionTimes,  OFX::Host::Property::eInt,    1,    false,    "0" },
+        OFX::Host::Property::propSpecEnd
+    };
+
+    getProps().addProperties(damageProps);
 }
 
 OfxImageEffectInstance::~OfxImageEffectInstance()
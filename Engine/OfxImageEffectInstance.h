@@ -40,6 +40,29 @@ CLANG_DIAG_ON(unknown-pragmas)
 #include "Global/GlobalDefines.h"
 #include "Engine/EngineFwd.h"
 
+/**
+ * @brief The region of the output of the effect, in canonical coordinates, affected by the parameter change being
+ * processed by the instance changed action. The plug-in sets it from the action, along with
+ * kNatronOfxImageEffectPropDamagedRegionTimes. The host then only renders again that region of the images cached
+ * before the change. The property is absent if the host does not support it.
+ *
+ * - Type - double X 4
+ * - Property Set - image effect instance (read/write)
+ * - Default - 0, 0, 0, 0
+ **/
+#define kNatronOfxImageEffectPropDamagedRegion "NatronOfxImageEffectPropDamagedRegion"
+
+/**
+ * @brief Tells whether kNatronOfxImageEffectPropDamagedRegion was set by the instance changed action:
+ * 0 if not (the whole output may have changed), 1 if the region is only valid at the time of the action,
+ * 2 if it is valid at all times. The host resets it to 0 after the action.
+ *
+ * - Type - int X 1
+ * - Property Set - image effect instance (read/write)
+ * - Default - 0
+ **/
+#define kNatronOfxImageEffectPropDamagedRegionTimes "NatronOfxImageEffectPropDamagedRegionTimes"
+
 
 NATRON_NAMESPACE_ENTER;
 
@@ -0,0 +1,677 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "OfxPluginCacheFile.h"
+
+#include <cassert>
+#include <cstdio> // rename, remove
+#include <cstdlib> // strtol
+#include <cstring> // memcpy
+#include <exception>
+#include <sstream>
+#include <vector>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef __NATRON_WIN32__
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+#include <expat.h>
+
+#include "Engine/MemoryFile.h"
+
+// Changes whenever the layout of the file changes: files of another version are ignored
+#define NATRON_OFX_PLUGIN_CACHE_FILE_VERSION 1
+
+#define NATRON_OFX_PLUGIN_CACHE_FILE_MAGIC "NOFXPCF"
+
+NATRON_NAMESPACE_ENTER;
+
+/*
+ * The file is made of:
+ * - the header
+ * - the segments table: each segment is a range of the elements. The elements of each <bundle> are a segment, the
+ *   elements in between (the <cache> element itself and the spaces) are gathered in the segments in between.
+ * - the elements of all the segments
+ *
+ * The strings are stored as their length (U32) followed by their characters and a terminating null character, so that
+ * they are passed to the handler straight from the mapping.
+ */
+
+struct OfxPluginCacheFileHeader
+{
+    char magic[8];
+    U32 version;
+    U32 segmentsCount;
+    U32 bundlesCount;
+    U32 unused;
+    U64 xmlHash;
+    U64 fileSize; //< a partially written file is invalid
+};
+
+enum OfxPluginCacheFileElementEnum
+{
+    eOfxPluginCacheFileElementBegin = 0,
+    eOfxPluginCacheFileElementCharacters,
+    eOfxPluginCacheFileElementEnd
+};
+
+struct OfxPluginCacheFileSegment
+{
+    // Offset and size of the elements of the segment in the file
+    U64 offset;
+    U64 size;
+
+    // For the segment of a bundle: its binary as written in the cache
+    bool isBundle;
+    const char* binaryPath;
+    long long binaryModificationTime;
+    long long binarySize;
+};
+
+/**
+ * @brief Bounds-checked reads in the mapping
+ **/
+class OfxPluginCacheFileReader
+{
+public:
+
+    OfxPluginCacheFileReader(const char* data,
+                             std::size_t size)
+        : _data(data)
+        , _size(size)
+        , _pos(0)
+    {
+    }
+
+    bool atEnd() const
+    {
+        return _pos == _size;
+    }
+
+    template <typename T>
+    bool read(T* value)
+    {
+        if (_size - _pos < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(value, _data + _pos, sizeof(T));
+        _pos += sizeof(T);
+
+        return true;
+    }
+
+    bool readString(const char** str)
+    {
+        U32 length;
+
+        if ( !read(&length) || (_size - _pos < (std::size_t)length + 1) || (_data[_pos + length] != '\0') ) {
+            return false;
+        }
+        *str = _data + _pos;
+        _pos += length + 1;
+
+        return true;
+    }
+
+    bool readCharacters(const char** data,
+                        int* length)
+    {
+        U32 n;
+
+        if ( !read(&n) || (_size - _pos < (std::size_t)n) ) {
+            return false;
+        }
+        *data = _data + _pos;
+        *length = (int)n;
+        _pos += n;
+
+        return true;
+    }
+
+private:
+
+    const char* _data;
+    std::size_t _size;
+    std::size_t _pos;
+};
+
+struct OfxPluginCacheFilePrivate
+{
+    boost::scoped_ptr<MemoryFile> file;
+    OfxPluginCacheFileHeader header;
+    std::vector<OfxPluginCacheFileSegment> segments;
+
+    OfxPluginCacheFilePrivate()
+        : file()
+        , header()
+        , segments()
+    {
+    }
+
+    bool readSegments();
+
+    /**
+     * @brief Reads the elements of the segment and passes them to the handler if any. Returns false if the
+     * segment is invalid.
+     **/
+    bool readElements(const OfxPluginCacheFileSegment & segment, OfxPluginCacheFileHandler* handler) const;
+};
+
+OfxPluginCacheFile::OfxPluginCacheFile()
+    : _imp( new OfxPluginCacheFilePrivate() )
+{
+}
+
+OfxPluginCacheFile::~OfxPluginCacheFile()
+{
+}
+
+bool
+OfxPluginCacheFile::open(const std::string & filePath)
+{
+    close();
+    _imp->file.reset( new MemoryFile() );
+    try {
+        _imp->file->open(filePath, MemoryFile::eFileOpenModeEnumIfExistsKeepElseFail);
+    } catch (const std::exception & /*e*/) {
+        _imp->file.reset();
+
+        return false;
+    }
+    if ( !_imp->readSegments() ) {
+        close();
+
+        return false;
+    }
+
+    return true;
+}
+
+void
+OfxPluginCacheFile::close()
+{
+    _imp->file.reset();
+    _imp->segments.clear();
+}
+
+bool
+OfxPluginCacheFile::isOpened() const
+{
+    return _imp->file.get() != 0;
+}
+
+U64
+OfxPluginCacheFile::getXMLHash() const
+{
+    return isOpened() ? _imp->header.xmlHash : 0;
+}
+
+int
+OfxPluginCacheFile::getBundlesCount() const
+{
+    return isOpened() ? (int)_imp->header.bundlesCount : 0;
+}
+
+bool
+OfxPluginCacheFilePrivate::readSegments()
+{
+    const char* data = file->data();
+    std::size_t size = file->size();
+
+    if ( !data || (size < sizeof(OfxPluginCacheFileHeader)) ) {
+        return false;
+    }
+    std::memcpy( &header, data, sizeof(OfxPluginCacheFileHeader) );
+    if ( (std::memcmp( header.magic, NATRON_OFX_PLUGIN_CACHE_FILE_MAGIC, sizeof(header.magic) ) != 0) ||
+         (header.version != NATRON_OFX_PLUGIN_CACHE_FILE_VERSION) || (header.fileSize != size) ) {
+        return false;
+    }
+
+    OfxPluginCacheFileReader reader(data, size);
+    OfxPluginCacheFileHeader skipped;
+    reader.read(&skipped);
+
+    if (header.segmentsCount > size) {
+        return false;
+    }
+    U32 bundlesCount = 0;
+    segments.resize(header.segmentsCount);
+    for (U32 i = 0; i < header.segmentsCount; ++i) {
+        OfxPluginCacheFileSegment & segment = segments[i];
+        unsigned char isBundle;
+        if ( !reader.read(&segment.offset) || !reader.read(&segment.size) || !reader.read(&isBundle) ||
+             !reader.read(&segment.binaryModificationTime) || !reader.read(&segment.binarySize) ||
+             !reader.readString(&segment.binaryPath) ) {
+            return false;
+        }
+        segment.isBundle = isBundle != 0;
+        if (segment.isBundle) {
+            ++bundlesCount;
+        }
+        if ( (segment.offset > size) || (segment.size > size - segment.offset) ) {
+            return false;
+        }
+    }
+    if (bundlesCount != header.bundlesCount) {
+        return false;
+    }
+
+    ///Check all the elements now: replay() must not stop in the middle of the cache
+    for (std::size_t i = 0; i < segments.size(); ++i) {
+        if ( !readElements(segments[i], 0) ) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool
+OfxPluginCacheFilePrivate::readElements(const OfxPluginCacheFileSegment & segment,
+                                        OfxPluginCacheFileHandler* handler) const
+{
+    OfxPluginCacheFileReader reader(file->data() + segment.offset, segment.size);
+    std::vector<const char*> attributes;
+
+    while ( !reader.atEnd() ) {
+        unsigned char type;
+        if ( !reader.read(&type) ) {
+            return false;
+        }
+        switch ( (OfxPluginCacheFileElementEnum)type ) {
+        case eOfxPluginCacheFileElementBegin: {
+            const char* name;
+            U32 attributesCount;
+            if ( !reader.readString(&name) || !reader.read(&attributesCount) ) {
+                return false;
+            }
+            attributes.resize(attributesCount * 2 + 1);
+            for (U32 i = 0; i < attributesCount * 2; ++i) {
+                if ( !reader.readString(&attributes[i]) ) {
+                    return false;
+                }
+            }
+            attributes[attributesCount * 2] = 0;
+            if (handler) {
+                handler->elementBegin(name, &attributes.front());
+            }
+            break;
+        }
+        case eOfxPluginCacheFileElementCharacters: {
+            const char* characters;
+            int length;
+            if ( !reader.readCharacters(&characters, &length) ) {
+                return false;
+            }
+            if (handler) {
+                handler->elementCharacters(characters, length);
+            }
+            break;
+        }
+        case eOfxPluginCacheFileElementEnd: {
+            const char* name;
+            if ( !reader.readString(&name) ) {
+                return false;
+            }
+            if (handler) {
+                handler->elementEnd(name);
+            }
+            break;
+        }
+        default:
+
+            return false;
+        }
+    }
+
+    return true;
+} // OfxPluginCacheFilePrivate::readElements
+
+/**
+ * @brief Returns true if the binary still has the modification time and size written in the cache.
+ * They are compared the way OFX::Host::PluginCache does, which writes them as int.
+ **/
+static bool
+isBinaryUnchanged(const OfxPluginCacheFileSegment & segment)
+{
+    struct stat sb;
+
+    if (stat(segment.binaryPath, &sb) != 0) {
+        return false;
+    }
+
+    return ( (long long)(int)sb.st_mtime == segment.binaryModificationTime ) && ( (long long)(int)sb.st_size == segment.binarySize );
+}
+
+int
+OfxPluginCacheFile::replay(OfxPluginCacheFileHandler* handler) const
+{
+    assert(handler);
+    if ( !isOpened() ) {
+        return 0;
+    }
+    int skipped = 0;
+    for (std::size_t i = 0; i < _imp->segments.size(); ++i) {
+        const OfxPluginCacheFileSegment & segment = _imp->segments[i];
+        if ( segment.isBundle && !isBinaryUnchanged(segment) ) {
+            ++skipped;
+            continue;
+        }
+        bool ok = _imp->readElements(segment, handler);
+        assert(ok);
+        (void)ok;
+    }
+
+    return skipped;
+}
+
+U64
+OfxPluginCacheFile::hashXML(const std::string & xmlCache)
+{
+    // FNV-1a
+    U64 hash = 14695981039346656037ULL;
+
+    for (std::size_t i = 0; i < xmlCache.size(); ++i) {
+        hash ^= (unsigned char)xmlCache[i];
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+/**
+ * @brief Gathers the elements parsed by expat in segments
+ **/
+struct OfxPluginCacheFileWriter
+{
+    struct Segment
+    {
+        std::string elements;
+        std::size_t lastCharactersPos; //< the position of the last element if it is characters, otherwise npos
+        bool isBundle;
+        std::string binaryPath;
+        long long binaryModificationTime;
+        long long binarySize;
+
+        Segment()
+            : elements()
+            , lastCharactersPos(std::string::npos)
+            , isBundle(false)
+            , binaryPath()
+            , binaryModificationTime(0)
+            , binarySize(0)
+        {
+        }
+    };
+
+    std::vector<Segment> segments;
+    int depth;
+    bool inSegment; //< false if the next element starts a new segment
+
+    OfxPluginCacheFileWriter()
+        : segments()
+        , depth(0)
+        , inSegment(false)
+    {
+    }
+
+    Segment & currentSegment(bool isBundle)
+    {
+        if (!inSegment || isBundle) {
+            segments.push_back( Segment() );
+            segments.back().isBundle = isBundle;
+            inSegment = true;
+        }
+
+        return segments.back();
+    }
+
+    template <typename T>
+    static void append(std::string* buffer,
+                       T value)
+    {
+        buffer->append( (const char*)&value, sizeof(T) );
+    }
+
+    static void appendString(std::string* buffer,
+                             const char* str,
+                             std::size_t length)
+    {
+        append<U32>(buffer, (U32)length);
+        buffer->append(str, length);
+        buffer->push_back('\0');
+    }
+
+    static void appendString(std::string* buffer,
+                             const char* str)
+    {
+        appendString( buffer, str, std::strlen(str) );
+    }
+
+    void elementBegin(const char* name,
+                      const char** attributes)
+    {
+        bool isBundle = (depth == 1) && (std::strcmp(name, "bundle") == 0);
+        Segment & segment = currentSegment(isBundle);
+        U32 attributesCount = 0;
+
+        segment.lastCharactersPos = std::string::npos;
+        while (attributes[attributesCount * 2]) {
+            ++attributesCount;
+        }
+        append<unsigned char>(&segment.elements, eOfxPluginCacheFileElementBegin);
+        appendString(&segment.elements, name);
+        append<U32>(&segment.elements, attributesCount);
+        for (U32 i = 0; i < attributesCount * 2; ++i) {
+            appendString(&segment.elements, attributes[i]);
+        }
+
+        if ( segment.isBundle && (depth == 2) && (std::strcmp(name, "binary") == 0) ) {
+            for (U32 i = 0; i < attributesCount; ++i) {
+                const char* attribute = attributes[i * 2];
+                const char* value = attributes[i * 2 + 1];
+                if (std::strcmp(attribute, "path") == 0) {
+                    segment.binaryPath = value;
+                } else if (std::strcmp(attribute, "mtime") == 0) {
+                    segment.binaryModificationTime = std::strtol(value, 0, 10);
+                } else if (std::strcmp(attribute, "size") == 0) {
+                    segment.binarySize = std::strtol(value, 0, 10);
+                }
+            }
+        }
+        ++depth;
+    }
+
+    void elementCharacters(const char* data,
+                           int length)
+    {
+        Segment & segment = currentSegment(false);
+
+        ///expat may split the characters in several calls, merge them
+        if (segment.lastCharactersPos != std::string::npos) {
+            std::size_t pos = segment.lastCharactersPos + 1;
+            U32 previousLength;
+            std::memcpy( &previousLength, &segment.elements[pos], sizeof(U32) );
+            previousLength += length;
+            std::memcpy( &segment.elements[pos], &previousLength, sizeof(U32) );
+        } else {
+            segment.lastCharactersPos = segment.elements.size();
+            append<unsigned char>(&segment.elements, eOfxPluginCacheFileElementCharacters);
+            append<U32>(&segment.elements, (U32)length);
+        }
+        segment.elements.append(data, length);
+    }
+
+    void elementEnd(const char* name)
+    {
+        --depth;
+        Segment & segment = currentSegment(false);
+        segment.lastCharactersPos = std::string::npos;
+        append<unsigned char>(&segment.elements, eOfxPluginCacheFileElementEnd);
+        appendString(&segment.elements, name);
+        if ( segment.isBundle && (depth == 1) ) {
+            inSegment = false;
+        }
+    }
+};
+
+static void
+elementBeginHandler(void* userData,
+                    const XML_Char* name,
+                    const XML_Char** attributes)
+{
+    ( (OfxPluginCacheFileWriter*)userData )->elementBegin(name, attributes);
+}
+
+static void
+elementCharactersHandler(void* userData,
+                         const XML_Char* data,
+                         int length)
+{
+    ( (OfxPluginCacheFileWriter*)userData )->elementCharacters(data, length);
+}
+
+static void
+elementEndHandler(void* userData,
+                  const XML_Char* name)
+{
+    ( (OfxPluginCacheFileWriter*)userData )->elementEnd(name);
+}
+
+static long long
+getProcessID()
+{
+#ifdef __NATRON_WIN32__
+
+    return (long long)GetCurrentProcessId();
+#else
+
+    return (long long)getpid();
+#endif
+}
+
+static bool
+replaceFile(const std::string & from,
+            const std::string & to)
+{
+#ifdef __NATRON_WIN32__
+
+    return MoveFileExW(Global::utf8_to_utf16(from).c_str(), Global::utf8_to_utf16(to).c_str(), MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+
+    ///rename() replaces the file atomically
+    return std::rename( from.c_str(), to.c_str() ) == 0;
+#endif
+}
+
+bool
+OfxPluginCacheFile::write(const std::string & xmlCache,
+                          const std::string & filePath)
+{
+    OfxPluginCacheFileWriter writer;
+    {
+        XML_Parser parser = XML_ParserCreate(NULL);
+        if (!parser) {
+            return false;
+        }
+        XML_SetUserData(parser, &writer);
+        XML_SetElementHandler(parser, elementBeginHandler, elementEndHandler);
+        XML_SetCharacterDataHandler(parser, elementCharactersHandler);
+        bool ok = XML_Parse(parser, xmlCache.c_str(), (int)xmlCache.size(), XML_TRUE) == XML_STATUS_OK;
+        XML_ParserFree(parser);
+        if (!ok) {
+            return false;
+        }
+    }
+
+    ///The segments table, whose offsets depend on its own size
+    std::size_t tableSize = 0;
+    for (std::size_t i = 0; i < writer.segments.size(); ++i) {
+        tableSize += 2 * sizeof(U64) + sizeof(unsigned char) + 2 * sizeof(long long) + sizeof(U32) + writer.segments[i].binaryPath.size() + 1;
+    }
+    std::string data;
+    OfxPluginCacheFileHeader header;
+    std::memset( &header, 0, sizeof(OfxPluginCacheFileHeader) );
+    std::memcpy( header.magic, NATRON_OFX_PLUGIN_CACHE_FILE_MAGIC, sizeof(header.magic) );
+    header.version = NATRON_OFX_PLUGIN_CACHE_FILE_VERSION;
+    header.segmentsCount = (U32)writer.segments.size();
+    header.xmlHash = hashXML(xmlCache);
+    data.append( (const char*)&header, sizeof(OfxPluginCacheFileHeader) );
+
+    U64 offset = sizeof(OfxPluginCacheFileHeader) + tableSize;
+    for (std::size_t i = 0; i < writer.segments.size(); ++i) {
+        const OfxPluginCacheFileWriter::Segment & segment = writer.segments[i];
+        OfxPluginCacheFileWriter::append<U64>(&data, offset);
+        OfxPluginCacheFileWriter::append<U64>(&data, segment.elements.size());
+        OfxPluginCacheFileWriter::append<unsigned char>(&data, segment.isBundle ? 1 : 0);
+        OfxPluginCacheFileWriter::append<long long>(&data, segment.binaryModificationTime);
+        OfxPluginCacheFileWriter::append<long long>(&data, segment.binarySize);
+        OfxPluginCacheFileWriter::appendString( &data, segment.binaryPath.c_str(), segment.binaryPath.size() );
+        offset += segment.elements.size();
+        if (segment.isBundle) {
+            ++header.bundlesCount;
+        }
+    }
+    assert( data.size() == sizeof(OfxPluginCacheFileHeader) + tableSize );
+    for (std::size_t i = 0; i < writer.segments.size(); ++i) {
+        data.append(writer.segments[i].elements);
+    }
+    header.fileSize = data.size();
+    std::memcpy( &data[0], &header, sizeof(OfxPluginCacheFileHeader) );
+
+    ///Several processes may start at the same time (e.g: NatronRenderer --workers): write to a file of our own
+    ///and replace the cache with it
+    std::stringstream ss;
+    ss << filePath << '.' << getProcessID();
+    std::string tmpFilePath = ss.str();
+    try {
+        MemoryFile tmpFile;
+        tmpFile.open(tmpFilePath, MemoryFile::eFileOpenModeEnumIfExistsTruncateElseCreate);
+        tmpFile.resize( data.size() );
+        std::memcpy( tmpFile.data(), data.c_str(), data.size() );
+        if ( !tmpFile.flush() ) {
+            tmpFile.remove();
+
+            return false;
+        }
+    } catch (const std::exception & /*e*/) {
+        std::remove( tmpFilePath.c_str() );
+
+        return false;
+    }
+    if ( !replaceFile(tmpFilePath, filePath) ) {
+        std::remove( tmpFilePath.c_str() );
+
+        return false;
+    }
+
+    return true;
+} // OfxPluginCacheFile::write
+
+NATRON_NAMESPACE_EXIT;
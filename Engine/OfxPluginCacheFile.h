@@ -0,0 +1,125 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_ENGINE_OFXPLUGINCACHEFILE_H
+#define NATRON_ENGINE_OFXPLUGINCACHEFILE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Receives the elements of the OpenFX plug-ins cache replayed by OfxPluginCacheFile, in the same order and
+ * with the same arguments as the expat handlers of OFX::Host::PluginCache::readCache() would.
+ **/
+class OfxPluginCacheFileHandler
+{
+public:
+
+    virtual ~OfxPluginCacheFileHandler() {}
+
+    ///attributes is a null-terminated list of name, value pairs
+    virtual void elementBegin(const char* name, const char** attributes) = 0;
+
+    virtual void elementCharacters(const char* data, int length) = 0;
+
+    virtual void elementEnd(const char* name) = 0;
+};
+
+struct OfxPluginCacheFilePrivate;
+
+/**
+ * @brief The OpenFX plug-ins cache in a binary form, so that it does not have to be parsed at each start.
+ * The XML written by OFX::Host::PluginCache::writePluginCache() is parsed once, when it changed, and its
+ * elements are stored already split into names, attributes and character data. The file is memory-mapped
+ * and its elements are replayed in the element callbacks of the PluginCache directly from the mapping.
+ *
+ * The elements of each <bundle> are stored apart, along with the modification time and size of its binary:
+ * the bundles whose binary changed on disk since the cache was written are not replayed, so that the
+ * PluginCache loads and describes them again when scanning the plug-ins.
+ * The file also records a hash of the XML it was made from, to know whether it must be written again.
+ *
+ * This is not MT-safe.
+ **/
+class OfxPluginCacheFile
+{
+public:
+
+    OfxPluginCacheFile();
+
+    ~OfxPluginCacheFile();
+
+    /**
+     * @brief Maps the given file to memory. Returns false if it does not exist or if it is not a valid cache file,
+     * e.g: written by another version of the format or partially written.
+     **/
+    bool open(const std::string & filePath);
+
+    void close();
+
+    bool isOpened() const;
+
+    /**
+     * @brief The hash (see hashXML()) of the XML cache the opened file was made from
+     **/
+    U64 getXMLHash() const;
+
+    /**
+     * @brief The number of <bundle> elements in the opened file
+     **/
+    int getBundlesCount() const;
+
+    /**
+     * @brief Replays the elements of the opened file in the handler, skipping the bundles whose binary
+     * changed on disk. Returns the number of bundles skipped.
+     **/
+    int replay(OfxPluginCacheFileHandler* handler) const;
+
+    static U64 hashXML(const std::string & xmlCache);
+
+    /**
+     * @brief Converts the given XML cache to the binary form and writes it to filePath.
+     * The file is written to a temporary file next to it which then replaces it, so that another process
+     * never maps a partially written cache. Returns false on failure.
+     **/
+    static bool write(const std::string & xmlCache, const std::string & filePath);
+
+private:
+
+    boost::scoped_ptr<OfxPluginCacheFilePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_ENGINE_OFXPLUGINCACHEFILE_H
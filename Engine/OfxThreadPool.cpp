@@ -0,0 +1,434 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "OfxThreadPool.h"
+
+#include <algorithm> // max
+#include <cassert>
+#include <list>
+#include <new> // std::bad_alloc
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QWaitCondition>
+
+#include "Engine/AppManager.h"
+#include "Engine/OfxHost.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+/**
+ * @brief A multiThread call being processed
+ **/
+struct PoolJob
+{
+    OfxThreadFunctionV1* func;
+    unsigned int nThreads;
+    unsigned int maxThreads;
+    void* customArg;
+    const QThread* spawnerThread;
+
+    //The NUMA node of the calling thread, or -1 if unknown
+    int node;
+
+    //The next thread index to call func with
+    unsigned int nextIndex;
+
+    //The number of calls to func that returned
+    unsigned int finishedCount;
+
+    //The number of threads of the pool processing this job
+    unsigned int activeThreads;
+
+    //The first error returned by a call
+    OfxStatus status;
+
+    //Signaled when finishedCount reaches nThreads
+    QWaitCondition finishedCond;
+
+    PoolJob()
+        : func(0)
+        , nThreads(0)
+        , maxThreads(0)
+        , customArg(0)
+        , spawnerThread(0)
+        , node(-1)
+        , nextIndex(0)
+        , finishedCount(0)
+        , activeThreads(0)
+        , status(kOfxStatOK)
+        , finishedCond()
+    {
+    }
+};
+
+class OfxPoolThread
+    : public QThread
+{
+public:
+
+    OfxPoolThread(OfxThreadPoolPrivate* pool,
+                  int cpu,
+                  int node)
+        : QThread()
+        , pool(pool)
+        , cpu(cpu)
+        , node(node)
+        , affinityGeneration(-1)
+        , pinned(false)
+    {
+        setObjectName( QString::fromUtf8("Multi-thread suite") );
+    }
+
+    virtual ~OfxPoolThread()
+    {
+    }
+
+    OfxThreadPoolPrivate* pool;
+
+    //The CPU this thread was created for and its NUMA node
+    int cpu;
+    int node;
+
+    //The value of OfxThreadPoolPrivate::affinityGeneration when the affinity of this thread was last set
+    int affinityGeneration;
+
+    //True if the affinity of this thread was restricted
+    bool pinned;
+
+private:
+
+    virtual void run() OVERRIDE FINAL;
+};
+
+OfxStatus
+callThreadFunction(PoolJob* job,
+                   unsigned int threadIndex)
+{
+    OfxHost::OfxHostDataTLSPtr tls = appPTR->getOFXHost()->getTLSData();
+
+    tls->threadIndexes.push_back( (int)threadIndex );
+
+    OfxStatus ret = kOfxStatOK;
+    try {
+        job->func(threadIndex, job->nThreads, job->customArg);
+    } catch (const std::bad_alloc & ba) {
+        ret = kOfxStatErrMemory;
+    } catch (...) {
+        ret = kOfxStatFailed;
+    }
+
+    ///reset back the index otherwise it could mess up the indexes of the next job run by this thread
+    tls->threadIndexes.pop_back();
+
+    return ret;
+}
+} // anon namespace
+
+struct OfxThreadPoolPrivate
+{
+    const CpuTopology* topology;
+
+    //Protects all the members below and the jobs
+    QMutex mutex;
+
+    //Signaled when a job is added, when a job can take more threads, when the affinity changes and on exit
+    QWaitCondition jobsCond;
+
+    std::list<PoolJob*> jobs;
+    std::vector<OfxPoolThread*> threads;
+
+    //The number of threads of each NUMA node waiting for a job
+    std::vector<int> idleThreadsPerNode;
+
+    CpuAffinityModeEnum affinityMode;
+
+    //Incremented each time the affinity mode changes, so that each thread applies it once
+    int affinityGeneration;
+
+    bool quit;
+
+    OfxThreadPoolPrivate(const CpuTopology* topology)
+        : topology(topology)
+        , mutex()
+        , jobsCond()
+        , jobs()
+        , threads()
+        , idleThreadsPerNode(topology->getNumaNodesCount(), 0)
+        , affinityMode(eCpuAffinityModeNone)
+        , affinityGeneration(0)
+        , quit(false)
+    {
+    }
+
+    ///Must be called with mutex locked
+    void startThreads()
+    {
+        const std::vector<CpuInfo>& cpus = topology->getCpus();
+
+        threads.resize( cpus.size() );
+        for (std::size_t i = 0; i < cpus.size(); ++i) {
+            threads[i] = new OfxPoolThread(this, cpus[i].cpu, cpus[i].numaNode);
+            threads[i]->start();
+        }
+    }
+
+    /**
+     * @brief Returns the first job the given thread may help with, or NULL. Must be called with mutex locked.
+     * A thread only takes a job of another node if all the threads of that node are busy.
+     **/
+    PoolJob* findJob(int node) const
+    {
+        for (std::list<PoolJob*>::const_iterator it = jobs.begin(); it != jobs.end(); ++it) {
+            PoolJob* job = *it;
+            if (job->activeThreads >= job->maxThreads) {
+                continue;
+            }
+            if ( (job->node < 0) || (job->node == node) || (idleThreadsPerNode[job->node] == 0) ) {
+                return job;
+            }
+        }
+
+        return 0;
+    }
+
+    ///Must be called with mutex locked. Returns false if all the indexes of the job were taken.
+    bool takeNextIndex(PoolJob* job,
+                       unsigned int* threadIndex)
+    {
+        if (job->nextIndex >= job->nThreads) {
+            return false;
+        }
+        *threadIndex = job->nextIndex++;
+        if (job->nextIndex == job->nThreads) {
+            ///Nothing left for other threads
+            jobs.remove(job);
+        }
+
+        return true;
+    }
+
+    void applyAffinity(OfxPoolThread* thread,
+                       CpuAffinityModeEnum mode)
+    {
+        std::vector<int> cpus;
+
+        switch (mode) {
+        case eCpuAffinityModeNone:
+            break;
+        case eCpuAffinityModeNumaNode:
+            ///On a single node this is the same as no affinity
+            if (topology->getNumaNodesCount() > 1) {
+                topology->getCpusOfNode(thread->node, &cpus);
+            }
+            break;
+        case eCpuAffinityModeCpu:
+            cpus.push_back(thread->cpu);
+            break;
+        }
+
+        if ( cpus.empty() ) {
+            if (!thread->pinned) {
+                return;
+            }
+            const std::vector<CpuInfo>& allCpus = topology->getCpus();
+            for (std::size_t i = 0; i < allCpus.size(); ++i) {
+                cpus.push_back(allCpus[i].cpu);
+            }
+            CpuTopology::setCurrentThreadAffinity(cpus);
+            thread->pinned = false;
+        } else {
+            thread->pinned = CpuTopology::setCurrentThreadAffinity(cpus);
+        }
+    }
+
+    void runThread(OfxPoolThread* thread);
+};
+
+void
+OfxThreadPoolPrivate::runThread(OfxPoolThread* thread)
+{
+    CpuTopology::setCurrentThreadNumaNode(thread->node);
+
+    QMutexLocker k(&mutex);
+    for (;;) {
+        if (quit) {
+            return;
+        }
+
+        if (thread->affinityGeneration != affinityGeneration) {
+            CpuAffinityModeEnum mode = affinityMode;
+            thread->affinityGeneration = affinityGeneration;
+            k.unlock();
+            applyAffinity(thread, mode);
+            k.relock();
+            continue;
+        }
+
+        PoolJob* job = findJob(thread->node);
+        if (!job) {
+            ++idleThreadsPerNode[thread->node];
+            jobsCond.wait(&mutex);
+            --idleThreadsPerNode[thread->node];
+            continue;
+        }
+
+        unsigned int threadIndex;
+        if ( !takeNextIndex(job, &threadIndex) ) {
+            continue;
+        }
+        ++job->activeThreads;
+        if ( (job->activeThreads < job->maxThreads) && (job->nextIndex < job->nThreads) ) {
+            ///Threads of other nodes may have skipped this job while threads of its node were idle
+            jobsCond.wakeAll();
+        }
+        const QThread* spawnerThread = job->spawnerThread;
+        k.unlock();
+
+        appPTR->fetchAndAddNRunningThreads(1);
+        appPTR->getAppTLS()->softCopy(spawnerThread, thread);
+
+        bool hasIndex = true;
+        while (hasIndex) {
+            OfxStatus stat = callThreadFunction(job, threadIndex);
+
+            ///Once finishedCount reaches nThreads, the caller may return and destroy the job: it must not be accessed
+            ///after the mutex is released
+            k.relock();
+            if ( (stat != kOfxStatOK) && (job->status == kOfxStatOK) ) {
+                job->status = stat;
+            }
+            ++job->finishedCount;
+            hasIndex = takeNextIndex(job, &threadIndex);
+            if (!hasIndex) {
+                --job->activeThreads;
+                if (job->finishedCount == job->nThreads) {
+                    job->finishedCond.wakeAll();
+                }
+            }
+            k.unlock();
+        }
+
+        appPTR->getAppTLS()->cleanupTLSForThread();
+        appPTR->fetchAndAddNRunningThreads(-1);
+
+        k.relock();
+    }
+} // OfxThreadPoolPrivate::runThread
+
+void
+OfxPoolThread::run()
+{
+    pool->runThread(this);
+}
+
+OfxThreadPool::OfxThreadPool(const CpuTopology* topology)
+    : _imp( new OfxThreadPoolPrivate(topology) )
+{
+}
+
+OfxThreadPool::~OfxThreadPool()
+{
+    {
+        QMutexLocker k(&_imp->mutex);
+        assert( _imp->jobs.empty() );
+        _imp->quit = true;
+        _imp->jobsCond.wakeAll();
+    }
+    for (std::size_t i = 0; i < _imp->threads.size(); ++i) {
+        _imp->threads[i]->wait();
+        delete _imp->threads[i];
+    }
+}
+
+void
+OfxThreadPool::setAffinityMode(CpuAffinityModeEnum mode)
+{
+    QMutexLocker k(&_imp->mutex);
+
+    if (mode == _imp->affinityMode) {
+        return;
+    }
+    _imp->affinityMode = mode;
+    ++_imp->affinityGeneration;
+    _imp->jobsCond.wakeAll();
+}
+
+bool
+OfxThreadPool::isPoolThread()
+{
+    return dynamic_cast<OfxPoolThread*>( QThread::currentThread() ) != 0;
+}
+
+OfxStatus
+OfxThreadPool::run(OfxThreadFunctionV1 func,
+                   unsigned int nThreads,
+                   unsigned int maxConcurrentThreads,
+                   void* customArg)
+{
+    if (nThreads == 0) {
+        return kOfxStatOK;
+    }
+
+    PoolJob job;
+    job.func = func;
+    job.nThreads = nThreads;
+    job.maxThreads = std::max(1U, maxConcurrentThreads);
+    job.customArg = customArg;
+    job.spawnerThread = QThread::currentThread();
+
+    if ( isPoolThread() ) {
+        ///A plug-in calling multiThread from a thread function: waiting for other threads of the pool
+        ///could dead-lock if all of them do the same
+        for (unsigned int i = 0; i < nThreads; ++i) {
+            OfxStatus stat = callThreadFunction(&job, i);
+            if ( (stat != kOfxStatOK) && (job.status == kOfxStatOK) ) {
+                job.status = stat;
+            }
+        }
+
+        return job.status;
+    }
+
+    int cpu = CpuTopology::getCurrentCpu();
+    job.node = cpu < 0 ? -1 : _imp->topology->getNodeOfCpu(cpu);
+
+    QMutexLocker k(&_imp->mutex);
+    if ( _imp->threads.empty() ) {
+        _imp->startThreads();
+    }
+    _imp->jobs.push_back(&job);
+    _imp->jobsCond.wakeAll();
+    while (job.finishedCount < job.nThreads) {
+        job.finishedCond.wait(&_imp->mutex);
+    }
+    assert(job.activeThreads == 0);
+
+    return job.status;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,93 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef OFXTHREADPOOL_H
+#define OFXTHREADPOOL_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include <ofxCore.h>
+#include <ofxMultiThread.h>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/CpuTopology.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief The threads running the OfxMultiThreadSuiteV1::multiThread calls of the plug-ins.
+ * Instead of creating threads for each call, the pool keeps one thread per CPU the process may run on, started
+ * on the first call. Each thread belongs to the NUMA node of its CPU and, depending on the affinity mode, is bound
+ * to the CPUs of that node or to its CPU only, so that the scheduler does not move it away from the memory it
+ * touched.
+ *
+ * A call is first given to the threads of the NUMA node of the calling thread, which is where the render thread
+ * allocated and wrote the images the plug-in reads. Threads of the other nodes only help if there is no idle thread
+ * left on that node. The thread indexes are taken in increasing order, so that the rows a plug-in processes for
+ * neighbouring indexes are most often processed on the same node.
+ *
+ * The memory the threads touch first, such as the buffers they allocate with the memory suites, is placed by the
+ * kernel on their node. The PluginMemoryPool only gives them back blocks released on their node.
+ *
+ * The thread-local storage of the caller is copied to the threads for the duration of the call, as for the threads
+ * spawned by the multi-thread suite.
+ **/
+struct OfxThreadPoolPrivate;
+class OfxThreadPool
+{
+public:
+
+    OfxThreadPool(const CpuTopology* topology);
+
+    ///Stops the threads, no call may be running
+    ~OfxThreadPool();
+
+    void setAffinityMode(CpuAffinityModeEnum mode);
+
+    /**
+     * @brief Calls func for each thread index from 0 to nThreads - 1 on at most maxConcurrentThreads threads of the pool
+     * and returns once all the calls returned. Returns the first error of the calls.
+     * If called from a thread of the pool, the calls are made by the calling thread.
+     **/
+    OfxStatus run(OfxThreadFunctionV1 func, unsigned int nThreads, unsigned int maxConcurrentThreads, void* customArg);
+
+    /**
+     * @brief Returns true if the calling thread belongs to an OfxThreadPool
+     **/
+    static bool isPoolThread();
+
+private:
+
+    boost::scoped_ptr<OfxThreadPoolPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // OFXTHREADPOOL_H
@@ -56,6 +56,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/KnobFile.h"
 #include "Engine/KnobTypes.h"
 #include "Engine/Log.h"
+#include "Engine/MemoryGovernor.h"
 #include "Engine/Node.h"
 #include "Engine/OfxEffectInstance.h"
 #include "Engine/OfxEffectInstance.h"
@@ -502,6 +503,23 @@ OutputEffectInstance::reportStats(int time,
     }
 
     ofile << "Time spent to render frame (wall clock time): " << Timer::printAsTime(wallTime, false).toStdString() << std::endl;
+
+    MemoryStats memory;
+    appPTR->getMemoryStats(&memory);
+    ofile << "Memory available: " << printAsRAM(memory.totalRAM).toStdString();
+    if (memory.cgroupLimit != 0) {
+        ofile << " (cgroup limit: " << printAsRAM(memory.cgroupLimit).toStdString() << ", used: " << printAsRAM(memory.cgroupUsage).toStdString() << ")";
+    }
+    ofile << std::endl;
+    ofile << "Memory free: " << printAsRAM(memory.freeRAM).toStdString() << std::endl;
+    if (memory.pressure >= 0) {
+        ofile << "Memory pressure: " << memory.pressure << "%" << std::endl;
+    }
+    ofile << "Memory budget factor: " << memory.budgetFactor << std::endl;
+    ofile << "NodeCache: " << printAsRAM(memory.nodeCacheSize).toStdString() << " / " << printAsRAM(memory.nodeCacheBudget).toStdString() << std::endl;
+    ofile << "ViewerCache: " << printAsRAM(memory.viewerCacheSize).toStdString() << " / " << printAsRAM(memory.viewerCacheBudget).toStdString() << std::endl;
+    ofile << "Plug-ins memory: " << printAsRAM(memory.pluginMemorySize).toStdString() << " / " << printAsRAM(memory.pluginMemoryBudget).toStdString()
+          << " (" << printAsRAM(memory.pluginMemoryPoolSize).toStdString() << " free in the pool)" << std::endl;
     for (std::map<NodePtr, NodeRenderStats >::const_iterator it = stats.begin(); it != stats.end(); ++it) {
         ofile << "------------------------------- " << it->first->getScriptName_mt_safe() << "------------------------------- " << std::endl;
         ofile << "Time spent rendering: " << Timer::printAsTime(it->second.getTotalTimeSpentRendering(), false).toStdString() << std::endl;
@@ -569,6 +587,11 @@ OutputEffectInstance::reportStats(int time,
         ofile << "Nb cache hit: " << nbCacheMiss << std::endl;
         ofile << "Nb cache miss: " << nbCacheMiss << std::endl;
         ofile << "Nb cache hit requiring mipmap downscaling: " << nbCacheHitButDownscaled << std::endl;
+        int nbPluginAllocations, nbPluginRecycledAllocations;
+        U64 pluginMemoryAllocated;
+        it->second.getPluginMemoryInfos(&nbPluginAllocations, &nbPluginRecycledAllocations, &pluginMemoryAllocated);
+        ofile << "Plug-in memory allocated: " << printAsRAM(pluginMemoryAllocated).toStdString() << " in " << nbPluginAllocations
+              << " allocation(s), " << nbPluginRecycledAllocations << " recycled" << std::endl;
 
         const std::set<std::string> & planes = it->second.getPlanesRendered();
         ofile << "Plane(s) rendered: ";
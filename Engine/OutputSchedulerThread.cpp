@@ -53,6 +53,7 @@
 #include "Engine/KnobFile.h"
 #include "Engine/Node.h"
 #include "Engine/OpenGLViewerI.h"
+#include "Engine/PerfReport.h"
 #include "Engine/Project.h"
 #include "Engine/RenderStats.h"
 #include "Engine/RotoContext.h"
@@ -179,6 +180,7 @@ struct OutputSchedulerThreadPrivate
 {
     
     FrameBuffer buf; //the frames rendered by the worker threads that needs to be rendered in order by the output device
+    std::set<double> droppedFrames; //frames skipped by realtime playback whose render is not finished yet: they are not buffered, protected by bufMutex
     QWaitCondition bufCondition;
     mutable QMutex bufMutex;
     
@@ -278,6 +280,7 @@ struct OutputSchedulerThreadPrivate
     
     OutputSchedulerThreadPrivate(RenderEngine* engine,const boost::shared_ptr<OutputEffectInstance>& effect,OutputSchedulerThread::ProcessFrameModeEnum mode)
     : buf()
+    , droppedFrames()
     , bufCondition()
     , bufMutex()
     , working(false)
@@ -540,7 +543,7 @@ OutputSchedulerThread::OutputSchedulerThread(RenderEngine* engine,const boost::s
     QObject::connect(this, SIGNAL(s_doProcessOnMainThread(BufferedFrames)), this,
                      SLOT(doProcessFrameMainThread(BufferedFrames)));
     
-    QObject::connect(_imp->timer.get(), SIGNAL(fpsChanged(double,double)), _imp->engine, SIGNAL(fpsChanged(double,double)));
+    QObject::connect(_imp->timer.get(), SIGNAL(fpsChanged(double,double,int)), _imp->engine, SIGNAL(fpsChanged(double,double,int)));
     
     QObject::connect(this, SIGNAL(s_abortRenderingOnMainThread(bool,bool)), this, SLOT(abortRendering(bool,bool)));
     
@@ -1024,6 +1027,7 @@ OutputSchedulerThread::startRender()
 
     
     if ( isFPSRegulationNeeded() ) {
+        _imp->timer->setRealtimeEnabled( appPTR->getCurrentSettings()->isRealtimePlaybackEnabled() );
         _imp->timer->playState = ePlayStateRunning;
     }
     
@@ -1218,6 +1222,7 @@ OutputSchedulerThread::stopRender()
         {
             QMutexLocker k(&_imp->bufMutex);
             _imp->buf.clear();
+            _imp->droppedFrames.clear();
         }
 
         
@@ -1287,6 +1292,8 @@ OutputSchedulerThread::run()
                 BufferedFrames framesToRender;
                 {
                     QMutexLocker l(&_imp->bufMutex);
+                    ///The frame may have been skipped earlier (e.g: in the previous loop), we now want it
+                    _imp->droppedFrames.erase(expectedTimeToRender);
                     _imp->getFromBufferAndErase(expectedTimeToRender, framesToRender);
                 }
                 
@@ -1296,6 +1303,9 @@ OutputSchedulerThread::run()
                 }
     
                 int nextFrameToRender = -1;
+                int firstFrame = 0,lastFrame = 0,frameStep = 1;
+                PlaybackModeEnum pMode = ePlaybackModeLoop;
+                RenderDirectionEnum timelineDirection = eRenderDirectionForward;
                
                 if (!renderFinished) {
                 
@@ -1303,12 +1313,9 @@ OutputSchedulerThread::run()
                     /////Refresh frame range if needed (for viewers)
                     
 
-                    int firstFrame,lastFrame;
                     getFrameRangeToRender(firstFrame, lastFrame);
                     
                     
-                    RenderDirectionEnum timelineDirection;
-                    int frameStep;
                     {
                         QMutexLocker l(&_imp->runArgsMutex);
                         
@@ -1325,7 +1332,7 @@ OutputSchedulerThread::run()
                     ///////////
                     ///Determine if we finished rendering or if we should just increment/decrement the timeline
                     ///or just loop/bounce
-                    PlaybackModeEnum pMode = _imp->engine->getPlaybackMode();
+                    pMode = _imp->engine->getPlaybackMode();
                     RenderDirectionEnum newDirection;
                     if (firstFrame == lastFrame && pMode == ePlaybackModeOnce) {
                         renderFinished = true;
@@ -1340,6 +1347,7 @@ OutputSchedulerThread::run()
                         _imp->livingRunArgs.timelineDirection = newDirection;
                         _imp->requestedRunArgs.timelineDirection = newDirection;
                     }
+                    timelineDirection = newDirection;
                                         
                     if (!renderFinished) {
 #ifndef NATRON_SCHEDULER_SPAWN_THREADS_WITH_TIMER
@@ -1362,7 +1370,10 @@ OutputSchedulerThread::run()
                 } // if (!renderFinished) {
                 
                 if (_imp->timer->playState == ePlayStateRunning) {
-                    _imp->timer->waitUntilNextFrameIsDue(); // timer synchronizing with the requested fps
+                    int framesLate = _imp->timer->waitUntilNextFrameIsDue(); // timer synchronizing with the requested fps
+                    if ( (framesLate > 0) && !renderFinished && (firstFrame != lastFrame) ) {
+                        dropFrames(framesLate, pMode, firstFrame, lastFrame, frameStep, timelineDirection, &nextFrameToRender);
+                    }
                 }
                 
                 
@@ -1543,7 +1554,17 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
     if (stats) {
         std::map<NodePtr,NodeRenderStats > statResults = stats->getStats(&timeSpent);
         if (!statResults.empty()) {
-            effect->reportStats(frame, viewIndex, timeSpent, statResults);
+            bool enableRenderStats;
+            {
+                QMutexLocker l(&_imp->runArgsMutex);
+                enableRenderStats = _imp->livingRunArgs.enableRenderStats;
+            }
+            if (enableRenderStats) {
+                effect->reportStats(frame, viewIndex, timeSpent, statResults);
+            }
+            if ( PerfReport::isEnabled() ) {
+                PerfReport::addFrame(effect->getNode()->getFullyQualifiedName(), timeSpent, statResults);
+            }
         }
     }
     //U64 nbFramesLeftToRender;
@@ -1633,7 +1654,11 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
             ts << "\nTime elapsed for frame: " << timeSpentStr;
             ts << "\nTime remaining: " << timeRemainingStr;
         }
-        appPTR->writeToOutputPipe(longMessage,QString::fromUtf8(kFrameRenderedStringShort) + frameStr + QString::fromUtf8(kProgressChangedStringShort) + QString::number(percentage));
+        QString shortMessage = QString::fromUtf8(kFrameRenderedStringShort) + frameStr + QString::fromUtf8(kProgressChangedStringShort) + QString::number(percentage);
+        if (stats) {
+            shortMessage += QString::fromUtf8(kFrameRenderTimeStringShort) + QString::number(timeSpent);
+        }
+        appPTR->writeToOutputPipe(longMessage, shortMessage);
     }
     
     if (viewIndex == viewsToRender[viewsToRender.size() - 1] || viewIndex == -1) {
@@ -1687,6 +1712,43 @@ OutputSchedulerThread::notifyFrameRendered(int frame,
     }
 }
 
+void
+OutputSchedulerThread::dropFrames(int nFrames,
+                                  PlaybackModeEnum pMode,
+                                  int firstFrame,
+                                  int lastFrame,
+                                  int frameStep,
+                                  RenderDirectionEnum direction,
+                                  int* nextFrameToRender)
+{
+    ///Skip the frames that missed their presentation time. They are still rendered by the render threads
+    ///so that they are in the cache the next time they are needed, but they will not be displayed.
+    int dropped = 0;
+    RenderDirectionEnum newDirection = direction;
+    {
+        QMutexLocker l(&_imp->bufMutex);
+        for (; dropped < nFrames; ++dropped) {
+            int frame;
+            if ( !OutputSchedulerThreadPrivate::getNextFrameInSequence(pMode, newDirection, *nextFrameToRender,
+                                                                       firstFrame, lastFrame, frameStep, &frame, &newDirection) ) {
+                break;
+            }
+            BufferedFrames discarded;
+            _imp->getFromBufferAndErase(*nextFrameToRender, discarded);
+            if ( discarded.empty() ) {
+                _imp->droppedFrames.insert(*nextFrameToRender);
+            }
+            *nextFrameToRender = frame;
+        }
+    }
+    if (newDirection != direction) {
+        QMutexLocker l(&_imp->runArgsMutex);
+        _imp->livingRunArgs.timelineDirection = newDirection;
+        _imp->requestedRunArgs.timelineDirection = newDirection;
+    }
+    _imp->timer->addDroppedFrames(dropped);
+}
+
 void
 OutputSchedulerThread::appendToBuffer_internal(double time,
                                                ViewIdx view,
@@ -1710,6 +1772,10 @@ OutputSchedulerThread::appendToBuffer_internal(double time,
         ///Called by the scheduler thread when an image is rendered
         
         QMutexLocker l(&_imp->bufMutex);
+        if (_imp->droppedFrames.erase(time) > 0) {
+            ///The frame was skipped by realtime playback, it was only rendered to be cached
+            return;
+        }
         ignore_result(_imp->appendBufferedFrame(time, view, stats, frame));
         if (wakeThread) {
             ///Wake up the scheduler thread that an image is available if it is asleep so it can process it.
@@ -1931,6 +1997,18 @@ OutputSchedulerThread::getDesiredFPS() const
     return _imp->timer->getDesiredFrameRate();
 }
 
+double
+OutputSchedulerThread::getActualFPS() const
+{
+    return _imp->timer->getActualFrameRate();
+}
+
+int
+OutputSchedulerThread::getDroppedFrames() const
+{
+    return _imp->timer->getDroppedFrames();
+}
+
 void
 OutputSchedulerThread::renderFrameRange(bool isBlocking,
                                         bool enableRenderStats,
@@ -2390,7 +2468,8 @@ private:
 
         ///Even if enableRenderStats is false, we at least profile the time spent rendering the frame when rendering with a Write node.
         ///Though we don't enable render stats for sequential renders (e.g: WriteFFMPEG) since this is 1 file.
-        RenderStatsPtr stats(new RenderStats(renderDirectly && enableRenderStats));
+        ///The performance report needs the time spent by each node, even if no stats file is written.
+        RenderStatsPtr stats(new RenderStats(renderDirectly && (enableRenderStats || PerfReport::isEnabled())));
         
         NodePtr outputNode = output->getNode();
         
@@ -2666,6 +2745,9 @@ DefaultScheduler::processFrame(const BufferedFrames& frames)
             retCode = effect->renderRoI(*renderArgs, &planes);
             if (retCode != EffectInstance::eRenderRoIRetCodeOk) {
                 notifyRenderFailure("");
+            } else if ( appPTR->isBackground() ) {
+                ///Hand the frame to the process which launched this one, see ProcessHandler
+                appPTR->publishImageToSharedFrameChannel(inputImage);
             }
         } catch (const std::exception& e) {
             notifyRenderFailure(e.what());
@@ -2712,6 +2794,7 @@ DefaultScheduler::handleRenderFailure(const std::string& errorMessage)
 {
     if (appPTR->isBackground()) {
         std::cerr << errorMessage << std::endl;
+        _effect.lock()->getApp()->notifyRenderFailure(errorMessage);
     }
 }
 
@@ -3392,6 +3475,18 @@ RenderEngine::getDesiredFPS() const
     return _imp->scheduler ? _imp->scheduler->getDesiredFPS() : 24;
 }
 
+double
+RenderEngine::getActualFPS() const
+{
+    return _imp->scheduler ? _imp->scheduler->getActualFPS() : 0.;
+}
+
+int
+RenderEngine::getDroppedFrames() const
+{
+    return _imp->scheduler ? _imp->scheduler->getDroppedFrames() : 0;
+}
+
 
 void
 RenderEngine::notifyFrameProduced(const BufferableObjectList& frames, const RenderStatsPtr& stats, const boost::shared_ptr<RequestedFrame>& request)
@@ -171,6 +171,18 @@ private:
                                  const boost::shared_ptr<BufferableObject>& frame,
                                  bool wakeThread);
     
+    /**
+     * @brief Called in realtime playback when the frame being presented is nFrames late: skips the nFrames frames
+     * following nextFrameToRender in the sequence and sets nextFrameToRender to the frame after them.
+     **/
+    void dropFrames(int nFrames,
+                    PlaybackModeEnum pMode,
+                    int firstFrame,
+                    int lastFrame,
+                    int frameStep,
+                    RenderDirectionEnum direction,
+                    int* nextFrameToRender);
+    
 public:
     
     
@@ -285,6 +297,17 @@ public:
      **/
     double getDesiredFPS() const;
     
+    /**
+     * @brief Returns the frame rate at which frames were actually presented, averaged over the last second or so.
+     **/
+    double getActualFPS() const;
+    
+    /**
+     * @brief Returns the number of frames skipped during the current or last playback to keep up with the desired FPS.
+     * This is always 0 unless realtime playback is enabled in the settings.
+     **/
+    int getDroppedFrames() const;
+    
     void runCallbackWithVariables(const QString& callback);
     
     /**
@@ -683,6 +706,16 @@ public:
      **/
     double getDesiredFPS() const;
     
+    /**
+     * @brief Returns the frame rate at which frames were actually presented during playback.
+     **/
+    double getActualFPS() const;
+    
+    /**
+     * @brief Returns the number of frames skipped during playback to keep up with the desired FPS, see OutputSchedulerThread::getDroppedFrames()
+     **/
+    int getDroppedFrames() const;
+    
     /**
      * @brief Quit all processing, making sure all threads are finished.
      **/
@@ -737,10 +770,10 @@ public Q_SLOTS:
 Q_SIGNALS:
     
     /**
-     * @brief Emitted when the fps has changed
+     * @brief Emitted when the fps has changed, along with the number of frames dropped since playback started.
      * This will not be emitted after calling renderCurrentFrame
      **/
-    void fpsChanged(double actualFps,double desiredFps);
+    void fpsChanged(double actualFps,double desiredFps,int droppedFrames);
     
     /**
      * @brief Emitted after a frame is rendered.
@@ -782,7 +815,7 @@ private:
     /**
      * The following functions are called by the OutputThreadScheduler to Q_EMIT the corresponding signals
      **/
-    void s_fpsChanged(double actual,double desired) { Q_EMIT fpsChanged(actual, desired); }
+    void s_fpsChanged(double actual,double desired,int dropped) { Q_EMIT fpsChanged(actual, desired, dropped); }
     void s_frameRendered(int time, double progress) { Q_EMIT frameRendered(time,progress); }
    
     void s_renderStarted(bool forward) { Q_EMIT renderStarted(forward); }
@@ -0,0 +1,194 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PerfReport.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+#include "Global/GitVersion.h"
+#include "Global/JSONUtils.h"
+#include "Global/MemoryInfo.h"
+
+#include "Engine/AppManager.h"
+#include "Engine/FStreamsSupport.h"
+#include "Engine/Node.h"
+#include "Engine/RenderStats.h"
+#include "Engine/Settings.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+struct NodePerf
+{
+    std::string pluginID;
+    int frames;
+    double timeSpent;
+    int cacheHits;
+    int cacheMisses;
+
+    NodePerf()
+        : pluginID()
+        , frames(0)
+        , timeSpent(0.)
+        , cacheHits(0)
+        , cacheMisses(0)
+    {
+    }
+};
+
+struct WriterPerf
+{
+    int frames;
+    double timeSpent;
+
+    WriterPerf()
+        : frames(0)
+        , timeSpent(0.)
+    {
+    }
+};
+
+QAtomicInt enabled(0);
+
+//Protects all the variables below
+QMutex perfMutex;
+QElapsedTimer processTimer;
+double renderWallTime = 0.;
+std::map<std::string, WriterPerf> writers;
+std::map<std::string, NodePerf> nodes;
+} // anon namespace
+
+void
+PerfReport::setEnabled(bool enable)
+{
+    if (enable) {
+        QMutexLocker k(&perfMutex);
+        if ( !processTimer.isValid() ) {
+            processTimer.start();
+        }
+    }
+    enabled.fetchAndStoreOrdered(enable ? 1 : 0);
+}
+
+bool
+PerfReport::isEnabled()
+{
+    return (int)enabled != 0;
+}
+
+void
+PerfReport::addFrame(const std::string& writerName,
+                     double timeSpent,
+                     const std::map<NodePtr, NodeRenderStats>& stats)
+{
+    QMutexLocker k(&perfMutex);
+    WriterPerf& writer = writers[writerName];
+
+    ++writer.frames;
+    writer.timeSpent += timeSpent;
+
+    for (std::map<NodePtr, NodeRenderStats>::const_iterator it = stats.begin(); it != stats.end(); ++it) {
+        ///Nodes are identified by their fully qualified name so that nodes with the same name in different groups are not mixed
+        NodePerf& node = nodes[it->first->getFullyQualifiedName()];
+        if ( node.pluginID.empty() ) {
+            node.pluginID = it->first->getPluginID();
+        }
+        ++node.frames;
+        node.timeSpent += it->second.getTotalTimeSpentRendering();
+        int misses, hits, downscaled;
+        it->second.getCacheAccessInfos(&misses, &hits, &downscaled);
+        node.cacheHits += hits + downscaled;
+        node.cacheMisses += misses;
+    }
+}
+
+void
+PerfReport::addRenderWallTime(double seconds)
+{
+    QMutexLocker k(&perfMutex);
+
+    renderWallTime += seconds;
+}
+
+bool
+PerfReport::writeJSON(const std::string& filename,
+                      std::string* error)
+{
+    FStreamsSupport::ofstream ofile;
+
+    FStreamsSupport::open(&ofile, filename);
+    if (!ofile) {
+        *error = "Failed to open " + filename + " for writing";
+
+        return false;
+    }
+
+    int nThreads = appPTR->getCurrentSettings()->getNumberOfThreads();
+    if (nThreads == 0) {
+        nThreads = QThread::idealThreadCount();
+    }
+
+    QMutexLocker k(&perfMutex);
+    ofile.precision(9);
+    ofile << "{\n";
+    ofile << "  \"version\": " << NATRON_PERF_REPORT_VERSION << ",\n";
+    ofile << "  \"natronVersion\": \"" << NATRON_VERSION_STRING << "\",\n";
+    ofile << "  \"gitCommit\": \"" << GIT_COMMIT << "\",\n";
+    ofile << "  \"threads\": " << nThreads << ",\n";
+    ofile << "  \"wallSeconds\": " << (processTimer.isValid() ? processTimer.elapsed() / 1000. : 0.) << ",\n";
+    ofile << "  \"renderWallSeconds\": " << renderWallTime << ",\n";
+    ofile << "  \"peakRSS\": " << (U64)getPeakRSS() << ",\n";
+    ofile << "  \"writers\": [";
+    for (std::map<std::string, WriterPerf>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        ofile << ( it == writers.begin() ? "\n" : ",\n" ) << "    {\"name\": ";
+        JSONUtils::writeString(ofile, it->first);
+        ofile << ", \"frames\": " << it->second.frames << ", \"frameSeconds\": " << it->second.timeSpent << "}";
+    }
+    ofile << "\n  ],\n";
+    ofile << "  \"nodes\": [";
+    for (std::map<std::string, NodePerf>::const_iterator it = nodes.begin(); it != nodes.end(); ++it) {
+        ofile << ( it == nodes.begin() ? "\n" : ",\n" ) << "    {\"name\": ";
+        JSONUtils::writeString(ofile, it->first);
+        ofile << ", \"pluginID\": ";
+        JSONUtils::writeString(ofile, it->second.pluginID);
+        ofile << ", \"frames\": " << it->second.frames << ", \"seconds\": " << it->second.timeSpent
+              << ", \"cacheHits\": " << it->second.cacheHits << ", \"cacheMisses\": " << it->second.cacheMisses << "}";
+    }
+    ofile << "\n  ]\n";
+    ofile << "}\n";
+
+    if (!ofile) {
+        *error = "Failed to write " + filename;
+
+        return false;
+    }
+
+    return true;
+} // PerfReport::writeJSON
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,78 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef PERFREPORT_H
+#define PERFREPORT_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <map>
+#include <string>
+
+#include "Global/Macros.h"
+
+#include <QtCore/QtGlobal>
+
+#include "Engine/EngineFwd.h"
+
+///The version of the JSON written by PerfReport, increment it when its layout changes
+#define NATRON_PERF_REPORT_VERSION 1
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Accumulates the render statistics of all the frames rendered by the writers, to measure the performance of
+ * a whole render from the command-line (see the --perf-report option).
+ * The time spent by each node is summed over all frames, along with the wall-clock time of the renders and the peak
+ * resident memory of the process, and written in JSON so that renders can be compared across versions.
+ * All functions are thread-safe.
+ **/
+class PerfReport
+{
+public:
+
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled();
+
+    /**
+     * @brief Adds the statistics of a frame rendered by the given writer, as returned by RenderStats::getStats()
+     **/
+    static void addFrame(const std::string& writerName,
+                         double timeSpent,
+                         const std::map<NodePtr, NodeRenderStats>& stats);
+
+    /**
+     * @brief Adds the wall-clock time spent in a blocking render of the writers.
+     **/
+    static void addRenderWallTime(double seconds);
+
+    /**
+     * @brief Writes the report to filename in JSON.
+     * @returns True on success, otherwise error is set.
+     **/
+    static bool writeJSON(const std::string& filename, std::string* error);
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // PERFREPORT_H
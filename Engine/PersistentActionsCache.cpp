@@ -0,0 +1,324 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PersistentActionsCache.h"
+
+#include <map>
+#include <vector>
+#include <algorithm> // sort
+#include <stdexcept>
+
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_OFF
+GCC_DIAG_OFF(unused-parameter)
+#include <boost/archive/binary_iarchive.hpp>
+#include <boost/archive/binary_oarchive.hpp>
+GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
+GCC_DIAG_ON(unused-parameter)
+
+#include <QtCore/QMutex>
+#include <QtCore/QFile>
+#include <QtCore/QDebug>
+
+#include "Engine/FStreamsSupport.h"
+#include "Engine/RectD.h"
+
+// Bump this whenever the layout of the file changes, files with another version are ignored
+#define NATRON_PERSISTENT_ACTIONS_CACHE_VERSION 1
+
+// Maximum number of node hashes written to the file
+#define NATRON_PERSISTENT_ACTIONS_CACHE_MAX_HASHES 10000
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+struct PersistentActionKey
+{
+    double time;
+    int view;
+    unsigned int mipMapLevel;
+
+    bool operator<(const PersistentActionKey& other) const
+    {
+        if (time != other.time) {
+            return time < other.time;
+        }
+        if (mipMapLevel != other.mipMapLevel) {
+            return mipMapLevel < other.mipMapLevel;
+        }
+        return view < other.view;
+    }
+};
+
+struct PersistentActionsEntry
+{
+    std::map<PersistentActionKey, RectD> rods;
+    bool timeDomainSet;
+    double firstFrame, lastFrame;
+
+    ///Value of the use counter the last time this entry was read or written, to keep the most recent entries when saving
+    U64 lastUsed;
+
+    PersistentActionsEntry()
+    : rods()
+    , timeDomainSet(false)
+    , firstFrame(0)
+    , lastFrame(0)
+    , lastUsed(0)
+    {
+    }
+};
+
+typedef std::map<U64, PersistentActionsEntry> PersistentActionsEntriesMap;
+
+struct CompareEntriesByUse
+{
+    bool operator() (PersistentActionsEntriesMap::const_iterator lhs,
+                     PersistentActionsEntriesMap::const_iterator rhs) const
+    {
+        return lhs->second.lastUsed > rhs->second.lastUsed;
+    }
+};
+
+} // anon namespace
+
+struct PersistentActionsCachePrivate
+{
+    mutable QMutex lock; //< protects everything below
+    PersistentActionsEntriesMap entries;
+    U64 useCounter;
+
+    PersistentActionsCachePrivate()
+    : lock()
+    , entries()
+    , useCounter(0)
+    {
+    }
+};
+
+PersistentActionsCache::PersistentActionsCache()
+: _imp( new PersistentActionsCachePrivate() )
+{
+}
+
+PersistentActionsCache::~PersistentActionsCache()
+{
+}
+
+void
+PersistentActionsCache::restore(const std::string& filePath)
+{
+    FStreamsSupport::ifstream ifile;
+    FStreamsSupport::open(&ifile, filePath);
+    if (!ifile) {
+        // Nothing was saved by a previous session
+        return;
+    }
+
+    PersistentActionsEntriesMap entries;
+    try {
+        boost::archive::binary_iarchive iArchive(ifile);
+        unsigned int version;
+        iArchive >> version;
+        if (version != NATRON_PERSISTENT_ACTIONS_CACHE_VERSION) {
+            return;
+        }
+        std::size_t nEntries;
+        iArchive >> nEntries;
+        for (std::size_t i = 0; i < nEntries; ++i) {
+            U64 hash;
+            iArchive >> hash;
+            PersistentActionsEntry& entry = entries[hash];
+            iArchive >> entry.timeDomainSet;
+            iArchive >> entry.firstFrame;
+            iArchive >> entry.lastFrame;
+            std::size_t nRoDs;
+            iArchive >> nRoDs;
+            for (std::size_t j = 0; j < nRoDs; ++j) {
+                PersistentActionKey key;
+                iArchive >> key.time;
+                iArchive >> key.view;
+                iArchive >> key.mipMapLevel;
+                RectD& rod = entry.rods[key];
+                iArchive >> rod.x1;
+                iArchive >> rod.y1;
+                iArchive >> rod.x2;
+                iArchive >> rod.y2;
+            }
+        }
+    } catch (const std::exception & e) {
+        qDebug() << "Failed to read the actions cache:" << e.what();
+        return;
+    }
+
+    QMutexLocker k(&_imp->lock);
+    _imp->entries.swap(entries);
+}
+
+void
+PersistentActionsCache::save(const std::string& filePath) const
+{
+    QMutexLocker k(&_imp->lock);
+
+    if ( _imp->entries.empty() ) {
+        QFile::remove( QString::fromUtf8( filePath.c_str() ) );
+        return;
+    }
+
+    ///Only keep the most recently used entries
+    std::vector<PersistentActionsEntriesMap::const_iterator> toSave;
+    toSave.reserve( _imp->entries.size() );
+    for (PersistentActionsEntriesMap::const_iterator it = _imp->entries.begin(); it != _imp->entries.end(); ++it) {
+        toSave.push_back(it);
+    }
+    if (toSave.size() > NATRON_PERSISTENT_ACTIONS_CACHE_MAX_HASHES) {
+        std::sort( toSave.begin(), toSave.end(), CompareEntriesByUse() );
+        toSave.resize(NATRON_PERSISTENT_ACTIONS_CACHE_MAX_HASHES);
+    }
+
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open(&ofile, filePath);
+    if (!ofile) {
+        qDebug() << "Failed to save the actions cache to" << filePath.c_str();
+        return;
+    }
+
+    try {
+        boost::archive::binary_oarchive oArchive(ofile);
+        unsigned int version = NATRON_PERSISTENT_ACTIONS_CACHE_VERSION;
+        oArchive << version;
+        std::size_t nEntries = toSave.size();
+        oArchive << nEntries;
+        for (std::size_t i = 0; i < toSave.size(); ++i) {
+            const PersistentActionsEntry& entry = toSave[i]->second;
+            oArchive << toSave[i]->first;
+            oArchive << entry.timeDomainSet;
+            oArchive << entry.firstFrame;
+            oArchive << entry.lastFrame;
+            std::size_t nRoDs = entry.rods.size();
+            oArchive << nRoDs;
+            for (std::map<PersistentActionKey, RectD>::const_iterator it = entry.rods.begin(); it != entry.rods.end(); ++it) {
+                oArchive << it->first.time;
+                oArchive << it->first.view;
+                oArchive << it->first.mipMapLevel;
+                oArchive << it->second.x1;
+                oArchive << it->second.y1;
+                oArchive << it->second.x2;
+                oArchive << it->second.y2;
+            }
+        }
+    } catch (const std::exception & e) {
+        qDebug() << "Failed to write the actions cache:" << e.what();
+    }
+}
+
+void
+PersistentActionsCache::clear()
+{
+    QMutexLocker k(&_imp->lock);
+
+    _imp->entries.clear();
+}
+
+bool
+PersistentActionsCache::getRoDResult(U64 hash,
+                                     double time,
+                                     ViewIdx view,
+                                     unsigned int mipMapLevel,
+                                     RectD* rod) const
+{
+    QMutexLocker k(&_imp->lock);
+    PersistentActionsEntriesMap::iterator found = _imp->entries.find(hash);
+
+    if ( found == _imp->entries.end() ) {
+        return false;
+    }
+
+    PersistentActionKey key;
+    key.time = time;
+    key.view = view;
+    key.mipMapLevel = mipMapLevel;
+
+    std::map<PersistentActionKey, RectD>::const_iterator foundRoD = found->second.rods.find(key);
+    if ( foundRoD == found->second.rods.end() ) {
+        return false;
+    }
+    *rod = foundRoD->second;
+    found->second.lastUsed = ++_imp->useCounter;
+
+    return true;
+}
+
+void
+PersistentActionsCache::setRoDResult(U64 hash,
+                                     double time,
+                                     ViewIdx view,
+                                     unsigned int mipMapLevel,
+                                     const RectD & rod)
+{
+    QMutexLocker k(&_imp->lock);
+    PersistentActionsEntry& entry = _imp->entries[hash];
+    PersistentActionKey key;
+
+    key.time = time;
+    key.view = view;
+    key.mipMapLevel = mipMapLevel;
+
+    entry.rods[key] = rod;
+    entry.lastUsed = ++_imp->useCounter;
+}
+
+bool
+PersistentActionsCache::getTimeDomainResult(U64 hash,
+                                            double *first,
+                                            double* last) const
+{
+    QMutexLocker k(&_imp->lock);
+    PersistentActionsEntriesMap::iterator found = _imp->entries.find(hash);
+
+    if ( ( found == _imp->entries.end() ) || !found->second.timeDomainSet ) {
+        return false;
+    }
+    *first = found->second.firstFrame;
+    *last = found->second.lastFrame;
+    found->second.lastUsed = ++_imp->useCounter;
+
+    return true;
+}
+
+void
+PersistentActionsCache::setTimeDomainResult(U64 hash,
+                                            double first,
+                                            double last)
+{
+    QMutexLocker k(&_imp->lock);
+    PersistentActionsEntry& entry = _imp->entries[hash];
+
+    entry.timeDomainSet = true;
+    entry.firstFrame = first;
+    entry.lastFrame = last;
+    entry.lastUsed = ++_imp->useCounter;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,89 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef PERSISTENTACTIONSCACHE_H
+#define PERSISTENTACTIONSCACHE_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+#include "Engine/ViewIdx.h"
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct PersistentActionsCachePrivate;
+
+/**
+ * @brief Keeps the results of the getRegionOfDefinition and getFrameRange actions of all nodes, indexed
+ * by the node hash, across sessions. The node hash only depends on the node parameters, inputs and name,
+ * so when a project is opened again the results can be reused without calling the plug-ins.
+ * The content of the files read by the Read nodes is not part of the hash: the results of the Read nodes and of
+ * the nodes downstream of a Read node are not kept in this cache (see EffectInstance::getRegionOfDefinition_public).
+ * The cache is saved next to the disk caches when the application exits and restored at startup.
+ * This class is thread-safe.
+ **/
+class PersistentActionsCache
+{
+public:
+
+    PersistentActionsCache();
+
+    ~PersistentActionsCache();
+
+    /**
+     * @brief Loads the results saved by a previous session in filePath. Files written by another
+     * version of the cache are ignored.
+     **/
+    void restore(const std::string& filePath);
+
+    /**
+     * @brief Writes the results to filePath, keeping only the most recently used nodes.
+     **/
+    void save(const std::string& filePath) const;
+
+    void clear();
+
+    bool getRoDResult(U64 hash, double time, ViewIdx view, unsigned int mipMapLevel, RectD* rod) const;
+
+    void setRoDResult(U64 hash, double time, ViewIdx view, unsigned int mipMapLevel, const RectD & rod);
+
+    bool getTimeDomainResult(U64 hash, double *first, double* last) const;
+
+    void setTimeDomainResult(U64 hash, double first, double last);
+
+private:
+
+    boost::scoped_ptr<PersistentActionsCachePrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // PERSISTENTACTIONSCACHE_H
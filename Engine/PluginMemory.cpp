@@ -26,28 +26,52 @@
 
 #include <vector>
 #include <cassert>
+#include <cstdlib> // free
+#include <new> // bad_alloc
 #include <stdexcept>
 
 #include "Global/Macros.h"
 CLANG_DIAG_OFF(deprecated)
 #include <QMutex>
 CLANG_DIAG_ON(deprecated)
+#include "Engine/AppManager.h"
 #include "Engine/EffectInstance.h"
-#include "Engine/CacheEntry.h"
+#include "Engine/ParallelRenderArgs.h"
+#include "Engine/PluginMemoryPool.h"
+#include "Engine/RenderStats.h"
 
 NATRON_NAMESPACE_ENTER;
 
 struct PluginMemory::Implementation
 {
     Implementation(const EffectInstPtr& effect_)
-        : data()
+        : data(0)
+          , size(0)
           , locked(0)
           , mutex()
           , effect(effect_)
     {
     }
 
-    RamBuffer<char> data;
+    ///Gives the block back to the pool
+    void releaseData()
+    {
+        if (!data) {
+            return;
+        }
+        if (appPTR) {
+            appPTR->getPluginMemoryPool()->release(data, size);
+        } else {
+            ///The application is being destroyed along with the pool, the blocks are plain malloc'ed memory
+            std::free(data);
+        }
+        data = 0;
+        size = 0;
+    }
+
+    //A block of PluginMemoryPool::getBlockSize(size) bytes taken from the PluginMemoryPool
+    void* data;
+    std::size_t size;
     int locked;
     QMutex mutex;
     EffectInstWPtr effect;
@@ -67,20 +91,44 @@ PluginMemory::~PluginMemory()
     if (e) {
         e->removePluginMemoryPointer(this);
     }
+    _imp->releaseData();
 }
 
 bool
 PluginMemory::alloc(size_t nBytes)
 {
+    ///Before allocating the memory check that there's enough space to fit in memory
+    appPTR->checkCacheFreeMemoryIsGoodEnough();
+
     QMutexLocker l(&_imp->mutex);
 
     if (_imp->locked) {
         return false;
     } else {
-        _imp->data.resize(nBytes);
+        if (nBytes == 0) {
+            return true;
+        }
         EffectInstPtr e = _imp->effect.lock();
+        if (e && _imp->size) {
+            e->unregisterPluginMemory(_imp->size);
+        }
+
+        ///Like a malloc, the previous content is not kept. The block is kept if it has the right size class.
+        bool recycled = true;
+        if ( !_imp->data || ( PluginMemoryPool::getBlockSize(nBytes) != PluginMemoryPool::getBlockSize(_imp->size) ) ) {
+            _imp->releaseData();
+            ///Throws std::bad_alloc when over the plug-ins memory budget: failing the allocation lets the plug-in handle it,
+            ///exceeding the cgroup limit would get us killed
+            _imp->data = appPTR->getPluginMemoryPool()->allocate(nBytes, &recycled);
+        }
+        _imp->size = nBytes;
+
         if (e) {
-            e->registerPluginMemory( _imp->data.size() );
+            e->registerPluginMemory(nBytes);
+            boost::shared_ptr<ParallelRenderArgs> frameArgs = e->getParallelRenderArgsTLS();
+            if ( frameArgs && frameArgs->stats && frameArgs->stats->isInDepthProfilingEnabled() ) {
+                frameArgs->stats->addPluginMemoryInfosForNode(e->getNode(), nBytes, recycled);
+            }
         }
 
         return true;
@@ -93,9 +141,9 @@ PluginMemory::freeMem()
     QMutexLocker l(&_imp->mutex);
     EffectInstPtr e = _imp->effect.lock();
     if (e) {
-        e->unregisterPluginMemory( _imp->data.size() );
+        e->unregisterPluginMemory(_imp->size);
     }
-    _imp->data.clear();
+    _imp->releaseData();
     _imp->locked = 0;
 }
 
@@ -104,9 +152,9 @@ PluginMemory::getPtr()
 {
     QMutexLocker l(&_imp->mutex);
 
-    assert(_imp->data.size() == 0 || (_imp->data.size() > 0 && _imp->data.getData()));
+    assert(_imp->size == 0 || (_imp->size > 0 && _imp->data));
 
-    return (void*)( _imp->data.getData() );
+    return _imp->data;
 }
 
 void
@@ -0,0 +1,287 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PluginMemoryPool.h"
+
+#include <algorithm> // max
+#include <cassert>
+#include <cstdlib> // malloc, free
+#include <map>
+#include <new> // bad_alloc
+#include <vector>
+
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+
+#include "Engine/CpuTopology.h"
+#include "Engine/MemoryGovernor.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+///The free blocks of a shard, by block size
+struct PoolShard
+{
+    QMutex mutex;
+    std::map<std::size_t, std::vector<void*> > freeBlocks;
+
+    PoolShard()
+        : mutex()
+        , freeBlocks()
+    {
+    }
+};
+} // anon namespace
+
+struct PluginMemoryPoolPrivate
+{
+    MemoryGovernor* governor;
+    std::size_t fixedMaxIdleBytes;
+    int numaNodesCount;
+    PoolShard shards[NATRON_PLUGIN_MEMORY_POOL_SHARDS];
+
+    //Protects idleBytes and usedBytes. A shard mutex may be locked before it, never after
+    mutable QMutex countersMutex;
+    std::size_t idleBytes;
+    std::size_t usedBytes;
+
+    PluginMemoryPoolPrivate(MemoryGovernor* governor,
+                            std::size_t maxIdleBytes,
+                            int numaNodesCount)
+        : governor(governor)
+        , fixedMaxIdleBytes(maxIdleBytes)
+        , numaNodesCount(numaNodesCount)
+        , countersMutex()
+        , idleBytes(0)
+        , usedBytes(0)
+    {
+    }
+
+    std::size_t getMaxIdleBytes() const
+    {
+        if ( (fixedMaxIdleBytes != 0) || !governor ) {
+            return fixedMaxIdleBytes;
+        }
+
+        return (std::size_t)(governor->getTotalRAM() * governor->getBudgetFactor() * NATRON_PLUGIN_MEMORY_POOL_MAX_IDLE_FRACTION);
+    }
+
+    /**
+     * @brief The shard of the calling thread and the range of shards it may take blocks from: all of them,
+     * or only the ones of its NUMA node if it is bound to one.
+     **/
+    void getCurrentThreadShards(int* shard,
+                                int* firstShard,
+                                int* shardsCount) const
+    {
+        ///Thread ids are usually aligned addresses, mix the higher bits in
+        quintptr id = (quintptr)QThread::currentThreadId();
+        int hash = (int)( ( (id >> 4) ^ (id >> 12) ) % NATRON_PLUGIN_MEMORY_POOL_SHARDS );
+        int node = CpuTopology::getCurrentThreadNumaNode();
+
+        if ( (node < 0) || (numaNodesCount <= 1) ) {
+            *firstShard = 0;
+            *shardsCount = NATRON_PLUGIN_MEMORY_POOL_SHARDS;
+        } else {
+            *shardsCount = std::max(1, NATRON_PLUGIN_MEMORY_POOL_SHARDS / numaNodesCount);
+            *firstShard = (node * *shardsCount) % NATRON_PLUGIN_MEMORY_POOL_SHARDS;
+        }
+        *shard = *firstShard + hash % *shardsCount;
+    }
+
+    void freeBlock(void* ptr,
+                   std::size_t blockSize)
+    {
+        std::free(ptr);
+        if (governor) {
+            governor->registerPluginMemory( -(qint64)blockSize );
+            governor->registerFreedMemory(blockSize);
+        }
+    }
+};
+
+PluginMemoryPool::PluginMemoryPool(MemoryGovernor* governor,
+                                   std::size_t maxIdleBytes,
+                                   int numaNodesCount)
+    : _imp( new PluginMemoryPoolPrivate(governor, maxIdleBytes, numaNodesCount) )
+{
+}
+
+PluginMemoryPool::~PluginMemoryPool()
+{
+    trim(0);
+}
+
+std::size_t
+PluginMemoryPool::getBlockSize(std::size_t nBytes)
+{
+    if (nBytes <= NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE) {
+        return NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE;
+    }
+
+    ///Round up to a multiple of the largest power of two below nBytes divided by the number of size classes
+    std::size_t powerOfTwo = NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE;
+    while ( powerOfTwo <= (nBytes - 1) / 2 ) {
+        powerOfTwo *= 2;
+    }
+    std::size_t step = powerOfTwo / NATRON_PLUGIN_MEMORY_POOL_SIZE_CLASSES;
+
+    return ( (nBytes + step - 1) / step ) * step;
+}
+
+void*
+PluginMemoryPool::allocate(std::size_t nBytes,
+                           bool* recycled)
+{
+    std::size_t blockSize = getBlockSize(nBytes);
+    bool hasIdleBlocks;
+    {
+        QMutexLocker k(&_imp->countersMutex);
+        hasIdleBlocks = _imp->idleBytes > 0;
+    }
+
+    if (hasIdleBlocks) {
+        ///Look in the shard of this thread first, then steal from the others
+        int threadShard, firstShard, shardsCount;
+        _imp->getCurrentThreadShards(&threadShard, &firstShard, &shardsCount);
+        for (int i = 0; i < shardsCount; ++i) {
+            PoolShard& shard = _imp->shards[firstShard + (threadShard - firstShard + i) % shardsCount];
+            QMutexLocker k(&shard.mutex);
+            std::map<std::size_t, std::vector<void*> >::iterator found = shard.freeBlocks.find(blockSize);
+            if ( ( found == shard.freeBlocks.end() ) || found->second.empty() ) {
+                continue;
+            }
+            void* ptr = found->second.back();
+            found->second.pop_back();
+            {
+                QMutexLocker c(&_imp->countersMutex);
+                _imp->idleBytes -= blockSize;
+                _imp->usedBytes += blockSize;
+            }
+            *recycled = true;
+
+            return ptr;
+        }
+    }
+
+    if ( _imp->governor && !_imp->governor->canAllocatePluginMemory(blockSize) ) {
+        ///The free blocks count in the budget, they must go before failing an allocation
+        trim(0);
+        if ( !_imp->governor->canAllocatePluginMemory(blockSize) ) {
+            throw std::bad_alloc();
+        }
+    }
+
+    void* ptr = std::malloc(blockSize);
+    if (!ptr) {
+        throw std::bad_alloc();
+    }
+    if (_imp->governor) {
+        _imp->governor->registerPluginMemory( (qint64)blockSize );
+        _imp->governor->registerAllocatedMemory(blockSize);
+    }
+    {
+        QMutexLocker c(&_imp->countersMutex);
+        _imp->usedBytes += blockSize;
+    }
+    *recycled = false;
+
+    return ptr;
+} // PluginMemoryPool::allocate
+
+void
+PluginMemoryPool::release(void* ptr,
+                          std::size_t nBytes)
+{
+    if (!ptr) {
+        return;
+    }
+
+    std::size_t blockSize = getBlockSize(nBytes);
+    std::size_t maxIdleBytes = _imp->getMaxIdleBytes();
+    {
+        int threadShard, firstShard, shardsCount;
+        _imp->getCurrentThreadShards(&threadShard, &firstShard, &shardsCount);
+        PoolShard& shard = _imp->shards[threadShard];
+        QMutexLocker k(&shard.mutex);
+        QMutexLocker c(&_imp->countersMutex);
+        assert(_imp->usedBytes >= blockSize);
+        _imp->usedBytes -= blockSize;
+        if (_imp->idleBytes + blockSize <= maxIdleBytes) {
+            _imp->idleBytes += blockSize;
+            shard.freeBlocks[blockSize].push_back(ptr);
+
+            return;
+        }
+    }
+
+    _imp->freeBlock(ptr, blockSize);
+}
+
+void
+PluginMemoryPool::trim(std::size_t maxIdleBytes)
+{
+    for (int i = 0; i < NATRON_PLUGIN_MEMORY_POOL_SHARDS; ++i) {
+        PoolShard& shard = _imp->shards[i];
+        QMutexLocker k(&shard.mutex);
+        for (std::map<std::size_t, std::vector<void*> >::reverse_iterator it = shard.freeBlocks.rbegin(); it != shard.freeBlocks.rend(); ++it) {
+            while ( !it->second.empty() ) {
+                {
+                    QMutexLocker c(&_imp->countersMutex);
+                    if (_imp->idleBytes <= maxIdleBytes) {
+                        return;
+                    }
+                    _imp->idleBytes -= it->first;
+                }
+                _imp->freeBlock(it->second.back(), it->first);
+                it->second.pop_back();
+            }
+        }
+    }
+}
+
+void
+PluginMemoryPool::trim()
+{
+    trim( _imp->getMaxIdleBytes() );
+}
+
+std::size_t
+PluginMemoryPool::getIdleBytes() const
+{
+    QMutexLocker c(&_imp->countersMutex);
+
+    return _imp->idleBytes;
+}
+
+std::size_t
+PluginMemoryPool::getUsedBytes() const
+{
+    QMutexLocker c(&_imp->countersMutex);
+
+    return _imp->usedBytes;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,133 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef PLUGINMEMORYPOOL_H
+#define PLUGINMEMORYPOOL_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstddef>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+///Blocks are never smaller than this: smaller allocations are rare and would fragment the pool
+#define NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE 4096
+
+///Each power of two is split in this many block sizes, so that at most 1/NATRON_PLUGIN_MEMORY_POOL_SIZE_CLASSES of a block is wasted
+#define NATRON_PLUGIN_MEMORY_POOL_SIZE_CLASSES 4
+
+///The free blocks are spread over this many lists, each with its own lock, picked from the id of the calling thread
+#define NATRON_PLUGIN_MEMORY_POOL_SHARDS 16
+
+///At most this fraction of the plug-ins memory budget is kept in free blocks, the rest is returned to the system
+#define NATRON_PLUGIN_MEMORY_POOL_MAX_IDLE_FRACTION 0.25
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Recycles the memory allocated by plug-ins through the OpenFX memory suites.
+ * Plug-ins such as blurs or convolutions allocate large scratch buffers for each render: instead of freeing them,
+ * they are kept in the pool so that the next render of any plug-in asking for a buffer of about the same size gets it
+ * without going through malloc and without the kernel having to fault in new pages.
+ *
+ * Sizes are rounded up to a size class (see getBlockSize()), free blocks are kept in lists per size class.
+ * The lists are sharded by thread: a thread gets back the blocks it released itself first, which are still in its
+ * caches and on its NUMA node, and threads rarely contend on the same lock.
+ * The threads bound to a NUMA node (see CpuTopology::setCurrentThreadNumaNode()) only use the shards of their node:
+ * they never get a block whose pages were placed on another node, a new block is allocated instead and its pages
+ * are placed on their node when they first write to it.
+ *
+ * All the memory held by the pool, used or free, is registered to the MemoryGovernor as plug-ins memory.
+ * The free blocks are limited to NATRON_PLUGIN_MEMORY_POOL_MAX_IDLE_FRACTION of the plug-ins memory budget, which
+ * shrinks with the memory pressure, and are released before an allocation is refused by the governor.
+ * All functions are thread-safe.
+ **/
+struct PluginMemoryPoolPrivate;
+class PluginMemoryPool
+{
+public:
+
+    /**
+     * @brief If governor is NULL, the memory is not accounted for and the free blocks are only limited by maxIdleBytes.
+     * @param maxIdleBytes If not 0, the free blocks are limited to this size instead of the fraction of the governor budget.
+     * @param numaNodesCount The shards are split between this many NUMA nodes.
+     **/
+    PluginMemoryPool(MemoryGovernor* governor,
+                     std::size_t maxIdleBytes = 0,
+                     int numaNodesCount = 1);
+
+    ///Frees all the free blocks, all the blocks must have been released
+    ~PluginMemoryPool();
+
+    /**
+     * @brief The size of the block holding nBytes: nBytes rounded up to its size class.
+     **/
+    static std::size_t getBlockSize(std::size_t nBytes);
+
+    /**
+     * @brief Returns a block of getBlockSize(nBytes) bytes, which must be released with release().
+     * @param recycled Set to true if the block was taken from the pool rather than allocated.
+     * Throws std::bad_alloc if the allocation failed or if the plug-ins memory budget is exceeded.
+     **/
+    void* allocate(std::size_t nBytes, bool* recycled);
+
+    /**
+     * @brief Gives back to the pool a block returned by allocate(nBytes), it is freed if the pool is full.
+     **/
+    void release(void* ptr, std::size_t nBytes);
+
+    /**
+     * @brief Frees the free blocks until they total at most maxIdleBytes, the largest blocks of each shard first.
+     **/
+    void trim(std::size_t maxIdleBytes);
+
+    /**
+     * @brief Frees the free blocks exceeding the current limit, which shrinks when the memory pressure rises.
+     **/
+    void trim();
+
+    /**
+     * @brief The memory held in free blocks
+     **/
+    std::size_t getIdleBytes() const;
+
+    /**
+     * @brief The memory held by the blocks in use
+     **/
+    std::size_t getUsedBytes() const;
+
+private:
+
+    boost::scoped_ptr<PluginMemoryPoolPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // PLUGINMEMORYPOOL_H
@@ -25,6 +25,7 @@
 #include "ProcessHandler.h"
 
 #include <cassert>
+#include <iostream>
 #include <stdexcept>
 
 #include <QProcess>
@@ -41,6 +42,7 @@
 #include "Engine/AppManager.h"
 #include "Engine/Node.h"
 #include "Engine/OutputEffectInstance.h"
+#include "Engine/SharedFrameChannel.h"
 
 NATRON_NAMESPACE_ENTER;
 
@@ -54,6 +56,29 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
 ,_earlyCancel(false)
 ,_processLog()
 ,_processArgs()
+,_processPid(0)
+{
+    _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8(writer->getScriptName_mt_safe().c_str());
+    _processArgs << QString::fromUtf8("\"") + projectPath + QString::fromUtf8("\"");
+    initialize();
+}
+
+ProcessHandler::ProcessHandler(const QStringList & processArgs)
+: _process(new QProcess)
+,_writer(0)
+,_ipcServer(0)
+,_bgProcessOutputSocket(0)
+,_bgProcessInputSocket(0)
+,_earlyCancel(false)
+,_processLog()
+,_processArgs(processArgs)
+,_processPid(0)
+{
+    initialize();
+}
+
+void
+ProcessHandler::initialize()
 {
     ///setup the server used to listen the output of the background process
     _ipcServer = new QLocalServer();
@@ -67,10 +92,14 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
     }
     _ipcServer->listen(serverName);
 
-
-    _processArgs << QString::fromUtf8("-b") << QString::fromUtf8("-w") << QString::fromUtf8(writer->getScriptName_mt_safe().c_str());
     _processArgs << QString::fromUtf8("--IPCpipe") << QString::fromUtf8("\"") + _ipcServer->fullServerName() + QString::fromUtf8("\"");
-    _processArgs << QString::fromUtf8("\"") + projectPath + QString::fromUtf8("\"");
+
+    ///Let the process hand its rendered frames to the cache of this one. There is no cache when the
+    ///processes are started by a RenderCoordinator, which does not create an AppManager
+    SharedFrameChannel* frameChannel = appPTR ? appPTR->getSharedFrameChannel() : 0;
+    if (frameChannel) {
+        _processArgs << QString::fromUtf8("--frameChannel") << QString::fromUtf8( frameChannel->getName().c_str() );
+    }
 
     ///connect the useful slots of the process
     QObject::connect( _process,SIGNAL(readyReadStandardOutput()),this,SLOT(onStandardOutputBytesWritten()) );
@@ -85,7 +114,6 @@ ProcessHandler::ProcessHandler(const QString & projectPath,
     for (int i = 0; i < _processArgs.size(); ++i) {
         _processLog.push_back(_processArgs[i] + QString::fromUtf8(" "));
     }
-   
 }
 
 ProcessHandler::~ProcessHandler()
@@ -110,6 +138,9 @@ void
 ProcessHandler::startProcess()
 {
      _process->start(QCoreApplication::applicationFilePath(),_processArgs);
+#ifdef __NATRON_UNIX__
+    _processPid = (long long)_process->pid();
+#endif
 }
 
 const QString &
@@ -137,49 +168,62 @@ ProcessHandler::onDataWrittenToSocket()
     ///always running in the main thread
     assert( QThread::currentThread() == qApp->thread() );
 
-    QString str = QString::fromUtf8(_bgProcessOutputSocket->readLine());
-    while ( str.endsWith(QLatin1Char('\n')) ) {
-        str.chop(1);
-    }
-    _processLog.append(QString::fromUtf8("Message received: ") + str + QLatin1Char('\n'));
-    if ( str.startsWith(QString::fromUtf8(kFrameRenderedStringShort) )) {
-        str = str.remove(QString::fromUtf8(kFrameRenderedStringShort));
-        
-        double progressPercent = 0.;
-        int foundProgress = str.lastIndexOf(QString::fromUtf8(kProgressChangedStringShort));
-        if (foundProgress != -1) {
-            QString progressStr = str.mid(foundProgress);
-            progressStr.remove(QString::fromUtf8(kProgressChangedStringShort));
-            progressPercent = progressStr.toDouble();
-            str = str.mid(0, foundProgress);
+    ///several messages may be pending when readyRead() is emitted, each of them is exactly 1 line
+    while ( _bgProcessOutputSocket->canReadLine() ) {
+        QString str = QString::fromUtf8(_bgProcessOutputSocket->readLine());
+        while ( str.endsWith(QLatin1Char('\n')) ) {
+            str.chop(1);
         }
-        if (!str.isEmpty()) {
-            //The report does not have extended timer infos
-            Q_EMIT frameRendered(str.toInt(), progressPercent);
+        _processLog.append(QString::fromUtf8("Message received: ") + str + QLatin1Char('\n'));
+        if ( str.startsWith(QString::fromUtf8(kFrameRenderedStringShort) )) {
+            str = str.remove(QString::fromUtf8(kFrameRenderedStringShort));
             
+            double timeSpent = -1.;
+            int foundTime = str.lastIndexOf(QString::fromUtf8(kFrameRenderTimeStringShort));
+            if (foundTime != -1) {
+                timeSpent = str.mid(foundTime).remove(QString::fromUtf8(kFrameRenderTimeStringShort)).toDouble();
+                str = str.mid(0, foundTime);
+            }
+            
+            double progressPercent = 0.;
+            int foundProgress = str.lastIndexOf(QString::fromUtf8(kProgressChangedStringShort));
+            if (foundProgress != -1) {
+                QString progressStr = str.mid(foundProgress);
+                progressStr.remove(QString::fromUtf8(kProgressChangedStringShort));
+                progressPercent = progressStr.toDouble();
+                str = str.mid(0, foundProgress);
+            }
+            if (!str.isEmpty()) {
+                //The report does not have extended timer infos
+                if (timeSpent >= 0.) {
+                    Q_EMIT frameRenderTimeReported(str.toInt(), timeSpent);
+                }
+                Q_EMIT frameRendered(str.toInt(), progressPercent);
+                
+            }
+            
+        } else if ( str.startsWith(QString::fromUtf8(kRenderingFinishedStringShort)) ) {
+            ///don't do anything
+        } else if ( str.startsWith(QString::fromUtf8(kBgProcessServerCreatedShort)) ) {
+            str = str.remove(QString::fromUtf8(kBgProcessServerCreatedShort));
+            ///the bg process wants us to create the pipe for its input
+            if (!_bgProcessInputSocket) {
+                _bgProcessInputSocket = new QLocalSocket();
+                QObject::connect( _bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
+                _bgProcessInputSocket->connectToServer(str,QLocalSocket::ReadWrite);
+            }
+        } else if ( str.startsWith(QString::fromUtf8(kRenderingStartedShort)) ) {
+            ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
+            ///message right away
+            if (_earlyCancel) {
+                _bgProcessInputSocket->waitForConnected(5000);
+                _earlyCancel = false;
+                onProcessCanceled();
+            }
+        } else {
+            _processLog.append(QString::fromUtf8("Error: Unable to interpret message.\n"));
+            throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
         }
-        
-    } else if ( str.startsWith(QString::fromUtf8(kRenderingFinishedStringShort)) ) {
-        ///don't do anything
-    } else if ( str.startsWith(QString::fromUtf8(kBgProcessServerCreatedShort)) ) {
-        str = str.remove(QString::fromUtf8(kBgProcessServerCreatedShort));
-        ///the bg process wants us to create the pipe for its input
-        if (!_bgProcessInputSocket) {
-            _bgProcessInputSocket = new QLocalSocket();
-            QObject::connect( _bgProcessInputSocket, SIGNAL(connected()), this, SLOT(onInputPipeConnectionMade()) );
-            _bgProcessInputSocket->connectToServer(str,QLocalSocket::ReadWrite);
-        }
-    } else if ( str.startsWith(QString::fromUtf8(kRenderingStartedShort)) ) {
-        ///if the user pressed cancel prior to the pipe being created, wait for it to be created and send the abort
-        ///message right away
-        if (_earlyCancel) {
-            _bgProcessInputSocket->waitForConnected(5000);
-            _earlyCancel = false;
-            onProcessCanceled();
-        }
-    } else {
-        _processLog.append(QString::fromUtf8("Error: Unable to interpret message.\n"));
-        throw std::runtime_error("ProcessHandler::onDataWrittenToSocket() received erroneous message");
     }
 }
 
@@ -229,7 +273,13 @@ void
 ProcessHandler::onProcessError(QProcess::ProcessError err)
 {
     if (err == QProcess::FailedToStart) {
-        Dialogs::errorDialog( _writer->getScriptName(),QObject::tr("The render process failed to start").toStdString() );
+        if (_writer) {
+            Dialogs::errorDialog( _writer->getScriptName(),QObject::tr("The render process failed to start").toStdString() );
+        } else {
+            ///No GUI to report to, and finished() will never be emitted for a process that did not start
+            std::cerr << QObject::tr("The render process failed to start").toStdString() << std::endl;
+            Q_EMIT processFinished(1);
+        }
     } else if (err == QProcess::Crashed) {
         //@TODO: find out a way to get the backtrace
     }
@@ -241,6 +291,12 @@ ProcessHandler::onProcessEnd(int exitCode,
 {
     int returnCode = 0;
 
+    SharedFrameChannel* frameChannel = appPTR ? appPTR->getSharedFrameChannel() : 0;
+    if (frameChannel && _processPid) {
+        ///The process may have crashed while reading or publishing frames
+        frameChannel->releaseProcess(_processPid);
+    }
+
     if (stat == QProcess::CrashExit) {
         returnCode = 2;
     } else if (exitCode == 1) {
@@ -95,6 +95,7 @@ class ProcessHandler
     bool _earlyCancel; //< true if the user pressed cancel but the _bgProcessInput socket was not created yet
     QString _processLog; //< used to record the log of the process
     QStringList _processArgs;
+    long long _processPid; //< the pid of the process once started, to release its frames of the shared frame channel
     
 public:
 
@@ -105,6 +106,14 @@ public:
     ProcessHandler(const QString & projectPath,
                    OutputEffectInstance* writer);
 
+    /**
+     * @brief Starts a new process with the given command-line arguments, which must contain everything the
+     * background process needs to render (-b, the project or script, the writers and the frame range).
+     * The --IPCpipe argument is appended by this class, and --frameChannel if there is an AppManager. getWriter() returns NULL
+     * for such processes.
+     **/
+    ProcessHandler(const QStringList & processArgs);
+
     virtual ~ProcessHandler();
 
     const QString & getProcessLog() const;
@@ -171,6 +180,11 @@ Q_SIGNALS:
 
     void frameRendered(int frame, double progress);
 
+    /**
+     * @brief Emitted before frameRendered() when the process reported the time it spent rendering the frame, in seconds.
+     **/
+    void frameRenderTimeReported(int frame, double timeSpent);
+
     void processCanceled();
 
     /**
@@ -180,6 +194,14 @@ Q_SIGNALS:
      * 2: Crash.
      **/
     void processFinished(int);
+
+private:
+
+    /**
+     * @brief Creates the IPC server, appends its name and the name of the shared frame channel to the process arguments
+     * and connects the process signals.
+     **/
+    void initialize();
 };
 
 /**
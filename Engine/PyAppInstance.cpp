@@ -336,4 +336,16 @@ App::getViewNames() const
     return ret;
 }
 
+void
+App::beginBatch()
+{
+    _instance->beginBatch();
+}
+
+void
+App::endBatch()
+{
+    _instance->endBatch();
+}
+
 NATRON_NAMESPACE_EXIT;
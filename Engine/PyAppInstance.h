@@ -115,6 +115,14 @@ public:
     
     std::list<std::string> getViewNames() const;
     
+    /**
+     * @brief Starts a batch of changes: until the matching endBatch() call, the changes made to the parameters,
+     * keyframes and connections of all nodes of the project only trigger one hash update and one render
+     * request per viewer when the batch ends. Calls can be nested.
+     **/
+    void beginBatch();
+    void endBatch();
+    
 protected:
     
     void renderInternal(bool forceBlocking,Effect* writeNode,int firstFrame, int lastFrame, int frameStep);
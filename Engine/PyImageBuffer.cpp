@@ -0,0 +1,218 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "PyImageBuffer.h"
+
+#include <cassert>
+#include <cstring> // memcpy
+#include <new> // std::bad_alloc
+
+#include "Engine/Image.h"
+#include "Engine/ImageParams.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+/*
+ * The object is allocated by Python, hence the C++ members are held by pointer.
+ * The pixels are copied when the object is created: the object does not reference the image of the cache, so that no
+ * lock of the cache entry is held while Python code reads the buffer, possibly from another thread, for as long as it likes.
+ */
+struct ImageBufferObject
+{
+    PyObject_HEAD
+    unsigned char* pixels;
+    char* format;
+    RectI* rect;
+    Py_ssize_t shape[3];
+    Py_ssize_t strides[3];
+};
+
+static char formatByte[] = "B";
+static char formatShort[] = "H";
+static char formatHalf[] = "e";
+static char formatFloat[] = "f";
+
+static char*
+getBufferFormat(ImageBitDepthEnum depth)
+{
+    switch (depth) {
+    case eImageBitDepthByte:
+        return formatByte;
+    case eImageBitDepthShort:
+        return formatShort;
+    case eImageBitDepthHalf:
+        return formatHalf;
+    case eImageBitDepthFloat:
+        return formatFloat;
+    case eImageBitDepthNone:
+        break;
+    }
+    return 0;
+}
+
+static void
+ImageBuffer_dealloc(PyObject* obj)
+{
+    ImageBufferObject* self = (ImageBufferObject*)obj;
+
+    delete [] self->pixels;
+    delete self->rect;
+    Py_TYPE(obj)->tp_free(obj);
+}
+
+static int
+ImageBuffer_getbuffer(PyObject* obj,
+                      Py_buffer* view,
+                      int flags)
+{
+    ImageBufferObject* self = (ImageBufferObject*)obj;
+
+    view->obj = NULL;
+    if ( (flags & PyBUF_WRITABLE) == PyBUF_WRITABLE ) {
+        PyErr_SetString(PyExc_BufferError, "Natron images are read-only");
+        return -1;
+    }
+
+    ///The rows of the copy are contiguous, the strides are only given if asked for
+    Py_INCREF(obj);
+    view->obj = obj;
+    view->buf = (void*)self->pixels;
+    view->itemsize = self->strides[2];
+    view->len = self->shape[0] * self->shape[1] * self->shape[2] * view->itemsize;
+    view->readonly = 1;
+    view->format = (flags & PyBUF_FORMAT) ? self->format : NULL;
+    view->ndim = 3;
+    view->shape = (flags & PyBUF_ND) ? self->shape : NULL;
+    view->strides = ( (flags & PyBUF_STRIDES) == PyBUF_STRIDES ) ? self->strides : NULL;
+    view->suboffsets = NULL;
+    view->internal = NULL;
+
+    return 0;
+} // ImageBuffer_getbuffer
+
+static PyObject*
+ImageBuffer_getBounds(PyObject* obj,
+                      void* /*closure*/)
+{
+    const RectI& rect = *( (ImageBufferObject*)obj )->rect;
+
+    return Py_BuildValue("(iiii)", rect.x1, rect.y1, rect.x2, rect.y2);
+}
+
+static PyGetSetDef ImageBuffer_getset[] = {
+    {(char*)"bounds", (getter)ImageBuffer_getBounds, NULL, (char*)"The rectangle of the image viewed by the buffer, as a (x1, y1, x2, y2) tuple of pixel coordinates.", NULL},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+static PyBufferProcs ImageBuffer_bufferProcs;
+
+static PyTypeObject ImageBuffer_Type = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+};
+
+static bool
+initImageBufferType()
+{
+    if (ImageBuffer_Type.tp_flags & Py_TPFLAGS_READY) {
+        return true;
+    }
+    ImageBuffer_bufferProcs.bf_getbuffer = ImageBuffer_getbuffer;
+    ImageBuffer_bufferProcs.bf_releasebuffer = NULL;
+
+    ImageBuffer_Type.tp_name = "NatronEngine.ImageBuffer";
+    ImageBuffer_Type.tp_basicsize = sizeof(ImageBufferObject);
+    ImageBuffer_Type.tp_dealloc = ImageBuffer_dealloc;
+    ImageBuffer_Type.tp_as_buffer = &ImageBuffer_bufferProcs;
+#if PY_MAJOR_VERSION >= 3
+    ImageBuffer_Type.tp_flags = Py_TPFLAGS_DEFAULT;
+#else
+    ImageBuffer_Type.tp_flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_HAVE_NEWBUFFER;
+#endif
+    ImageBuffer_Type.tp_doc = (char*)"Read-only view on the pixels of an image rendered by Natron, implementing the buffer protocol.";
+    ImageBuffer_Type.tp_getset = ImageBuffer_getset;
+
+    return PyType_Ready(&ImageBuffer_Type) == 0;
+}
+
+} // anon namespace
+
+PyObject*
+createPyImageBuffer(const boost::shared_ptr<Image>& image,
+                    const RectI& rect)
+{
+    assert(image);
+    if ( !initImageBufferType() ) {
+        return NULL;
+    }
+    char* format = getBufferFormat( image->getBitDepth() );
+    if (!format) {
+        PyErr_SetString(PyExc_ValueError, "Unsupported image bit depth");
+        return NULL;
+    }
+    RectI bufferRect;
+    if ( !image->getBounds().intersect(rect, &bufferRect) ) {
+        PyErr_SetString(PyExc_ValueError, "The rectangle does not intersect the image");
+        return NULL;
+    }
+
+    const int itemSize = getSizeOfForBitDepth( image->getBitDepth() );
+    const int nComps = (int)image->getComponentsCount();
+    const std::size_t rowBytes = (std::size_t)bufferRect.width() * nComps * itemSize;
+    unsigned char* pixels = 0;
+    try {
+        pixels = new unsigned char[rowBytes * bufferRect.height()];
+    } catch (const std::bad_alloc&) {
+        return PyErr_NoMemory();
+    }
+
+    {
+        ///The lock of the image is only held while copying
+        Image::ReadAccess acc( image.get() );
+        for (int y = bufferRect.y1; y < bufferRect.y2; ++y) {
+            std::memcpy( pixels + (std::size_t)(y - bufferRect.y1) * rowBytes, acc.pixelAt(bufferRect.x1, y), rowBytes );
+        }
+    }
+
+    ImageBufferObject* self = PyObject_New(ImageBufferObject, &ImageBuffer_Type);
+    if (!self) {
+        delete [] pixels;
+
+        return NULL;
+    }
+    self->pixels = pixels;
+    self->format = format;
+    self->rect = new RectI(bufferRect);
+    self->shape[0] = bufferRect.height();
+    self->shape[1] = bufferRect.width();
+    self->shape[2] = nComps;
+    self->strides[0] = (Py_ssize_t)rowBytes;
+    self->strides[1] = nComps * itemSize;
+    self->strides[2] = itemSize;
+
+    return (PyObject*)self;
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,50 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef Engine_PyImageBuffer_h
+#define Engine_PyImageBuffer_h
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Returns a new reference to a NatronEngine.ImageBuffer object holding a copy of the given rectangle of the image,
+ * or NULL with a Python exception set on failure.
+ * The object implements the Python buffer protocol: the buffer is read-only, has the shape (height, width, components),
+ * with rows ordered from bottom to top like Natron pixel coordinates, and the format of the image bit depth.
+ * The pixels are copied once, when the object is created: the object does not keep the image nor any lock on it, so that
+ * the image can be written to by Natron while Python code uses a memoryview or a numpy array created from the object.
+ **/
+PyObject* createPyImageBuffer(const boost::shared_ptr<Image>& image, const RectI& rect);
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // Engine_PyImageBuffer_h
@@ -33,8 +33,12 @@
 #include "Engine/AppInstance.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/NodeGroup.h"
+#include "Engine/Image.h"
+#include "Engine/ParallelRenderArgs.h"
+#include "Engine/PyImageBuffer.h"
 #include "Engine/PyRoto.h"
 #include "Engine/Hash64.h"
+#include "Engine/TimeLine.h"
 
 NATRON_NAMESPACE_ENTER;
 
@@ -733,6 +737,97 @@ Effect::getRegionOfDefinition(double time,
     return rod;
 }
 
+PyObject*
+Effect::getImage(double time,
+                 int view,
+                 const RectI& rect,
+                 const ImageLayer& plane) const
+{
+    NodePtr node = getInternalNode();
+    if (!node || !node->getEffectInstance()) {
+        Py_RETURN_NONE;
+    }
+    EffectInstance* effect = node->getEffectInstance().get();
+    NodeGroup* isGroup = node->isEffectGroup();
+    if (isGroup) {
+        NodePtr output = isGroup->getOutputNode(false);
+        if (!output) {
+            Py_RETURN_NONE;
+        }
+        effect = output->getEffectInstance().get();
+    }
+    
+    const RenderScale scale(1.);
+    RectD rod;
+    bool isProjectFormat;
+    StatusEnum stat = effect->getRegionOfDefinition_public(effect->getHash(), time, scale, ViewIdx(view), &rod, &isProjectFormat);
+    if ( (stat == eStatusFailed) || rod.isNull() ) {
+        Py_RETURN_NONE;
+    }
+    RectI rodPixel;
+    rod.toPixelEnclosing(0, effect->getAspectRatio(-1), &rodPixel);
+    RectI renderWindow = rodPixel;
+    if ( !rect.isNull() && !rodPixel.intersect(rect, &renderWindow) ) {
+        Py_RETURN_NONE;
+    }
+    
+    std::list<ImageComponents> requestedComps;
+    requestedComps.push_back( ImageComponents( plane.getLayerName(), plane.getComponentsPrettyName(), plane.getComponentsNames() ) );
+    
+    std::map<ImageComponents,ImagePtr> planes;
+    {
+        NodePtr treeRoot = effect->getNode();
+        RenderingFlagSetter flagIsRendering( treeRoot.get() );
+        ParallelRenderArgsSetter frameRenderArgs(time,
+                                                 ViewIdx(view),
+                                                 false, //isRenderUserInteraction
+                                                 false, //isSequential
+                                                 false, //can abort
+                                                 0, //render Age
+                                                 treeRoot,
+                                                 0, //texture index
+                                                 node->getApp()->getTimeLine().get(),
+                                                 NodePtr(), //rotoPaint node
+                                                 false, // isAnalysis
+                                                 false, // isDraft
+                                                 false, // enableProgress
+                                                 boost::shared_ptr<RenderStats>());
+        
+        FrameRequestMap request;
+        stat = EffectInstance::computeRequestPass(time, ViewIdx(view), 0, rod, treeRoot, request);
+        if (stat == eStatusFailed) {
+            Py_RETURN_NONE;
+        }
+        frameRenderArgs.updateNodesRequest(request);
+        
+        try {
+            EffectInstance::RenderRoIArgs renderArgs(time,
+                                                     scale,
+                                                     0, //mipMapLevel
+                                                     ViewIdx(view),
+                                                     false, //byPassCache
+                                                     renderWindow,
+                                                     rod,
+                                                     requestedComps,
+                                                     effect->getBitDepth(-1),
+                                                     false,
+                                                     effect);
+            if (effect->renderRoI(renderArgs, &planes) != EffectInstance::eRenderRoIRetCodeOk) {
+                Py_RETURN_NONE;
+            }
+        } catch (const std::exception& e) {
+            PyErr_SetString( PyExc_RuntimeError, e.what() );
+            return NULL;
+        }
+    }
+    if ( planes.empty() || !planes.begin()->second ) {
+        Py_RETURN_NONE;
+    }
+    
+    ///The buffer object holds a copy of the rendered window, the image itself may be evicted from the cache
+    return createPyImageBuffer(planes.begin()->second, renderWindow);
+} // getImage
+
 void
 Effect::setSubGraphEditable(bool editable)
 {
@@ -39,6 +39,7 @@
 #include "Engine/Knob.h" // KnobI
 #include "Engine/PyNodeGroup.h" // Group
 #include "Engine/RectD.h"
+#include "Engine/RectI.h"
 #include "Engine/EngineFwd.h"
 
 NATRON_NAMESPACE_ENTER;
@@ -352,6 +353,15 @@ public:
     
     RectD getRegionOfDefinition(double time, int /* Python API: do not use ViewIdx */ view) const;
     
+    /**
+     * @brief Renders the given plane of this effect at the given time and view, in the rectangle rect (in pixel
+     * coordinates at scale 1, the whole region of definition if rect is null) and returns a new reference to a
+     * NatronEngine.ImageBuffer holding a copy of the rendered pixels. It implements the buffer protocol so that
+     * e.g memoryview or numpy can read them without copying them again.
+     * Returns None if the effect could not be rendered.
+     **/
+    PyObject* getImage(double time, int /* Python API: do not use ViewIdx */ view, const RectI& rect, const ImageLayer& plane) const;
+    
     static Param* createParamWrapperForKnob(const KnobPtr& knob);
     
     void setSubGraphEditable(bool editable);
@@ -25,13 +25,17 @@
 #include "PyParameter.h"
 
 #include <cassert>
+#include <list>
 #include <stdexcept>
+#include <vector>
 
 #include "Engine/EffectInstance.h"
 #include "Engine/Node.h"
 #include "Engine/Curve.h"
 #include "Engine/ViewIdx.h"
 
+#include <QtCore/QObject>
+
 NATRON_NAMESPACE_ENTER;
 
 Param::Param(const KnobPtr& knob)
@@ -576,6 +580,36 @@ IntParam::setValueAtTime(int value, double time, int dimension)
     _intKnob.lock()->setValueAtTime(time, value, ViewSpec::current(), dimension);
 }
 
+/**
+ * @brief Adds all the keyframes at once with Knob::setValuesAtTimes, so that the curve is rebuilt once
+ * and the knob is evaluated once for all keys.
+ **/
+template <typename T>
+static void
+setKnobValuesAtTimes(const boost::shared_ptr<Knob<T> >& knob,
+                     const std::list<double>& times,
+                     const std::list<T>& values,
+                     int dimension)
+{
+    if (times.size() != values.size()) {
+        PyErr_SetString(PyExc_ValueError, QObject::tr("setValuesAtTimes: times and values must have the same size").toStdString().c_str());
+        return;
+    }
+    if (dimension < 0 || dimension >= knob->getDimension()) {
+        PyErr_SetString(PyExc_IndexError, QObject::tr("setValuesAtTimes: invalid dimension").toStdString().c_str());
+        return;
+    }
+    std::vector<double> timesVec(times.begin(), times.end());
+    std::vector<T> valuesVec(values.begin(), values.end());
+    knob->setValuesAtTimes(timesVec, valuesVec, ViewSpec::current(), dimension, eValueChangedReasonNatronInternalEdited);
+}
+
+void
+IntParam::setValuesAtTimes(const std::list<double>& times, const std::list<int>& values, int dimension)
+{
+    setKnobValuesAtTimes<int>(_intKnob.lock(), times, values, dimension);
+}
+
 void
 IntParam::setDefaultValue(int value,int dimension)
 {
@@ -799,6 +833,12 @@ DoubleParam::setValueAtTime(double value,double time,int dimension)
     _doubleKnob.lock()->setValueAtTime(time, value, ViewSpec::current(), dimension);
 }
 
+void
+DoubleParam::setValuesAtTimes(const std::list<double>& times, const std::list<double>& values, int dimension)
+{
+    setKnobValuesAtTimes<double>(_doubleKnob.lock(), times, values, dimension);
+}
+
 void
 DoubleParam::setDefaultValue(double value,int dimension)
 {
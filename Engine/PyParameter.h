@@ -336,6 +336,12 @@ public:
      **/
     void setValueAtTime(int value,double time,int dimension = 0);
     
+    /**
+     * @brief Set a keyframe at each of the given times with the value at the same position in values.
+     * All keyframes are added to the curve at once, so the node is evaluated only once.
+     **/
+    void setValuesAtTimes(const std::list<double>& times, const std::list<int>& values, int dimension = 0);
+    
     /**
      * @brief Set the default value for the given dimension
      **/
@@ -481,6 +487,12 @@ public:
      **/
     void setValueAtTime(double value,double time,int dimension = 0);
     
+    /**
+     * @brief Set a keyframe at each of the given times with the value at the same position in values.
+     * All keyframes are added to the curve at once, so the node is evaluated only once.
+     **/
+    void setValuesAtTimes(const std::list<double>& times, const std::list<double>& values, int dimension = 0);
+    
     /**
      * @brief Set the default value for the given dimension
      **/
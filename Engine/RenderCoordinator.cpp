@@ -0,0 +1,484 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderCoordinator.h"
+
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <iostream>
+#include <list>
+#include <map>
+#include <set>
+#include <vector>
+
+#include <QtCore/QEventLoop>
+#include <QtCore/QStringList>
+
+#include "Engine/CLArgs.h"
+#include "Engine/ProcessHandler.h"
+#include "Engine/Timer.h"
+
+// A frame is given up after failing this number of times in addition to its first render
+#define NATRON_RENDER_COORDINATOR_MAX_RETRIES 2
+
+// A worker must have at least this number of frames left to be split when another one is idle
+#define NATRON_RENDER_COORDINATOR_MIN_FRAMES_TO_SPLIT 4
+
+// The default chunk size gives approximately this number of chunks to each worker
+#define NATRON_RENDER_COORDINATOR_CHUNKS_PER_WORKER 4
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderWorker
+{
+    ProcessHandler* process;
+    int slot; //< index of the worker in RenderCoordinatorPrivate::workerStats
+    std::vector<int> frames; //< frames given to this process, sorted
+    std::map<int, int> nReports; //< for each frame, the number of writers that reported it rendered
+    int nFramesDone;
+    bool aborted; //< true if we aborted the process to give its frames to idle workers
+    TimeLapse timer;
+
+    RenderWorker()
+    : process(0)
+    , slot(-1)
+    , frames()
+    , nReports()
+    , nFramesDone(0)
+    , aborted(false)
+    , timer()
+    {
+    }
+};
+
+/**
+ * @brief The render times of the frames reported by the workers, as measured by the RenderStats of each process
+ **/
+struct RenderTimeStats
+{
+    int nFrames;
+    double totalTime;
+    double minTime;
+    double maxTime;
+
+    RenderTimeStats()
+    : nFrames(0)
+    , totalTime(0.)
+    , minTime(0.)
+    , maxTime(0.)
+    {
+    }
+
+    void add(double timeSpent)
+    {
+        if (nFrames == 0) {
+            minTime = maxTime = timeSpent;
+        } else {
+            minTime = std::min(minTime, timeSpent);
+            maxTime = std::max(maxTime, timeSpent);
+        }
+        ++nFrames;
+        totalTime += timeSpent;
+    }
+
+    QString toString() const
+    {
+        return QObject::tr("%1 per frame on average, from %2 to %3")
+               .arg( Timer::printAsTime(totalTime / nFrames, false) )
+               .arg( Timer::printAsTime(minTime, false) )
+               .arg( Timer::printAsTime(maxTime, false) );
+    }
+};
+
+struct RenderWorkerStats
+{
+    int nFramesRendered;
+    int nChunks;
+    int nFailures;
+    double busyTime;
+    RenderTimeStats renderTimes;
+
+    RenderWorkerStats()
+    : nFramesRendered(0)
+    , nChunks(0)
+    , nFailures(0)
+    , busyTime(0.)
+    , renderTimes()
+    {
+    }
+};
+
+typedef std::list<RenderWorker> RenderWorkersList;
+
+struct RenderCoordinatorPrivate
+{
+    int nWorkers;
+    int nWriters;
+    QStringList workerArgs;
+    std::size_t nFrames;
+    std::list<std::vector<int> > pendingChunks;
+    RenderWorkersList running;
+    std::vector<RenderWorkerStats> workerStats;
+    std::vector<bool> workerBusy;
+    std::set<int> renderedFrames;
+    std::set<int> failedFrames;
+    std::map<int, int> retries;
+    int nFramesRetried;
+    RenderTimeStats renderTimes; //< of all the workers
+    QEventLoop* loop;
+    TimeLapse totalTime;
+
+    RenderCoordinatorPrivate(const CLArgs& args)
+    : nWorkers( std::max(1, args.getRenderWorkersCount()) )
+    , nWriters( std::max(1, (int)args.getWriterArgs().size()) )
+    , workerArgs( args.getRenderWorkerArgs() )
+    , nFrames(0)
+    , pendingChunks()
+    , running()
+    , workerStats(nWorkers)
+    , workerBusy(nWorkers, false)
+    , renderedFrames()
+    , failedFrames()
+    , retries()
+    , nFramesRetried(0)
+    , renderTimes()
+    , loop(0)
+    , totalTime()
+    {
+    }
+
+    RenderWorkersList::iterator findWorker(QObject* process)
+    {
+        for (RenderWorkersList::iterator it = running.begin(); it != running.end(); ++it) {
+            if (it->process == process) {
+                return it;
+            }
+        }
+        return running.end();
+    }
+
+    /**
+     * @brief Splits the given sorted frames in nChunks chunks of (almost) the same size and queue them,
+     * either before or after the chunks already pending.
+     **/
+    void queueFrames(const std::vector<int>& frames, int nChunks, bool first);
+};
+
+void
+RenderCoordinatorPrivate::queueFrames(const std::vector<int>& frames,
+                                      int nChunks,
+                                      bool first)
+{
+    nChunks = std::max( 1, std::min( nChunks, (int)frames.size() ) );
+    std::list<std::vector<int> > chunks;
+    std::size_t begin = 0;
+    for (int i = 0; i < nChunks; ++i) {
+        std::size_t end = ( frames.size() * (i + 1) ) / nChunks;
+        if (end > begin) {
+            chunks.push_back( std::vector<int>(frames.begin() + begin, frames.begin() + end) );
+        }
+        begin = end;
+    }
+    if (first) {
+        pendingChunks.splice(pendingChunks.begin(), chunks);
+    } else {
+        pendingChunks.splice(pendingChunks.end(), chunks);
+    }
+}
+
+/**
+ * @brief Returns the frames in the format of the frame range argument of CLArgs, e.g: 1-10:1,15,17,20-30:2
+ **/
+static QString
+framesToRangeArg(const std::vector<int>& frames)
+{
+    QStringList ranges;
+    std::size_t i = 0;
+
+    while ( i < frames.size() ) {
+        std::size_t last = i;
+        if ( i + 1 < frames.size() ) {
+            int step = frames[i + 1] - frames[i];
+            while ( last + 1 < frames.size() && frames[last + 1] - frames[last] == step ) {
+                ++last;
+            }
+            if (last - i >= 2) {
+                ranges.push_back( QString::fromUtf8("%1-%2:%3").arg(frames[i]).arg(frames[last]).arg(step) );
+                i = last + 1;
+                continue;
+            }
+        }
+        ranges.push_back( QString::number(frames[i]) );
+        ++i;
+    }
+
+    return ranges.join( QString::fromUtf8(",") );
+}
+
+RenderCoordinator::RenderCoordinator(const CLArgs& args)
+    : QObject()
+    , _imp( new RenderCoordinatorPrivate(args) )
+{
+    std::set<int> frames;
+    const std::list<std::pair<int, std::pair<int, int> > >& ranges = args.getFrameRanges();
+
+    for (std::list<std::pair<int, std::pair<int, int> > >::const_iterator it = ranges.begin(); it != ranges.end(); ++it) {
+        // Without a project loaded we cannot know the frame step of the writers: default to 1
+        int step = it->first == INT_MIN ? 1 : std::max(1, it->first);
+        for (int f = it->second.first; f <= it->second.second; f += step) {
+            frames.insert(f);
+        }
+    }
+    _imp->nFrames = frames.size();
+
+    int chunkSize = args.getRenderChunkSize();
+    if (chunkSize <= 0) {
+        int nChunks = _imp->nWorkers * NATRON_RENDER_COORDINATOR_CHUNKS_PER_WORKER;
+        chunkSize = std::max( 1, (int)( (frames.size() + nChunks - 1) / nChunks ) );
+    }
+    std::vector<int> sortedFrames( frames.begin(), frames.end() );
+    _imp->queueFrames(sortedFrames, (int)( (sortedFrames.size() + chunkSize - 1) / chunkSize ), false);
+}
+
+RenderCoordinator::~RenderCoordinator()
+{
+    for (RenderWorkersList::iterator it = _imp->running.begin(); it != _imp->running.end(); ++it) {
+        delete it->process;
+    }
+}
+
+int
+RenderCoordinator::exec()
+{
+    std::cout << tr("Rendering %1 frames with %2 processes").arg(_imp->nFrames).arg(_imp->nWorkers).toStdString() << std::endl;
+
+    startPendingChunks();
+    if ( !_imp->running.empty() ) {
+        QEventLoop loop;
+        _imp->loop = &loop;
+        loop.exec();
+        _imp->loop = 0;
+    }
+
+    double totalTime = _imp->totalTime.getTimeSinceCreation();
+    std::size_t nRendered = _imp->renderedFrames.size();
+    std::cout << tr("Rendered %1 of %2 frames in %3").arg(nRendered).arg(_imp->nFrames).arg( Timer::printAsTime(totalTime, false) ).toStdString();
+    if (nRendered > 0) {
+        std::cout << tr(" (%1 per frame)").arg( Timer::printAsTime(totalTime / nRendered, false) ).toStdString();
+    }
+    std::cout << std::endl;
+    if (_imp->nFramesRetried > 0) {
+        std::cout << tr("%1 frames were rendered again after a process failure").arg(_imp->nFramesRetried).toStdString() << std::endl;
+    }
+    if (_imp->renderTimes.nFrames > 0) {
+        std::cout << tr("Render time: %1").arg( _imp->renderTimes.toString() ).toStdString() << std::endl;
+    }
+    for (std::size_t i = 0; i < _imp->workerStats.size(); ++i) {
+        const RenderWorkerStats& stats = _imp->workerStats[i];
+        std::cout << tr("Process %1: %2 frames rendered in %3 chunks, %4 failures, busy during %5")
+        .arg(i + 1).arg(stats.nFramesRendered).arg(stats.nChunks).arg(stats.nFailures)
+        .arg( Timer::printAsTime(stats.busyTime, false) ).toStdString();
+        if (stats.renderTimes.nFrames > 0) {
+            std::cout << tr(", %1").arg( stats.renderTimes.toString() ).toStdString();
+        }
+        std::cout << std::endl;
+    }
+    if ( !_imp->failedFrames.empty() ) {
+        QStringList failed;
+        for (std::set<int>::const_iterator it = _imp->failedFrames.begin(); it != _imp->failedFrames.end(); ++it) {
+            failed.push_back( QString::number(*it) );
+        }
+        std::cout << tr("The following frames could not be rendered: %1").arg( failed.join( QString::fromUtf8(",") ) ).toStdString() << std::endl;
+    }
+
+    return nRendered == _imp->nFrames ? 0 : 1;
+}
+
+void
+RenderCoordinator::startPendingChunks()
+{
+    while ( !_imp->pendingChunks.empty() && (int)_imp->running.size() < _imp->nWorkers ) {
+        int slot = 0;
+        while (_imp->workerBusy[slot]) {
+            ++slot;
+        }
+        assert( slot < (int)_imp->workerBusy.size() );
+        _imp->workerBusy[slot] = true;
+
+        RenderWorker worker;
+        worker.slot = slot;
+        worker.frames = _imp->pendingChunks.front();
+        _imp->pendingChunks.pop_front();
+
+        // The frame range must come first: the first argument that looks like a frame range is taken as such
+        QStringList processArgs;
+        processArgs << QString::fromUtf8("-b") << framesToRangeArg(worker.frames) << _imp->workerArgs;
+        worker.process = new ProcessHandler(processArgs);
+        QObject::connect( worker.process, SIGNAL(frameRendered(int,double)), this, SLOT(onWorkerFrameRendered(int,double)) );
+        QObject::connect( worker.process, SIGNAL(frameRenderTimeReported(int,double)), this, SLOT(onWorkerFrameRenderTimeReported(int,double)) );
+        QObject::connect( worker.process, SIGNAL(processFinished(int)), this, SLOT(onWorkerFinished(int)) );
+
+        ProcessHandler* process = worker.process;
+        _imp->running.push_back(worker);
+        process->startProcess();
+    }
+
+    if ( _imp->pendingChunks.empty() ) {
+        rebalance();
+    }
+}
+
+void
+RenderCoordinator::rebalance()
+{
+    if ( (int)_imp->running.size() >= _imp->nWorkers ) {
+        return;
+    }
+
+    // Abort the worker with the most remaining frames. Only workers that already rendered a frame are considered:
+    // the others are still loading the project, which an idle worker would have to do as well.
+    RenderWorkersList::iterator slowest = _imp->running.end();
+    int slowestRemaining = 0;
+    for (RenderWorkersList::iterator it = _imp->running.begin(); it != _imp->running.end(); ++it) {
+        int remaining = (int)it->frames.size() - it->nFramesDone;
+        if ( !it->aborted && it->nFramesDone > 0 && remaining > slowestRemaining ) {
+            slowest = it;
+            slowestRemaining = remaining;
+        }
+    }
+    if ( slowest == _imp->running.end() || slowestRemaining < NATRON_RENDER_COORDINATOR_MIN_FRAMES_TO_SPLIT ) {
+        return;
+    }
+
+    std::cout << tr("Process %1 has %2 frames left: splitting them with idle processes").arg(slowest->slot + 1).arg(slowestRemaining).toStdString() << std::endl;
+    slowest->aborted = true;
+    slowest->process->onProcessCanceled();
+}
+
+void
+RenderCoordinator::onWorkerFrameRendered(int frame,
+                                         double /*progress*/)
+{
+    RenderWorkersList::iterator it = _imp->findWorker( sender() );
+
+    if ( it == _imp->running.end() ) {
+        return;
+    }
+    int& nReports = it->nReports[frame];
+    ++nReports;
+    if (nReports != _imp->nWriters) {
+        return;
+    }
+    ++it->nFramesDone;
+    if ( _imp->renderedFrames.insert(frame).second ) {
+        ++_imp->workerStats[it->slot].nFramesRendered;
+        double percent = _imp->nFrames ? _imp->renderedFrames.size() * 100. / _imp->nFrames : 100.;
+        std::cout << kFrameRenderedStringLong << frame << " (" << QString::number(percent, 'f', 1).toStdString() << "%)" << std::endl;
+    }
+}
+
+void
+RenderCoordinator::onWorkerFrameRenderTimeReported(int /*frame*/,
+                                                   double timeSpent)
+{
+    RenderWorkersList::iterator it = _imp->findWorker( sender() );
+
+    if ( it == _imp->running.end() ) {
+        return;
+    }
+    ///Each writer reports the frame with the time it spent on it
+    _imp->workerStats[it->slot].renderTimes.add(timeSpent);
+    _imp->renderTimes.add(timeSpent);
+}
+
+void
+RenderCoordinator::onWorkerFinished(int returnCode)
+{
+    RenderWorkersList::iterator it = _imp->findWorker( sender() );
+
+    if ( it == _imp->running.end() ) {
+        return;
+    }
+
+    RenderWorkerStats& stats = _imp->workerStats[it->slot];
+    stats.busyTime += it->timer.getTimeSinceCreation();
+    ++stats.nChunks;
+
+    std::vector<int> remaining;
+    for (std::size_t i = 0; i < it->frames.size(); ++i) {
+        if ( _imp->renderedFrames.find(it->frames[i]) == _imp->renderedFrames.end() ) {
+            remaining.push_back(it->frames[i]);
+        }
+    }
+
+    if ( (returnCode == 0) && !it->aborted ) {
+        // The process rendered all its frames, even if some reports did not reach us
+        for (std::size_t i = 0; i < remaining.size(); ++i) {
+            _imp->renderedFrames.insert(remaining[i]);
+        }
+        stats.nFramesRendered += (int)remaining.size();
+    } else if ( !remaining.empty() ) {
+        if (it->aborted) {
+            // Split the remaining frames between this worker and the idle ones
+            int nIdle = _imp->nWorkers - (int)_imp->running.size() + 1;
+            _imp->queueFrames(remaining, nIdle, true);
+        } else {
+            ++stats.nFailures;
+            std::cerr << tr("Process %1 failed with %2 frames left to render. Its log is:").arg(it->slot + 1).arg( remaining.size() ).toStdString() << std::endl;
+            std::cerr << it->process->getProcessLog().toStdString() << std::endl;
+
+            std::vector<int> retry;
+            for (std::size_t i = 0; i < remaining.size(); ++i) {
+                int& nRetries = _imp->retries[remaining[i]];
+                ++nRetries;
+                if (nRetries > NATRON_RENDER_COORDINATOR_MAX_RETRIES) {
+                    _imp->failedFrames.insert(remaining[i]);
+                } else {
+                    retry.push_back(remaining[i]);
+                }
+            }
+            // Bisect the frames so that a frame that makes the process fail ends up alone
+            if ( !retry.empty() ) {
+                _imp->nFramesRetried += (int)retry.size();
+                _imp->queueFrames(retry, 2, true);
+            }
+        }
+    }
+
+    _imp->workerBusy[it->slot] = false;
+    it->process->deleteLater();
+    _imp->running.erase(it);
+
+    startPendingChunks();
+    if ( _imp->running.empty() && _imp->loop ) {
+        _imp->loop->quit();
+    }
+}
+
+NATRON_NAMESPACE_EXIT;
+
+NATRON_NAMESPACE_USING;
+#include "moc_RenderCoordinator.cpp"
@@ -0,0 +1,92 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+#ifndef RENDERCOORDINATOR_H
+#define RENDERCOORDINATOR_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QObject>
+CLANG_DIAG_ON(deprecated)
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderCoordinatorPrivate;
+
+/**
+ * @brief Renders the frame range given on the command line with several background processes instead of
+ * rendering it in this process (see the --workers option of CLArgs).
+ * The frames are split in chunks that are given to at most N worker processes at a time. Each worker is a
+ * ProcessHandler, hence it reports its rendered frames through the usual IPC pipe and can be aborted through it.
+ * - When a worker fails or crashes, the frames it did not report are rendered again by another worker. A frame
+ * failing more than a few times is given up.
+ * - When a worker is idle and there is nothing left to render, the worker with the most remaining frames is
+ * aborted and its remaining frames are split among the idle workers.
+ * The progress of all workers is reported on the standard output, and a summary is printed at the end.
+ * This does not need an AppManager: the workers load the project, not the coordinator.
+ **/
+class RenderCoordinator
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    RenderCoordinator(const CLArgs& args);
+
+    virtual ~RenderCoordinator();
+
+    /**
+     * @brief Renders all frames, blocking until they are all rendered or given up.
+     * A QCoreApplication must exist. Returns the exit code of the process: 0 if all frames were rendered, 1 otherwise.
+     **/
+    int exec();
+
+public Q_SLOTS:
+
+    void onWorkerFrameRendered(int frame, double progress);
+
+    void onWorkerFrameRenderTimeReported(int frame, double timeSpent);
+
+    void onWorkerFinished(int returnCode);
+
+private:
+
+    void startPendingChunks();
+
+    void rebalance();
+
+    boost::scoped_ptr<RenderCoordinatorPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // RENDERCOORDINATOR_H
@@ -0,0 +1,403 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "RenderDaemon.h"
+
+#include <cassert>
+#include <cstring>
+#include <iostream>
+#include <list>
+#include <map>
+#include <stdexcept>
+#include <string>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDateTime>
+#include <QtCore/QEventLoop>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtNetwork/QLocalServer>
+#include <QtNetwork/QLocalSocket>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/CLArgs.h"
+
+// The maximum number of projects kept loaded, the least recently used one is closed first
+#define NATRON_RENDER_DAEMON_MAX_PROJECTS 4
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderDaemonProject
+{
+    AppInstance* app;
+    QDateTime lastModified; //< of the file when it was loaded
+    qint64 size; //< of the file when it was loaded
+    bool mustReload; //< true if the last job modified the project
+    U64 lastUsed;
+
+    RenderDaemonProject()
+    : app(0)
+    , lastModified()
+    , size(0)
+    , mustReload(false)
+    , lastUsed(0)
+    {
+    }
+};
+
+typedef std::map<QString, RenderDaemonProject> RenderDaemonProjectsMap;
+
+struct RenderDaemonPrivate
+{
+    QString serverName;
+    QLocalServer* server;
+    std::list<QLocalSocket*> clients;
+    QMutex currentClientMutex;
+    QLocalSocket* currentClient; //< the client of the job being rendered, protected by currentClientMutex
+    bool processingMessages;
+    bool mustQuit;
+    QEventLoop* loop;
+    RenderDaemonProjectsMap projects;
+    U64 jobsCount;
+    int projectsLoadedCount;
+
+    RenderDaemonPrivate(const QString& serverName)
+    : serverName(serverName)
+    , server(0)
+    , clients()
+    , currentClientMutex()
+    , currentClient(0)
+    , processingMessages(false)
+    , mustQuit(false)
+    , loop(0)
+    , projects()
+    , jobsCount(0)
+    , projectsLoadedCount(0)
+    {
+    }
+
+    /**
+     * @brief Parses and renders a job, throws an exception on failure.
+     **/
+    void runJob(const QString& job);
+
+    AppInstance* getProject(const CLArgs& args);
+
+    void closeProject(RenderDaemonProjectsMap::iterator it);
+};
+
+/**
+ * @brief Returns true if rendering the given job changes the project, in which case it must be reloaded for the next job.
+ **/
+static bool
+jobModifiesProject(const CLArgs& args)
+{
+    if ( !args.getPythonCommands().empty() || !args.getReaderArgs().empty() || !args.getDefaultOnProjectLoadedScript().isEmpty() ) {
+        return true;
+    }
+    const std::list<CLArgs::WriterArg>& writers = args.getWriterArgs();
+    for (std::list<CLArgs::WriterArg>::const_iterator it = writers.begin(); it != writers.end(); ++it) {
+        if ( it->mustCreate || !it->filename.isEmpty() ) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void
+RenderDaemonPrivate::runJob(const QString& job)
+{
+    QStringList jobArgs = job.split(QLatin1Char('\t'), QString::SkipEmptyParts);
+
+    jobArgs.prepend( QCoreApplication::applicationFilePath() );
+
+    CLArgs args(jobArgs, true);
+    if (args.getError() > 0) {
+        throw std::invalid_argument( QObject::tr("Invalid job arguments").toStdString() );
+    }
+    if ( args.isInterpreterMode() || (args.getRenderWorkersCount() > 0) || !args.getDaemonServerName().isEmpty() ) {
+        throw std::invalid_argument( QObject::tr("The -t, --workers and --daemon options cannot be used in a job").toStdString() );
+    }
+
+    AppInstance* app = getProject(args);
+    assert(app);
+
+    ///Render failures are not reported by exceptions: the render engines record them in the app instance
+    app->takeRenderFailures();
+    app->renderFromCL(args);
+    std::string failures = app->takeRenderFailures();
+    if ( !failures.empty() ) {
+        throw std::runtime_error(failures);
+    }
+}
+
+AppInstance*
+RenderDaemonPrivate::getProject(const CLArgs& args)
+{
+    QFileInfo info( args.getScriptFilename() );
+
+    if ( !info.exists() ) {
+        throw std::invalid_argument( QObject::tr("Specified project file does not exist").toStdString() );
+    }
+    QString filePath = info.canonicalFilePath();
+    bool modifies = jobModifiesProject(args);
+
+    RenderDaemonProjectsMap::iterator found = projects.find(filePath);
+    if ( found != projects.end() ) {
+        RenderDaemonProject& project = found->second;
+        if ( !project.mustReload && (project.lastModified == info.lastModified()) && (project.size == info.size()) ) {
+            project.lastUsed = ++jobsCount;
+            project.mustReload = modifies;
+
+            return project.app;
+        }
+        closeProject(found);
+    }
+
+    while ( !projects.empty() && (projects.size() >= NATRON_RENDER_DAEMON_MAX_PROJECTS) ) {
+        RenderDaemonProjectsMap::iterator leastRecentlyUsed = projects.begin();
+        for (RenderDaemonProjectsMap::iterator it = projects.begin(); it != projects.end(); ++it) {
+            if (it->second.lastUsed < leastRecentlyUsed->second.lastUsed) {
+                leastRecentlyUsed = it;
+            }
+        }
+        closeProject(leastRecentlyUsed);
+    }
+
+    AppInstance* app = appPTR->newBackgroundInstance(CLArgs(), true);
+    if (!app) {
+        throw std::runtime_error( QObject::tr("Could not create a new application instance").toStdString() );
+    }
+    try {
+        app->loadScriptFromCL(args);
+    } catch (...) {
+        app->quit();
+        throw;
+    }
+
+    ++projectsLoadedCount;
+
+    RenderDaemonProject project;
+    project.app = app;
+    project.lastModified = info.lastModified();
+    project.size = info.size();
+    project.mustReload = modifies;
+    project.lastUsed = ++jobsCount;
+    projects[filePath] = project;
+
+    return app;
+}
+
+void
+RenderDaemonPrivate::closeProject(RenderDaemonProjectsMap::iterator it)
+{
+    AppInstance* app = it->second.app;
+
+    projects.erase(it);
+    try {
+        app->quit();
+    } catch (const std::exception& e) {
+        std::cerr << e.what() << std::endl;
+    }
+}
+
+RenderDaemon::RenderDaemon(const QString& serverName)
+    : QObject()
+    , _imp( new RenderDaemonPrivate(serverName) )
+{
+    _imp->server = new QLocalServer();
+    QObject::connect( _imp->server, SIGNAL(newConnection()), this, SLOT(onNewConnectionPending()) );
+}
+
+RenderDaemon::~RenderDaemon()
+{
+    while ( !_imp->projects.empty() ) {
+        _imp->closeProject( _imp->projects.begin() );
+    }
+    for (std::list<QLocalSocket*>::iterator it = _imp->clients.begin(); it != _imp->clients.end(); ++it) {
+        (*it)->close();
+        delete *it;
+    }
+    _imp->server->close();
+    delete _imp->server;
+}
+
+bool
+RenderDaemon::exec()
+{
+    if ( !_imp->server->listen(_imp->serverName) ) {
+        ///A daemon that did not exit properly may have left its server behind: remove it if nobody answers
+        QLocalSocket probe;
+        probe.connectToServer(_imp->serverName);
+        if ( probe.waitForConnected(1000) ) {
+            std::cerr << tr("A render daemon is already listening on %1").arg(_imp->serverName).toStdString() << std::endl;
+
+            return false;
+        }
+        QLocalServer::removeServer(_imp->serverName);
+        if ( !_imp->server->listen(_imp->serverName) ) {
+            std::cerr << tr("Could not create the render daemon server %1: %2").arg(_imp->serverName).arg( _imp->server->errorString() ).toStdString() << std::endl;
+
+            return false;
+        }
+    }
+    std::cout << tr("Render daemon listening on %1").arg( _imp->server->fullServerName() ).toStdString() << std::endl;
+
+    QEventLoop loop;
+    _imp->loop = &loop;
+    loop.exec();
+    _imp->loop = 0;
+    _imp->server->close();
+
+    return true;
+}
+
+int
+RenderDaemon::getProjectsLoadedCount() const
+{
+    return _imp->projectsLoadedCount;
+}
+
+void
+RenderDaemon::writeToClient(const QString& message)
+{
+    QMutexLocker k(&_imp->currentClientMutex);
+
+    if (!_imp->currentClient) {
+        return;
+    }
+    _imp->currentClient->write( ( message + QLatin1Char('\n') ).toUtf8() );
+    _imp->currentClient->flush();
+}
+
+void
+RenderDaemon::onNewConnectionPending()
+{
+    while ( _imp->server->hasPendingConnections() ) {
+        QLocalSocket* client = _imp->server->nextPendingConnection();
+        QObject::connect( client, SIGNAL(readyRead()), this, SLOT(onClientDataAvailable()) );
+        QObject::connect( client, SIGNAL(disconnected()), this, SLOT(onClientDisconnected()) );
+        _imp->clients.push_back(client);
+    }
+}
+
+void
+RenderDaemon::onClientDataAvailable()
+{
+    processPendingMessages();
+}
+
+void
+RenderDaemon::onClientDisconnected()
+{
+    processPendingMessages();
+}
+
+void
+RenderDaemon::processPendingMessages()
+{
+    ///Loading a project may process events: the messages received meanwhile are handled by the outer call
+    if (_imp->processingMessages) {
+        return;
+    }
+    _imp->processingMessages = true;
+
+    bool hadMessage = true;
+    while (hadMessage && !_imp->mustQuit) {
+        hadMessage = false;
+        for (std::list<QLocalSocket*>::iterator it = _imp->clients.begin(); it != _imp->clients.end() && !_imp->mustQuit; ++it) {
+            QLocalSocket* client = *it;
+            if ( !client->canReadLine() ) {
+                continue;
+            }
+            hadMessage = true;
+
+            QString str = QString::fromUtf8( client->readLine() );
+            while ( str.endsWith( QLatin1Char('\n') ) ) {
+                str.chop(1);
+            }
+            if ( str.startsWith( QString::fromUtf8(kDaemonQuitShort) ) ) {
+                _imp->mustQuit = true;
+            } else if ( str.startsWith( QString::fromUtf8(kDaemonRenderJobShort) ) ) {
+                str.remove( 0, (int)std::strlen(kDaemonRenderJobShort) );
+                {
+                    QMutexLocker k(&_imp->currentClientMutex);
+                    _imp->currentClient = client;
+                }
+                QString error;
+                try {
+                    _imp->runJob(str);
+                } catch (const std::exception& e) {
+                    error = QString::fromUtf8( e.what() );
+                    if ( error.isEmpty() ) {
+                        error = tr("Unknown error");
+                    }
+                } catch (...) {
+                    error = tr("Unknown error");
+                }
+                {
+                    QMutexLocker k(&_imp->currentClientMutex);
+                    _imp->currentClient = 0;
+                }
+                QString reply = QString::fromUtf8(kDaemonJobFinishedShort);
+                if ( error.isEmpty() ) {
+                    reply += QLatin1Char('0');
+                } else {
+                    std::cerr << tr("Job failed: %1").arg(error).toStdString() << std::endl;
+                    reply += QString::fromUtf8("1\t") + error.replace( QLatin1Char('\n'), QLatin1Char(' ') );
+                }
+                client->write( ( reply + QLatin1Char('\n') ).toUtf8() );
+                client->flush();
+            } else {
+                std::cerr << tr("Error: Unable to interpret message: %1").arg(str).toStdString() << std::endl;
+            }
+        }
+    }
+
+    ///Forget the clients that left, now that their pending jobs are done
+    for (std::list<QLocalSocket*>::iterator it = _imp->clients.begin(); it != _imp->clients.end();) {
+        if ( (*it)->state() == QLocalSocket::UnconnectedState ) {
+            (*it)->deleteLater();
+            it = _imp->clients.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    _imp->processingMessages = false;
+    if (_imp->mustQuit && _imp->loop) {
+        _imp->loop->quit();
+    }
+}
+
+NATRON_NAMESPACE_EXIT;
+
+NATRON_NAMESPACE_USING;
+#include "moc_RenderDaemon.cpp"
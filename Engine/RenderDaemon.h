@@ -0,0 +1,101 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+
+#ifndef RENDERDAEMON_H
+#define RENDERDAEMON_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "Global/Macros.h"
+CLANG_DIAG_OFF(deprecated)
+#include <QtCore/QObject>
+#include <QtCore/QString>
+CLANG_DIAG_ON(deprecated)
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#endif
+
+#include "Engine/EngineFwd.h"
+
+NATRON_NAMESPACE_ENTER;
+
+struct RenderDaemonPrivate;
+
+/**
+ * @brief A resident background render process (see the --daemon option of CLArgs), so that the plug-ins and
+ * Python are loaded once for many render jobs instead of once per NatronRenderer invocation.
+ * The daemon listens on a local server. Clients send one job per line (kDaemonRenderJobShort followed by
+ * the command-line arguments of the render separated by tabulations). Jobs are rendered one after another.
+ * While a job renders, the client receives the usual kFrameRenderedStringShort and kRenderingFinishedStringShort
+ * messages, followed by kDaemonJobFinishedShort once the job is done.
+ *
+ * The projects are kept loaded, each in its own AppInstance, and are reloaded only when the file changed on disk
+ * or when the previous job modified them (file names given to -w/-i, Python commands, --onload script...).
+ **/
+class RenderDaemon
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    RenderDaemon(const QString& serverName);
+
+    virtual ~RenderDaemon();
+
+    /**
+     * @brief Listens to the clients and renders their jobs until a client sends kDaemonQuitShort.
+     * Returns false if the server could not be created.
+     **/
+    bool exec();
+
+    /**
+     * @brief Writes a message to the client of the job being rendered, if any. This is thread-safe.
+     **/
+    void writeToClient(const QString& message);
+
+    /**
+     * @brief Returns how many times a project was loaded (or reloaded) to render a job. Jobs rendered with
+     * an already loaded project do not count.
+     **/
+    int getProjectsLoadedCount() const;
+
+public Q_SLOTS:
+
+    void onNewConnectionPending();
+
+    void onClientDataAvailable();
+
+    void onClientDisconnected();
+
+private:
+
+    void processPendingMessages();
+
+    boost::scoped_ptr<RenderDaemonPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // RENDERDAEMON_H
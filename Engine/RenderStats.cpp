@@ -66,6 +66,11 @@ struct NodeRenderStatsPrivate
     int nbCacheHit;
     int nbCacheHitButDownscaledImages;
     
+    //Memory allocated by the plug-in through the OpenFX memory suites
+    int nbPluginMemoryAllocations;
+    int nbPluginMemoryRecycledAllocations;
+    U64 pluginMemoryAllocated;
+    
     //Is tile support enabled for this render
     bool tileSupportEnabled;
     
@@ -89,6 +94,9 @@ struct NodeRenderStatsPrivate
     , nbCacheMisses(0)
     , nbCacheHit(0)
     , nbCacheHitButDownscaledImages(0)
+    , nbPluginMemoryAllocations(0)
+    , nbPluginMemoryRecycledAllocations(0)
+    , pluginMemoryAllocated(0)
     , tileSupportEnabled(false)
     , renderScaleSupportEnabled(false)
     , channelsEnabled()
@@ -130,6 +138,9 @@ NodeRenderStats::operator=(const NodeRenderStats& other)
     _imp->nbCacheMisses = other._imp->nbCacheMisses;
     _imp->nbCacheHit = other._imp->nbCacheHit;
     _imp->nbCacheHitButDownscaledImages = other._imp->nbCacheHitButDownscaledImages;
+    _imp->nbPluginMemoryAllocations = other._imp->nbPluginMemoryAllocations;
+    _imp->nbPluginMemoryRecycledAllocations = other._imp->nbPluginMemoryRecycledAllocations;
+    _imp->pluginMemoryAllocated = other._imp->pluginMemoryAllocated;
     _imp->tileSupportEnabled = other._imp->tileSupportEnabled;
     _imp->renderScaleSupportEnabled = other._imp->renderScaleSupportEnabled;
     for (int i = 0; i < 4; ++i) {
@@ -251,6 +262,24 @@ NodeRenderStats::getCacheAccessInfos(int* nbCacheMisses, int* nbCacheHits, int*
     *nbCacheHitButDownscaledImages = _imp->nbCacheHitButDownscaledImages;
 }
 
+void
+NodeRenderStats::addPluginMemoryAllocation(U64 nBytes, bool recycled)
+{
+    ++_imp->nbPluginMemoryAllocations;
+    if (recycled) {
+        ++_imp->nbPluginMemoryRecycledAllocations;
+    }
+    _imp->pluginMemoryAllocated += nBytes;
+}
+
+void
+NodeRenderStats::getPluginMemoryInfos(int* nbAllocations, int* nbRecycledAllocations, U64* nBytesAllocated) const
+{
+    *nbAllocations = _imp->nbPluginMemoryAllocations;
+    *nbRecycledAllocations = _imp->nbPluginMemoryRecycledAllocations;
+    *nBytesAllocated = _imp->pluginMemoryAllocated;
+}
+
 void
 NodeRenderStats::setTilesSupported(bool tilesSupported)
 {
@@ -411,6 +440,18 @@ RenderStats::addCacheInfosForNode(const NodePtr& node,
     stats.addCacheAccessInfo(isCacheMiss, hasDownscaled);
 }
 
+void
+RenderStats::addPluginMemoryInfosForNode(const NodePtr& node,
+                                         U64 nBytes,
+                                         bool recycled)
+{
+    QMutexLocker k(&_imp->lock);
+    assert(_imp->doNodesProfiling);
+    
+    NodeRenderStats& stats = _imp->findOrCreateNodeStats(node);
+    stats.addPluginMemoryAllocation(nBytes, recycled);
+}
+
 void
 RenderStats::addRenderInfosForNode(const NodePtr& node,
                            const NodePtr& identity,
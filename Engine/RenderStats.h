@@ -85,6 +85,9 @@ public:
     void addCacheAccessInfo(bool isCacheMiss, bool hasDownscaled);
     void getCacheAccessInfos(int* nbCacheMisses, int* nbCacheHits, int* nbCacheHitButDownscaledImages) const;
     
+    void addPluginMemoryAllocation(U64 nBytes, bool recycled);
+    void getPluginMemoryInfos(int* nbAllocations, int* nbRecycledAllocations, U64* nBytesAllocated) const;
+    
     void setTilesSupported(bool tilesSupported);
     bool isTilesSupportEnabled() const;
     
@@ -134,6 +137,14 @@ public:
                               bool isCacheMiss,
                               bool hasDownscaled);
     
+    /**
+     * @brief Called when the plug-in of node allocated nBytes through the OpenFX memory suites. recycled is true if the
+     * memory was taken from the PluginMemoryPool instead of being allocated.
+     **/
+    void addPluginMemoryInfosForNode(const NodePtr& node,
+                                     U64 nBytes,
+                                     bool recycled);
+    
     void addRenderInfosForNode(const NodePtr& node,
                         const NodePtr& identity,
                         const std::string& plane,
@@ -1879,8 +1879,50 @@ RotoContext::incrementAge()
 void
 RotoContext::evaluateChange()
 {
+    /*
+     * Report the region of the output damaged since the last evaluation: the union of the damage of the items
+     * whose nodes changed. Adding, removing or re-ordering items may change everything.
+     */
+    std::list< boost::shared_ptr<RotoDrawableItem> > items = getCurvesByRenderOrder(false);
+    std::vector<RotoItemEvaluationState> states;
+    DamageRegion damage;
+    bool sameItems = _imp->lastEvaluationStatesSet && _imp->lastEvaluationStates.size() == items.size();
+    for (std::list< boost::shared_ptr<RotoDrawableItem> >::const_iterator it = items.begin(); it != items.end(); ++it) {
+        RotoItemEvaluationState state;
+        state.item = it->get();
+        NodePtr effectNode = (*it)->getEffectNode();
+        NodePtr mergeNode = (*it)->getMergeNode();
+        state.effectHash = effectNode ? effectNode->getHashValue() : 0;
+        state.mergeHash = mergeNode ? mergeNode->getHashValue() : 0;
+
+        DamageRegion itemDamage = (*it)->takeDamageSinceEvaluation();
+        if (sameItems) {
+            const RotoItemEvaluationState & prev = _imp->lastEvaluationStates[states.size()];
+            if (prev.item != state.item) {
+                sameItems = false;
+            } else if ( (prev.effectHash != state.effectHash) || (prev.mergeHash != state.mergeHash) ) {
+                if ( itemDamage.isEmpty() ) {
+                    ///The item changed without reporting it
+                    itemDamage.setUnknown();
+                }
+                damage.merge(itemDamage);
+            }
+        }
+        states.push_back(state);
+    }
+    if (!sameItems) {
+        damage.setUnknown();
+    } else if ( damage.isEmpty() ) {
+        ///Nothing changed in the items: this is a change of the context itself
+        damage.setUnknown();
+    }
+    _imp->lastEvaluationStatesSet = true;
+    _imp->lastEvaluationStates = states;
+
     _imp->incrementRotoAge();
-    getNode()->getEffectInstance()->incrHashAndEvaluate(true,false);
+    NodePtr node = getNode();
+    node->reportDamagedRegion(damage);
+    node->getEffectInstance()->incrHashAndEvaluate(true,false);
 }
 
 void
@@ -51,6 +51,7 @@
 #include "Engine/AppManager.h"
 #include "Engine/BezierCP.h"
 #include "Engine/Curve.h"
+#include "Engine/DamageHistory.h"
 #include "Engine/EffectInstance.h"
 #include "Engine/Image.h"
 #include "Engine/KnobTypes.h"
@@ -742,6 +743,16 @@ struct RotoDrawableItemPrivate
 #endif
     std::list<KnobPtr > knobs; //< list for easy access to all knobs
 
+    //The bounding box of the shape when the age of the nodes was last incremented, to report the region damaged
+    //by the next change, see RotoDrawableItem::incrementNodesAge()
+    bool lastDamageBboxSet;
+    RectD lastDamageBbox;
+    double lastDamageTime;
+    int lastCompOperator;
+
+    //The damage of the changes since the last RotoContext::evaluateChange()
+    DamageRegion damageSinceEvaluation;
+
     RotoDrawableItemPrivate(bool isPaintingNode)
     : effectNode()
     , mergeNode()
@@ -789,6 +800,11 @@ struct RotoDrawableItemPrivate
     , timeOffset(new KnobInt(NULL, kRotoBrushTimeOffsetParamLabel, 1, false))
     , timeOffsetMode(new KnobChoice(NULL, kRotoBrushTimeOffsetModeParamLabel, 1, false))
     , knobs()
+    , lastDamageBboxSet(false)
+    , lastDamageBbox()
+    , lastDamageTime(0)
+    , lastCompOperator(-1)
+    , damageSinceEvaluation()
     {
         opacity.reset(new KnobDouble(NULL, kRotoOpacityParamLabel, 1, false));
         opacity->setHintToolTip(kRotoOpacityHint);
@@ -1239,6 +1255,16 @@ struct RotoStrokeItemPrivate
     }
 };
 
+/**
+ * @brief The state of the nodes of an item when the context was last evaluated, see RotoContext::evaluateChange()
+ **/
+struct RotoItemEvaluationState
+{
+    const RotoDrawableItem* item;
+    U64 effectHash;
+    U64 mergeHash;
+};
+
 struct RotoContextPrivate
 {
     mutable QMutex rotoContextMutex;
@@ -1341,6 +1367,10 @@ struct RotoContextPrivate
      */
     NodesList globalMergeNodes;
 
+    //The items in render order when the context was last evaluated, to find out which ones changed since then
+    bool lastEvaluationStatesSet;
+    std::vector<RotoItemEvaluationState> lastEvaluationStates;
+
     RotoContextPrivate(const NodePtr& n )
     : rotoContextMutex()
     , isPaintNode(false)
@@ -1354,6 +1384,8 @@ struct RotoContextPrivate
     , doingNeatRender(false)
     , mustDoNeatRender(false)
     , globalMergeNodes()
+    , lastEvaluationStatesSet(false)
+    , lastEvaluationStates()
     {
         EffectInstPtr effect = n->getEffectInstance();
         RotoPaint* isRotoNode = dynamic_cast<RotoPaint*>(effect.get());
@@ -45,6 +45,7 @@ GCC_DIAG_UNUSED_LOCAL_TYPEDEFS_ON
 #include "Engine/RotoContextPrivate.h"
 
 #include "Engine/AppInstance.h"
+#include "Engine/Bezier.h"
 #include "Engine/BezierCP.h"
 #include "Engine/CoonsRegularization.h"
 #include "Engine/FeatherPoint.h"
@@ -636,26 +637,97 @@ RotoDrawableItem::rotoKnobChanged(const KnobPtr& knob, ValueChangedReasonEnum re
 
 }
 
+///True if the result of the merge is B wherever A is transparent and its region of definition is the union of A and B
+static bool
+isMergingOperatorLocalToA(int compOperator)
+{
+    switch ( (MergingFunctionEnum)compOperator ) {
+    case eMergeATop:
+    case eMergeMatte:
+    case eMergeOver:
+    case eMergePlus:
+    case eMergeScreen:
+    case eMergeXOR:
+
+        return true;
+    default:
+
+        return false;
+    }
+}
+
 void
 RotoDrawableItem::incrementNodesAge()
 {
     if (getContext()->getNode()->getApp()->getProject()->isLoadingProject()) {
         return;
     }
+
+    /*
+     * A shape only changes its output within its bounding box: the change damages the union of the bounding boxes
+     * before and after it. The merge only spreads that damage if its operator leaves B untouched outside of A and did
+     * not change. Strokes keep being rendered through the last stroke changes, their damage is unknown.
+     */
+    DamageRegion shapeDamage, mergeDamage;
+    int compOperator = getCompositingOperator();
+    if ( dynamic_cast<Bezier*>(this) ) {
+        double time = getContext()->getTimelineCurrentTime();
+        RectD bbox = getBoundingBox(time);
+        bool inverted = getInverted(time);
+        if ( _imp->lastDamageBboxSet && (_imp->lastDamageTime == time) && !inverted ) {
+            RectD damage = _imp->lastDamageBbox;
+            if ( damage.isNull() ) {
+                damage = bbox;
+            } else if ( !bbox.isNull() ) {
+                damage.merge(bbox);
+            }
+            shapeDamage.merge(damage, false, time);
+            if ( (compOperator == _imp->lastCompOperator) && isMergingOperatorLocalToA(compOperator) ) {
+                mergeDamage = shapeDamage;
+            }
+        }
+        ///An inverted shape covers everything outside of its bounding box
+        _imp->lastDamageBboxSet = !inverted;
+        _imp->lastDamageBbox = bbox;
+        _imp->lastDamageTime = time;
+    }
+    _imp->lastCompOperator = compOperator;
+    if ( shapeDamage.isEmpty() ) {
+        shapeDamage.setUnknown();
+    }
+    if ( mergeDamage.isEmpty() ) {
+        mergeDamage.setUnknown();
+    }
+    _imp->damageSinceEvaluation.merge(mergeDamage);
+
     if (_imp->effectNode) {
+        _imp->effectNode->reportDamagedRegion(shapeDamage);
         _imp->effectNode->incrementKnobsAge();
     }
     if (_imp->mergeNode) {
+        _imp->mergeNode->reportDamagedRegion(mergeDamage);
         _imp->mergeNode->incrementKnobsAge();
     }
     if (_imp->timeOffsetNode) {
+        _imp->timeOffsetNode->reportUnknownDamage();
         _imp->timeOffsetNode->incrementKnobsAge();
     }
     if (_imp->frameHoldNode) {
+        _imp->frameHoldNode->reportUnknownDamage();
         _imp->frameHoldNode->incrementKnobsAge();
     }
 }
 
+DamageRegion
+RotoDrawableItem::takeDamageSinceEvaluation()
+{
+    DamageRegion ret = _imp->damageSinceEvaluation;
+
+    _imp->damageSinceEvaluation.clear();
+
+    return ret;
+}
+
 NodePtr
 RotoDrawableItem::getEffectNode() const
 {
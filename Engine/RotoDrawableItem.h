@@ -84,6 +84,12 @@ public:
     void setNodesThreadSafetyForRotopainting();
     
     void incrementNodesAge();
+
+    /**
+     * @brief Returns the region of the output of the merge node damaged by the changes since the last call, see
+     * RotoContext::evaluateChange()
+     **/
+    DamageRegion takeDamageSinceEvaluation();
     
     void refreshNodesConnections();
 
@@ -244,6 +244,27 @@ Settings::initializeKnobsGeneral()
     _useThreadPool->setAnimationEnabled(false);
     _generalTab->addKnob(_useThreadPool);
 
+    _threadPoolAffinity = AppManager::createKnob<KnobChoice>(this, "Thread-pool CPU affinity");
+    _threadPoolAffinity->setName("threadPoolAffinity");
+    _threadPoolAffinity->setAnimationEnabled(false);
+    {
+        std::vector<std::string> affinityModes;
+        std::vector<std::string> helpStringsAffinityModes;
+        affinityModes.push_back("None");
+        helpStringsAffinityModes.push_back("The threads may run on any CPU.");
+        affinityModes.push_back("NUMA node");
+        helpStringsAffinityModes.push_back("Each thread stays on the CPUs of one NUMA node (processor socket), close to the memory it uses. "
+                                           "This has no effect on machines with a single NUMA node.");
+        affinityModes.push_back("CPU");
+        helpStringsAffinityModes.push_back("Each thread stays on a single CPU. This may be slower if other processes are running on the same CPUs.");
+        _threadPoolAffinity->populateChoices(affinityModes, helpStringsAffinityModes);
+    }
+    _threadPoolAffinity->setHintToolTip("Controls on which CPUs the threads of the thread-pool used by the effects run. "
+                                        "On machines with several processor sockets, keeping the threads on the CPUs of a socket "
+                                        "avoids that they access the memory of the other socket, which is much slower. "
+                                        "Only used when \"Effects use thread-pool\" is checked.");
+    _generalTab->addKnob(_threadPoolAffinity);
+
     _nThreadsPerEffect = AppManager::createKnob<KnobInt>(this, "Max threads usable per effect (0=\"guess\")");
     _nThreadsPerEffect->setName("nThreadsPerEffect");
     _nThreadsPerEffect->setAnimationEnabled(false);
@@ -355,6 +376,29 @@ Settings::initializeKnobsGeneral()
     _activateTransformConcatenationSupport->setAnimationEnabled(false);
     _activateTransformConcatenationSupport->setName("transformCatSupport");
     _generalTab->addKnob(_activateTransformConcatenationSupport);
+
+    _transformConcatenationFilter = AppManager::createKnob<KnobChoice>(this, "Concatenated transforms filter");
+    _transformConcatenationFilter->setName("transformCatFilter");
+    _transformConcatenationFilter->setAnimationEnabled(false);
+    {
+        std::vector<std::string> filters;
+        std::vector<std::string> helpStringsFilters;
+        filters.push_back("Plug-in");
+        helpStringsFilters.push_back("The last transform effect of the chain renders the image with its own filter and motion blur.");
+        filters.push_back("Bilinear");
+        helpStringsFilters.push_back("Bilinear interpolation: fast, slightly soft.");
+        filters.push_back("Cubic");
+        helpStringsFilters.push_back("Keys cubic interpolation: sharper than bilinear.");
+        filters.push_back("Lanczos");
+        helpStringsFilters.push_back("Lanczos interpolation with 3 lobes: the sharpest, may ring on edges.");
+        _transformConcatenationFilter->populateChoices(filters, helpStringsFilters);
+    }
+    _transformConcatenationFilter->setHintToolTip("When not set to Plug-in, " NATRON_APPLICATION_NAME " applies the concatenated transforms "
+                                                  "itself, in a single pass with the selected filter, instead of calling the render action "
+                                                  "of the last transform effect. The filter and motion blur parameters of the transform "
+                                                  "effects are then ignored, except when motion blur is enabled, in which case the effect "
+                                                  "renders the image itself. Only used when \"Transforms concatenation support\" is checked.");
+    _generalTab->addKnob(_transformConcatenationFilter);
     
     _hostName = AppManager::createKnob<KnobChoice>(this, "Appear to plug-ins as");
     _hostName->setName("pluginHostName");
@@ -871,6 +915,15 @@ Settings::initializeKnobsViewers()
                                           "is unchecked.");
     _viewersTab->addKnob(_enableProgressReport);
     
+    _realtimePlayback = AppManager::createKnob<KnobBool>(this, "Realtime playback (drop frames)");
+    _realtimePlayback->setName("realtimePlayback");
+    _realtimePlayback->setAnimationEnabled(false);
+    _realtimePlayback->setHintToolTip("When checked, playback follows the clock at the frame rate of the viewer: when rendering "
+                                      "cannot keep up, frames are skipped instead of playing slower. The skipped frames are still "
+                                      "rendered and cached so that they can be played the next time. The number of frames "
+                                      "dropped is displayed next to the frame rate in the viewer.");
+    _viewersTab->addKnob(_realtimePlayback);
+    
 }
 
 void
@@ -1097,6 +1150,16 @@ Settings::initializeKnobsCaching()
                                                                                                                            "which have multiple outputs, or their parameter \"Force caching\" checked or if one of its "
                                                                                                                            "output has its settings panel opened.");
     _cachingTab->addKnob(_aggressiveCaching);
+
+    _persistActionsCache = AppManager::createKnob<KnobBool>(this, "Keep nodes regions of definition across sessions");
+    _persistActionsCache->setName("persistActionsCache");
+    _persistActionsCache->setAnimationEnabled(false);
+    _persistActionsCache->setHintToolTip("When checked, the region of definition and frame range computed by each node are saved "
+                                         "along with the disk caches when " NATRON_APPLICATION_NAME " exits. When a project is opened "
+                                         "again, they are reused instead of asking the plug-ins to compute them again, which speeds-up "
+                                         "the first render of large projects.\n"
+                                         "Readers are never cached this way since their results depend on the content of the files they read.");
+    _cachingTab->addKnob(_persistActionsCache);
     
     _maxRAMPercent = AppManager::createKnob<KnobInt>(this, "Maximum amount of RAM memory used for caching (% of total RAM)");
     _maxRAMPercent->setName("maxRAMPercent");
@@ -1391,6 +1454,7 @@ Settings::setDefaultValues()
 #endif
     
     _useThreadPool->setDefaultValue(true);
+    _threadPoolAffinity->setDefaultValue(1);
     _nThreadsPerEffect->setDefaultValue(0);
     _renderInSeparateProcess->setDefaultValue(false,0);
     _queueRenders->setDefaultValue(false);
@@ -1402,6 +1466,7 @@ Settings::setDefaultValues()
     _renderOnEditingFinished->setDefaultValue(false);
     _activateRGBSupport->setDefaultValue(true);
     _activateTransformConcatenationSupport->setDefaultValue(true);
+    _transformConcatenationFilter->setDefaultValue(0);
     _extraPluginPaths->setDefaultValue("",0);
     _preferBundledPlugins->setDefaultValue(true);
     _loadBundledPlugins->setDefaultValue(true);
@@ -1420,11 +1485,13 @@ Settings::setDefaultValues()
     _autoProxyWhenScrubbingTimeline->setDefaultValue(true);
     _autoProxyLevel->setDefaultValue(1);
     _enableProgressReport->setDefaultValue(false);
+    _realtimePlayback->setDefaultValue(false);
     
     _warnOcioConfigKnobChanged->setDefaultValue(true);
     _ocioStartupCheck->setDefaultValue(true);
 
     _aggressiveCaching->setDefaultValue(false);
+    _persistActionsCache->setDefaultValue(false);
     _maxRAMPercent->setDefaultValue(50,0);
     _maxPlayBackPercent->setDefaultValue(25,0);
     _unreachableRAMPercent->setDefaultValue(5);
@@ -3031,6 +3098,19 @@ Settings::isTransformConcatenationEnabled() const
     return _activateTransformConcatenationSupport->getValue();
 }
 
+bool
+Settings::getConcatenatedTransformsFilter(ResampleFilterEnum* filter) const
+{
+    int index = _transformConcatenationFilter->getValue();
+
+    if (index <= 0) {
+        return false;
+    }
+    *filter = (ResampleFilterEnum)(index - 1);
+
+    return true;
+}
+
 bool
 Settings::useGlobalThreadPool() const
 {
@@ -3043,6 +3123,12 @@ Settings::setUseGlobalThreadPool(bool use)
     _useThreadPool->setValue(use);
 }
 
+CpuAffinityModeEnum
+Settings::getMultiThreadAffinityMode() const
+{
+    return (CpuAffinityModeEnum)_threadPoolAffinity->getValue();
+}
+
 bool
 Settings::isMergeAutoConnectingToAInput() const
 {
@@ -3129,6 +3215,12 @@ Settings::isAggressiveCachingEnabled() const
     return _aggressiveCaching->getValue();
 }
 
+bool
+Settings::isActionsCachePersistent() const
+{
+    return _persistActionsCache->getValue();
+}
+
 bool
 Settings::isAutoTurboEnabled() const
 {
@@ -3532,6 +3624,12 @@ Settings::isInViewerProgressReportEnabled() const
     return _enableProgressReport->getValue();
 }
 
+bool
+Settings::isRealtimePlaybackEnabled() const
+{
+    return _realtimePlayback->getValue();
+}
+
 bool
 Settings::isDefaultAppearanceOutdated() const
 {
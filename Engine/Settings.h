@@ -32,6 +32,8 @@
 #include "Global/Macros.h"
 #include "Global/GlobalDefines.h"
 
+#include "Engine/CpuTopology.h"
+#include "Engine/ImageResampler.h"
 #include "Engine/Knob.h"
 #include "Engine/ViewIdx.h"
 #include "Engine/EngineFwd.h"
@@ -120,6 +122,8 @@ public:
     
     void setUseGlobalThreadPool(bool use) ;
 
+    CpuAffinityModeEnum getMultiThreadAffinityMode() const;
+
     std::string getReaderPluginIDForFileType(const std::string & extension);
     std::string getWriterPluginIDForFileType(const std::string & extension);
 
@@ -242,6 +246,12 @@ public:
     bool areRGBPixelComponentsSupported() const;
     
     bool isTransformConcatenationEnabled() const;
+
+    /**
+     * @brief Returns true if the host applies the concatenated transforms with the returned filter rather than
+     * letting the last transform effect of the chain render them.
+     **/
+    bool getConcatenatedTransformsFilter(ResampleFilterEnum* filter) const;
     
     bool isMergeAutoConnectingToAInput() const;
     
@@ -268,6 +278,8 @@ public:
     bool notifyOnFileChange() const;
     
     bool isAggressiveCachingEnabled() const;
+
+    bool isActionsCachePersistent() const;
     
     bool isAutoTurboEnabled() const;
     
@@ -344,6 +356,8 @@ public:
     
     bool isInViewerProgressReportEnabled() const;
     
+    bool isRealtimePlaybackEnabled() const;
+    
     bool isDefaultAppearanceOutdated() const;
     void restoreDefaultAppearance();
     
@@ -391,6 +405,7 @@ private:
     boost::shared_ptr<KnobInt> _numberOfThreads;
     boost::shared_ptr<KnobInt> _numberOfParallelRenders;
     boost::shared_ptr<KnobBool> _useThreadPool;
+    boost::shared_ptr<KnobChoice> _threadPoolAffinity;
     boost::shared_ptr<KnobInt> _nThreadsPerEffect;
     boost::shared_ptr<KnobBool> _renderInSeparateProcess;
     boost::shared_ptr<KnobBool> _queueRenders;
@@ -404,6 +419,7 @@ private:
     boost::shared_ptr<KnobBool> _renderOnEditingFinished;
     boost::shared_ptr<KnobBool> _activateRGBSupport;
     boost::shared_ptr<KnobBool> _activateTransformConcatenationSupport;
+    boost::shared_ptr<KnobChoice> _transformConcatenationFilter;
     boost::shared_ptr<KnobChoice> _hostName;
     boost::shared_ptr<KnobString> _customHostName;
     
@@ -416,6 +432,7 @@ private:
     boost::shared_ptr<KnobPage> _cachingTab;
 
     boost::shared_ptr<KnobBool> _aggressiveCaching;
+    boost::shared_ptr<KnobBool> _persistActionsCache;
     ///The percentage of the value held by _maxRAMPercent to dedicate to playback cache (viewer cache's in-RAM portion) only
     boost::shared_ptr<KnobInt> _maxPlayBackPercent;
     boost::shared_ptr<KnobString> _maxPlaybackLabel;
@@ -450,6 +467,7 @@ private:
     boost::shared_ptr<KnobBool> _autoProxyWhenScrubbingTimeline;
     boost::shared_ptr<KnobChoice> _autoProxyLevel;
     boost::shared_ptr<KnobBool> _enableProgressReport;
+    boost::shared_ptr<KnobBool> _realtimePlayback;
     
     boost::shared_ptr<KnobPage> _nodegraphTab;
     boost::shared_ptr<KnobBool> _autoTurbo;
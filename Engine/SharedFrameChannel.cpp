@@ -0,0 +1,732 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "SharedFrameChannel.h"
+
+#include <cassert>
+#include <cerrno>
+#include <cstring> // memcpy
+#include <set>
+#include <sstream>
+
+#ifdef __NATRON_UNIX__
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+///Identifies the index segment and the version of its layout
+#define NATRON_SHARED_FRAME_CHANNEL_MAGIC 0x4e534643
+#define NATRON_SHARED_FRAME_CHANNEL_VERSION 1
+
+NATRON_NAMESPACE_ENTER;
+
+#ifdef __NATRON_UNIX__
+
+namespace {
+
+enum SharedFrameStateEnum
+{
+    eSharedFrameStateFree = 0, //< the slot is not used
+    eSharedFrameStateWriting, //< the segment is being filled by the publishing process
+    eSharedFrameStateReady //< the frame is available, the index holds a reference on it
+};
+
+struct SharedFrameReader
+{
+    long long pid;
+    int refs;
+};
+
+/**
+ * @brief A slot of the index. Everything in the index must be plain old data, the same in all processes.
+ **/
+struct SharedFrameEntry
+{
+    int state;
+
+    //Names the segment of the frame, never re-used by the channel
+    U64 serial;
+
+    long long writerPid;
+
+    //The reference of the index while the frame is ready plus the references of the readers
+    int refCount;
+    SharedFrameReader readers[NATRON_SHARED_FRAME_CHANNEL_MAX_READERS];
+
+    //The value of SharedFrameIndex::clock when the frame was last published or acquired
+    U64 lastAccess;
+
+    SharedFrameInfo info;
+};
+
+struct SharedFrameIndex
+{
+    unsigned int magic;
+    unsigned int version;
+
+    //Protects everything below, shared between the processes
+    pthread_mutex_t mutex;
+
+    long long ownerPid;
+
+    //Set to 0 when the owner is destroyed: no frame may be published any longer
+    int ownerAlive;
+
+    U64 nextSerial;
+    U64 clock;
+    U64 maxBytes;
+    U64 usedBytes;
+
+    SharedFrameEntry entries[NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES];
+};
+
+bool
+isProcessAlive(long long pid)
+{
+    return ( kill( (pid_t)pid, 0 ) == 0 ) || (errno == EPERM);
+}
+} // anon namespace
+
+struct SharedFrameChannelPrivate
+{
+    std::string name;
+    bool owner;
+    SharedFrameIndex* index;
+    long long pid;
+
+    SharedFrameChannelPrivate()
+        : name()
+        , owner(false)
+        , index(0)
+        , pid( (long long)getpid() )
+    {
+    }
+
+    std::string getFrameSegmentName(U64 serial) const
+    {
+        std::stringstream ss;
+
+        ss << name << '_' << serial;
+
+        return ss.str();
+    }
+
+    void lock()
+    {
+#ifdef __NATRON_LINUX__
+        if (pthread_mutex_lock(&index->mutex) == EOWNERDEAD) {
+            ///A process died while holding the lock
+            pthread_mutex_consistent(&index->mutex);
+            releaseDeadProcesses();
+        }
+#else
+        pthread_mutex_lock(&index->mutex);
+#endif
+    }
+
+    void unlock()
+    {
+        pthread_mutex_unlock(&index->mutex);
+    }
+
+    ///Must be called with the lock held
+    void freeEntry(SharedFrameEntry & entry)
+    {
+        shm_unlink( getFrameSegmentName(entry.serial).c_str() );
+        assert(index->usedBytes >= entry.info.dataSize);
+        index->usedBytes -= entry.info.dataSize;
+        std::memset( &entry, 0, sizeof(SharedFrameEntry) );
+    }
+
+    ///Must be called with the lock held
+    void releaseProcess(long long processPid)
+    {
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            SharedFrameEntry & entry = index->entries[i];
+            if (entry.state == eSharedFrameStateWriting) {
+                if (entry.writerPid == processPid) {
+                    freeEntry(entry);
+                }
+                continue;
+            }
+            if (entry.state != eSharedFrameStateReady) {
+                continue;
+            }
+            for (int r = 0; r < NATRON_SHARED_FRAME_CHANNEL_MAX_READERS; ++r) {
+                SharedFrameReader & reader = entry.readers[r];
+                if ( (reader.refs > 0) && (reader.pid == processPid) ) {
+                    entry.refCount -= reader.refs;
+                    reader.pid = 0;
+                    reader.refs = 0;
+                }
+            }
+        }
+    }
+
+    ///Must be called with the lock held
+    void releaseDeadProcesses()
+    {
+        std::set<long long> pids;
+
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            const SharedFrameEntry & entry = index->entries[i];
+            if (entry.state == eSharedFrameStateWriting) {
+                pids.insert(entry.writerPid);
+            }
+            for (int r = 0; r < NATRON_SHARED_FRAME_CHANNEL_MAX_READERS; ++r) {
+                if (entry.readers[r].refs > 0) {
+                    pids.insert(entry.readers[r].pid);
+                }
+            }
+        }
+        for (std::set<long long>::const_iterator it = pids.begin(); it != pids.end(); ++it) {
+            if ( !isProcessAlive(*it) ) {
+                releaseProcess(*it);
+            }
+        }
+    }
+
+    /**
+     * @brief Removes the least recently used frame which is not being read. Returns false if there is none.
+     * Must be called with the lock held.
+     **/
+    bool removeLeastRecentlyUsed()
+    {
+        SharedFrameEntry* lru = 0;
+
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            SharedFrameEntry & entry = index->entries[i];
+            if ( (entry.state == eSharedFrameStateReady) && (entry.refCount == 1) &&
+                 ( !lru || (entry.lastAccess < lru->lastAccess) ) ) {
+                lru = &entry;
+            }
+        }
+        if (!lru) {
+            return false;
+        }
+        freeEntry(*lru);
+
+        return true;
+    }
+
+    ///Must be called with the lock held
+    int findFreeSlot() const
+    {
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            if (index->entries[i].state == eSharedFrameStateFree) {
+                return i;
+            }
+        }
+
+        return -1;
+    }
+
+    bool mapIndex(int fd)
+    {
+        void* ptr = mmap(0, sizeof(SharedFrameIndex), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+        if (ptr == MAP_FAILED) {
+            return false;
+        }
+        index = (SharedFrameIndex*)ptr;
+
+        return true;
+    }
+};
+
+SharedFrame::SharedFrame(SharedFrameChannel* channel,
+                         int slot,
+                         U64 serial,
+                         const SharedFrameInfo & info,
+                         const void* data)
+    : _channel(channel)
+    , _slot(slot)
+    , _serial(serial)
+    , _info(info)
+    , _data(data)
+{
+}
+
+SharedFrame::~SharedFrame()
+{
+    munmap(const_cast<void*>(_data), _info.dataSize);
+    _channel->release(_slot, _serial);
+}
+
+SharedFrameChannel::SharedFrameChannel()
+    : _imp( new SharedFrameChannelPrivate() )
+{
+}
+
+SharedFrameChannel::~SharedFrameChannel()
+{
+    if (!_imp->index) {
+        return;
+    }
+    if (_imp->owner) {
+        ///Unlink everything: the frames mapped by other processes stay valid until they unmap them
+        _imp->lock();
+        _imp->index->ownerAlive = 0;
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            SharedFrameEntry & entry = _imp->index->entries[i];
+            if (entry.state != eSharedFrameStateFree) {
+                _imp->freeEntry(entry);
+            }
+        }
+        _imp->unlock();
+        shm_unlink( _imp->name.c_str() );
+    } else {
+        _imp->lock();
+        _imp->releaseProcess(_imp->pid);
+        _imp->unlock();
+    }
+    munmap( _imp->index, sizeof(SharedFrameIndex) );
+}
+
+bool
+SharedFrameChannel::create(std::size_t maxBytes)
+{
+    assert(!_imp->index);
+    static int channelsCount = 0;
+    std::string name;
+    {
+        std::stringstream ss;
+        ss << "/" NATRON_APPLICATION_NAME "FC_" << _imp->pid << '_' << channelsCount++;
+        name = ss.str();
+    }
+
+    ///A segment with this name can only be left by a dead process which had the same pid
+    shm_unlink( name.c_str() );
+    int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    if ( ( ftruncate( fd, sizeof(SharedFrameIndex) ) != 0 ) || !_imp->mapIndex(fd) ) {
+        close(fd);
+        shm_unlink( name.c_str() );
+
+        return false;
+    }
+    close(fd);
+
+    SharedFrameIndex* index = _imp->index;
+    std::memset( index, 0, sizeof(SharedFrameIndex) );
+
+    pthread_mutexattr_t attr;
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_setpshared(&attr, PTHREAD_PROCESS_SHARED);
+#ifdef __NATRON_LINUX__
+    ///So that the lock is not held forever by a process which crashed
+    pthread_mutexattr_setrobust(&attr, PTHREAD_MUTEX_ROBUST);
+#endif
+    int ret = pthread_mutex_init(&index->mutex, &attr);
+    pthread_mutexattr_destroy(&attr);
+    if (ret != 0) {
+        munmap( index, sizeof(SharedFrameIndex) );
+        _imp->index = 0;
+        shm_unlink( name.c_str() );
+
+        return false;
+    }
+
+    index->ownerPid = _imp->pid;
+    index->ownerAlive = 1;
+    index->nextSerial = 1;
+    index->clock = 1;
+    index->maxBytes = maxBytes;
+    index->usedBytes = 0;
+    index->version = NATRON_SHARED_FRAME_CHANNEL_VERSION;
+    index->magic = NATRON_SHARED_FRAME_CHANNEL_MAGIC;
+
+    _imp->name = name;
+    _imp->owner = true;
+
+    return true;
+} // SharedFrameChannel::create
+
+bool
+SharedFrameChannel::attach(const std::string & name)
+{
+    assert(!_imp->index);
+    int fd = shm_open(name.c_str(), O_RDWR, 0600);
+    if (fd == -1) {
+        return false;
+    }
+    struct stat st;
+    if ( (fstat(fd, &st) != 0) || ( st.st_size != (off_t)sizeof(SharedFrameIndex) ) || !_imp->mapIndex(fd) ) {
+        close(fd);
+
+        return false;
+    }
+    close(fd);
+
+    if ( (_imp->index->magic != NATRON_SHARED_FRAME_CHANNEL_MAGIC) || (_imp->index->version != NATRON_SHARED_FRAME_CHANNEL_VERSION) ) {
+        munmap( _imp->index, sizeof(SharedFrameIndex) );
+        _imp->index = 0;
+
+        return false;
+    }
+    _imp->name = name;
+    _imp->owner = false;
+
+    return true;
+}
+
+bool
+SharedFrameChannel::isOwner() const
+{
+    return _imp->owner;
+}
+
+const std::string &
+SharedFrameChannel::getName() const
+{
+    return _imp->name;
+}
+
+bool
+SharedFrameChannel::publish(const SharedFrameInfo & info,
+                            const void* data)
+{
+    if ( !_imp->index || (info.dataSize == 0) ) {
+        return false;
+    }
+
+    ///Reserve a slot, removing the least recently used frames if needed
+    int slot;
+    U64 serial;
+    {
+        _imp->lock();
+        SharedFrameIndex* index = _imp->index;
+        if ( !index->ownerAlive || (info.dataSize > index->maxBytes) ) {
+            _imp->unlock();
+
+            return false;
+        }
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            const SharedFrameEntry & entry = index->entries[i];
+            if ( ( (entry.state == eSharedFrameStateWriting) || (entry.state == eSharedFrameStateReady) ) &&
+                 (entry.info.keyHash == info.keyHash) && (entry.info.mipMapLevel == info.mipMapLevel) ) {
+                _imp->unlock();
+
+                return false;
+            }
+        }
+        bool deadProcessesReleased = false;
+        for (;;) {
+            slot = _imp->findFreeSlot();
+            if ( (slot != -1) && (index->usedBytes + info.dataSize <= index->maxBytes) ) {
+                break;
+            }
+            if ( !_imp->removeLeastRecentlyUsed() ) {
+                if (deadProcessesReleased) {
+                    _imp->unlock();
+
+                    return false;
+                }
+                ///The frames may be held by processes which crashed
+                _imp->releaseDeadProcesses();
+                deadProcessesReleased = true;
+            }
+        }
+        SharedFrameEntry & entry = index->entries[slot];
+        entry.state = eSharedFrameStateWriting;
+        entry.serial = index->nextSerial++;
+        entry.writerPid = _imp->pid;
+        entry.refCount = 0;
+        entry.info = info;
+        index->usedBytes += info.dataSize;
+        serial = entry.serial;
+        _imp->unlock();
+    }
+
+    ///Fill the segment without holding the lock
+    std::string segmentName = _imp->getFrameSegmentName(serial);
+    bool ok = false;
+    int fd = shm_open(segmentName.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd != -1) {
+        if (ftruncate(fd, info.dataSize) == 0) {
+            void* ptr = mmap(0, info.dataSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (ptr != MAP_FAILED) {
+                std::memcpy(ptr, data, info.dataSize);
+                munmap(ptr, info.dataSize);
+                ok = true;
+            }
+        }
+        close(fd);
+    }
+
+    _imp->lock();
+    SharedFrameEntry & entry = _imp->index->entries[slot];
+    bool stillReserved = (entry.state == eSharedFrameStateWriting) && (entry.serial == serial);
+    if ( ok && stillReserved && _imp->index->ownerAlive ) {
+        entry.state = eSharedFrameStateReady;
+        entry.refCount = 1;
+        entry.lastAccess = _imp->index->clock++;
+    } else {
+        ok = false;
+        if (stillReserved) {
+            _imp->freeEntry(entry);
+        } else {
+            shm_unlink( segmentName.c_str() );
+        }
+    }
+    _imp->unlock();
+
+    return ok;
+} // SharedFrameChannel::publish
+
+SharedFramePtr
+SharedFrameChannel::acquire(U64 keyHash,
+                            unsigned int mipMapLevel)
+{
+    SharedFramePtr ret;
+
+    if (!_imp->index) {
+        return ret;
+    }
+
+    int slot = -1;
+    U64 serial = 0;
+    SharedFrameInfo info;
+    {
+        _imp->lock();
+        for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+            const SharedFrameEntry & entry = _imp->index->entries[i];
+            if ( (entry.state == eSharedFrameStateReady) && (entry.info.keyHash == keyHash) && (entry.info.mipMapLevel == mipMapLevel) ) {
+                slot = i;
+                break;
+            }
+        }
+        if (slot == -1) {
+            _imp->unlock();
+
+            return ret;
+        }
+
+        SharedFrameEntry & entry = _imp->index->entries[slot];
+        SharedFrameReader* reader = 0;
+        for (int r = 0; r < NATRON_SHARED_FRAME_CHANNEL_MAX_READERS; ++r) {
+            SharedFrameReader & cur = entry.readers[r];
+            if ( (cur.refs > 0) && (cur.pid == _imp->pid) ) {
+                reader = &cur;
+                break;
+            } else if ( !reader && (cur.refs == 0) ) {
+                reader = &cur;
+            }
+        }
+        if (!reader) {
+            ///Too many processes are reading this frame
+            _imp->unlock();
+
+            return ret;
+        }
+        reader->pid = _imp->pid;
+        ++reader->refs;
+        ++entry.refCount;
+        entry.lastAccess = _imp->index->clock++;
+        serial = entry.serial;
+        info = entry.info;
+        _imp->unlock();
+    }
+
+    ///Map the segment without holding the lock: the reference keeps it alive
+    void* ptr = MAP_FAILED;
+    int fd = shm_open(_imp->getFrameSegmentName(serial).c_str(), O_RDONLY, 0600);
+    if (fd != -1) {
+        ptr = mmap(0, info.dataSize, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+    }
+    if (ptr == MAP_FAILED) {
+        release(slot, serial);
+
+        return ret;
+    }
+    ret.reset( new SharedFrame(this, slot, serial, info, ptr) );
+
+    return ret;
+} // SharedFrameChannel::acquire
+
+void
+SharedFrameChannel::release(int slot,
+                            U64 serial)
+{
+    _imp->lock();
+    SharedFrameEntry & entry = _imp->index->entries[slot];
+    if ( (entry.serial == serial) && (entry.state == eSharedFrameStateReady) ) {
+        for (int r = 0; r < NATRON_SHARED_FRAME_CHANNEL_MAX_READERS; ++r) {
+            SharedFrameReader & reader = entry.readers[r];
+            if ( (reader.refs > 0) && (reader.pid == _imp->pid) ) {
+                --reader.refs;
+                --entry.refCount;
+                break;
+            }
+        }
+    }
+    _imp->unlock();
+}
+
+void
+SharedFrameChannel::releaseProcess(long long pid)
+{
+    if (!_imp->index) {
+        return;
+    }
+    _imp->lock();
+    _imp->releaseProcess(pid);
+    _imp->unlock();
+}
+
+int
+SharedFrameChannel::getFramesCount() const
+{
+    if (!_imp->index) {
+        return 0;
+    }
+    int ret = 0;
+    _imp->lock();
+    for (int i = 0; i < NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES; ++i) {
+        if (_imp->index->entries[i].state == eSharedFrameStateReady) {
+            ++ret;
+        }
+    }
+    _imp->unlock();
+
+    return ret;
+}
+
+std::size_t
+SharedFrameChannel::getUsedBytes() const
+{
+    if (!_imp->index) {
+        return 0;
+    }
+    _imp->lock();
+    std::size_t ret = _imp->index->usedBytes;
+    _imp->unlock();
+
+    return ret;
+}
+
+#else // !__NATRON_UNIX__
+
+struct SharedFrameChannelPrivate
+{
+    std::string name;
+};
+
+SharedFrame::SharedFrame(SharedFrameChannel* channel,
+                         int slot,
+                         U64 serial,
+                         const SharedFrameInfo & info,
+                         const void* data)
+    : _channel(channel)
+    , _slot(slot)
+    , _serial(serial)
+    , _info(info)
+    , _data(data)
+{
+}
+
+SharedFrame::~SharedFrame()
+{
+}
+
+SharedFrameChannel::SharedFrameChannel()
+    : _imp( new SharedFrameChannelPrivate() )
+{
+}
+
+SharedFrameChannel::~SharedFrameChannel()
+{
+}
+
+bool
+SharedFrameChannel::create(std::size_t /*maxBytes*/)
+{
+    return false;
+}
+
+bool
+SharedFrameChannel::attach(const std::string & /*name*/)
+{
+    return false;
+}
+
+bool
+SharedFrameChannel::isOwner() const
+{
+    return false;
+}
+
+const std::string &
+SharedFrameChannel::getName() const
+{
+    return _imp->name;
+}
+
+bool
+SharedFrameChannel::publish(const SharedFrameInfo & /*info*/,
+                            const void* /*data*/)
+{
+    return false;
+}
+
+SharedFramePtr
+SharedFrameChannel::acquire(U64 /*keyHash*/,
+                            unsigned int /*mipMapLevel*/)
+{
+    return SharedFramePtr();
+}
+
+void
+SharedFrameChannel::release(int /*slot*/,
+                            U64 /*serial*/)
+{
+}
+
+void
+SharedFrameChannel::releaseProcess(long long /*pid*/)
+{
+}
+
+int
+SharedFrameChannel::getFramesCount() const
+{
+    return 0;
+}
+
+std::size_t
+SharedFrameChannel::getUsedBytes() const
+{
+    return 0;
+}
+
+#endif // __NATRON_UNIX__
+
+NATRON_NAMESPACE_EXIT;
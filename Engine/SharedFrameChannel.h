@@ -0,0 +1,204 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef SHAREDFRAMECHANNEL_H
+#define SHAREDFRAMECHANNEL_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstddef>
+#include <string>
+
+#include "Global/Macros.h"
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/scoped_ptr.hpp>
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/EngineFwd.h"
+
+///The maximum number of frames in the channel, whatever their size
+#define NATRON_SHARED_FRAME_CHANNEL_MAX_FRAMES 256
+
+///The maximum number of processes reading the same frame at once
+#define NATRON_SHARED_FRAME_CHANNEL_MAX_READERS 8
+
+///The fraction of the node cache size the frames of a channel created by the application may use
+#define NATRON_SHARED_FRAME_CHANNEL_CACHE_FRACTION 0.25
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief What a process needs to know about a frame of the channel to put it in its cache.
+ * The frame is identified by the hash of its image key (which includes the node hash, the time and the view)
+ * and its mipmap level. It must be plain old data: it is stored as is in the shared memory.
+ **/
+struct SharedFrameInfo
+{
+    U64 keyHash; //< ImageKey::getHash()
+    U64 nodeHash;
+    double time;
+    int view;
+    unsigned int mipMapLevel;
+
+    double rod[4]; //< canonical x1, y1, x2, y2
+    int bounds[4]; //< pixel x1, y1, x2, y2 of the data
+    double pixelAspect;
+    int isRodProjectFormat;
+    int nComps; //< the frame is always of the color plane
+    int bitDepth; //< ImageBitDepthEnum
+    int premult; //< ImagePremultiplicationEnum
+    int fielding; //< ImageFieldingOrderEnum
+
+    std::size_t dataSize; //< the size of the pixels, packed rows of the bounds
+};
+
+/**
+ * @brief A frame of the channel mapped in the memory of this process. The frame stays in the channel while it is
+ * mapped, it is released when the last reference to this object goes away.
+ **/
+class SharedFrame
+{
+public:
+
+    ~SharedFrame();
+
+    const SharedFrameInfo & getInfo() const
+    {
+        return _info;
+    }
+
+    const void* getData() const
+    {
+        return _data;
+    }
+
+private:
+
+    friend class SharedFrameChannel;
+
+    SharedFrame(SharedFrameChannel* channel,
+                int slot,
+                U64 serial,
+                const SharedFrameInfo & info,
+                const void* data);
+
+    SharedFrameChannel* _channel;
+    int _slot;
+    U64 _serial;
+    SharedFrameInfo _info;
+    const void* _data;
+};
+
+typedef boost::shared_ptr<SharedFrame> SharedFramePtr;
+
+/**
+ * @brief Exchanges rendered frames between processes through POSIX shared memory, so that a background render
+ * process can hand its frames to the cache of the GUI process (or of other render processes) without going
+ * through files.
+ *
+ * The channel is created by one process, the owner, and other processes attach to it by its name
+ * (see ProcessHandler, which passes it to the processes it starts with --frameChannel).
+ * It is made of an index segment, which lists the frames keyed by the hash of their image key and their mipmap
+ * level, and of one segment per frame holding its pixels.
+ *
+ * The segments of the frames are reference counted: the index holds a reference on each available frame and each
+ * process reading it holds another one until its SharedFrame is destroyed. When the channel is full, the least
+ * recently used frames which are not being read are removed and their segment unlinked.
+ * The references are counted per process, so that those of a process which died can be dropped (see releaseProcess()):
+ * this is done when a process started by a ProcessHandler ends, when the channel is full and whenever a process finds
+ * the index lock abandoned by a dead process.
+ * When the owner is destroyed, all the segments are unlinked: the frames still mapped by other processes stay
+ * valid until they are released and no frame can be published any longer.
+ *
+ * Shared memory is only supported on Unix: on other systems create() and attach() fail.
+ * All functions are thread-safe.
+ **/
+struct SharedFrameChannelPrivate;
+class SharedFrameChannel
+{
+public:
+
+    SharedFrameChannel();
+
+    ~SharedFrameChannel();
+
+    /**
+     * @brief Creates a new channel owned by this process, whose frames may use at most maxBytes.
+     * Returns false on failure.
+     **/
+    bool create(std::size_t maxBytes);
+
+    /**
+     * @brief Attaches to the channel created by another process. Returns false on failure.
+     **/
+    bool attach(const std::string & name);
+
+    bool isOwner() const;
+
+    /**
+     * @brief The name to pass to attach() in another process
+     **/
+    const std::string & getName() const;
+
+    /**
+     * @brief Copies a frame to the channel. Returns false if it is already in the channel, if the channel is full of
+     * frames being read or if the shared memory could not be allocated.
+     **/
+    bool publish(const SharedFrameInfo & info, const void* data);
+
+    /**
+     * @brief Returns the frame with the given key hash and mipmap level mapped in this process, or NULL if there is none.
+     **/
+    SharedFramePtr acquire(U64 keyHash, unsigned int mipMapLevel);
+
+    /**
+     * @brief Drops the references held by the given process and discards the frames it was publishing.
+     * Must be called when a process attached to the channel ends, in case it crashed.
+     **/
+    void releaseProcess(long long pid);
+
+    /**
+     * @brief The number of frames available in the channel
+     **/
+    int getFramesCount() const;
+
+    /**
+     * @brief The memory used by the frames of the channel, including the ones being published
+     **/
+    std::size_t getUsedBytes() const;
+
+private:
+
+    friend class SharedFrame;
+
+    void release(int slot, U64 serial);
+
+    boost::scoped_ptr<SharedFrameChannelPrivate> _imp;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // SHAREDFRAMECHANNEL_H
@@ -128,6 +128,10 @@ _spf (1 / 24.0),
 _timingError (0),
 _framesSinceLastFpsFrame (0),
 _actualFrameRate (0),
+_realtime(false),
+_presentationClock(),
+_nextPresentationTime(-1),
+_droppedFrames(0),
 _mutex(new QMutex)
 {
     gettimeofday (&_lastFrameTime, 0);
@@ -139,7 +143,28 @@ Timer::~Timer()
     delete _mutex;
 }
 
-void
+static void
+sleepSeconds(double timeToSleep)
+{
+    #ifdef _WIN32
+
+    if (timeToSleep > 0) {
+        Sleep ( int (timeToSleep * 1000.0f) );
+    }
+
+    #else
+
+    if (timeToSleep > 0) {
+        timespec ts;
+        ts.tv_sec = (time_t) timeToSleep;
+        ts.tv_nsec = (long) ( (timeToSleep - ts.tv_sec) * 1e9f );
+        nanosleep (&ts, 0);
+    }
+
+    #endif
+}
+
+int
 Timer::waitUntilNextFrameIsDue ()
 {
     if (playState != ePlayStateRunning) {
@@ -153,14 +178,22 @@ Timer::waitUntilNextFrameIsDue ()
         _lastFpsFrameTime = _lastFrameTime;
         _framesSinceLastFpsFrame = 0;
 
-        return;
+        QMutexLocker l(_mutex);
+        _nextPresentationTime = -1;
+
+        return 0;
     }
 
     
     double spf;
+    bool realtime;
     {
         QMutexLocker l(_mutex);
         spf = _spf;
+        realtime = _realtime;
+    }
+    if (realtime) {
+        return waitUntilNextFrameIsDueRealtime(spf);
     }
     //
     // If less than _spf seconds have passed since the last frame
@@ -177,22 +210,7 @@ Timer::waitUntilNextFrameIsDue ()
     }
     double timeToSleep = spf - timeSinceLastFrame - _timingError;
 
-    #ifdef _WIN32
-
-    if (timeToSleep > 0) {
-        Sleep ( int (timeToSleep * 1000.0f) );
-    }
-
-    #else
-
-    if (timeToSleep > 0) {
-        timespec ts;
-        ts.tv_sec = (time_t) timeToSleep;
-        ts.tv_nsec = (long) ( (timeToSleep - ts.tv_sec) * 1e9f );
-        nanosleep (&ts, 0);
-    }
-
-    #endif
+    sleepSeconds(timeToSleep);
 
     //
     // If we slept, it is possible that we woke up a little too early
@@ -219,6 +237,73 @@ Timer::waitUntilNextFrameIsDue ()
 
     _lastFrameTime = now;
 
+    refreshActualFrameRate(now);
+
+    return 0;
+} // waitUntilNextFrameIsDue
+
+int
+Timer::waitUntilNextFrameIsDueRealtime(double spf)
+{
+    qint64 spfNS = (qint64)(spf * 1e9);
+
+    if (spfNS <= 0) {
+        spfNS = 1;
+    }
+
+    //
+    // The first frame is presented right away and starts the schedule.
+    // The schedule may be restarted by setRealtimeEnabled() from
+    // another thread, the lock is not held while sleeping.
+    //
+
+    qint64 presentationTime;
+    {
+        QMutexLocker l(_mutex);
+        if ( (_nextPresentationTime < 0) || !_presentationClock.isValid() ) {
+            _presentationClock.start();
+            _nextPresentationTime = 0;
+        }
+        presentationTime = _nextPresentationTime;
+    }
+
+    //
+    // Sleep until the frame is due. If we are late by one or more
+    // frames, present it now: the frames whose time already passed
+    // will be skipped by the caller.
+    //
+
+    qint64 now = _presentationClock.nsecsElapsed();
+    int framesLate = 0;
+    if (now < presentationTime) {
+        sleepSeconds( (presentationTime - now) * 1e-9 );
+    } else {
+        framesLate = (int)( (now - presentationTime) / spfNS );
+    }
+
+    //
+    // Unlike the non-realtime mode, timing errors are not carried
+    // over: the schedule only depends on when playback started.
+    //
+
+    {
+        QMutexLocker l(_mutex);
+        if (_nextPresentationTime == presentationTime) {
+            _nextPresentationTime += (framesLate + 1) * spfNS;
+        }
+    }
+
+    timeval tv;
+    gettimeofday (&tv, 0);
+    _lastFrameTime = tv;
+    refreshActualFrameRate(tv);
+
+    return framesLate;
+}
+
+void
+Timer::refreshActualFrameRate(const timeval& now)
+{
     //
     // Calculate our actual frame rate, averaged over several frames.
     //
@@ -229,16 +314,18 @@ Timer::waitUntilNextFrameIsDue ()
     if (t > NATRON_FPS_REFRESH_RATE_SECONDS) {
         double actualFrameRate = _framesSinceLastFpsFrame / t;
         double curActualFrameRate;
+        int droppedFrames;
         {
             QMutexLocker l(_mutex);
             if (actualFrameRate != _actualFrameRate) {
                 _actualFrameRate = actualFrameRate;
             }
             curActualFrameRate = _actualFrameRate;
+            droppedFrames = _droppedFrames;
         }
         
         
-        Q_EMIT fpsChanged(curActualFrameRate,getDesiredFrameRate());
+        Q_EMIT fpsChanged(curActualFrameRate,getDesiredFrameRate(),droppedFrames);
         
         _framesSinceLastFpsFrame = 0;
     }
@@ -249,7 +336,7 @@ Timer::waitUntilNextFrameIsDue ()
     }
 
     _framesSinceLastFpsFrame += 1;
-} // waitUntilNextFrameIsDue
+} // refreshActualFrameRate
 
 double
 Timer::getActualFrameRate() const
@@ -258,6 +345,36 @@ Timer::getActualFrameRate() const
     return _actualFrameRate;
 }
 
+void
+Timer::setRealtimeEnabled(bool enabled)
+{
+    QMutexLocker l(_mutex);
+    _realtime = enabled;
+    _nextPresentationTime = -1;
+    _droppedFrames = 0;
+}
+
+bool
+Timer::isRealtimeEnabled() const
+{
+    QMutexLocker l(_mutex);
+    return _realtime;
+}
+
+void
+Timer::addDroppedFrames(int nFrames)
+{
+    QMutexLocker l(_mutex);
+    _droppedFrames += nFrames;
+}
+
+int
+Timer::getDroppedFrames() const
+{
+    QMutexLocker l(_mutex);
+    return _droppedFrames;
+}
+
 void
 Timer::setDesiredFrameRate (double fps)
 {
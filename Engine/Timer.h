@@ -42,6 +42,7 @@
 
 #include <QtCore/QString>
 #include <QtCore/QObject>
+#include <QtCore/QElapsedTimer>
 
 #include "Engine/EngineFwd.h"
 
@@ -82,9 +83,39 @@ public:
     // since the last call to waitUntilNextFrameIsDue().
     // If playState != ePlayStateRunning, then waitUntilNextFrameIsDue()
     // returns immediately.
+    //
+    // In realtime mode, frames are presented according to a schedule
+    // measured with a monotonic clock: frame n is due n * spf seconds
+    // after playback started. If the frame comes after the time at
+    // which one or more of the following frames were due, it is
+    // presented immediately and the number of frames that missed their
+    // slot is returned: the caller should skip as many frames so that
+    // playback stays in sync with the clock. Otherwise 0 is returned.
+    //--------------------------------------------------------
+
+    int    waitUntilNextFrameIsDue ();
+
+    //--------------------------------------------------------
+    // Enables or disables the realtime mode, this also restarts
+    // the presentation schedule and the dropped frames count.
+    // Must be called before playback starts.
+    //--------------------------------------------------------
+
+    void setRealtimeEnabled(bool enabled);
+    bool isRealtimeEnabled() const;
+
+    //--------------------------------------------------------
+    // Called by the caller of waitUntilNextFrameIsDue() with the
+    // number of frames it actually skipped.
+    //--------------------------------------------------------
+
+    void addDroppedFrames(int nFrames);
+
+    //--------------------------------------------------------
+    // The number of frames skipped since playback started.
     //--------------------------------------------------------
 
-    void    waitUntilNextFrameIsDue ();
+    int getDroppedFrames() const;
 
 
     //-------------------------------------------------
@@ -106,10 +137,14 @@ public:
     
 Q_SIGNALS:
     
-    void fpsChanged(double actualfps,double desiredfps);
+    void fpsChanged(double actualfps,double desiredfps,int droppedFrames);
 
 private:
 
+    int waitUntilNextFrameIsDueRealtime(double spf);
+
+    void refreshActualFrameRate(const timeval& now);
+
     double _spf;                 // desired frame rate,
     // in seconds per frame
     timeval _lastFrameTime;         // time when we displayed the
@@ -118,8 +153,15 @@ private:
     timeval _lastFpsFrameTime;      // state to keep track of the
     int _framesSinceLastFpsFrame;       // actual frame rate, averaged
     double _actualFrameRate;         // over several frames
+
+    bool _realtime;                  // realtime mode, see waitUntilNextFrameIsDue()
+    QElapsedTimer _presentationClock; // monotonic clock for the presentation schedule,
+    // only restarted by the thread calling waitUntilNextFrameIsDue()
+    qint64 _nextPresentationTime;    // when the next frame is due, in nanoseconds
+    // on _presentationClock, or -1 to restart the schedule
+    int _droppedFrames;              // frames skipped since playback started
     
-    QMutex* _mutex; //< protects _spf and _actualFrameRate
+    QMutex* _mutex; //< protects _spf, _actualFrameRate, _realtime, _nextPresentationTime and _droppedFrames
 };
 
 
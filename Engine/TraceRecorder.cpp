@@ -0,0 +1,325 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include "TraceRecorder.h"
+
+#include <algorithm> // min, max
+#include <cstring>
+#include <list>
+#include <vector>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QCoreApplication>
+
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/shared_ptr.hpp>
+#endif
+
+#include "Global/JSONUtils.h"
+
+#include "Engine/EffectInstance.h"
+#include "Engine/FStreamsSupport.h"
+#include "Engine/ThreadStorage.h"
+#include "Engine/Timer.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace {
+
+struct TraceEventData
+{
+    const char* name;
+    const char* category;
+    qint64 startTime;
+    qint64 duration;
+    char detail[NATRON_TRACE_DETAIL_SIZE];
+};
+
+struct TraceEvent
+{
+    //Odd while the owner thread writes the event of index (sequence - 1) / 2 in the slot, (index + 1) * 2 once written.
+    //The slot may be overwritten while it is exported: the exporting thread copies the data and keeps the copy only
+    //if the sequence was the same before and after.
+    QAtomicInt sequence;
+    TraceEventData data;
+
+    TraceEvent()
+    : sequence(0)
+    , data()
+    {
+    }
+
+    TraceEvent(const TraceEvent& other)
+    : sequence( (int)other.sequence )
+    , data(other.data)
+    {
+    }
+};
+
+inline int
+getWrittenSequence(int index)
+{
+    return (int)( ( (unsigned int)index + 1 ) * 2 );
+}
+
+struct TraceThreadBuffer
+{
+    //Only written by the thread owning the buffer
+    std::vector<TraceEvent> events;
+    int ownerCount;
+
+    //The number of events written since the buffer was created, published by the owner thread
+    QAtomicInt written;
+
+    //Events before this index were cleared
+    QAtomicInt firstVisible;
+
+    int tid;
+    std::string threadName;
+
+    TraceThreadBuffer()
+    : events(NATRON_TRACE_EVENTS_PER_THREAD)
+    , ownerCount(0)
+    , written(0)
+    , firstVisible(0)
+    , tid(0)
+    , threadName()
+    {
+    }
+};
+
+typedef boost::shared_ptr<TraceThreadBuffer> TraceThreadBufferPtr;
+
+QAtomicInt enabled(0);
+
+//Protects the list of buffers and the origin of the timestamps, not the events
+QMutex buffersMutex;
+std::list<TraceThreadBufferPtr> buffers;
+timeval origin;
+bool originSet = false;
+
+//The buffers are owned by the list above so that the events of threads that exited can still be exported
+ThreadStorage<TraceThreadBufferPtr> localBuffer;
+
+TraceThreadBuffer*
+getOrCreateLocalBuffer()
+{
+    TraceThreadBufferPtr& buf = localBuffer.localData();
+
+    if (buf) {
+        return buf.get();
+    }
+    buf.reset(new TraceThreadBuffer);
+
+    QThread* thread = QThread::currentThread();
+    QString name = thread ? thread->objectName() : QString();
+    if ( name.isEmpty() ) {
+        if ( qApp && (thread == qApp->thread()) ) {
+            name = QString::fromUtf8("Main thread");
+        } else {
+            name = QString::fromUtf8("Thread %1").arg( (quintptr)thread, 0, 16 );
+        }
+    }
+    buf->threadName = name.toStdString();
+
+    QMutexLocker k(&buffersMutex);
+    buf->tid = (int)buffers.size() + 1;
+    buffers.push_back(buf);
+
+    return buf.get();
+}
+
+} // anon namespace
+
+void
+TraceRecorder::setEnabled(bool enable)
+{
+    if (enable) {
+        QMutexLocker k(&buffersMutex);
+        if (!originSet) {
+            gettimeofday(&origin, 0);
+            originSet = true;
+        }
+    }
+    enabled.fetchAndStoreOrdered(enable ? 1 : 0);
+}
+
+bool
+TraceRecorder::isEnabled()
+{
+    return (int)enabled != 0;
+}
+
+void
+TraceRecorder::clear()
+{
+    QMutexLocker k(&buffersMutex);
+
+    for (std::list<TraceThreadBufferPtr>::iterator it = buffers.begin(); it != buffers.end(); ++it) {
+        (*it)->firstVisible.fetchAndStoreOrdered( (int)(*it)->written );
+    }
+}
+
+qint64
+TraceRecorder::getTimestamp()
+{
+    timeval now;
+
+    gettimeofday(&now, 0);
+
+    return ( (qint64)now.tv_sec - (qint64)origin.tv_sec ) * 1000000 + ( (qint64)now.tv_usec - (qint64)origin.tv_usec );
+}
+
+void
+TraceRecorder::addEvent(const char* name,
+                        const char* category,
+                        qint64 startTime,
+                        qint64 duration,
+                        const std::string& detail)
+{
+    TraceThreadBuffer* buf = getOrCreateLocalBuffer();
+    TraceEvent& slot = buf->events[buf->ownerCount % NATRON_TRACE_EVENTS_PER_THREAD];
+    int writtenSequence = getWrittenSequence(buf->ownerCount);
+
+    slot.sequence.fetchAndStoreOrdered(writtenSequence - 1);
+
+    TraceEventData& e = slot.data;
+    e.name = name;
+    e.category = category;
+    e.startTime = startTime;
+    e.duration = duration;
+    std::size_t len = std::min(detail.size(), (std::size_t)NATRON_TRACE_DETAIL_SIZE - 1);
+    std::memcpy(e.detail, detail.c_str(), len);
+    e.detail[len] = '\0';
+
+    slot.sequence.fetchAndStoreRelease(writtenSequence);
+    ++buf->ownerCount;
+    buf->written.fetchAndStoreRelease(buf->ownerCount);
+}
+
+bool
+TraceRecorder::writeChromeTrace(const std::string& filename,
+                                std::string* error)
+{
+    FStreamsSupport::ofstream ofile;
+
+    FStreamsSupport::open(&ofile, filename);
+    if (!ofile) {
+        *error = "Failed to open " + filename + " for writing";
+
+        return false;
+    }
+
+    std::list<TraceThreadBufferPtr> buffersCopy;
+    {
+        QMutexLocker k(&buffersMutex);
+        buffersCopy = buffers;
+    }
+
+    ofile << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (std::list<TraceThreadBufferPtr>::iterator it = buffersCopy.begin(); it != buffersCopy.end(); ++it) {
+        const TraceThreadBuffer& buf = **it;
+        if (!first) {
+            ofile << ",\n";
+        }
+        first = false;
+        ofile << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buf.tid << ",\"args\":{\"name\":";
+        JSONUtils::writeString( ofile, buf.threadName.c_str() );
+        ofile << "}}";
+
+        int written = (*it)->written.fetchAndAddAcquire(0);
+        int firstEvent = std::max( (int)(*it)->firstVisible, written - NATRON_TRACE_EVENTS_PER_THREAD );
+        for (int i = firstEvent; i < written; ++i) {
+            TraceEvent& slot = (*it)->events[i % NATRON_TRACE_EVENTS_PER_THREAD];
+            int writtenSequence = getWrittenSequence(i);
+            if (slot.sequence.fetchAndAddAcquire(0) != writtenSequence) {
+                //Overwritten by a more recent event
+                continue;
+            }
+            TraceEventData e = slot.data;
+            if (slot.sequence.fetchAndAddOrdered(0) != writtenSequence) {
+                continue;
+            }
+            e.detail[NATRON_TRACE_DETAIL_SIZE - 1] = '\0';
+            ofile << ",\n{\"name\":";
+            JSONUtils::writeString(ofile, e.name);
+            ofile << ",\"cat\":";
+            JSONUtils::writeString(ofile, e.category);
+            ofile << ",\"ph\":\"X\",\"ts\":" << e.startTime << ",\"dur\":" << e.duration << ",\"pid\":1,\"tid\":" << buf.tid;
+            if (e.detail[0] != '\0') {
+                ofile << ",\"args\":{\"detail\":";
+                JSONUtils::writeString(ofile, e.detail);
+                ofile << "}";
+            }
+            ofile << "}";
+        }
+    }
+    ofile << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    if (!ofile) {
+        *error = "Failed to write " + filename;
+
+        return false;
+    }
+
+    return true;
+} // TraceRecorder::writeChromeTrace
+
+TraceScope::TraceScope(const char* name,
+                       const char* category)
+    : _name(name)
+    , _category(category)
+    , _startTime(-1)
+    , _detail()
+{
+    if ( TraceRecorder::isEnabled() ) {
+        _startTime = TraceRecorder::getTimestamp();
+    }
+}
+
+TraceScope::TraceScope(const char* name,
+                       const char* category,
+                       const EffectInstance* effect)
+    : _name(name)
+    , _category(category)
+    , _startTime(-1)
+    , _detail()
+{
+    if ( TraceRecorder::isEnabled() ) {
+        _detail = effect->getScriptName_mt_safe();
+        _startTime = TraceRecorder::getTimestamp();
+    }
+}
+
+TraceScope::~TraceScope()
+{
+    if (_startTime >= 0) {
+        TraceRecorder::addEvent( _name, _category, _startTime, TraceRecorder::getTimestamp() - _startTime, _detail );
+    }
+}
+
+NATRON_NAMESPACE_EXIT;
@@ -0,0 +1,117 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef TRACERECORDER_H
+#define TRACERECORDER_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+
+#include "Global/Macros.h"
+
+#include <QtCore/QtGlobal>
+
+#include "Engine/EngineFwd.h"
+
+///The number of events kept for each thread, older events are overwritten
+#define NATRON_TRACE_EVENTS_PER_THREAD 16384
+
+///The maximum length of the detail (e.g: the node name) attached to an event
+#define NATRON_TRACE_DETAIL_SIZE 32
+
+NATRON_NAMESPACE_ENTER;
+
+/**
+ * @brief Records timed events of all threads so that they can be exported in the Chrome trace format,
+ * which can be opened with chrome://tracing or https://ui.perfetto.dev
+ * Each thread records its events in its own ring buffer, so recording never takes a lock once the buffer
+ * of the thread exists. When the buffer of a thread is full, its oldest events are overwritten.
+ * Events should be recorded with TraceScope. All functions are thread-safe.
+ **/
+class TraceRecorder
+{
+public:
+
+    static void setEnabled(bool enabled);
+
+    static bool isEnabled();
+
+    /**
+     * @brief Forgets all the events recorded so far.
+     **/
+    static void clear();
+
+    /**
+     * @brief Returns the time in microseconds since recording was first enabled.
+     **/
+    static qint64 getTimestamp();
+
+    /**
+     * @brief Records an event of the current thread that started at startTime and lasted duration microseconds.
+     * name and category must be string literals: they are not copied.
+     **/
+    static void addEvent(const char* name,
+                         const char* category,
+                         qint64 startTime,
+                         qint64 duration,
+                         const std::string& detail);
+
+    /**
+     * @brief Writes all the events recorded to filename, in the Chrome trace JSON format.
+     * Recording may go on meanwhile: the events overwritten while the file is written are left out.
+     * @returns True on success, otherwise error is set.
+     **/
+    static bool writeChromeTrace(const std::string& filename, std::string* error);
+};
+
+/**
+ * @brief Records an event lasting for the life-time of this object, if recording is enabled when it is created.
+ * The overhead when recording is disabled is a single test.
+ **/
+class TraceScope
+{
+public:
+
+    TraceScope(const char* name,
+               const char* category);
+
+    /**
+     * @brief Same as above, the script-name of the effect is attached to the event.
+     **/
+    TraceScope(const char* name,
+               const char* category,
+               const EffectInstance* effect);
+
+    ~TraceScope();
+
+private:
+
+    const char* _name;
+    const char* _category;
+    qint64 _startTime;
+    std::string _detail;
+};
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // TRACERECORDER_H
@@ -1637,7 +1637,11 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
         if (singleThreaded) {
             if (inArgs.autoContrast) {
                 double vmin, vmax;
-                std::pair<double,double> vMinMax = findAutoContrastVminVmax(colorImage, inArgs.channels, viewerRenderRoI);
+                std::pair<double,double> vMinMax;
+                if ( !_imp->getAutoContrastFromCache(colorImage, inArgs.channels, viewerRenderRoI, &vMinMax) ) {
+                    vMinMax = findAutoContrastVminVmax(colorImage, inArgs.channels, viewerRenderRoI);
+                    _imp->setAutoContrastInCache(colorImage, inArgs.channels, viewerRenderRoI, vMinMax);
+                }
                 vmin = vMinMax.first;
                 vmax = vMinMax.second;
                 
@@ -1685,7 +1689,11 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
                 double vmin = std::numeric_limits<double>::infinity();
                 double vmax = -std::numeric_limits<double>::infinity();
                 
-                if (!runInCurrentThread) {
+                std::pair<double,double> cachedVMinMax;
+                if ( _imp->getAutoContrastFromCache(colorImage, inArgs.channels, viewerRenderRoI, &cachedVMinMax) ) {
+                    vmin = cachedVMinMax.first;
+                    vmax = cachedVMinMax.second;
+                } else if (!runInCurrentThread) {
                     
                     QFuture<std::pair<double,double> > future = QtConcurrent::mapped( splitRects,
                                                                                      boost::bind(findAutoContrastVminVmax,
@@ -1703,10 +1711,12 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
                             vmax = vMinMax.second;
                         }
                     }
+                    _imp->setAutoContrastInCache( colorImage, inArgs.channels, viewerRenderRoI, std::make_pair(vmin, vmax) );
                 } else { //!runInCurrentThread
                     std::pair<double,double> vMinMax = findAutoContrastVminVmax(colorImage, inArgs.channels, viewerRenderRoI);
                     vmin = vMinMax.first;
                     vmax = vMinMax.second;
+                    _imp->setAutoContrastInCache(colorImage, inArgs.channels, viewerRenderRoI, vMinMax);
                 }
                 
                 if (vmax == vmin) {
@@ -1768,6 +1778,62 @@ ViewerInstance::renderViewer_internal(ViewIdx view,
     return eViewerRenderRetCodeRender;
 } // renderViewer_internal
 
+bool
+ViewerInstance::ViewerInstancePrivate::getAutoContrastFromCache(const boost::shared_ptr<const Image>& image,
+                                                                DisplayChannelsEnum channels,
+                                                                const RectI& rect,
+                                                                std::pair<double,double>* vMinMax)
+{
+    U64 hashKey = image->getHashKey();
+    QMutexLocker k(&autoContrastCacheMutex);
+    for (std::list<AutoContrastCacheEntry>::iterator it = autoContrastCache.begin(); it != autoContrastCache.end(); ++it) {
+        if ( (it->hashKey == hashKey) && (it->channels == channels) && (it->rect == rect) && (it->image.lock() == image) ) {
+            vMinMax->first = it->vmin;
+            vMinMax->second = it->vmax;
+            ///Move it to the front so that it is the last one to be evicted
+            autoContrastCache.splice(autoContrastCache.begin(), autoContrastCache, it);
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+ViewerInstance::ViewerInstancePrivate::setAutoContrastInCache(const boost::shared_ptr<const Image>& image,
+                                                              DisplayChannelsEnum channels,
+                                                              const RectI& rect,
+                                                              const std::pair<double,double>& vMinMax)
+{
+    ///Pixels that are not rendered yet may still change
+    std::list<RectI> restToRender;
+    image->getRestToRender(rect, restToRender);
+    if (!restToRender.empty()) {
+        return;
+    }
+    
+    AutoContrastCacheEntry entry;
+    entry.image = image;
+    entry.hashKey = image->getHashKey();
+    entry.rect = rect;
+    entry.channels = channels;
+    entry.vmin = vMinMax.first;
+    entry.vmax = vMinMax.second;
+    
+    QMutexLocker k(&autoContrastCacheMutex);
+    ///Drop the entries of the images that no longer exist
+    for (std::list<AutoContrastCacheEntry>::iterator it = autoContrastCache.begin(); it != autoContrastCache.end();) {
+        if ( it->image.expired() ) {
+            it = autoContrastCache.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    autoContrastCache.push_front(entry);
+    if (autoContrastCache.size() > NATRON_AUTO_CONTRAST_CACHE_MAX_ENTRIES) {
+        autoContrastCache.pop_back();
+    }
+}
+
 void
 ViewerInstance::ViewerInstancePrivate::reportProgress(const boost::shared_ptr<UpdateViewerParams>& originalParams,
                                                       const std::list<RectI>& rectangles,
@@ -1943,13 +2009,133 @@ findAutoContrastVminVmax_generic(boost::shared_ptr<const Image> inputImage,
     return std::make_pair(localVmin, localVmax);
 }
 
+/**
+ * @brief Accumulates the minimum and maximum of the component comp of count pixels.
+ * The loop keeps 4 independent accumulators and has no branch, so that the compiler can vectorize it.
+ * NaNs are ignored, because comparisons with them are false.
+ **/
+template <int nComps>
+static void
+findMinMaxRow(const float* pix,
+              int count,
+              int comp,
+              float* mini,
+              float* maxi)
+{
+    float mn[4] = { *mini, *mini, *mini, *mini };
+    float mx[4] = { *maxi, *maxi, *maxi, *maxi };
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        for (int k = 0; k < 4; ++k) {
+            const float v = pix[(x + k) * nComps + comp];
+            mn[k] = v < mn[k] ? v : mn[k];
+            mx[k] = v > mx[k] ? v : mx[k];
+        }
+    }
+    for (; x < count; ++x) {
+        const float v = pix[x * nComps + comp];
+        mn[0] = v < mn[0] ? v : mn[0];
+        mx[0] = v > mx[0] ? v : mx[0];
+    }
+    *mini = std::min( std::min(mn[0], mn[1]), std::min(mn[2], mn[3]) );
+    *maxi = std::max( std::max(mx[0], mx[1]), std::max(mx[2], mx[3]) );
+}
+
+/// Same as findMinMaxRow() for the luminance of pixels with at least 3 components
+template <int nComps>
+static void
+findMinMaxLuminanceRow(const float* pix,
+                       int count,
+                       float* mini,
+                       float* maxi)
+{
+    float mn[4] = { *mini, *mini, *mini, *mini };
+    float mx[4] = { *maxi, *maxi, *maxi, *maxi };
+    int x = 0;
+    for (; x + 4 <= count; x += 4) {
+        for (int k = 0; k < 4; ++k) {
+            const float* p = pix + (x + k) * nComps;
+            const float v = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+            mn[k] = v < mn[k] ? v : mn[k];
+            mx[k] = v > mx[k] ? v : mx[k];
+        }
+    }
+    for (; x < count; ++x) {
+        const float* p = pix + x * nComps;
+        const float v = 0.299f * p[0] + 0.587f * p[1] + 0.114f * p[2];
+        mn[0] = v < mn[0] ? v : mn[0];
+        mx[0] = v > mx[0] ? v : mx[0];
+    }
+    *mini = std::min( std::min(mn[0], mn[1]), std::min(mn[2], mn[3]) );
+    *maxi = std::max( std::max(mx[0], mx[1]), std::max(mx[2], mx[3]) );
+}
+
 template <int nComps>
 std::pair<double, double>
 findAutoContrastVminVmax_internal(boost::shared_ptr<const Image> inputImage,
                                   DisplayChannelsEnum channels,
                                   const RectI & rect)
 {
-    return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
+    assert(nComps == 1 || nComps == 3 || nComps == 4);
+    if ( rect.isNull() ) {
+        return std::make_pair( std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity() );
+    }
+
+    ///The channels the image does not have are constant: 0 for the colors, 1 for the alpha
+    int comps[3];
+    int compsCount = 0;
+    bool luminance = false;
+    switch (channels) {
+        case eDisplayChannelsRGB:
+            if (nComps != 1) {
+                comps[0] = 0;
+                comps[1] = 1;
+                comps[2] = 2;
+                compsCount = 3;
+            }
+            break;
+        case eDisplayChannelsY:
+            luminance = nComps != 1;
+            break;
+        case eDisplayChannelsR:
+        case eDisplayChannelsG:
+        case eDisplayChannelsB:
+            if (nComps != 1) {
+                comps[0] = channels == eDisplayChannelsR ? 0 : (channels == eDisplayChannelsG ? 1 : 2);
+                compsCount = 1;
+            }
+            break;
+        case eDisplayChannelsA:
+            if (nComps == 3) {
+                return std::make_pair(1., 1.);
+            }
+            comps[0] = nComps - 1;
+            compsCount = 1;
+            break;
+        default:
+            break;
+    }
+    if (!luminance && compsCount == 0) {
+        return std::make_pair(0., 0.);
+    }
+
+    float localVmin = std::numeric_limits<float>::infinity();
+    float localVmax = -std::numeric_limits<float>::infinity();
+
+    Image::ReadAccess acc = inputImage->getReadRights();
+
+    for (int y = rect.bottom(); y < rect.top(); ++y) {
+        const float* src_pixels = (const float*)acc.pixelAt(rect.left(),y);
+        if (luminance) {
+            findMinMaxLuminanceRow<nComps>(src_pixels, rect.width(), &localVmin, &localVmax);
+        } else {
+            for (int c = 0; c < compsCount; ++c) {
+                findMinMaxRow<nComps>(src_pixels, rect.width(), comps[c], &localVmin, &localVmax);
+            }
+        }
+    }
+
+    return std::make_pair(localVmin, localVmax);
 }
 
 std::pair<double, double>
@@ -1965,6 +2151,7 @@ findAutoContrastVminVmax(boost::shared_ptr<const Image> inputImage,
     } else if (nComps == 1) {
         return findAutoContrastVminVmax_internal<1>(inputImage, channels, rect);
     } else {
+        // 2 components images are rare enough not to deserve a specialized version
         return findAutoContrastVminVmax_generic(inputImage, nComps, channels, rect);
     }
     
@@ -40,6 +40,10 @@
 #include <QtCore/QThread>
 #include <QtCore/QCoreApplication>
 
+#if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
+#include <boost/weak_ptr.hpp>
+#endif
+
 #include "Engine/OutputSchedulerThread.h"
 #include "Engine/ImageComponents.h"
 #include "Engine/FrameEntry.h"
@@ -50,6 +54,9 @@
 
 #define GAMMA_LUT_NB_VALUES 1023
 
+///Maximum number of image portions whose auto-contrast minimum and maximum are remembered
+#define NATRON_AUTO_CONTRAST_CACHE_MAX_ENTRIES 512
+
 NATRON_NAMESPACE_ENTER;
 
 struct OnGoingRenderInfo
@@ -106,6 +113,20 @@ struct RenderViewerArgs
 };
 
 
+/**
+ * @brief The minimum and maximum found by the auto-contrast in a portion of an image.
+ * The values remain valid as long as the image is alive and has the same hash.
+ **/
+struct AutoContrastCacheEntry
+{
+    boost::weak_ptr<const Image> image;
+    U64 hashKey;
+    RectI rect;
+    DisplayChannelsEnum channels;
+    double vmin, vmax;
+};
+
+
 struct ViewerInstance::ViewerInstancePrivate
 : public QObject, public LockManagerI<FrameEntry>
 {
@@ -145,6 +166,8 @@ public:
     , renderAgeMutex()
     , renderAge()
     , displayAge()
+    , autoContrastCacheMutex()
+    , autoContrastCache()
     {
 
         for (int i = 0; i < 2; ++i) {
@@ -365,6 +388,22 @@ public:
                         const boost::shared_ptr<RenderStats>& stats,
                         const boost::shared_ptr<RequestedFrame>& request);
 
+    /**
+     * @brief Returns true if the auto-contrast minimum and maximum of the given portion of the image were already computed.
+     **/
+    bool getAutoContrastFromCache(const boost::shared_ptr<const Image>& image,
+                                  DisplayChannelsEnum channels,
+                                  const RectI& rect,
+                                  std::pair<double,double>* vMinMax);
+
+    /**
+     * @brief Remembers the auto-contrast minimum and maximum of the given portion of the image, if it is fully rendered.
+     **/
+    void setAutoContrastInCache(const boost::shared_ptr<const Image>& image,
+                                DisplayChannelsEnum channels,
+                                const RectI& rect,
+                                const std::pair<double,double>& vMinMax);
+
 public Q_SLOTS:
 
     /**
@@ -435,6 +474,11 @@ public:
     
     OnGoingRenders currentRenderAges[2];
     
+    ///The auto-contrast results per image portion, most recently used first. This lets auto-contrast
+    ///skip scanning the images that did not change, e.g when playing back frames already in the cache
+    mutable QMutex autoContrastCacheMutex;
+    std::list<AutoContrastCacheEntry> autoContrastCache;
+    
 };
 
 NATRON_NAMESPACE_EXIT;
@@ -108,6 +108,8 @@ typedef OfxRangeD RangeD;
 #define kProgressChangedStringLong "Progress changed: "
 #define kProgressChangedStringShort "-p"
 
+#define kFrameRenderTimeStringShort "-t" //< appended to the frame rendered message: the time spent rendering the frame in seconds
+
 #define kRenderingFinishedStringLong "Rendering finished"
 #define kRenderingFinishedStringShort "-e"
 
@@ -116,6 +118,13 @@ typedef OfxRangeD RangeD;
 
 #define kBgProcessServerCreatedShort "--bg_server_created"
 
+///these are used between a render daemon (see the --daemon option) and its clients.
+///A client sends a job as the command-line arguments of a background render separated by tabulations,
+///the daemon answers with the messages above for each frame and a job finished message.
+#define kDaemonRenderJobShort "-j"
+#define kDaemonJobFinishedShort "-f" //< followed by 0 on success or 1 on failure, then a tabulation and the error message
+#define kDaemonQuitShort "-q"
+
 //Increment this to wipe all disk cache structure and ensure that the user has a clean cache when starting the next version of Natron
 #define NATRON_CACHE_VERSION 3
 #define kNatronCacheVersionSettingsKey "NatronCacheVersionSettingsKey"
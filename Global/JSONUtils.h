@@ -0,0 +1,90 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef NATRON_GLOBAL_JSONUTILS_H
+#define NATRON_GLOBAL_JSONUTILS_H
+
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include "Global/Macros.h"
+
+NATRON_NAMESPACE_ENTER;
+
+namespace JSONUtils {
+
+/*Writes the given characters to os, escaped so that they can be put between the quotes of a JSON string.*/
+inline void
+writeEscaped(std::ostream & os,
+             const char* str,
+             std::size_t length)
+{
+    for (std::size_t i = 0; i < length; ++i) {
+        char c = str[i];
+        if ( (c == '"') || (c == '\\') ) {
+            os << '\\' << c;
+        } else if ( (unsigned char)c < 0x20 ) {
+            char escaped[8];
+            std::sprintf(escaped, "\\u%04x", (int)(unsigned char)c);
+            os << escaped;
+        } else {
+            os << c;
+        }
+    }
+}
+
+/*Returns str escaped so that it can be put between the quotes of a JSON string.*/
+inline std::string
+escape(const std::string & str)
+{
+    std::ostringstream os;
+
+    writeEscaped( os, str.c_str(), str.size() );
+
+    return os.str();
+}
+
+/*Writes str to os as a JSON string, with the quotes.*/
+inline void
+writeString(std::ostream & os,
+            const std::string & str)
+{
+    os << '"';
+    writeEscaped( os, str.c_str(), str.size() );
+    os << '"';
+}
+
+/*Same as above for a null-terminated string.*/
+inline void
+writeString(std::ostream & os,
+            const char* str)
+{
+    os << '"';
+    writeEscaped( os, str, std::strlen(str) );
+    os << '"';
+}
+
+} // namespace JSONUtils
+
+NATRON_NAMESPACE_EXIT;
+
+#endif // NATRON_GLOBAL_JSONUTILS_H
@@ -61,6 +61,14 @@ CurveGui::CurveGui(CurveWidget *curveWidget,
     , _thickness(thickness)
     , _visible(false)
     , _selected(false)
+    , _cachedVertices()
+    , _cachedVerticesCurveAge(0)
+    , _cachedVerticesYRange(0., 0.)
+    , _cachedVerticesXMin(0.)
+    , _cachedVerticesXMax(0.)
+    , _cachedVerticesPixelWidth(0.)
+    , _cachedVerticesPixelHeight(0.)
+    , _cachedVerticesValid(false)
 {
     // always running in the main thread
     assert( qApp && qApp->thread() == QThread::currentThread() );
@@ -80,6 +88,7 @@ void CurveGui::nextPointForSegment(const double x1,
                                    const std::pair<double,double>& curveYRange,
                                    const double xminCurveWidgetCoord,
                                    const double xmaxCurveWidgetCoord,
+                                   const double samplingEndWidgetCoord,
                                    KeyFrameSet::const_iterator* lastUpperIt,
                                    std::list<double>::const_iterator* lastUpperItCoords,
                                    double* x2,
@@ -124,20 +133,20 @@ void CurveGui::nextPointForSegment(const double x1,
         }
     } else if (x1 >= xmaxCurveWidgetCoord) {
         if ( (curveYRange.first <= kOfxFlagInfiniteMin) && (curveYRange.second >= kOfxFlagInfiniteMax) ) {
-            *x2 = _curveWidget->width() - 1;
+            *x2 = samplingEndWidgetCoord;
         } else {
             ///the curve has a min/max, find out the slope of the curve so we know whether the curve intersects
             ///the min axis, the max axis or nothing.
             if (keys.size() == 1) {
                 ///if only 1 keyframe, the curve is horizontal
-                *x2 = _curveWidget->width() - 1;
+                *x2 = samplingEndWidgetCoord;
             } else {
                 ///find out the equation of the straight line going from the last keyframe and intersecting
                 ///the min axis, so we can get the coordinates of the point intersecting the min axis.
                 KeyFrameSet::const_reverse_iterator lastKf = keys.rbegin();
 
                 if (lastKf->getRightDerivative() == 0) {
-                    *x2 = _curveWidget->width() - 1;
+                    *x2 = samplingEndWidgetCoord;
                 } else {
                     double b = lastKf->getValue() - lastKf->getRightDerivative() * lastKf->getTime();
                     *x2 = _curveWidget->toWidgetCoordinates( (curveYRange.first - b) / lastKf->getRightDerivative(),0 ).x();
@@ -147,7 +156,7 @@ void CurveGui::nextPointForSegment(const double x1,
 
                         if ( (x1 >= *x2) || (*x2 < xmaxCurveWidgetCoord) ) {
                             /// ok the curve doesn't intersect the min/max axis
-                            *x2 = _curveWidget->width() - 1;
+                            *x2 = samplingEndWidgetCoord;
                         }
                     }
                 }
@@ -232,6 +241,85 @@ CurveGui::getInternalCurve() const
     return _internalCurve;
 }
 
+void
+CurveGui::evaluateCurve(const std::vector<double>& xs,
+                        std::vector<double>* ys) const
+{
+    ys->resize( xs.size() );
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        (*ys)[i] = evaluate(false, xs[i]);
+    }
+}
+
+void
+CurveGui::computeCurveVertices(const KeyFrameSet& keyframes,
+                               double samplingStart,
+                               double samplingEnd,
+                               std::vector<float>* vertices)
+{
+    assert( !keyframes.empty() );
+
+    // first compute where the curve must be sampled, then evaluate all the points at once
+    std::vector<double> xs, ys;
+    std::vector<double> evalXs, evalYs;
+    std::vector<bool> isKey;
+    try {
+        double xminCurveWidgetCoord = _curveWidget->toWidgetCoordinates(keyframes.begin()->getTime(),0).x();
+        double xmaxCurveWidgetCoord = _curveWidget->toWidgetCoordinates(keyframes.rbegin()->getTime(),0).x();
+        
+        std::list<double> keysWidgetCoords;
+        for (KeyFrameSet::const_iterator it = keyframes.begin(); it != keyframes.end(); ++it) {
+            double widgetCoord = _curveWidget->toWidgetCoordinates(it->getTime(),0).x();
+            keysWidgetCoords.push_back(widgetCoord);
+        }
+        
+        std::pair<double,double> curveYRange = getCurveYRange();
+        
+        bool isX1AKey = false;
+        KeyFrame x1Key;
+        std::list<double>::const_iterator lastUpperItCoords = keysWidgetCoords.end();
+        KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
+        double x1 = samplingStart;
+        double x2;
+        
+        while (x1 < samplingEnd) {
+            if (!isX1AKey) {
+                double x = _curveWidget->toZoomCoordinates(x1,0).x();
+                xs.push_back(x);
+                ys.push_back(0.);
+                isKey.push_back(false);
+                evalXs.push_back(x);
+            } else {
+                xs.push_back( x1Key.getTime() );
+                ys.push_back( x1Key.getValue() );
+                isKey.push_back(true);
+            }
+            nextPointForSegment(x1, keyframes, keysWidgetCoords,curveYRange, xminCurveWidgetCoord, xmaxCurveWidgetCoord, samplingEnd, &lastUpperIt, &lastUpperItCoords, &x2, &x1Key, &isX1AKey);
+            x1 = x2;
+        }
+        //also add the last point
+        {
+            double x = _curveWidget->toZoomCoordinates(x1,0).x();
+            xs.push_back(x);
+            ys.push_back(0.);
+            isKey.push_back(false);
+            evalXs.push_back(x);
+        }
+
+        evaluateCurve(evalXs, &evalYs);
+    } catch (...) {
+        return;
+    }
+
+    assert( evalXs.size() == evalYs.size() );
+    vertices->reserve(xs.size() * 2);
+    std::size_t evalIndex = 0;
+    for (std::size_t i = 0; i < xs.size(); ++i) {
+        vertices->push_back( (float)xs[i] );
+        vertices->push_back( isKey[i] ? (float)ys[i] : (float)evalYs[evalIndex++] );
+    }
+} // computeCurveVertices
+
 static void drawLineStrip(const std::vector<float>& vertices,
                           const QPointF& btmLeft,
                           const QPointF& topRight)
@@ -266,6 +354,10 @@ static void drawLineStrip(const std::vector<float>& vertices,
                 glVertex2f(vertices[i - 2], vertices[i -1] + 100000);
             } else if (previousWasTooBelow) {
                 glVertex2f(vertices[i - 2], vertices[i -1] - 100000);
+            } else {
+                //The previous point is on the left of the viewport (vertices may extend outside of it), draw it
+                //so that the line reaches the left edge
+                glVertex2f(vertices[i - 2], vertices[i - 1]);
             }
         }
         glVertex2f(vertices[i],vertices[i + 1]);
@@ -287,9 +379,7 @@ CurveGui::drawCurve(int curveIndex,
 
     assert( QGLContext::currentContext() == _curveWidget->context() );
 
-    std::vector<float> vertices,exprVertices;
-    double x1 = 0;
-    double x2;
+    std::vector<float> exprVertices;
     const double widgetWidth = _curveWidget->width();
     KeyFrameSet keyframes;
     BezierCPCurveGui* isBezier = dynamic_cast<BezierCPCurveGui*>(this);
@@ -303,7 +393,7 @@ CurveGui::drawCurve(int curveIndex,
         expr = knob->getExpression(isKnobCurve->getDimension());
         if (!expr.empty()) {
             //we have no choice but to evaluate the expression at each time
-            for (int i = x1; i < widgetWidth; ++i) {
+            for (int i = 0; i < widgetWidth; ++i) {
                 double x = _curveWidget->toZoomCoordinates(i,0).x();;
                 double y = knob->getValueAtWithExpression(x, ViewIdx(0), isKnobCurve->getDimension());
                 exprVertices.push_back(x);
@@ -313,6 +403,7 @@ CurveGui::drawCurve(int curveIndex,
         }
     }
     
+    boost::shared_ptr<Curve> internalCurve;
     if (isBezier) {
         std::set<double> keys;
         isBezier->getBezier()->getKeyframeTimes(&keys);
@@ -321,52 +412,46 @@ CurveGui::drawCurve(int curveIndex,
             keyframes.insert(KeyFrame(*it,i));
         }
     } else {
-        keyframes = getInternalCurve()->getKeyFrames_mt_safe();
+        internalCurve = getInternalCurve();
+        keyframes = internalCurve->getKeyFrames_mt_safe();
     }
-    if (!keyframes.empty()) {
-        
-        try {
-            double xminCurveWidgetCoord = _curveWidget->toWidgetCoordinates(keyframes.begin()->getTime(),0).x();
-            double xmaxCurveWidgetCoord = _curveWidget->toWidgetCoordinates(keyframes.rbegin()->getTime(),0).x();
-            
-            std::list<double> keysWidgetCoords;
-            for (KeyFrameSet::const_iterator it = keyframes.begin(); it != keyframes.end(); ++it) {
-                double widgetCoord = _curveWidget->toWidgetCoordinates(it->getTime(),0).x();
-                keysWidgetCoords.push_back(widgetCoord);
-            }
-            
-            std::pair<double,double> curveYRange = getCurveYRange();
-            
-            bool isX1AKey = false;
-            KeyFrame x1Key;
-            std::list<double>::const_iterator lastUpperItCoords = keysWidgetCoords.end();
-            KeyFrameSet::const_iterator lastUpperIt = keyframes.end();
-            
-            while (x1 < (widgetWidth - 1)) {
-                double x,y;
-                if (!isX1AKey) {
-                    x = _curveWidget->toZoomCoordinates(x1,0).x();
-                    y = evaluate(false,x);
-                } else {
-                    x = x1Key.getTime();
-                    y = x1Key.getValue();
-                }
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
-                nextPointForSegment(x1, keyframes, keysWidgetCoords,curveYRange, xminCurveWidgetCoord, xmaxCurveWidgetCoord, &lastUpperIt, &lastUpperItCoords, &x2, &x1Key, &isX1AKey);
-                x1 = x2;
-            }
-            //also add the last point
-            {
-                double x = _curveWidget->toZoomCoordinates(x1,0).x();
-                double y = evaluate(false,x);
-                vertices.push_back( (float)x );
-                vertices.push_back( (float)y );
+    if ( keyframes.empty() ) {
+        _cachedVerticesValid = false;
+        _cachedVertices.clear();
+    } else {
+        const QPointF visibleTopLeft = _curveWidget->toZoomCoordinates(0, 0);
+        const double visibleRight = _curveWidget->toZoomCoordinates(widgetWidth - 1, 0).x();
+        double pixelWidth, pixelHeight;
+        _curveWidget->getPixelScale(pixelWidth, pixelHeight);
+        const std::pair<double,double> curveYRange = getCurveYRange();
+
+        // Bezier curves have no internal curve to tell us whether they changed: always recompute them
+        bool cacheValid = _cachedVerticesValid && internalCurve &&
+                          _cachedVerticesCurveAge == internalCurve->getKeyFramesAge() &&
+                          _cachedVerticesPixelWidth == pixelWidth &&
+                          _cachedVerticesPixelHeight == pixelHeight &&
+                          _cachedVerticesYRange == curveYRange &&
+                          _cachedVerticesXMin <= visibleTopLeft.x() &&
+                          visibleRight <= _cachedVerticesXMax;
+        if (!cacheValid) {
+            double samplingStart = 0.;
+            double samplingEnd = widgetWidth - 1;
+            if (internalCurve) {
+                samplingStart -= widgetWidth;
+                samplingEnd += widgetWidth;
+                _cachedVerticesCurveAge = internalCurve->getKeyFramesAge();
             }
-        } catch (...) {
-            
+            _cachedVertices.clear();
+            computeCurveVertices(keyframes, samplingStart, samplingEnd, &_cachedVertices);
+            _cachedVerticesPixelWidth = pixelWidth;
+            _cachedVerticesPixelHeight = pixelHeight;
+            _cachedVerticesYRange = curveYRange;
+            _cachedVerticesXMin = _curveWidget->toZoomCoordinates(samplingStart, 0).x();
+            _cachedVerticesXMax = _curveWidget->toZoomCoordinates(samplingEnd, 0).x();
+            _cachedVerticesValid = true;
         }
     }
+    const std::vector<float>& vertices = _cachedVertices;
     
     QPointF btmLeft = _curveWidget->toZoomCoordinates(0,_curveWidget->height() - 1);
     QPointF topRight = _curveWidget->toZoomCoordinates(_curveWidget->width() - 1, 0);
@@ -681,6 +766,24 @@ KnobCurveGui::evaluate(bool useExpr,double x) const
     }
 }
 
+void
+KnobCurveGui::evaluateCurve(const std::vector<double>& xs,
+                            std::vector<double>* ys) const
+{
+    ys->resize( xs.size() );
+    if ( xs.empty() ) {
+        return;
+    }
+    KnobPtr knob = getInternalKnob();
+    KnobParametric* isParametric = dynamic_cast<KnobParametric*>(knob.get());
+    if (isParametric) {
+        isParametric->getParametricCurve(_dimension)->getValuesAt(&xs[0], &(*ys)[0], (int)xs.size());
+    } else {
+        assert(_internalCurve);
+        _internalCurve->getValuesAt(&xs[0], &(*ys)[0], (int)xs.size(), false);
+    }
+}
+
 boost::shared_ptr<Curve>
 KnobCurveGui::getInternalCurve() const
 {
@@ -27,6 +27,8 @@
 
 #include "Global/Macros.h"
 
+#include <vector>
+
 #if !defined(Q_MOC_RUN) && !defined(SBK_RUN)
 #include <boost/shared_ptr.hpp>
 #endif
@@ -119,6 +121,12 @@ public:
      * The coordinates are those of the curve, not of the widget.
      **/
     virtual double evaluate(bool useExpr, double x) const = 0;
+
+    /**
+     * @brief Same as evaluate(false,x) for each x in xs, but derived classes may evaluate
+     * all the points in one pass.
+     **/
+    virtual void evaluateCurve(const std::vector<double>& xs, std::vector<double>* ys) const;
     
     virtual boost::shared_ptr<Curve>  getInternalCurve() const;
 
@@ -143,11 +151,21 @@ private:
                              const std::pair<double,double>& curveYRange,
                              const double xminCurveWidgetCoord,
                              const double xmaxCurveWidgetCoord,
+                             const double samplingEndWidgetCoord,
                              KeyFrameSet::const_iterator* lastUpperIt,
                              std::list<double>::const_iterator* lastUpperItCoords,
                              double* x2,
                              KeyFrame* key,
                              bool* isKey );
+
+    /**
+     * @brief Computes the vertices of the curve (in curve coordinates) from widget x coordinate
+     * samplingStart to samplingEnd, evaluating all the points in one pass.
+     **/
+    void computeCurveVertices(const KeyFrameSet& keyframes,
+                              double samplingStart,
+                              double samplingEnd,
+                              std::vector<float>* vertices);
     
 protected:
     
@@ -161,6 +179,16 @@ private:
     int _thickness; /// its thickness
     bool _visible; /// should we draw this curve ?
     bool _selected; /// is this curve selected
+
+    ///The vertices computed by the last drawCurve() call. They cover one widget width on each side
+    ///of the visible area so that panning does not re-evaluate the curve: they are only recomputed
+    ///when the keyframes, the Y range or the zoom scale change or when panning too far.
+    std::vector<float> _cachedVertices;
+    U64 _cachedVerticesCurveAge;
+    std::pair<double,double> _cachedVerticesYRange;
+    double _cachedVerticesXMin, _cachedVerticesXMax; /// the range covered by the vertices in curve coordinates
+    double _cachedVerticesPixelWidth, _cachedVerticesPixelHeight;
+    bool _cachedVerticesValid;
    
 };
 
@@ -203,6 +231,8 @@ public:
     }
     
     virtual double evaluate(bool useExpr,double x) const OVERRIDE FINAL WARN_UNUSED_RETURN;
+
+    virtual void evaluateCurve(const std::vector<double>& xs, std::vector<double>* ys) const OVERRIDE FINAL;
     
     boost::shared_ptr<RotoContext> getRotoContext() const { return _roto; }
     
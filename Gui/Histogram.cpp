@@ -135,7 +135,11 @@ struct HistogramPrivate
     {
     }
     
-    boost::shared_ptr<Image> getHistogramImage(RectI* imagePortion) const;
+    /**
+     * @brief Returns in tiles the last images rendered by the selected viewer, and in imagePortion the
+     * portion of these tiles the histogram should be computed on. Returns false if there is no image.
+     **/
+    bool getHistogramTiles(std::list<boost::shared_ptr<Image> >* tiles, RectI* imagePortion) const;
     
     
     void showMenu(const QPoint & globalPos);
@@ -451,7 +455,9 @@ Histogram::getViewerTextureInputDisplayed() const
     return textureIndex;
 }
 
-boost::shared_ptr<Image> HistogramPrivate::getHistogramImage(RectI* imagePortion) const
+bool
+HistogramPrivate::getHistogramTiles(std::list<boost::shared_ptr<Image> >* tiles,
+                                    RectI* imagePortion) const
 {
     // always running in the main thread
     assert( qApp && qApp->thread() == QThread::currentThread() );
@@ -475,13 +481,12 @@ boost::shared_ptr<Image> HistogramPrivate::getHistogramImage(RectI* imagePortion
     if (index == 0) {
         //no viewer selected
         imagePortion->clear();
-        return boost::shared_ptr<Image>();
+        return false;
     } else if (index == 1) {
         //current viewer
         viewer = widget->getGui()->getNodeGraph()->getLastSelectedViewer();
         
     } else {
-        boost::shared_ptr<Image> ret;
         const std::list<ViewerTab*> & viewerTabs = widget->getGui()->getViewersList();
         for (std::list<ViewerTab*>::const_iterator it = viewerTabs.begin(); it != viewerTabs.end(); ++it) {
             if ( (*it)->getInternalNode()->getScriptName_mt_safe() == viewerName ) {
@@ -492,56 +497,28 @@ boost::shared_ptr<Image> HistogramPrivate::getHistogramImage(RectI* imagePortion
 
     }
     
-    std::list<boost::shared_ptr<Image> > tiles;
     if (viewer) {
-        viewer->getViewer()->getLastRenderedImageByMipMapLevel(textureIndex,viewer->getInternalNode()->getMipMapLevelFromZoomFactor(),&tiles);
+        viewer->getViewer()->getLastRenderedImageByMipMapLevel(textureIndex,viewer->getInternalNode()->getMipMapLevelFromZoomFactor(),tiles);
     }
     
-    ///We must copy all tiles into an image of the whole size
-    boost::shared_ptr<Image> ret;
-    if (!tiles.empty()) {
-        const    boost::shared_ptr<Image>& firstTile = tiles.front();
+    ///The tiles are given as is to the histogram thread, which keeps the partial histogram of each of them
+    if (!tiles->empty()) {
         RectI bounds;
         unsigned int mipMapLevel = 0;
         double par = 1.;
-        ImageBitDepthEnum depth = eImageBitDepthFloat;
-        ImageComponents comps;
-        ImagePremultiplicationEnum premult = eImagePremultiplicationPremultiplied;
-        ImageFieldingOrderEnum fielding = eImageFieldingOrderNone;
-        for (std::list<boost::shared_ptr<Image> >::const_iterator it = tiles.begin(); it!=tiles.end(); ++it) {
+        for (std::list<boost::shared_ptr<Image> >::const_iterator it = tiles->begin(); it!=tiles->end(); ++it) {
             if (bounds.isNull()) {
                 bounds = (*it)->getBounds();
                 mipMapLevel = (*it)->getMipMapLevel();
                 par = (*it)->getPixelAspectRatio();
-                depth = (*it)->getBitDepth();
-                comps = (*it)->getComponents();
-                fielding = (*it)->getFieldingOrder();
-                premult = (*it)->getPremultiplication();
             } else {
                 bounds.merge((*it)->getBounds());
                 assert(mipMapLevel == (*it)->getMipMapLevel());
-                assert(depth == (*it)->getBitDepth());
-                assert(comps == (*it)->getComponents());
                 assert(par == (*it)->getPixelAspectRatio());
-                assert(fielding == (*it)->getFieldingOrder());
-                assert(premult == (*it)->getPremultiplication());
             }
         }
         if (bounds.isNull()) {
-            return ret;
-        }
-        
-        ret.reset(new Image(comps,
-                            firstTile->getRoD(),
-                            bounds,
-                            mipMapLevel,
-                            par,
-                            depth,
-                            premult,
-                            fielding,
-                            false));
-        for (std::list<boost::shared_ptr<Image> >::const_iterator it = tiles.begin(); it!=tiles.end(); ++it) {
-            ret->pasteFrom(**it, (*it)->getBounds(), false);
+            return false;
         }
         
         if (!useImageRoD) {
@@ -549,12 +526,13 @@ boost::shared_ptr<Image> HistogramPrivate::getHistogramImage(RectI* imagePortion
                 *imagePortion = viewer->getViewer()->getImageRectangleDisplayed(bounds,par, mipMapLevel);
             }
         } else {
-            *imagePortion = ret->getBounds();
+            *imagePortion = bounds;
         }
+        return true;
     }
     
-    return ret;
-} // getHistogramImage
+    return false;
+} // getHistogramTiles
 
 void
 HistogramPrivate::showMenu(const QPoint & globalPos)
@@ -1544,9 +1522,9 @@ Histogram::computeHistogramAndRefresh(bool forceEvenIfNotVisible)
 #ifndef NATRON_HISTOGRAM_USING_OPENGL
 
     RectI rect;
-    boost::shared_ptr<Image> image = _imp->getHistogramImage(&rect);
-    if (image) {
-        _imp->histogramThread.computeHistogram(_imp->mode, image, rect, width(),vmin,vmax,_imp->filterSize);
+    std::list<boost::shared_ptr<Image> > tiles;
+    if ( _imp->getHistogramTiles(&tiles, &rect) ) {
+        _imp->histogramThread.computeHistogram(_imp->mode, tiles, rect, width(),vmin,vmax,_imp->filterSize);
     } else {
         _imp->hasImage = false;
     }
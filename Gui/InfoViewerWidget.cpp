@@ -183,7 +183,8 @@ InfoViewerWidget::minimumSizeHint() const
 
 void
 InfoViewerWidget::setFps(double actualFps,
-                         double desiredFps)
+                         double desiredFps,
+                         int droppedFrames)
 {
     QString colorStr = QString::fromUtf8("green");
     
@@ -194,8 +195,13 @@ InfoViewerWidget::setFps(double actualFps,
     } else if ( actualFps < (desiredFps / 2.f) ) {
         colorStr = QString::fromUtf8("red");
     }
-    QString str = QString::fromUtf8("<font color=\"")+ colorStr + QString::fromUtf8("\" face=\"%2\" size=%3>%1 fps</font>")
-    .arg( QString::number(actualFps,'f',1) )
+    QString fpsStr = tr("%1 fps").arg( QString::number(actualFps,'f',1) );
+    if (droppedFrames > 0) {
+        ///Realtime playback skipped frames to keep up with desiredFps
+        fpsStr = tr("%1 / %2 fps, %3 dropped").arg( QString::number(actualFps,'f',1) ).arg( QString::number(desiredFps,'f',1) ).arg(droppedFrames);
+    }
+    QString str = QString::fromUtf8("<font color=\"")+ colorStr + QString::fromUtf8("\" face=\"%2\" size=%3>%1</font>")
+    .arg(fpsStr)
     .arg(font.family())
     .arg(font.pixelSize());
 
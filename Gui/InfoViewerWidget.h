@@ -78,7 +78,7 @@ public Q_SLOTS:
 
     void hideColorAndMouseInfo();
     void showColorAndMouseInfo();
-    void setFps(double actualFps,double desiredFps);
+    void setFps(double actualFps,double desiredFps,int droppedFrames);
     void hideFps();
 
 private:
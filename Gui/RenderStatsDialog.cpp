@@ -26,6 +26,7 @@
 
 #include <bitset>
 #include <stdexcept>
+#include <vector>
 
 #include <QVBoxLayout>
 #include <QHBoxLayout>
@@ -33,9 +34,13 @@
 #include <QCheckBox>
 #include <QItemSelectionModel>
 #include <QRegExp>
+#include "Global/MemoryInfo.h"
 
+#include "Engine/AppManager.h"
+#include "Engine/MemoryGovernor.h"
 #include "Engine/Node.h"
 #include "Engine/Timer.h"
+#include "Engine/TraceRecorder.h"
 #include "Engine/ViewIdx.h"
 
 #include "Gui/Button.h"
@@ -43,6 +48,7 @@
 #include "Gui/Label.h"
 #include "Gui/LineEdit.h"
 #include "Gui/NodeGui.h"
+#include "Gui/SequenceFileDialog.h"
 #include "Gui/TableModelView.h"
 #include "Gui/Utils.h"
 
@@ -63,8 +69,9 @@
 #define COL_NB_CACHE_HIT 13
 #define COL_NB_CACHE_HIT_DOWNSCALED 14
 #define COL_NB_CACHE_MISS 15
+#define COL_PLUGIN_MEMORY 16
 
-#define NUM_COLS 16
+#define NUM_COLS 17
 
 NATRON_NAMESPACE_ENTER;
 
@@ -75,6 +82,9 @@ enum ItemsRoleEnum
     eItemsRoleIdentityTilesInfo = 102,
     eItemsRoleRenderedTilesNb = 103,
     eItemsRoleRenderedTilesInfo = 104,
+    eItemsRolePluginMemory = 105,
+    eItemsRolePluginMemoryAllocationsNb = 106,
+    eItemsRolePluginMemoryRecycledNb = 107,
 };
 
 struct RowInfo
@@ -106,6 +116,8 @@ struct StatRowsCompare
                 return lhs.item->data((int)eItemsRoleRenderedTilesNb).toInt() < rhs.item->data((int)eItemsRoleRenderedTilesNb).toInt();
             case COL_TIME:
                 return lhs.item->data((int)eItemsRoleTime).toDouble() < rhs.item->data((int)eItemsRoleTime).toDouble();
+            case COL_PLUGIN_MEMORY:
+                return lhs.item->data((int)eItemsRolePluginMemory).toULongLong() < rhs.item->data((int)eItemsRolePluginMemory).toULongLong();
             default:
                 return lhs.item->text() < rhs.item->text();
         }
@@ -642,6 +654,49 @@ public:
                 }
             }
         }
+        {
+            TableItem* item = 0;
+            
+            U64 bytes = 0;
+            int nbAllocations = 0;
+            int nbRecycled = 0;
+            if (exists) {
+                item = view->item(row, COL_PLUGIN_MEMORY);
+                if (item) {
+                    bytes = item->data((int)eItemsRolePluginMemory).toULongLong();
+                    nbAllocations = item->data((int)eItemsRolePluginMemoryAllocationsNb).toInt();
+                    nbRecycled = item->data((int)eItemsRolePluginMemoryRecycledNb).toInt();
+                }
+            } else {
+                item = new TableItem;
+                QString tt = GuiUtils::convertFromPlainText(QObject::tr("The memory allocated by the plug-in through the OpenFX memory suites, "
+                                                                      "the number of allocations and how many of them were recycled from "
+                                                                      "memory previously freed by a plug-in."), Qt::WhiteSpaceNormal);
+                item->setToolTip(tt);
+                item->setFlags(Qt::ItemIsSelectable | Qt::ItemIsEnabled);
+            }
+            assert(item);
+            if (item) {
+                int statsAllocations, statsRecycled;
+                U64 statsBytes;
+                stats.getPluginMemoryInfos(&statsAllocations, &statsRecycled, &statsBytes);
+                bytes += statsBytes;
+                nbAllocations += statsAllocations;
+                nbRecycled += statsRecycled;
+                
+                if (nodeUi) {
+                    item->setTextColor(Qt::black);
+                    item->setBackgroundColor(c);
+                }
+                item->setData( (int)eItemsRolePluginMemory, QVariant( (qulonglong)bytes ) );
+                item->setData( (int)eItemsRolePluginMemoryAllocationsNb, nbAllocations );
+                item->setData( (int)eItemsRolePluginMemoryRecycledNb, nbRecycled );
+                item->setText( QObject::tr("%1 (%2 allocations, %3 recycled)").arg( printAsRAM(bytes) ).arg(nbAllocations).arg(nbRecycled) );
+                if (!exists) {
+                    view->setItem(row, COL_PLUGIN_MEMORY, item);
+                }
+            }
+        }
         if (!exists) {
             rows.push_back(node);
         }
@@ -706,8 +761,15 @@ struct RenderStatsDialogPrivate
     Label* totalTimeSpentValueLabel;
     double totalSpentTime;
     
+    Label* memoryDescLabel;
+    Label* memoryValueLabel;
+    
     Button* resetButton;
     
+    Label* traceLabel;
+    QCheckBox* traceCheckbox;
+    Button* exportTraceButton;
+    
     QWidget* filterContainer;
     QHBoxLayout* filterLayout;
     
@@ -739,7 +801,12 @@ struct RenderStatsDialogPrivate
     , totalTimeSpentDescLabel(0)
     , totalTimeSpentValueLabel(0)
     , totalSpentTime(0)
+    , memoryDescLabel(0)
+    , memoryValueLabel(0)
     , resetButton(0)
+    , traceLabel(0)
+    , traceCheckbox(0)
+    , exportTraceButton(0)
     , filterContainer(0)
     , filterLayout(0)
     , filtersLabel(0)
@@ -823,11 +890,45 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentDescLabel);
     _imp->globalInfosLayout->addWidget(_imp->totalTimeSpentValueLabel);
     
+    _imp->globalInfosLayout->addSpacing(20);
+    
+    QString memoryTt = GuiUtils::convertFromPlainText(tr("The memory used by the caches and the plug-ins at the end of the last render, "
+                                                         "out of the memory available to %1. When running in a container, this is "
+                                                         "the memory limit of the container. The caches and plug-ins budgets shrink "
+                                                         "when the memory pressure rises.").arg( QString::fromUtf8(NATRON_APPLICATION_NAME) ), Qt::WhiteSpaceNormal);
+    _imp->memoryDescLabel = new Label(tr("Memory:"), _imp->globalInfosContainer);
+    _imp->memoryDescLabel->setToolTip(memoryTt);
+    _imp->memoryValueLabel = new Label(_imp->globalInfosContainer);
+    _imp->memoryValueLabel->setToolTip(memoryTt);
+    
+    _imp->globalInfosLayout->addWidget(_imp->memoryDescLabel);
+    _imp->globalInfosLayout->addWidget(_imp->memoryValueLabel);
+    
     _imp->resetButton = new Button(tr("Reset"), _imp->globalInfosContainer);
-    _imp->resetButton->setToolTip(tr("Clears the statistics."));
+    _imp->resetButton->setToolTip(tr("Clears the statistics and the recorded trace."));
     QObject::connect(_imp->resetButton, SIGNAL(clicked(bool)), this, SLOT(resetStats()));
     _imp->globalInfosLayout->addWidget(_imp->resetButton);
     
+    _imp->globalInfosLayout->addSpacing(20);
+    
+    QString traceTt = GuiUtils::convertFromPlainText(tr("When checked, the time spent by each thread in the renders, plug-in actions, "
+                                                        "cache lookups and waits is recorded.\nThe recording can be exported with \"Export trace...\" "
+                                                        "and opened with chrome://tracing or https://ui.perfetto.dev"), Qt::WhiteSpaceNormal);
+    _imp->traceLabel = new Label(tr("Trace:"), _imp->globalInfosContainer);
+    _imp->traceLabel->setToolTip(traceTt);
+    _imp->traceCheckbox = new QCheckBox(_imp->globalInfosContainer);
+    _imp->traceCheckbox->setChecked( TraceRecorder::isEnabled() );
+    _imp->traceCheckbox->setToolTip(traceTt);
+    QObject::connect(_imp->traceCheckbox, SIGNAL(clicked(bool)), this, SLOT(onTraceCheckboxClicked(bool)));
+    
+    _imp->globalInfosLayout->addWidget(_imp->traceLabel);
+    _imp->globalInfosLayout->addWidget(_imp->traceCheckbox);
+    
+    _imp->exportTraceButton = new Button(tr("Export trace..."), _imp->globalInfosContainer);
+    _imp->exportTraceButton->setToolTip(tr("Writes what was recorded while \"Trace\" was checked to a file in the Chrome trace format."));
+    QObject::connect(_imp->exportTraceButton, SIGNAL(clicked(bool)), this, SLOT(exportTrace()));
+    _imp->globalInfosLayout->addWidget(_imp->exportTraceButton);
+    
     _imp->globalInfosLayout->addStretch();
     
     _imp->mainLayout->addWidget(_imp->globalInfosContainer);
@@ -903,7 +1004,8 @@ RenderStatsDialog::RenderStatsDialog(Gui* gui)
     << tr("Rendered Planes")
     << tr("Cache Hits")
     << tr("Cache Hits Higher Scale")
-    << tr("Cache Misses");
+    << tr("Cache Misses")
+    << tr("Plug-in Memory");
     
     _imp->view->setColumnCount( dimensionNames.size() );
     _imp->view->setHorizontalHeaderLabels(dimensionNames);
@@ -977,6 +1079,7 @@ RenderStatsDialog::refreshAdvancedColsVisibility()
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_HIT_DOWNSCALED, !checked);
     _imp->view->setColumnHidden(COL_NB_CACHE_MISS, !checked);
+    _imp->view->setColumnHidden(COL_PLUGIN_MEMORY, !checked);
 }
 
 void
@@ -985,9 +1088,38 @@ RenderStatsDialog::resetStats()
     _imp->model->clearRows();
     _imp->totalTimeSpentValueLabel->setText(QString::fromUtf8("0.0 sec"));
     _imp->totalSpentTime = 0;
+    TraceRecorder::clear();
 }
 
+void
+RenderStatsDialog::onTraceCheckboxClicked(bool checked)
+{
+    TraceRecorder::setEnabled(checked);
+}
 
+void
+RenderStatsDialog::exportTrace()
+{
+    std::vector<std::string> filters;
+    filters.push_back("json");
+    SequenceFileDialog dialog(this, filters, false, SequenceFileDialog::eFileDialogModeSave, "", _imp->gui, false);
+    if ( !dialog.exec() ) {
+        return;
+    }
+    std::string filename = dialog.filesToSave();
+    if ( filename.empty() ) {
+        return;
+    }
+
+    ///Events being recorded while writing could be incomplete
+    bool wasEnabled = TraceRecorder::isEnabled();
+    TraceRecorder::setEnabled(false);
+    std::string error;
+    if ( !TraceRecorder::writeChromeTrace(filename, &error) ) {
+        Dialogs::errorDialog(tr("Export trace").toStdString(), error);
+    }
+    TraceRecorder::setEnabled(wasEnabled);
+}
 
 void
 RenderStatsDialog::addStats(int /*time*/, ViewIdx /*view*/, double wallTime, const std::map<NodePtr,NodeRenderStats >& stats)
@@ -1001,6 +1133,15 @@ RenderStatsDialog::addStats(int /*time*/, ViewIdx /*view*/, double wallTime, con
     _imp->totalSpentTime += wallTime;
     _imp->totalTimeSpentValueLabel->setText(Timer::printAsTime(_imp->totalSpentTime, false));
     
+    MemoryStats memory;
+    appPTR->getMemoryStats(&memory);
+    QString memoryText = tr("%1 cache, %2 plug-ins (%3 pooled) / %4").arg( printAsRAM(memory.nodeCacheSize + memory.viewerCacheSize) )
+                         .arg( printAsRAM(memory.pluginMemorySize) ).arg( printAsRAM(memory.pluginMemoryPoolSize) ).arg( printAsRAM(memory.totalRAM) );
+    if (memory.pressure >= 0) {
+        memoryText += tr(", pressure %1%").arg(memory.pressure, 0, 'f', 1);
+    }
+    _imp->memoryValueLabel->setText(memoryText);
+    
     for (std::map<NodePtr,NodeRenderStats >::const_iterator it = stats.begin(); it!=stats.end(); ++it) {
         _imp->model->editNodeRow(it->first, it->second);
     }
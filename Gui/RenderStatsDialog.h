@@ -72,6 +72,9 @@ public Q_SLOTS:
     void onNameLineEditChanged(const QString& filter);
     void onIDLineEditChanged(const QString& filter);
     
+    void onTraceCheckboxClicked(bool checked);
+    void exportTrace();
+    
 private:
     
     virtual void closeEvent(QCloseEvent * event) OVERRIDE FINAL;
@@ -146,11 +146,11 @@ ViewerTab::manageSlotsForInfoWidget(int textureIndex,
     RenderEngine* engine = _imp->viewerNode->getRenderEngine();
     assert(engine);
     if (connect) {
-        QObject::connect( engine, SIGNAL(fpsChanged(double,double)), _imp->infoWidget[textureIndex], SLOT(setFps(double,double)) );
+        QObject::connect( engine, SIGNAL(fpsChanged(double,double,int)), _imp->infoWidget[textureIndex], SLOT(setFps(double,double,int)) );
         QObject::connect( engine,SIGNAL(renderFinished(int)),_imp->infoWidget[textureIndex],SLOT(hideFps()) );
     } else {
-        QObject::disconnect( engine, SIGNAL(fpsChanged(double,double)), _imp->infoWidget[textureIndex],
-                            SLOT(setFps(double,double)) );
+        QObject::disconnect( engine, SIGNAL(fpsChanged(double,double,int)), _imp->infoWidget[textureIndex],
+                            SLOT(setFps(double,double,int)) );
         QObject::disconnect( engine,SIGNAL(renderFinished(int)),_imp->infoWidget[textureIndex],SLOT(hideFps()) );
     }
 }
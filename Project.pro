@@ -31,6 +31,7 @@ SUBDIRS += \
     Renderer \
     Gui \
     Tests \
+    Benchmarks \
     App
 
 OTHER_FILES += \
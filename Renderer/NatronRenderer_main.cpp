@@ -30,6 +30,7 @@
 
 #include "Engine/AppManager.h"
 #include "Engine/CLArgs.h"
+#include "Engine/RenderCoordinator.h"
 
 NATRON_NAMESPACE_USING
 
@@ -42,6 +43,14 @@ main(int argc,
         return 1;
     }
 
+    if (args.getRenderWorkersCount() > 0) {
+        // The project is loaded by the worker processes only, this process just dispatches the frames
+        QCoreApplication app(argc,argv);
+        RenderCoordinator coordinator(args);
+
+        return coordinator.exec();
+    }
+
     AppManager manager;
 
     // coverity[tainted_data]
@@ -0,0 +1,62 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <climits>
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QStringList>
+
+#include "Engine/CLArgs.h"
+
+NATRON_NAMESPACE_USING
+
+typedef std::list<std::pair<int, std::pair<int, int> > > FrameRangesList;
+
+TEST(CLArgs, NegativeFrameRanges)
+{
+    ///This is also the syntax the RenderCoordinator gives to its workers
+    QStringList args;
+
+    args << QString::fromUtf8("NatronRenderer") << QString::fromUtf8("-w") << QString::fromUtf8("Write1")
+         << QString::fromUtf8("-10--8:1,-3,-2-4,5-7:2") << QString::fromUtf8("/tmp/project.ntp");
+    CLArgs cl(args, true);
+    ASSERT_EQ( 0, cl.getError() );
+
+    std::vector<std::pair<int, std::pair<int, int> > > ranges( cl.getFrameRanges().begin(), cl.getFrameRanges().end() );
+    ASSERT_EQ( 4U, ranges.size() );
+    EXPECT_EQ(1, ranges[0].first);
+    EXPECT_EQ(-10, ranges[0].second.first);
+    EXPECT_EQ(-8, ranges[0].second.second);
+    EXPECT_EQ(INT_MIN, ranges[1].first);
+    EXPECT_EQ(-3, ranges[1].second.first);
+    EXPECT_EQ(-3, ranges[1].second.second);
+    EXPECT_EQ(-2, ranges[2].second.first);
+    EXPECT_EQ(4, ranges[2].second.second);
+    EXPECT_EQ(2, ranges[3].first);
+    EXPECT_EQ(5, ranges[3].second.first);
+    EXPECT_EQ(7, ranges[3].second.second);
+}
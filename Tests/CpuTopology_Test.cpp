@@ -0,0 +1,110 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <gtest/gtest.h>
+
+#include "Global/QtCompat.h"
+
+#include "Engine/CpuTopology.h"
+
+#include "FakeDir.h"
+
+NATRON_NAMESPACE_USING
+
+TEST(CpuTopologyTest,ParseCpuList) {
+    std::vector<int> cpus;
+
+    EXPECT_TRUE( CpuTopology::parseCpuList("0-2,5,8-9", &cpus) );
+    ASSERT_EQ( 6, (int)cpus.size() );
+    EXPECT_EQ( 0, cpus[0] );
+    EXPECT_EQ( 2, cpus[2] );
+    EXPECT_EQ( 5, cpus[3] );
+    EXPECT_EQ( 9, cpus[5] );
+
+    EXPECT_TRUE( CpuTopology::parseCpuList("3", &cpus) );
+    ASSERT_EQ( 1, (int)cpus.size() );
+    EXPECT_EQ( 3, cpus[0] );
+
+    EXPECT_FALSE( CpuTopology::parseCpuList("4-1", &cpus) );
+    EXPECT_FALSE( CpuTopology::parseCpuList("0-", &cpus) );
+    EXPECT_FALSE( CpuTopology::parseCpuList("cpu0", &cpus) );
+}
+
+TEST(CpuTopologyTest,TwoSockets) {
+    QDir dir = makeFakeDir("sysfs");
+
+    //2 sockets of 2 cores with 2 hardware threads, the second NUMA node is numbered 2
+    writeFakeFile(dir, "cpu/online", "0-7\n");
+    writeFakeFile(dir, "node/online", "0,2\n");
+    writeFakeFile(dir, "node/node0/cpulist", "0-1,4-5\n");
+    writeFakeFile(dir, "node/node2/cpulist", "2-3,6-7\n");
+    for (int cpu = 0; cpu < 8; ++cpu) {
+        int package = (cpu % 4) / 2;
+        std::string cpuDir = "cpu/cpu" + QString::number(cpu).toStdString();
+        writeFakeFile(dir, (cpuDir + "/topology/physical_package_id").c_str(), QString::number(package).toStdString() + "\n");
+        writeFakeFile(dir, (cpuDir + "/topology/core_id").c_str(), QString::number(cpu % 2).toStdString() + "\n");
+        writeFakeFile(dir, (cpuDir + "/cache/index0/level").c_str(), "1\n");
+        writeFakeFile(dir, (cpuDir + "/cache/index0/shared_cpu_list").c_str(), QString::fromUtf8("%1,%2\n").arg(cpu % 4).arg(cpu % 4 + 4).toStdString() );
+        writeFakeFile(dir, (cpuDir + "/cache/index1/level").c_str(), "3\n");
+        writeFakeFile(dir, (cpuDir + "/cache/index1/shared_cpu_list").c_str(), package == 0 ? "0-1,4-5\n" : "2-3,6-7\n");
+    }
+
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+
+    EXPECT_EQ( 8, topology.getCpusCount() );
+    EXPECT_EQ( 2, topology.getNumaNodesCount() );
+    EXPECT_EQ( 4, topology.getPhysicalCoresCount() );
+    EXPECT_EQ( 0, topology.getNodeOfCpu(5) );
+    EXPECT_EQ( 1, topology.getNodeOfCpu(6) );
+    EXPECT_EQ( -1, topology.getNodeOfCpu(8) );
+
+    //The first hardware thread of each core comes first
+    std::vector<int> cpus;
+    topology.getCpusOfNode(1, &cpus);
+    ASSERT_EQ( 4, (int)cpus.size() );
+    EXPECT_EQ( 2, cpus[0] );
+    EXPECT_EQ( 3, cpus[1] );
+    EXPECT_EQ( 6, cpus[2] );
+    EXPECT_EQ( 7, cpus[3] );
+
+    const std::vector<CpuInfo>& infos = topology.getCpus();
+    EXPECT_EQ( 0, infos[0].cacheGroup );
+    EXPECT_EQ( 2, infos[7].cacheGroup );
+    EXPECT_EQ( 1, infos[7].smtIndex );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST(CpuTopologyTest,NoSysfs) {
+    QDir dir = makeFakeDir("nosysfs");
+
+    //All the CPUs are on a single node
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+
+    EXPECT_TRUE( topology.getCpusCount() >= 1 );
+    EXPECT_EQ( 1, topology.getNumaNodesCount() );
+    EXPECT_EQ( 0, topology.getNodeOfCpu(0) );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
@@ -22,6 +22,10 @@
 #include <Python.h>
 // ***** END PYTHON BLOCK *****
 
+#include <cmath>
+#include <list>
+#include <vector>
+
 #include <gtest/gtest.h>
 
 #include <QString>
@@ -121,3 +125,93 @@ TEST(Curve,Basic)
 }
 
 
+
+TEST(Curve,GetValuesAt)
+{
+    Curve c;
+
+    c.setYRange(-100., 100.);
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(0.,5.) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(3.,-20.,0.,0.,eKeyframeTypeLinear) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(4.,200.,0.,0.,eKeyframeTypeConstant) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(10.,50.,1.,-2.,eKeyframeTypeBroken) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(12.,0.,0.,0.,eKeyframeTypeCatmullRom) ) );
+
+    // increasing times, crossing every segment including before the first and after the last keyframe
+    const int n = 81;
+    std::vector<double> times(n);
+    for (int i = 0; i < n; ++i) {
+        times[i] = -3. + i * 0.25;
+    }
+    // followed by unsorted times
+    times.push_back(11.5);
+    times.push_back(-1.);
+    times.push_back(4.);
+    times.push_back(3.99);
+
+    std::vector<double> values( times.size() );
+    c.getValuesAt(&times[0], &values[0], (int)times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i]), values[i] );
+    }
+
+    c.getValuesAt(&times[0], &values[0], (int)times.size(), false);
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i], false), values[i] );
+    }
+
+    // the evaluation cache must follow keyframe changes
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(5.,-50.) ) );
+    c.getValuesAt(&times[0], &values[0], (int)times.size());
+    for (std::size_t i = 0; i < times.size(); ++i) {
+        EXPECT_EQ( c.getValueAt(times[i]), values[i] );
+    }
+    c.removeKeyFrameWithTime(5.);
+    double t = 5.;
+    double v;
+    c.getValuesAt(&t, &v, 1);
+    EXPECT_EQ( 200., c.getValueAt(5., false) );
+    EXPECT_EQ( 100., v );
+}
+
+TEST(Curve,AddKeyFrames)
+{
+    Curve c;
+
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(2.,7.,0.,0.,eKeyframeTypeConstant) ) );
+    EXPECT_TRUE( c.addKeyFrame( KeyFrame(20.,8.,0.,0.,eKeyframeTypeConstant) ) );
+
+    // unsorted, with a key replacing an existing one and two keys at the same time
+    std::vector<KeyFrame> keys;
+    keys.push_back( KeyFrame(10.,1.,0.,0.,eKeyframeTypeConstant) );
+    keys.push_back( KeyFrame(0.,2.,0.,0.,eKeyframeTypeConstant) );
+    keys.push_back( KeyFrame(20.,3.,0.,0.,eKeyframeTypeConstant) );
+    keys.push_back( KeyFrame(5.,4.,0.,0.,eKeyframeTypeConstant) );
+    keys.push_back( KeyFrame(5.,5.,0.,0.,eKeyframeTypeConstant) );
+
+    std::list<double> keysAdded;
+    c.addKeyFrames(keys, &keysAdded);
+    EXPECT_EQ( 5, c.getKeyFramesCount() );
+    EXPECT_EQ( 3, (int)keysAdded.size() );
+    EXPECT_EQ( 2., c.getValueAt(0.) );
+    EXPECT_EQ( 7., c.getValueAt(2.) );
+    EXPECT_EQ( 5., c.getValueAt(5.) ); // the last key at a given time wins
+    EXPECT_EQ( 1., c.getValueAt(15.) );
+    EXPECT_EQ( 3., c.getValueAt(20.) );
+
+    // adding keys one at a time or at once must give the same curve
+    Curve single, bulk;
+    std::vector<KeyFrame> smoothKeys;
+    for (int i = 0; i < 100; ++i) {
+        KeyFrame k(i * 2., std::sin(i * 0.3) * 10.);
+        smoothKeys.push_back(k);
+    }
+    bulk.addKeyFrames(smoothKeys);
+    for (std::size_t i = 0; i < smoothKeys.size(); ++i) {
+        EXPECT_TRUE( single.addKeyFrame(smoothKeys[i]) );
+    }
+    EXPECT_EQ( single.getKeyFramesCount(), bulk.getKeyFramesCount() );
+    for (double t = -5.; t < 205.; t += 0.5) {
+        EXPECT_NEAR( single.getValueAt(t, false), bulk.getValueAt(t, false), 1e-9 );
+    }
+}
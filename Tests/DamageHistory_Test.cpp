@@ -0,0 +1,140 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <list>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/DamageHistory.h"
+
+NATRON_NAMESPACE_USING
+
+// A change of the knobs of a node without inputs, the damage being reported before the knobs age is incremented
+static void
+changeKnobs(DamageHistory* history,
+            U64 oldHash,
+            U64 newHash,
+            const RectD& damage)
+{
+    history->reportDamagedRegion(damage, true, 0);
+    history->onKnobsAgeIncremented();
+    history->onHashChanged( oldHash, newHash, std::vector<DamageInputState>() );
+}
+
+TEST(DamageHistory, ReportedRegion)
+{
+    DamageHistory history;
+
+    history.onHashChanged( 0, 1, std::vector<DamageInputState>() );
+    changeKnobs( &history, 1, 2, RectD(0, 0, 10, 10) );
+    changeKnobs( &history, 2, 3, RectD(20, 20, 30, 30) );
+
+    std::vector<U64> hashes;
+    history.getOlderHashes(3, &hashes);
+    ASSERT_EQ(2U, hashes.size());
+    EXPECT_EQ(2U, hashes[0]);
+    EXPECT_EQ(1U, hashes[1]);
+
+    std::list<DamageRecord> records;
+    ASSERT_TRUE( history.getChanges(1, 3, &records) );
+    ASSERT_EQ(2U, records.size());
+    RectD region;
+    ASSERT_TRUE( records.front().knobsDamage.getRegionAtTime(0, &region) );
+    EXPECT_TRUE( region == RectD(20, 20, 30, 30) );
+
+    ///The first hash was computed without knowing the inputs
+    records.clear();
+    EXPECT_FALSE( history.getChanges(0, 3, &records) );
+}
+
+TEST(DamageHistory, UnreportedChange)
+{
+    DamageHistory history;
+
+    history.onHashChanged( 0, 1, std::vector<DamageInputState>() );
+    history.onKnobsAgeIncremented();
+    history.onHashChanged( 1, 2, std::vector<DamageInputState>() );
+    changeKnobs( &history, 2, 3, RectD(0, 0, 10, 10) );
+
+    std::vector<U64> hashes;
+    history.getOlderHashes(3, &hashes);
+    ASSERT_EQ(1U, hashes.size());
+    EXPECT_EQ(2U, hashes[0]);
+
+    std::list<DamageRecord> records;
+    EXPECT_FALSE( history.getChanges(1, 3, &records) );
+}
+
+TEST(DamageHistory, ReportAfterIncrement)
+{
+    DamageHistory history;
+
+    history.onHashChanged( 0, 1, std::vector<DamageInputState>() );
+
+    ///The plug-in reports the damage from its instance changed action, once the hash changed
+    history.beginChange();
+    history.onKnobsAgeIncremented();
+    history.onHashChanged( 1, 2, std::vector<DamageInputState>() );
+    std::list<DamageRecord> records;
+    EXPECT_FALSE( history.getChanges(1, 2, &records) );
+    history.reportDamagedRegion(RectD(0, 0, 10, 10), false, 5);
+    history.endChange();
+
+    ASSERT_TRUE( history.getChanges(1, 2, &records) );
+    RectD region;
+    EXPECT_TRUE( records.front().knobsDamage.getRegionAtTime(5, &region) );
+    EXPECT_FALSE( records.front().knobsDamage.getRegionAtTime(6, &region) );
+
+    ///Nothing reported during the change
+    history.beginChange();
+    history.onKnobsAgeIncremented();
+    history.onHashChanged( 2, 3, std::vector<DamageInputState>() );
+    history.endChange();
+    records.clear();
+    EXPECT_FALSE( history.getChanges(2, 3, &records) );
+}
+
+TEST(DamageHistory, InputChange)
+{
+    DamageHistory history;
+    const Node* input = reinterpret_cast<const Node*>(0x10);
+    std::vector<DamageInputState> inputs(1, DamageInputState(input, 100));
+
+    history.onHashChanged(0, 1, inputs);
+    inputs[0].hash = 101;
+    history.onHashChanged(1, 2, inputs);
+
+    std::list<DamageRecord> records;
+    ASSERT_TRUE( history.getChanges(1, 2, &records) );
+    ASSERT_EQ(1U, records.front().inputs.size());
+    EXPECT_EQ(100U, records.front().inputs[0].oldHash);
+    EXPECT_EQ(101U, records.front().inputs[0].newHash);
+
+    ///Disconnecting the input changes everything
+    inputs[0] = DamageInputState();
+    history.onHashChanged(2, 3, inputs);
+    records.clear();
+    EXPECT_FALSE( history.getChanges(2, 3, &records) );
+}
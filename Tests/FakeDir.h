@@ -0,0 +1,70 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+#ifndef FAKEDIR_H
+#define FAKEDIR_H
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <string>
+
+#include "Global/Macros.h"
+
+#include <QString>
+#include <QDir>
+#include <QFileInfo>
+
+#include "Engine/FStreamsSupport.h"
+#include "Engine/StandardPaths.h"
+
+NATRON_NAMESPACE_ENTER
+
+///Returns the directory NatronUnitTest/name in the temporary directory, created if needed.
+///The tests fill it with fake system files (sysfs, cgroup...) to read them instead of the ones of the host.
+inline QDir
+makeFakeDir(const char* name)
+{
+    QDir dir( StandardPaths::writableLocation(StandardPaths::eStandardLocationTemp) );
+
+    dir.mkpath( QString::fromUtf8("NatronUnitTest/") + QString::fromUtf8(name) );
+    dir.cd( QString::fromUtf8("NatronUnitTest/") + QString::fromUtf8(name) );
+
+    return dir;
+}
+
+///Writes content to the file at relativePath in dir, creating the directories on the way
+inline void
+writeFakeFile(const QDir& dir,
+              const char* relativePath,
+              const std::string& content)
+{
+    QString path = dir.absoluteFilePath( QString::fromUtf8(relativePath) );
+
+    QDir().mkpath( QFileInfo(path).absolutePath() );
+    FStreamsSupport::ofstream ofile;
+    FStreamsSupport::open( &ofile, path.toStdString() );
+    ofile << content;
+}
+
+NATRON_NAMESPACE_EXIT
+
+#endif // FAKEDIR_H
@@ -0,0 +1,151 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cmath>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/Image.h"
+#include "Engine/ImageResampler.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+// A ramp with a different value for each pixel and component
+static std::vector<float>
+makeRamp(const RectI& bounds,
+         int nComps)
+{
+    std::vector<float> pixels( (std::size_t)bounds.width() * bounds.height() * nComps );
+
+    for (int y = bounds.y1; y < bounds.y2; ++y) {
+        for (int x = bounds.x1; x < bounds.x2; ++x) {
+            for (int c = 0; c < nComps; ++c) {
+                pixels[( (std::size_t)(y - bounds.y1) * bounds.width() + (x - bounds.x1) ) * nComps + c] = x + 100.f * y + 0.1f * c;
+            }
+        }
+    }
+
+    return pixels;
+}
+
+TEST(ImageResampler, Identity)
+{
+    RectI bounds(0, 0, 32, 32);
+    std::vector<float> src = makeRamp(bounds, 4);
+
+    for (int filter = eResampleFilterBilinear; filter <= eResampleFilterLanczos; ++filter) {
+        std::vector<float> dst(src.size(), -1.f);
+        ImageResampler::resample(&src[0], bounds, 4, Transform::Matrix3x3(), (ResampleFilterEnum)filter, bounds, &dst[0], bounds);
+        EXPECT_TRUE(dst == src);
+    }
+}
+
+TEST(ImageResampler, Translate)
+{
+    RectI bounds(0, 0, 32, 32);
+    std::vector<float> src = makeRamp(bounds, 1);
+    std::vector<float> dst(src.size(), -1.f);
+
+    // An integer translation is a copy, the pixels coming from outside of the source are black
+    ImageResampler::resample(&src[0], bounds, 1, Transform::Matrix3x3(1, 0, 10, 0, 1, -3, 0, 0, 1), eResampleFilterLanczos, bounds, &dst[0], bounds);
+    EXPECT_EQ(src[2 * 32 + 15], dst[5 * 32 + 5]);
+    EXPECT_EQ(0.f, dst[1 * 32 + 5]);
+    EXPECT_EQ(0.f, dst[5 * 32 + 25]);
+
+    // Half a pixel: bilinear averages two pixels, cubic reproduces a linear ramp
+    ImageResampler::resample(&src[0], bounds, 1, Transform::Matrix3x3(1, 0, 0.5, 0, 1, 0, 0, 0, 1), eResampleFilterBilinear, bounds, &dst[0], bounds);
+    EXPECT_NEAR(1010.5f, dst[10 * 32 + 10], 1e-3);
+    ImageResampler::resample(&src[0], bounds, 1, Transform::Matrix3x3(1, 0, 0.25, 0, 1, 0.75, 0, 0, 1), eResampleFilterCubic, bounds, &dst[0], bounds);
+    EXPECT_NEAR(1085.25f, dst[10 * 32 + 10], 1e-2);
+}
+
+TEST(ImageResampler, Minify)
+{
+    RectI srcBounds(-200, -200, 600, 600);
+    RectI dstBounds(0, 0, 32, 32);
+    std::vector<float> src( (std::size_t)srcBounds.width() * srcBounds.height(), 0.7f );
+    Transform::Matrix3x3 dstToSrc(8, 0, 3, 0, 8, -7, 0, 0, 1);
+
+    EXPECT_EQ(3U, ImageResampler::getMipMapLevel(dstToSrc, dstBounds));
+    EXPECT_EQ(0U, ImageResampler::getMipMapLevel(Transform::Matrix3x3(1.5, 0, 0, 0, 1.5, 0, 0, 0, 1), dstBounds));
+
+    // A constant image stays constant whatever the filter
+    for (int filter = eResampleFilterBilinear; filter <= eResampleFilterLanczos; ++filter) {
+        std::vector<float> dst(dstBounds.width() * dstBounds.height(), -1.f);
+        ImageResampler::resample(&src[0], srcBounds, 1, dstToSrc, (ResampleFilterEnum)filter, dstBounds, &dst[0], dstBounds);
+        for (std::size_t i = 0; i < dst.size(); ++i) {
+            EXPECT_NEAR(0.7f, dst[i], 1e-4);
+        }
+    }
+
+    // A perspective transform crossing the horizon gives black behind it and no NaN
+    std::vector<float> dst(dstBounds.width() * dstBounds.height(), -1.f);
+    ImageResampler::resample(&src[0], srcBounds, 1, Transform::Matrix3x3(4, 0, 0, 0, 4, 0, 0.01, -0.05, 1), eResampleFilterCubic, dstBounds, &dst[0], dstBounds);
+    for (std::size_t i = 0; i < dst.size(); ++i) {
+        EXPECT_TRUE(dst[i] == dst[i]);
+    }
+    EXPECT_EQ(0.f, dst[31 * 32]);
+}
+
+TEST_F(BaseTest, ImageResamplerSourceRoI)
+{
+    RectI bounds(0, 0, 16, 16);
+    RectI srcRoI(4, 4, 12, 12);
+    Image src(ImageComponents::getAlphaComponents(), RectD(0, 0, 16, 16), bounds, 0, 1., eImageBitDepthFloat, eImagePremultiplicationPremultiplied, eImageFieldingOrderNone);
+    Image dst(ImageComponents::getAlphaComponents(), RectD(0, 0, 16, 16), bounds, 0, 1., eImageBitDepthFloat, eImagePremultiplicationPremultiplied, eImageFieldingOrderNone);
+    {
+        // Only the RoI was rendered, the rest of the bounds holds garbage
+        Image::WriteAccess acc = src.getWriteRights();
+        for (int y = bounds.y1; y < bounds.y2; ++y) {
+            for (int x = bounds.x1; x < bounds.x2; ++x) {
+                *(float*)acc.pixelAt(x, y) = srcRoI.contains(x, y) ? 1.f : 1000.f;
+            }
+        }
+    }
+
+    // The garbage is never read, whether the source is copied or filtered
+    EXPECT_TRUE( ImageResampler::resample(src, srcRoI, Transform::Matrix3x3(), eResampleFilterCubic, bounds, &dst) );
+    {
+        Image::ReadAccess acc = dst.getReadRights();
+        for (int y = bounds.y1; y < bounds.y2; ++y) {
+            for (int x = bounds.x1; x < bounds.x2; ++x) {
+                EXPECT_EQ(srcRoI.contains(x, y) ? 1.f : 0.f, *(const float*)acc.pixelAt(x, y));
+            }
+        }
+    }
+    EXPECT_TRUE( ImageResampler::resample(src, srcRoI, Transform::Matrix3x3(1, 0, 0.5, 0, 1, 0.5, 0, 0, 1), eResampleFilterBilinear, bounds, &dst) );
+    {
+        Image::ReadAccess acc = dst.getReadRights();
+        for (int y = bounds.y1; y < bounds.y2; ++y) {
+            for (int x = bounds.x1; x < bounds.x2; ++x) {
+                EXPECT_TRUE(*(const float*)acc.pixelAt(x, y) <= 1.f + 1e-5);
+            }
+        }
+        EXPECT_NEAR(1.f, *(const float*)acc.pixelAt(6, 6), 1e-5);
+        EXPECT_NEAR(0.25f, *(const float*)acc.pixelAt(12, 12), 1e-5);
+    }
+}
@@ -109,6 +109,64 @@ TEST(BitmapTest,SimpleRect) {
     EXPECT_TRUE(nonRenderedRects.size() == 3);
 }
 
+TEST(BitmapTest,TileBoundaries) {
+    ///Bounds which are not a multiple of the tile size, with a negative origin
+    RectI rod(-50,-30,250,170);
+    Bitmap bm(rod);
+    EXPECT_EQ(0, bm.getMixedTilesCount());
+
+    ///The tiles come on top of the per-pixel map: one more byte for each of the 5x4 tiles
+    EXPECT_EQ( (std::size_t)(rod.area() + 20), bm.getMemorySize() );
+
+    ///Rendered area that does not fall on tile boundaries
+    RectI xBox(-13,5,201,117);
+    bm.markForRendered(xBox);
+    EXPECT_TRUE(bm.getMixedTilesCount() > 0);
+
+    std::list<RectI> nonRenderedRects;
+    bm.minimalNonMarkedRects(rod, nonRenderedRects);
+    EXPECT_EQ(4, (int)nonRenderedRects.size());
+    int nonRenderedArea = 0;
+    for (std::list<RectI>::iterator it = nonRenderedRects.begin(); it != nonRenderedRects.end(); ++it) {
+        EXPECT_FALSE( it->intersects(xBox) );
+        nonRenderedArea += it->area();
+    }
+    EXPECT_EQ(rod.area() - xBox.area(), nonRenderedArea);
+
+    ///The bbox of what is left to render inside the rendered area is empty, and is precise on its edges
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(xBox).isNull() );
+    RectI roi(-20,0,202,118);
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(roi) == roi );
+    RectI edge(-13,5,202,117);
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(edge) == RectI(201,5,202,117) );
+
+    ///A single pixel being rendered elsewhere inside a rendered tile
+    RectI pixel(100,60,101,61);
+    bm.markForRendering(pixel);
+    bool beingRenderedElseWhere = false;
+    EXPECT_TRUE( bm.minimalNonMarkedBbox_trimap(xBox, &beingRenderedElseWhere).isNull() );
+    EXPECT_TRUE(beingRenderedElseWhere);
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(xBox) == pixel );
+
+    ///Once everything is rendered all the tiles become uniform again
+    bm.markForRendered(rod);
+    EXPECT_EQ(0, bm.getMixedTilesCount());
+    nonRenderedRects.clear();
+    bm.minimalNonMarkedRects(rod, nonRenderedRects);
+    EXPECT_TRUE( nonRenderedRects.empty() );
+
+    ///Writing directly into the map requires to refresh the tiles
+    char* map = bm.getBitmap();
+    map[0] = 0;
+    bm.refreshTilesState(RectI(rod.x1,rod.y1,rod.x1 + 1,rod.y1 + 1));
+    EXPECT_EQ(1, bm.getMixedTilesCount());
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(rod) == RectI(rod.x1,rod.y1,rod.x1 + 1,rod.y1 + 1) );
+
+    bm.clear(rod);
+    EXPECT_EQ(0, bm.getMixedTilesCount());
+    EXPECT_TRUE( bm.minimalNonMarkedBbox(rod) == rod );
+}
+
 TEST(ImageKeyTest,Equality) {
     srand(2000);
     // coverity[dont_call]
@@ -152,3 +210,34 @@ TEST(ImageKeyTest,Difference) {
     ASSERT_TRUE(keyHash1 != keyHash2);
 }
 
+
+TEST(ImageTest,DownscaleMipMap) {
+    RectI bounds(0,0,16,16);
+    RectD rod(0,0,16,16);
+    Image src(ImageComponents::getRGBAComponents(), rod, bounds, 0, 1., eImageBitDepthFloat,
+              eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, true);
+    src.fill(bounds, 1.f, 1.f);
+    ///The 6 first columns are black, which does not fall on the mipmap blocks
+    src.fill(RectI(0,0,6,16), 0.f, 0.f);
+    src.markForRendered(bounds);
+
+    RectI dstBounds = bounds.downscalePowerOfTwoSmallestEnclosing(2);
+    Image dst(ImageComponents::getRGBAComponents(), rod, dstBounds, 2, 1., eImageBitDepthFloat,
+              eImagePremultiplicationPremultiplied, eImageFieldingOrderNone, true);
+    src.downscaleMipMap(rod, bounds, 0, 2, true, &dst);
+
+    const float expected[4] = { 0.f, 0.5f, 1.f, 1.f };
+    for (int y = dstBounds.y1; y < dstBounds.y2; ++y) {
+        const float* pix = (const float*)dst.pixelAt(dstBounds.x1, y);
+        for (int x = dstBounds.x1; x < dstBounds.x2; ++x) {
+            for (int k = 0; k < 4; ++k) {
+                EXPECT_FLOAT_EQ(expected[x], pix[x * 4 + k]);
+            }
+        }
+    }
+
+    ///Everything was rendered in the source, so is the mipmap
+    std::list<RectI> rest;
+    dst.getRestToRender(dstBounds, rest);
+    EXPECT_TRUE( rest.empty() );
+}
@@ -0,0 +1,142 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <gtest/gtest.h>
+
+#include "Global/QtCompat.h"
+
+#include "Engine/MemoryGovernor.h"
+
+#include "FakeDir.h"
+
+NATRON_NAMESPACE_USING
+
+#define MB (1024ULL * 1024ULL)
+
+TEST(MemoryGovernorTest,CgroupV2) {
+    QDir dir = makeFakeDir("cgroupv2");
+
+    writeFakeFile(dir, "proc_self_cgroup", "0::/farm/job\n");
+    writeFakeFile(dir, "cgroup.controllers", "cpu memory\n");
+    writeFakeFile(dir, "farm/memory.max", "1073741824\n");
+    writeFakeFile(dir, "farm/job/memory.max", "max\n");
+    writeFakeFile(dir, "farm/job/memory.high", "max\n");
+    writeFakeFile(dir, "farm/job/memory.current", "805306368\n");
+    writeFakeFile(dir, "farm/job/memory.stat", "anon 536870912\nfile 268435456\ninactive_file 268435456\n");
+    writeFakeFile(dir, "farm/job/memory.pressure", "some avg10=0.00 avg60=0.00 avg300=0.00 total=0\nfull avg10=0.00 avg60=0.00 avg300=0.00 total=0\n");
+
+    std::string root = dir.absolutePath().toStdString();
+    MemoryGovernor governor( root, root + "/proc_self_cgroup", 16384 * MB );
+
+    //The limit of the parent applies, the reclaimable file pages are not counted as used
+    EXPECT_EQ( 2, governor.getCgroupVersion() );
+    EXPECT_EQ( 1024 * MB, governor.getTotalRAM() );
+    EXPECT_EQ( 1., governor.getBudgetFactor() );
+    EXPECT_TRUE( governor.getFreeRAM() <= 512 * MB );
+
+    MemoryStats stats;
+    governor.getStats(&stats);
+    EXPECT_EQ( 1024 * MB, stats.cgroupLimit );
+    EXPECT_EQ( 512 * MB, stats.cgroupUsage );
+    EXPECT_EQ( 0., stats.pressure );
+
+    //Plug-ins may not allocate more than the budget
+    EXPECT_TRUE( governor.canAllocatePluginMemory(1024 * MB) );
+    governor.registerPluginMemory(768 * MB);
+    EXPECT_FALSE( governor.canAllocatePluginMemory(512 * MB) );
+
+    //The usage is only read again by refresh(), the memory freed and allocated meanwhile is accounted for
+    writeFakeFile(dir, "farm/job/memory.current", "1073741824\n");
+    governor.registerFreedMemory(128 * MB);
+    governor.getStats(&stats);
+    EXPECT_EQ( 384 * MB, stats.cgroupUsage );
+    governor.registerAllocatedMemory(192 * MB);
+    governor.getStats(&stats);
+    EXPECT_EQ( 576 * MB, stats.cgroupUsage );
+    EXPECT_TRUE( governor.getFreeRAM() <= 448 * MB );
+    EXPECT_FALSE( governor.refresh(true) );
+    governor.getStats(&stats);
+    EXPECT_EQ( 768 * MB, stats.cgroupUsage );
+    EXPECT_TRUE( governor.getFreeRAM() <= 256 * MB );
+
+    //Under pressure the budgets shrink
+    writeFakeFile(dir, "farm/job/memory.pressure", "some avg10=35.00 avg60=10.00 avg300=2.00 total=1000\nfull avg10=20.00 avg60=5.00 avg300=1.00 total=500\n");
+    EXPECT_TRUE( governor.refresh(true) );
+    EXPECT_DOUBLE_EQ( 1. - 0.5 * (1. - NATRON_MEMORY_BUDGET_MIN_FACTOR), governor.getBudgetFactor() );
+    EXPECT_FALSE( governor.canAllocatePluginMemory(1) );
+
+    writeFakeFile(dir, "farm/job/memory.pressure", "some avg10=90.00 avg60=10.00 avg300=2.00 total=1000\nfull avg10=20.00 avg60=5.00 avg300=1.00 total=500\n");
+    EXPECT_TRUE( governor.refresh(true) );
+    EXPECT_EQ( NATRON_MEMORY_BUDGET_MIN_FACTOR, governor.getBudgetFactor() );
+
+    //Not refreshed again before the refresh interval
+    writeFakeFile(dir, "farm/job/memory.pressure", "some avg10=0.00 avg60=10.00 avg300=2.00 total=1000\n");
+    EXPECT_FALSE( governor.refresh() );
+    EXPECT_EQ( NATRON_MEMORY_BUDGET_MIN_FACTOR, governor.getBudgetFactor() );
+    EXPECT_TRUE( governor.refresh(true) );
+    EXPECT_EQ( 1., governor.getBudgetFactor() );
+
+    governor.registerPluginMemory(-768 * (qint64)MB);
+    EXPECT_TRUE( governor.canAllocatePluginMemory(1024 * MB) );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST(MemoryGovernorTest,CgroupV1) {
+    QDir dir = makeFakeDir("cgroupv1");
+
+    writeFakeFile(dir, "proc_self_cgroup", "5:cpu,cpuacct:/docker/abc\n4:memory:/docker/abc\n");
+    writeFakeFile(dir, "memory/memory.limit_in_bytes", "9223372036854771712\n");
+    writeFakeFile(dir, "memory/docker/abc/memory.limit_in_bytes", "2147483648\n");
+    writeFakeFile(dir, "memory/docker/abc/memory.usage_in_bytes", "1073741824\n");
+    writeFakeFile(dir, "memory/docker/abc/memory.stat", "cache 0\nhierarchical_memory_limit 2147483648\ntotal_inactive_file 0\n");
+
+    std::string root = dir.absolutePath().toStdString();
+    MemoryGovernor governor( root, root + "/proc_self_cgroup", 16384 * MB );
+
+    EXPECT_EQ( 1, governor.getCgroupVersion() );
+    EXPECT_EQ( 2048 * MB, governor.getTotalRAM() );
+    EXPECT_TRUE( governor.getFreeRAM() <= 1024 * MB );
+
+    //No PSI with cgroup v1
+    MemoryStats stats;
+    governor.getStats(&stats);
+    EXPECT_EQ( -1., stats.pressure );
+    EXPECT_EQ( 1., stats.budgetFactor );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST(MemoryGovernorTest,NoCgroup) {
+    QDir dir = makeFakeDir("nocgroup");
+    std::string root = dir.absolutePath().toStdString();
+    MemoryGovernor governor( root, root + "/proc_self_cgroup", 16384 * MB );
+
+    //Falls back on the system RAM
+    EXPECT_EQ( 0, governor.getCgroupVersion() );
+    EXPECT_EQ( 16384 * MB, governor.getTotalRAM() );
+    EXPECT_EQ( 1., governor.getBudgetFactor() );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
@@ -0,0 +1,188 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#include <gtest/gtest.h>
+
+#include "Engine/OfxPluginCacheFile.h"
+
+NATRON_NAMESPACE_USING
+
+/**
+ * @brief Records the elements it receives as text
+ **/
+class OfxPluginCacheFileRecorder
+    : public OfxPluginCacheFileHandler
+{
+public:
+
+    std::string elements;
+
+    virtual void elementBegin(const char* name,
+                              const char** attributes) OVERRIDE FINAL
+    {
+        elements += std::string("<") + name;
+        for (int i = 0; attributes[i]; i += 2) {
+            elements += std::string(" ") + attributes[i] + "=" + attributes[i + 1];
+        }
+        elements += ">";
+    }
+
+    virtual void elementCharacters(const char* data,
+                                   int length) OVERRIDE FINAL
+    {
+        elements.append(data, length);
+    }
+
+    virtual void elementEnd(const char* name) OVERRIDE FINAL
+    {
+        elements += std::string("</") + name + ">";
+    }
+};
+
+static void
+writeBinary(const std::string & path,
+            const std::string & content)
+{
+    std::ofstream ofs( path.c_str(), std::ios::binary | std::ios::trunc );
+
+    ofs << content;
+}
+
+/**
+ * @brief A cache in the format written by OFX::Host::PluginCache, with one bundle per binary
+ **/
+static std::string
+makeXMLCache(const std::string & binaryA,
+             const std::string & binaryB)
+{
+    std::stringstream ss;
+
+    ss << "<cache version=\"NatronOFXCachev1\">\n";
+    const std::string binaries[2] = { binaryA, binaryB };
+    for (int i = 0; i < 2; ++i) {
+        struct stat sb;
+        stat(binaries[i].c_str(), &sb);
+        ss << "<bundle>\n"
+           << "  <binary bundle_path=\"" << binaries[i] << ".bundle\" path=\"" << binaries[i]
+           << "\" mtime=\"" << (int)sb.st_mtime << "\" size=\"" << (int)sb.st_size << "\"/>\n"
+           << "  <plugin name=\"fr.inria.test" << i << "\" index=\"0\" api=\"OfxImageEffectPluginAPI\" api_version=\"1\" major_version=\"1\" minor_version=\"0\">\n"
+           << "   <property name=\"OfxPropLabel\" type=\"string\" dimension=\"1\">\n"
+           << "    <string value=\"Test &amp; &quot;plugin&quot; " << i << "\"/>\n"
+           << "   </property>\n"
+           << "  </plugin>\n"
+           << "</bundle>\n";
+    }
+    ss << "</cache>\n";
+
+    return ss.str();
+}
+
+TEST(OfxPluginCacheFile, WriteAndReplay)
+{
+    std::string binaryA("OfxPluginCacheFileTestA.ofx");
+    std::string binaryB("OfxPluginCacheFileTestB.ofx");
+    std::string cachePath("OfxPluginCacheFileTest.bin");
+
+    writeBinary(binaryA, "a");
+    writeBinary(binaryB, "b");
+    std::string xml = makeXMLCache(binaryA, binaryB);
+
+    ASSERT_TRUE( OfxPluginCacheFile::write(xml, cachePath) );
+
+    OfxPluginCacheFile file;
+    ASSERT_TRUE( file.open(cachePath) );
+    EXPECT_EQ( OfxPluginCacheFile::hashXML(xml), file.getXMLHash() );
+    EXPECT_EQ( 2, file.getBundlesCount() );
+
+    OfxPluginCacheFileRecorder all;
+    EXPECT_EQ( 0, file.replay(&all) );
+    EXPECT_TRUE( all.elements.find("<string value=Test & \"plugin\" 1></string>") != std::string::npos );
+    EXPECT_TRUE( all.elements.find("<cache version=NatronOFXCachev1>") == 0 );
+    EXPECT_TRUE( all.elements.find("</cache>") != std::string::npos );
+
+    ///The bundle of a binary which changed is not replayed
+    writeBinary(binaryB, "bb");
+    OfxPluginCacheFileRecorder changed;
+    EXPECT_EQ( 1, file.replay(&changed) );
+    EXPECT_TRUE( changed.elements.find("fr.inria.test0") != std::string::npos );
+    EXPECT_TRUE( changed.elements.find("fr.inria.test1") == std::string::npos );
+    EXPECT_TRUE( changed.elements.find("</cache>") != std::string::npos );
+
+    ///Rewriting replaces the file, the mapping of the previous one stays valid
+    std::string newXML = makeXMLCache(binaryA, binaryB);
+    ASSERT_TRUE( OfxPluginCacheFile::write(newXML, cachePath) );
+    OfxPluginCacheFileRecorder previous;
+    EXPECT_EQ( 1, file.replay(&previous) );
+    EXPECT_EQ( changed.elements, previous.elements );
+    ASSERT_TRUE( file.open(cachePath) );
+    EXPECT_EQ( OfxPluginCacheFile::hashXML(newXML), file.getXMLHash() );
+    OfxPluginCacheFileRecorder rewritten;
+    EXPECT_EQ( 0, file.replay(&rewritten) );
+    file.close();
+
+    std::remove( binaryA.c_str() );
+    std::remove( binaryB.c_str() );
+    std::remove( cachePath.c_str() );
+}
+
+TEST(OfxPluginCacheFile, InvalidFiles)
+{
+    std::string cachePath("OfxPluginCacheFileTestInvalid.bin");
+    OfxPluginCacheFile file;
+
+    std::remove( cachePath.c_str() );
+    EXPECT_FALSE( file.open(cachePath) );
+
+    ///An XML cache is not a binary cache
+    writeBinary(cachePath, "<cache version=\"NatronOFXCachev1\">\n</cache>\n");
+    EXPECT_FALSE( file.open(cachePath) );
+    EXPECT_FALSE( file.isOpened() );
+
+    ///A truncated file
+    ASSERT_TRUE( OfxPluginCacheFile::write("<cache version=\"NatronOFXCachev1\">\n</cache>\n", cachePath) );
+    EXPECT_TRUE( file.open(cachePath) );
+    file.close();
+    std::string content;
+    {
+        std::ifstream ifs( cachePath.c_str(), std::ios::binary );
+        std::stringstream ss;
+        ss << ifs.rdbuf();
+        content = ss.str();
+    }
+    writeBinary( cachePath, content.substr(0, content.size() - 1) );
+    EXPECT_FALSE( file.open(cachePath) );
+
+    ///Invalid XML is not written
+    EXPECT_FALSE( OfxPluginCacheFile::write("<cache>", cachePath) );
+
+    std::remove( cachePath.c_str() );
+}
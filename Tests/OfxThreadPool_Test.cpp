@@ -0,0 +1,333 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <new> // std::bad_alloc
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QAtomicInt>
+#include <QThread>
+
+#include "Global/QtCompat.h"
+
+#include "Engine/CpuTopology.h"
+#include "Engine/OfxThreadPool.h"
+#include "Engine/Timer.h"
+
+#include "BaseTest.h"
+#include "FakeDir.h"
+
+NATRON_NAMESPACE_USING
+
+///The number of threads of the pool on each of the 2 NUMA nodes of the fake topology
+#define OFX_THREAD_POOL_TEST_THREADS_PER_NODE 2
+
+/**
+ * @brief What the thread functions below record, each thread index writes its own element of the vectors
+ **/
+struct OfxThreadPoolTestData
+{
+    OfxThreadPool* pool;
+
+    //The number of calls made for each thread index
+    std::vector<int> calls;
+
+    //The NUMA node of the thread that made the call for each thread index
+    std::vector<int> nodes;
+
+    //The thread that made the call for each thread index
+    std::vector<const QThread*> threads;
+
+    //The thread functions wait until this many of them were called
+    int barrier;
+    QAtomicInt arrived;
+
+    //The number of thread functions running and its highest value
+    QAtomicInt running;
+    QAtomicInt maxRunning;
+
+    OfxThreadPoolTestData(OfxThreadPool* pool,
+                          unsigned int nThreads)
+        : pool(pool)
+        , calls(nThreads, 0)
+        , nodes(nThreads, -1)
+        , threads(nThreads, (const QThread*)0)
+        , barrier(0)
+        , arrived(0)
+        , running(0)
+        , maxRunning(0)
+    {
+    }
+};
+
+/**
+ * @brief Makes a fake sysfs tree of 2 NUMA nodes, the even CPUs on the first one and the odd CPUs on the second
+ **/
+static QDir
+makeFakeTopology()
+{
+    QDir dir = makeFakeDir("ofxthreadpool");
+
+    writeFakeFile(dir, "cpu/online", "0-3\n");
+    writeFakeFile(dir, "node/online", "0-1\n");
+    writeFakeFile(dir, "node/node0/cpulist", "0,2\n");
+    writeFakeFile(dir, "node/node1/cpulist", "1,3\n");
+
+    return dir;
+}
+
+static void
+waitSeconds(double seconds)
+{
+    TimeLapse t;
+
+    while (t.getTimeSinceCreation() < seconds) {
+    }
+}
+
+static void
+recordCall(unsigned int threadIndex,
+           unsigned int /*threadMax*/,
+           void* customArg)
+{
+    OfxThreadPoolTestData* data = (OfxThreadPoolTestData*)customArg;
+
+    ++data->calls[threadIndex];
+    data->nodes[threadIndex] = CpuTopology::getCurrentThreadNumaNode();
+    EXPECT_TRUE( OfxThreadPool::isPoolThread() );
+
+    int running = data->running.fetchAndAddOrdered(1) + 1;
+    for (;;) {
+        int maxRunning = data->maxRunning.fetchAndAddOrdered(0);
+        if ( (running <= maxRunning) || data->maxRunning.testAndSetOrdered(maxRunning, running) ) {
+            break;
+        }
+    }
+
+    ///Wait for the other threads, give up after a while so that a failure does not hang the test
+    TimeLapse t;
+    data->arrived.fetchAndAddOrdered(1);
+    while ( (data->arrived.fetchAndAddOrdered(0) < data->barrier) && (t.getTimeSinceCreation() < 5.) ) {
+    }
+    waitSeconds(0.002);
+
+    data->running.fetchAndAddOrdered(-1);
+}
+
+static void
+throwBadAlloc(unsigned int threadIndex,
+              unsigned int /*threadMax*/,
+              void* customArg)
+{
+    OfxThreadPoolTestData* data = (OfxThreadPoolTestData*)customArg;
+
+    ++data->calls[threadIndex];
+    if (threadIndex == 1) {
+        throw std::bad_alloc();
+    }
+}
+
+static void
+throwInt(unsigned int threadIndex,
+         unsigned int /*threadMax*/,
+         void* customArg)
+{
+    OfxThreadPoolTestData* data = (OfxThreadPoolTestData*)customArg;
+
+    ++data->calls[threadIndex];
+    if (threadIndex == 2) {
+        throw 1;
+    }
+}
+
+static void
+recordThread(unsigned int threadIndex,
+             unsigned int /*threadMax*/,
+             void* customArg)
+{
+    OfxThreadPoolTestData* data = (OfxThreadPoolTestData*)customArg;
+
+    ++data->calls[threadIndex];
+    data->threads[threadIndex] = QThread::currentThread();
+}
+
+/**
+ * @brief Each thread index calls the pool again, with its own part of the data
+ **/
+struct OfxThreadPoolNestedCall
+{
+    OfxThreadPoolTestData* data;
+    std::vector<OfxThreadPoolTestData*> nested;
+    std::vector<OfxStatus> status;
+};
+
+static void
+callPoolAgain(unsigned int threadIndex,
+              unsigned int /*threadMax*/,
+              void* customArg)
+{
+    OfxThreadPoolNestedCall* call = (OfxThreadPoolNestedCall*)customArg;
+    OfxThreadPoolTestData* nested = call->nested[threadIndex];
+
+    call->data->threads[threadIndex] = QThread::currentThread();
+    call->status[threadIndex] = call->data->pool->run(recordThread, (unsigned int)nested->calls.size(), 4, nested);
+}
+
+TEST_F(BaseTest,OfxThreadPoolNumaFirst)
+{
+    QDir dir = makeFakeTopology();
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+
+    ASSERT_EQ( 2, topology.getNumaNodesCount() );
+
+    bool pinned = false;
+    {
+        OfxThreadPool pool(&topology);
+
+        ///The first call starts the threads, wait until they are all idle
+        OfxThreadPoolTestData warmUp(&pool, 1);
+        EXPECT_EQ( kOfxStatOK, pool.run(recordCall, 1, 1, &warmUp) );
+        waitSeconds(0.2);
+
+        ///The node of a call is the node of the CPU the caller runs on. The threads of the pool were started
+        ///before, they do not inherit this affinity
+        std::vector<int> cpu0(1, 0);
+        pinned = CpuTopology::setCurrentThreadAffinity(cpu0) && (CpuTopology::getCurrentCpu() == 0);
+
+        ///While the threads of the node of the caller are idle, they take all the indexes
+        OfxThreadPoolTestData local(&pool, OFX_THREAD_POOL_TEST_THREADS_PER_NODE);
+        local.barrier = OFX_THREAD_POOL_TEST_THREADS_PER_NODE;
+        EXPECT_EQ( kOfxStatOK, pool.run(recordCall, OFX_THREAD_POOL_TEST_THREADS_PER_NODE, OFX_THREAD_POOL_TEST_THREADS_PER_NODE, &local) );
+        for (int i = 0; i < OFX_THREAD_POOL_TEST_THREADS_PER_NODE; ++i) {
+            EXPECT_EQ( 1, local.calls[i] );
+            if (pinned) {
+                EXPECT_EQ( 0, local.nodes[i] );
+            }
+        }
+        waitSeconds(0.2);
+
+        ///When they are all busy, the threads of the other node help
+        OfxThreadPoolTestData all(&pool, OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2);
+        all.barrier = OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2;
+        EXPECT_EQ( kOfxStatOK, pool.run(recordCall, OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2, OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2, &all) );
+        EXPECT_EQ( OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2, (int)all.maxRunning );
+        int threadsPerNode[2] = {0, 0};
+        for (int i = 0; i < OFX_THREAD_POOL_TEST_THREADS_PER_NODE * 2; ++i) {
+            EXPECT_EQ( 1, all.calls[i] );
+            ASSERT_TRUE(all.nodes[i] == 0 || all.nodes[i] == 1);
+            ++threadsPerNode[all.nodes[i]];
+        }
+        EXPECT_EQ( OFX_THREAD_POOL_TEST_THREADS_PER_NODE, threadsPerNode[0] );
+        EXPECT_EQ( OFX_THREAD_POOL_TEST_THREADS_PER_NODE, threadsPerNode[1] );
+    }
+
+    if (pinned) {
+        CpuTopology systemTopology;
+        std::vector<int> cpus;
+        for (int i = 0; i < systemTopology.getCpusCount(); ++i) {
+            cpus.push_back(systemTopology.getCpus()[i].cpu);
+        }
+        CpuTopology::setCurrentThreadAffinity(cpus);
+    }
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST_F(BaseTest,OfxThreadPoolMaxConcurrentThreads)
+{
+    QDir dir = makeFakeTopology();
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+    OfxThreadPool pool(&topology);
+
+    ///More indexes than threads: each index is called once, by at most 2 threads at a time
+    OfxThreadPoolTestData data(&pool, 16);
+    EXPECT_EQ( kOfxStatOK, pool.run(recordCall, 16, 2, &data) );
+    for (int i = 0; i < 16; ++i) {
+        EXPECT_EQ( 1, data.calls[i] );
+    }
+    EXPECT_TRUE( (int)data.maxRunning <= 2 );
+
+    ///0 is taken as 1
+    OfxThreadPoolTestData serial(&pool, 4);
+    EXPECT_EQ( kOfxStatOK, pool.run(recordCall, 4, 0, &serial) );
+    EXPECT_EQ( 1, (int)serial.maxRunning );
+
+    EXPECT_EQ( kOfxStatOK, pool.run(recordCall, 0, 4, &serial) );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST_F(BaseTest,OfxThreadPoolErrors)
+{
+    QDir dir = makeFakeTopology();
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+    OfxThreadPool pool(&topology);
+
+    ///The error of a call is returned, the other indexes are still called
+    OfxThreadPoolTestData badAlloc(&pool, 8);
+    EXPECT_EQ( kOfxStatErrMemory, pool.run(throwBadAlloc, 8, 4, &badAlloc) );
+    OfxThreadPoolTestData failed(&pool, 8);
+    EXPECT_EQ( kOfxStatFailed, pool.run(throwInt, 8, 4, &failed) );
+    for (int i = 0; i < 8; ++i) {
+        EXPECT_EQ( 1, badAlloc.calls[i] );
+        EXPECT_EQ( 1, failed.calls[i] );
+    }
+
+    ///A failed call does not affect the next ones
+    OfxThreadPoolTestData data(&pool, 8);
+    EXPECT_EQ( kOfxStatOK, pool.run(recordCall, 8, 4, &data) );
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
+
+TEST_F(BaseTest,OfxThreadPoolNestedCalls)
+{
+    QDir dir = makeFakeTopology();
+    CpuTopology topology(dir.absolutePath().toStdString(), false);
+    OfxThreadPool pool(&topology);
+    const unsigned int nThreads = 4;
+
+    OfxThreadPoolTestData data(&pool, nThreads);
+    OfxThreadPoolNestedCall call;
+    call.data = &data;
+    call.status.resize(nThreads, kOfxStatFailed);
+    for (unsigned int i = 0; i < nThreads; ++i) {
+        call.nested.push_back( new OfxThreadPoolTestData(&pool, nThreads) );
+    }
+
+    ///A call made from a thread of the pool is made serially by that thread, without waiting for the others
+    EXPECT_EQ( kOfxStatOK, pool.run(callPoolAgain, nThreads, nThreads, &call) );
+    for (unsigned int i = 0; i < nThreads; ++i) {
+        EXPECT_EQ( kOfxStatOK, call.status[i] );
+        EXPECT_TRUE(data.threads[i] != 0);
+        for (unsigned int j = 0; j < nThreads; ++j) {
+            EXPECT_EQ( 1, call.nested[i]->calls[j] );
+            EXPECT_EQ( data.threads[i], call.nested[i]->threads[j] );
+        }
+        delete call.nested[i];
+    }
+
+    QtCompat::removeRecursively( dir.absolutePath() );
+}
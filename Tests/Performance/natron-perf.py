@@ -0,0 +1,266 @@
+#!/usr/bin/env python
+# -*- coding: utf-8 -*-
+# ***** BEGIN LICENSE BLOCK *****
+# This file is part of Natron <http://www.natron.fr/>,
+# Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+#
+# Natron is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation; either version 2 of the License, or
+# (at your option) any later version.
+#
+# Natron is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+# ***** END LICENSE BLOCK *****
+
+# Renders the synthetic projects of the projects/ directory with NatronRenderer,
+# with fixed numbers of threads, and compares the timings and memory usage
+# reported by --perf-report against a baseline. See README.md
+
+from __future__ import print_function
+
+import argparse
+import glob
+import json
+import os
+import platform
+import shutil
+import subprocess
+import sys
+import tempfile
+import time
+
+RESULTS_VERSION = 1
+
+# Exit codes
+EXIT_OK = 0
+EXIT_REGRESSION = 1
+EXIT_FAILURE = 2
+
+WRITER_NAME = "PerfWrite"
+
+def parseArgs():
+    scriptDir = os.path.dirname(os.path.abspath(__file__))
+    parser = argparse.ArgumentParser(description="Renders the synthetic projects and compares their performance against a baseline.")
+    parser.add_argument("--renderer", default=os.environ.get("NATRON_RENDERER", "NatronRenderer"),
+                        help="Path to the NatronRenderer executable (default: $NATRON_RENDERER or NatronRenderer in the PATH)")
+    parser.add_argument("--projects", default=os.path.join(scriptDir, "projects"),
+                        help="Directory containing the project scripts (default: %(default)s)")
+    parser.add_argument("--filter", default="",
+                        help="Only runs the projects whose name contains this string")
+    parser.add_argument("--threads", default="1,4",
+                        help="Comma-separated list of the numbers of render threads to run each project with (default: %(default)s)")
+    parser.add_argument("--frames", default="1-10",
+                        help="Frame range to render (default: %(default)s)")
+    parser.add_argument("--repeat", type=int, default=3,
+                        help="Number of runs of each project, the fastest one is kept (default: %(default)s)")
+    parser.add_argument("--extension", default="pfm",
+                        help="Extension of the rendered images, an uncompressed format keeps the encoding out of the timings (default: %(default)s)")
+    parser.add_argument("--work-dir", default=None,
+                        help="Directory where the images and reports are written (default: a temporary directory, removed on exit)")
+    parser.add_argument("--results", default=None,
+                        help="Writes the results of this run in JSON to this file")
+    parser.add_argument("--baseline", default=None,
+                        help="JSON results to compare against")
+    parser.add_argument("--update-baseline", action="store_true",
+                        help="Writes the results of this run to the baseline file instead of comparing")
+    parser.add_argument("--time-tolerance", type=float, default=10.,
+                        help="Allowed increase of the render wall time, in percent (default: %(default)s)")
+    parser.add_argument("--node-tolerance", type=float, default=25.,
+                        help="Allowed increase of the render time of a node, in percent (default: %(default)s)")
+    parser.add_argument("--min-node-seconds", type=float, default=0.05,
+                        help="Nodes that rendered faster than this in the baseline are not compared, their timings are mostly noise (default: %(default)s)")
+    parser.add_argument("--rss-tolerance", type=float, default=10.,
+                        help="Allowed increase of the peak resident memory, in percent (default: %(default)s)")
+    args = parser.parse_args()
+
+    if args.update_baseline and not args.baseline:
+        parser.error("--update-baseline requires --baseline")
+    if args.repeat < 1:
+        parser.error("--repeat must be at least 1")
+    try:
+        args.threads = [int(n) for n in args.threads.split(",")]
+    except ValueError:
+        parser.error("--threads must be a comma-separated list of integers")
+    if min(args.threads) < 1:
+        parser.error("--threads must only contain positive numbers")
+    return args
+
+def findProjects(args):
+    projects = []
+    for path in sorted(glob.glob(os.path.join(args.projects, "*.py"))):
+        name = os.path.splitext(os.path.basename(path))[0]
+        if args.filter in name:
+            projects.append((name, path))
+    return projects
+
+def renderOnce(args, name, path, threads, workDir):
+    """Renders a project once and returns the content of its performance report, or None on failure"""
+    outDir = os.path.join(workDir, "%s_%d" % (name, threads))
+    if os.path.isdir(outDir):
+        shutil.rmtree(outDir)
+    os.makedirs(outDir)
+    report = os.path.join(outDir, "report.json")
+    image = os.path.join(outDir, "%s_####.%s" % (name, args.extension))
+
+    cmd = [args.renderer, "--threads", str(threads), "--perf-report", report,
+           "-w", WRITER_NAME, image, args.frames, path]
+    logFile = os.path.join(outDir, "log.txt")
+    with open(logFile, "w") as log:
+        try:
+            ret = subprocess.call(cmd, stdout=log, stderr=subprocess.STDOUT)
+        except OSError as e:
+            print("  Could not run %s: %s" % (args.renderer, e), file=sys.stderr)
+            return None
+    if ret != 0 or not os.path.isfile(report):
+        print("  %s failed with exit code %d, see %s" % (" ".join(cmd), ret, logFile), file=sys.stderr)
+        return None
+    with open(report) as f:
+        return json.load(f)
+
+def summarize(report):
+    """Keeps from a performance report what is compared between runs"""
+    frames = 0
+    for writer in report["writers"]:
+        frames += writer["frames"]
+    nodes = {}
+    for node in report["nodes"]:
+        nodes[node["name"]] = {"pluginID": node["pluginID"], "seconds": node["seconds"]}
+    return {"threads": report["threads"],
+            "frames": frames,
+            "wallSeconds": report["wallSeconds"],
+            "renderWallSeconds": report["renderWallSeconds"],
+            "peakRSS": report["peakRSS"],
+            "nodes": nodes}
+
+def runAll(args, projects, workDir):
+    results = {"version": RESULTS_VERSION,
+               "date": time.strftime("%Y-%m-%dT%H:%M:%SZ", time.gmtime()),
+               "host": {"system": platform.system(), "machine": platform.machine(), "node": platform.node()},
+               "frames": args.frames,
+               "runs": {}}
+    failed = False
+    for name, path in projects:
+        for threads in args.threads:
+            key = "%s@%d" % (name, threads)
+            best = None
+            for i in range(args.repeat):
+                report = renderOnce(args, name, path, threads, workDir)
+                if report is None:
+                    failed = True
+                    break
+                results["natronVersion"] = report["natronVersion"]
+                results["gitCommit"] = report["gitCommit"]
+                summary = summarize(report)
+                #The fastest run is the least disturbed by the rest of the system. The peak memory is kept
+                #from the same run so that both are consistent.
+                if best is None or summary["renderWallSeconds"] < best["renderWallSeconds"]:
+                    best = summary
+            if best is not None:
+                results["runs"][key] = best
+                print("%-28s %4d frames %10.3f s %10.1f MiB" % (key, best["frames"], best["renderWallSeconds"], best["peakRSS"] / 1048576.))
+    return results, failed
+
+def relativeIncrease(current, baseline):
+    if baseline <= 0:
+        return 0.
+    return 100. * (current - baseline) / baseline
+
+def compare(args, results, baseline):
+    """Prints the differences with the baseline and returns the number of regressions"""
+    regressions = 0
+    for key in sorted(baseline["runs"]):
+        base = baseline["runs"][key]
+        cur = results["runs"].get(key)
+        if cur is None:
+            #Either filtered out or failed, the failure was already reported
+            continue
+        if cur["frames"] != base["frames"]:
+            print("%s: rendered %d frames, the baseline rendered %d, not compared" % (key, cur["frames"], base["frames"]))
+            continue
+
+        increase = relativeIncrease(cur["renderWallSeconds"], base["renderWallSeconds"])
+        if increase > args.time_tolerance:
+            print("REGRESSION %s: render time %.3f s -> %.3f s (%+.1f%%, tolerance %.1f%%)" % (key, base["renderWallSeconds"], cur["renderWallSeconds"], increase, args.time_tolerance))
+            regressions += 1
+        elif increase < -args.time_tolerance:
+            print("improvement %s: render time %.3f s -> %.3f s (%+.1f%%)" % (key, base["renderWallSeconds"], cur["renderWallSeconds"], increase))
+
+        increase = relativeIncrease(cur["peakRSS"], base["peakRSS"])
+        if increase > args.rss_tolerance:
+            print("REGRESSION %s: peak RSS %.1f MiB -> %.1f MiB (%+.1f%%, tolerance %.1f%%)" % (key, base["peakRSS"] / 1048576., cur["peakRSS"] / 1048576., increase, args.rss_tolerance))
+            regressions += 1
+
+        for nodeName in sorted(base["nodes"]):
+            baseSeconds = base["nodes"][nodeName]["seconds"]
+            if baseSeconds < args.min_node_seconds or nodeName not in cur["nodes"]:
+                continue
+            curSeconds = cur["nodes"][nodeName]["seconds"]
+            increase = relativeIncrease(curSeconds, baseSeconds)
+            if increase > args.node_tolerance:
+                print("REGRESSION %s: node %s (%s) %.3f s -> %.3f s (%+.1f%%, tolerance %.1f%%)" % (key, nodeName, base["nodes"][nodeName]["pluginID"], baseSeconds, curSeconds, increase, args.node_tolerance))
+                regressions += 1
+
+    for key in sorted(results["runs"]):
+        if key not in baseline["runs"]:
+            print("%s is not in the baseline, not compared" % key)
+    return regressions
+
+def writeJSON(filename, content):
+    with open(filename, "w") as f:
+        json.dump(content, f, indent=2, sort_keys=True)
+        f.write("\n")
+
+def main():
+    args = parseArgs()
+
+    projects = findProjects(args)
+    if not projects:
+        print("No project found in %s" % args.projects, file=sys.stderr)
+        return EXIT_FAILURE
+
+    workDir = args.work_dir
+    removeWorkDir = workDir is None
+    if removeWorkDir:
+        workDir = tempfile.mkdtemp(prefix="natron-perf-")
+    elif not os.path.isdir(workDir):
+        os.makedirs(workDir)
+
+    try:
+        results, failed = runAll(args, projects, workDir)
+    finally:
+        if removeWorkDir:
+            shutil.rmtree(workDir, ignore_errors=True)
+
+    if args.results:
+        writeJSON(args.results, results)
+
+    if args.update_baseline:
+        if failed:
+            print("Some projects failed to render, the baseline was not updated", file=sys.stderr)
+            return EXIT_FAILURE
+        writeJSON(args.baseline, results)
+        print("Baseline written to %s" % args.baseline)
+        return EXIT_OK
+
+    status = EXIT_FAILURE if failed else EXIT_OK
+    if args.baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+        if baseline.get("version") != RESULTS_VERSION:
+            print("%s was written by another version of this script, regenerate it with --update-baseline" % args.baseline, file=sys.stderr)
+            return EXIT_FAILURE
+        regressions = compare(args, results, baseline)
+        if regressions:
+            print("%d regression(s) compared to %s" % (regressions, args.baseline))
+            if status == EXIT_OK:
+                status = EXIT_REGRESSION
+    return status
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,41 @@
+# -*- coding: utf-8 -*-
+# Synthetic project for the render performance harness: a long linear chain of
+# cheap filters, which stresses the per-node overhead of the render tree
+# (RoD/RoI requests, cache lookups, image allocations) rather than the pixel work.
+# The Write node must be named PerfWrite, see ../README.md
+
+import NatronEngine
+
+CHAIN_LENGTH = 150
+
+def createInstance(app,group):
+    source = app.createNode("net.sf.openfx.CheckerBoardPlugin", -1, group)
+    source.setScriptName("Source")
+
+    lastNode = source
+    for i in range(CHAIN_LENGTH):
+        if i % 3 == 0:
+            node = app.createNode("net.sf.openfx.GradePlugin", -1, group)
+            node.setScriptName("Grade%d" % i)
+            param = node.getParam("multiply")
+            for d in range(4):
+                param.setValue(1. + 0.001 * (i % 7), d)
+        elif i % 3 == 1:
+            node = app.createNode("net.sf.openfx.TransformPlugin", -1, group)
+            node.setScriptName("Transform%d" % i)
+            #Animated so that every frame has to be rendered again
+            param = node.getParam("rotate")
+            param.setValueAtTime(0., 1)
+            param.setValueAtTime(0.5, 100)
+        else:
+            node = app.createNode("net.sf.cimg.CImgBlur", -1, group)
+            node.setScriptName("Blur%d" % i)
+            param = node.getParam("size")
+            param.setValue(1., 0)
+            param.setValue(1., 1)
+        node.connectInput(0, lastNode)
+        lastNode = node
+
+    writer = app.createNode("fr.inria.built-in.Write", -1, group)
+    writer.setScriptName("PerfWrite")
+    writer.connectInput(0, lastNode)
@@ -0,0 +1,48 @@
+# -*- coding: utf-8 -*-
+# Synthetic project for the render performance harness: parameters driven by
+# Python expressions, each depending on a controller and on the previous node,
+# which stresses the expression evaluation done for every render.
+# The Write node must be named PerfWrite, see ../README.md
+
+import NatronEngine
+
+LINKED_NODES = 80
+
+def createInstance(app,group):
+    source = app.createNode("net.sf.openfx.CheckerBoardPlugin", -1, group)
+    source.setScriptName("Source")
+
+    #The controller is not connected, only its parameters are used
+    controller = app.createNode("net.sf.openfx.GradePlugin", -1, group)
+    controller.setScriptName("Controller")
+    param = controller.getParam("multiply")
+    for d in range(4):
+        param.setValueAtTime(0.9, 1, d)
+        param.setValueAtTime(1.1, 100, d)
+
+    lastNode = source
+    previousGrade = None
+    for i in range(LINKED_NODES):
+        grade = app.createNode("net.sf.openfx.GradePlugin", -1, group)
+        grade.setScriptName("Grade%d" % i)
+        grade.connectInput(0, lastNode)
+        param = grade.getParam("multiply")
+        if previousGrade is None:
+            expr = "Controller.multiply.get()[dimension]"
+        else:
+            expr = "(Controller.multiply.get()[dimension] + %s.multiply.get()[dimension]) / 2." % previousGrade
+        for d in range(4):
+            param.setExpression(expr, False, d)
+
+        transform = app.createNode("net.sf.openfx.TransformPlugin", -1, group)
+        transform.setScriptName("Transform%d" % i)
+        transform.connectInput(0, grade)
+        param = transform.getParam("rotate")
+        param.setExpression("ret = (Controller.multiply.get()[0] - 1.) * frame / %d.\n" % LINKED_NODES, True)
+
+        previousGrade = "Grade%d" % i
+        lastNode = transform
+
+    writer = app.createNode("fr.inria.built-in.Write", -1, group)
+    writer.setScriptName("PerfWrite")
+    writer.connectInput(0, lastNode)
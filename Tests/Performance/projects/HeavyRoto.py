@@ -0,0 +1,40 @@
+# -*- coding: utf-8 -*-
+# Synthetic project for the render performance harness: a Roto node with many
+# animated, feathered shapes, which stresses the shape rasterization.
+# The Write node must be named PerfWrite, see ../README.md
+
+import math
+
+import NatronEngine
+
+SHAPES = 200
+POINTS_PER_SHAPE = 12
+
+def createInstance(app,group):
+    source = app.createNode("net.sf.openfx.CheckerBoardPlugin", -1, group)
+    source.setScriptName("Source")
+
+    roto = app.createNode("fr.inria.built-in.Roto", -1, group)
+    roto.setScriptName("Roto")
+    roto.connectInput(0, source)
+
+    ctx = roto.getRotoContext()
+    for i in range(SHAPES):
+        x = 40. + (i * 97) % 1800
+        y = 40. + (i * 53) % 1000
+        shape = ctx.createBezier(x, y, 1)
+        for p in range(1, POINTS_PER_SHAPE):
+            #A star-like polygon so that the shapes are not convex
+            radius = 60. if p % 2 else 25.
+            angle = 6.283185307179586 * p / POINTS_PER_SHAPE
+            shape.addControlPoint( x + radius * (1. - math.cos(angle)), y + radius * math.sin(angle) )
+        shape.setCurveFinished(True)
+        shape.setFeatherDistance(5. + i % 20, 1)
+        shape.setOpacity(0.5 + 0.5 * (i % 2), 1)
+        #Animated so that every frame has to be rasterized again
+        for p in range(0, POINTS_PER_SHAPE, 3):
+            shape.movePointByIndex(p, 100, 30., -20.)
+
+    writer = app.createNode("fr.inria.built-in.Write", -1, group)
+    writer.setScriptName("PerfWrite")
+    writer.connectInput(0, roto)
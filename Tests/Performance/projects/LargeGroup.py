@@ -0,0 +1,67 @@
+# -*- coding: utf-8 -*-
+# Synthetic project for the render performance harness: nested groups holding many
+# nodes, which stresses the lookups across group boundaries (Input/Output nodes,
+# fully qualified names, hashes of the nodes inside groups).
+# The Write node must be named PerfWrite, see ../README.md
+
+import NatronEngine
+
+GROUPS = 8
+NODES_PER_GROUP = 40
+
+def createGroup(app, parent, name, depth):
+    group = app.createNode("fr.inria.built-in.Group", -1, parent)
+    group.setScriptName(name)
+
+    groupInput = app.createNode("fr.inria.built-in.Input", -1, group)
+    groupInput.setScriptName("Input1")
+
+    lastNode = groupInput
+    for i in range(NODES_PER_GROUP):
+        if i % 4 == 0:
+            node = app.createNode("fr.inria.built-in.Dot", -1, group)
+            node.setScriptName("Dot%d" % i)
+        elif i % 4 == 1:
+            node = app.createNode("net.sf.openfx.GradePlugin", -1, group)
+            node.setScriptName("Grade%d" % i)
+            param = node.getParam("gamma")
+            for d in range(4):
+                param.setValue(1. + 0.01 * i, d)
+        elif i % 4 == 2:
+            node = app.createNode("net.sf.openfx.TransformPlugin", -1, group)
+            node.setScriptName("Transform%d" % i)
+            param = node.getParam("translate")
+            param.setValueAtTime(0., 1, 0)
+            param.setValueAtTime(float(i), 100, 0)
+        else:
+            node = app.createNode("net.sf.openfx.MergePlugin", -1, group)
+            node.setScriptName("Merge%d" % i)
+            node.connectInput(1, groupInput)
+        node.connectInput(0, lastNode)
+        lastNode = node
+
+    #Groups are nested two levels deep
+    if depth > 0:
+        subGroup = createGroup(app, group, name + "Sub", depth - 1)
+        subGroup.connectInput(0, lastNode)
+        lastNode = subGroup
+
+    groupOutput = app.createNode("fr.inria.built-in.Output", -1, group)
+    groupOutput.setScriptName("Output")
+    groupOutput.connectInput(0, lastNode)
+
+    return group
+
+def createInstance(app,group):
+    source = app.createNode("net.sf.openfx.CheckerBoardPlugin", -1, group)
+    source.setScriptName("Source")
+
+    lastNode = source
+    for i in range(GROUPS):
+        node = createGroup(app, group, "Group%d" % i, 1)
+        node.connectInput(0, lastNode)
+        lastNode = node
+
+    writer = app.createNode("fr.inria.built-in.Write", -1, group)
+    writer.setScriptName("PerfWrite")
+    writer.connectInput(0, lastNode)
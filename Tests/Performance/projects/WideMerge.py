@@ -0,0 +1,46 @@
+# -*- coding: utf-8 -*-
+# Synthetic project for the render performance harness: many independent branches
+# merged together, which stresses the fan-in of the render tree and the rendering
+# of the inputs of a node in parallel.
+# The Write node must be named PerfWrite, see ../README.md
+
+import NatronEngine
+
+BRANCHES = 64
+
+def createInstance(app,group):
+    background = app.createNode("net.sf.openfx.ConstantPlugin", -1, group)
+    background.setScriptName("Background")
+
+    lastNode = background
+    for i in range(BRANCHES):
+        source = app.createNode("net.sf.openfx.CheckerBoardPlugin", -1, group)
+        source.setScriptName("Source%d" % i)
+
+        transform = app.createNode("net.sf.openfx.TransformPlugin", -1, group)
+        transform.setScriptName("Transform%d" % i)
+        transform.connectInput(0, source)
+        param = transform.getParam("translate")
+        param.setValueAtTime(-10. * i, 1, 0)
+        param.setValueAtTime(10. * i, 100, 0)
+        param = transform.getParam("scale")
+        param.setValue(0.25, 0)
+        param.setValue(0.25, 1)
+
+        grade = app.createNode("net.sf.openfx.GradePlugin", -1, group)
+        grade.setScriptName("Grade%d" % i)
+        grade.connectInput(0, transform)
+        param = grade.getParam("multiply")
+        for d in range(3):
+            param.setValue( 0.5 + 0.5 * ( (i + d) % 3 ) / 2., d )
+
+        #Input 0 is B, input 1 is A
+        merge = app.createNode("net.sf.openfx.MergePlugin", -1, group)
+        merge.setScriptName("Merge%d" % i)
+        merge.connectInput(0, lastNode)
+        merge.connectInput(1, grade)
+        lastNode = merge
+
+    writer = app.createNode("fr.inria.built-in.Write", -1, group)
+    writer.setScriptName("PerfWrite")
+    writer.connectInput(0, lastNode)
@@ -0,0 +1,86 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <new> // bad_alloc
+
+#include <gtest/gtest.h>
+
+#include "Engine/PluginMemoryPool.h"
+
+NATRON_NAMESPACE_USING
+
+#define MB (1024ULL * 1024ULL)
+
+TEST(PluginMemoryPoolTest,BlockSize) {
+    EXPECT_EQ( (std::size_t)NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE, PluginMemoryPool::getBlockSize(0) );
+    EXPECT_EQ( (std::size_t)NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE, PluginMemoryPool::getBlockSize(NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE) );
+
+    //Powers of two are size classes, in between the sizes are rounded up to a quarter of the power of two
+    EXPECT_EQ( 8 * MB, PluginMemoryPool::getBlockSize(8 * MB) );
+    EXPECT_EQ( 10 * MB, PluginMemoryPool::getBlockSize(8 * MB + 1) );
+    EXPECT_EQ( 10 * MB, PluginMemoryPool::getBlockSize(10 * MB) );
+    EXPECT_EQ( 16 * MB, PluginMemoryPool::getBlockSize(14 * MB + 1) );
+
+    for (std::size_t n = 1; n < 64 * MB; n = n * 3 + 7) {
+        std::size_t blockSize = PluginMemoryPool::getBlockSize(n);
+        EXPECT_TRUE(blockSize >= n);
+        EXPECT_TRUE( (n <= NATRON_PLUGIN_MEMORY_POOL_MIN_BLOCK_SIZE) || (blockSize - n < n / 4 + 1) );
+    }
+}
+
+TEST(PluginMemoryPoolTest,Recycle) {
+    PluginMemoryPool pool(0, 24 * MB);
+    bool recycled;
+
+    void* a = pool.allocate(9 * MB, &recycled);
+    ASSERT_TRUE(a != 0);
+    EXPECT_FALSE(recycled);
+    EXPECT_EQ( 10 * MB, pool.getUsedBytes() );
+
+    //A block of the same size class is recycled
+    pool.release(a, 9 * MB);
+    EXPECT_EQ( 0U, pool.getUsedBytes() );
+    EXPECT_EQ( 10 * MB, pool.getIdleBytes() );
+    void* b = pool.allocate(10 * MB, &recycled);
+    EXPECT_TRUE(recycled);
+    EXPECT_EQ(a, b);
+    EXPECT_EQ( 0U, pool.getIdleBytes() );
+
+    //Another size class is not
+    void* c = pool.allocate(12 * MB, &recycled);
+    EXPECT_FALSE(recycled);
+
+    //Only 24MB are kept
+    pool.release(b, 10 * MB);
+    pool.release(c, 12 * MB);
+    EXPECT_EQ( 22 * MB, pool.getIdleBytes() );
+    void* d = pool.allocate(4 * MB, &recycled);
+    pool.release(d, 4 * MB);
+    EXPECT_EQ( 22 * MB, pool.getIdleBytes() );
+
+    pool.trim(11 * MB);
+    EXPECT_EQ( 10 * MB, pool.getIdleBytes() );
+    pool.trim(0);
+    EXPECT_EQ( 0U, pool.getIdleBytes() );
+}
@@ -0,0 +1,211 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <gtest/gtest.h>
+
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QLocalSocket>
+#include <QStringList>
+#include <QThread>
+
+#include "Global/GlobalDefines.h"
+
+#include "Engine/AppInstance.h"
+#include "Engine/AppManager.h"
+#include "Engine/Node.h"
+#include "Engine/Project.h"
+#include "Engine/RenderDaemon.h"
+
+#include "BaseTest.h"
+
+NATRON_NAMESPACE_USING
+
+/**
+ * @brief A minimal client of the render daemon: it sends each request and waits for the job to finish before sending the
+ * next one. All the messages received from the daemon are recorded in replies.
+ **/
+class RenderDaemonClient
+    : public QThread
+{
+public:
+
+    RenderDaemonClient(const QString& serverName,
+                       const QStringList& requests)
+        : QThread()
+        , replies()
+        , _serverName(serverName)
+        , _requests(requests)
+    {
+    }
+
+    QStringList replies;
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        QLocalSocket socket;
+
+        // The daemon may not be listening yet
+        for (int i = 0; i < 50; ++i) {
+            socket.connectToServer(_serverName);
+            if ( socket.waitForConnected(100) ) {
+                break;
+            }
+            msleep(100);
+        }
+        if (socket.state() != QLocalSocket::ConnectedState) {
+            return;
+        }
+
+        for (int i = 0; i < _requests.size(); ++i) {
+            socket.write( ( _requests[i] + QLatin1Char('\n') ).toUtf8() );
+            socket.flush();
+            if ( _requests[i].startsWith( QString::fromUtf8(kDaemonQuitShort) ) ) {
+                break;
+            }
+            for (;;) {
+                while ( !socket.canReadLine() ) {
+                    if ( !socket.waitForReadyRead(30000) ) {
+                        return;
+                    }
+                }
+                QString line = QString::fromUtf8( socket.readLine() ).trimmed();
+                replies.push_back(line);
+                if ( line.startsWith( QString::fromUtf8(kDaemonJobFinishedShort) ) ) {
+                    break;
+                }
+            }
+        }
+        socket.waitForBytesWritten(1000);
+        socket.disconnectFromServer();
+    }
+
+    QString _serverName;
+    QStringList _requests;
+};
+
+TEST_F(BaseTest,RenderDaemonJobs)
+{
+    QString serverName = QString::fromUtf8("NatronRenderDaemonTest") + QString::number( QCoreApplication::applicationPid() );
+    QString job = QString::fromUtf8(kDaemonRenderJobShort);
+    QChar sep = QLatin1Char('\t');
+
+    QStringList requests;
+    // A project that does not exist
+    requests.push_back( job + sep + QString::fromUtf8("-w") + sep + QString::fromUtf8("Write1") + sep + QString::fromUtf8("1-2") + sep +
+                        QString::fromUtf8("/this/project/does/not/exist.ntp") );
+    // Invalid arguments: no project
+    requests.push_back( job + sep + QString::fromUtf8("-w") + sep + QString::fromUtf8("Write1") );
+    requests.push_back( QString::fromUtf8(kDaemonQuitShort) );
+
+    RenderDaemonClient client(serverName, requests);
+    client.start();
+    EXPECT_TRUE( appPTR->runRenderDaemon(serverName) );
+    client.wait();
+
+    QString failed = QString::fromUtf8(kDaemonJobFinishedShort) + QLatin1Char('1');
+    ASSERT_EQ( 2, client.replies.size() );
+    EXPECT_TRUE( client.replies[0].startsWith(failed) );
+    EXPECT_TRUE( client.replies[1].startsWith(failed) );
+}
+
+TEST_F(BaseTest,RenderDaemonWarmProjects)
+{
+    ///A project rendering one frame of the dot generator
+    NodePtr generator = createNode(_dotGeneratorPluginID);
+    NodePtr writer = createNode(_writeOIIOPluginID);
+    ASSERT_TRUE(generator && writer);
+    connectNodes(generator, writer, 0, true);
+
+    QString dirPath = QDir::tempPath() + QString::fromUtf8("/NatronRenderDaemonTest") + QString::number( QCoreApplication::applicationPid() );
+    ASSERT_TRUE( QDir().mkpath(dirPath) );
+    QString outputPath = dirPath + QString::fromUtf8("/dot.jpg");
+    QString otherOutputPath = dirPath + QString::fromUtf8("/dot_other.jpg");
+    // A directory where the writer expects a file, so that the render fails
+    QString blockedOutputPath = dirPath + QString::fromUtf8("/blocked.jpg");
+    ASSERT_TRUE( QDir().mkpath(blockedOutputPath) );
+    writer->setOutputFilesForWriter( outputPath.toStdString() );
+
+    QString projectPath;
+    ASSERT_TRUE( _app->getProject()->saveProject(dirPath + QLatin1Char('/'), QString::fromUtf8("daemon.ntp"), &projectPath) );
+    ASSERT_TRUE( QFile::exists(projectPath) );
+
+    QString serverName = QString::fromUtf8("NatronRenderDaemonTest") + QString::number( QCoreApplication::applicationPid() );
+    QString job = QString::fromUtf8(kDaemonRenderJobShort);
+    QChar sep = QLatin1Char('\t');
+    QString writerName = QString::fromUtf8( writer->getScriptName().c_str() );
+    QString renderJob = job + sep + QString::fromUtf8("-w") + sep + writerName + sep + QString::fromUtf8("1-1") + sep + projectPath;
+
+    QStringList requests;
+    // Loads the project
+    requests.push_back(renderJob);
+    // Re-uses the loaded project
+    requests.push_back(renderJob);
+    // Changes the output file name of the writer: the project must be reloaded for the next job
+    requests.push_back( job + sep + QString::fromUtf8("-w") + sep + writerName + sep + otherOutputPath + sep + QString::fromUtf8("1-1") + sep + projectPath );
+    requests.push_back(renderJob);
+    // A render that fails
+    requests.push_back( job + sep + QString::fromUtf8("-w") + sep + writerName + sep + blockedOutputPath + sep + QString::fromUtf8("1-1") + sep + projectPath );
+    requests.push_back( QString::fromUtf8(kDaemonQuitShort) );
+
+    int projectsLoadedCount = 0;
+    RenderDaemonClient client(serverName, requests);
+    {
+        RenderDaemon daemon(serverName);
+        client.start();
+        EXPECT_TRUE( daemon.exec() );
+        client.wait();
+        projectsLoadedCount = daemon.getProjectsLoadedCount();
+    }
+
+    QStringList finished;
+    for (int i = 0; i < client.replies.size(); ++i) {
+        if ( client.replies[i].startsWith( QString::fromUtf8(kDaemonJobFinishedShort) ) ) {
+            finished.push_back(client.replies[i]);
+        }
+    }
+    QString succeeded = QString::fromUtf8(kDaemonJobFinishedShort) + QLatin1Char('0');
+    QString failed = QString::fromUtf8(kDaemonJobFinishedShort) + QString::fromUtf8("1\t");
+    ASSERT_EQ( 5, finished.size() );
+    EXPECT_EQ( succeeded, finished[0] );
+    EXPECT_EQ( succeeded, finished[1] );
+    EXPECT_EQ( succeeded, finished[2] );
+    EXPECT_EQ( succeeded, finished[3] );
+    EXPECT_TRUE( finished[4].startsWith(failed) );
+    EXPECT_GT( finished[4].size(), failed.size() );
+
+    ///The first job loads the project, the second re-uses it, the fourth reloads it because the third changed it
+    EXPECT_EQ(2, projectsLoadedCount);
+    EXPECT_TRUE( QFile::exists(outputPath) );
+    EXPECT_TRUE( QFile::exists(otherOutputPath) );
+
+    QFile::remove(outputPath);
+    QFile::remove(otherOutputPath);
+    QFile::remove(projectPath);
+    QDir().rmdir(blockedOutputPath);
+    QDir().rmdir(dirPath);
+}
@@ -0,0 +1,123 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstring>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "Engine/SharedFrameChannel.h"
+
+#ifdef __NATRON_UNIX__
+#include <unistd.h>
+#endif
+
+NATRON_NAMESPACE_USING
+
+#ifdef __NATRON_UNIX__
+
+// Publishes a frame of size bytes filled with value
+static bool
+publishFrame(SharedFrameChannel* channel,
+             U64 keyHash,
+             std::size_t size,
+             unsigned char value)
+{
+    SharedFrameInfo info;
+
+    std::memset( &info, 0, sizeof(SharedFrameInfo) );
+    info.keyHash = keyHash;
+    info.nComps = 4;
+    info.dataSize = size;
+    std::vector<unsigned char> data(size, value);
+
+    return channel->publish(info, &data.front());
+}
+
+TEST(SharedFrameChannel, PublishAndAcquire)
+{
+    SharedFrameChannel owner;
+
+    ASSERT_TRUE( owner.create(1024) );
+
+    SharedFrameChannel worker;
+    ASSERT_TRUE( worker.attach( owner.getName() ) );
+    EXPECT_FALSE( worker.isOwner() );
+
+    ASSERT_TRUE( publishFrame(&worker, 1, 100, 42) );
+    EXPECT_FALSE( publishFrame(&worker, 1, 100, 42) );
+    EXPECT_EQ( 1, owner.getFramesCount() );
+
+    SharedFramePtr frame = owner.acquire(1, 0);
+    ASSERT_TRUE(frame);
+    EXPECT_EQ(100U, frame->getInfo().dataSize);
+    EXPECT_EQ(4, frame->getInfo().nComps);
+    EXPECT_EQ( 42, ( (const unsigned char*)frame->getData() )[99] );
+
+    EXPECT_FALSE( owner.acquire(1, 1) );
+    EXPECT_FALSE( owner.acquire(2, 0) );
+}
+
+TEST(SharedFrameChannel, Eviction)
+{
+    SharedFrameChannel channel;
+
+    ASSERT_TRUE( channel.create(300) );
+    ASSERT_TRUE( publishFrame(&channel, 1, 100, 1) );
+    ASSERT_TRUE( publishFrame(&channel, 2, 100, 2) );
+    ASSERT_TRUE( publishFrame(&channel, 3, 100, 3) );
+
+    ///The frame being read is kept, the least recently used of the others is removed
+    SharedFramePtr frame = channel.acquire(1, 0);
+    ASSERT_TRUE(frame);
+    ASSERT_TRUE( publishFrame(&channel, 4, 100, 4) );
+    EXPECT_FALSE( channel.acquire(2, 0) );
+    EXPECT_TRUE( channel.acquire(3, 0) );
+    EXPECT_EQ( 1, ( (const unsigned char*)frame->getData() )[0] );
+    EXPECT_EQ( 300U, channel.getUsedBytes() );
+
+    EXPECT_FALSE( publishFrame(&channel, 5, 400, 5) );
+}
+
+TEST(SharedFrameChannel, ReleaseProcess)
+{
+    SharedFrameChannel channel;
+
+    ASSERT_TRUE( channel.create(100) );
+    ASSERT_TRUE( publishFrame(&channel, 1, 100, 1) );
+    SharedFramePtr frame = channel.acquire(1, 0);
+    ASSERT_TRUE(frame);
+
+    ///Full of frames being read
+    EXPECT_FALSE( publishFrame(&channel, 2, 100, 2) );
+
+    ///As if the reading process had died
+    channel.releaseProcess( (long long)getpid() );
+    ASSERT_TRUE( publishFrame(&channel, 2, 100, 2) );
+    EXPECT_EQ( 1, channel.getFramesCount() );
+    frame.reset();
+    EXPECT_EQ( 100U, channel.getUsedBytes() );
+}
+
+#endif // __NATRON_UNIX__
@@ -220,8 +220,21 @@ SOURCES += \
     Hash64_Test.cpp \
     Image_Test.cpp \
     Lut_Test.cpp \
+    MemoryGovernor_Test.cpp \
+    PluginMemoryPool_Test.cpp \
+    CpuTopology_Test.cpp \
+    OfxThreadPool_Test.cpp \
+    ImageResampler_Test.cpp \
+    DamageHistory_Test.cpp \
+    SharedFrameChannel_Test.cpp \
+    Timer_Test.cpp \
+    TraceRecorder_Test.cpp \
+    CLArgs_Test.cpp \
+    OfxPluginCacheFile_Test.cpp \
     KnobFile_Test.cpp \
-    Curve_Test.cpp
+    Curve_Test.cpp \
+    RenderDaemon_Test.cpp
 
 HEADERS += \
-    BaseTest.h
+    BaseTest.h \
+    FakeDir.h
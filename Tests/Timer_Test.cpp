@@ -0,0 +1,135 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <gtest/gtest.h>
+
+#include <QObject>
+
+#include "Engine/Timer.h"
+
+NATRON_NAMESPACE_USING
+
+/**
+ * @brief Records the arguments of the last Timer::fpsChanged() signal
+ **/
+class TimerFpsReceiver
+    : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    TimerFpsReceiver()
+        : QObject()
+        , count(0)
+        , actualFps(0.)
+        , desiredFps(0.)
+        , droppedFrames(-1)
+    {
+    }
+
+    int count;
+    double actualFps;
+    double desiredFps;
+    int droppedFrames;
+
+public Q_SLOTS:
+
+    void onFpsChanged(double actual,
+                      double desired,
+                      int dropped)
+    {
+        ++count;
+        actualFps = actual;
+        desiredFps = desired;
+        droppedFrames = dropped;
+    }
+};
+
+static void
+waitSeconds(double seconds)
+{
+    TimeLapse t;
+
+    while (t.getTimeSinceCreation() < seconds) {
+    }
+}
+
+TEST(Timer, RealtimeDropsLateFrames)
+{
+    Timer timer;
+    TimerFpsReceiver receiver;
+
+    QObject::connect( &timer, SIGNAL(fpsChanged(double,double,int)), &receiver, SLOT(onFpsChanged(double,double,int)) );
+    timer.setDesiredFrameRate(20.);
+    timer.setRealtimeEnabled(true);
+    ASSERT_TRUE( timer.isRealtimeEnabled() );
+
+    ///The first frame starts the schedule
+    EXPECT_EQ( 0, timer.waitUntilNextFrameIsDue() );
+
+    ///The second frame is due after 50ms: 4.5 frames later, the 4 frames whose time passed must be skipped
+    waitSeconds(0.275);
+    int framesLate = timer.waitUntilNextFrameIsDue();
+    EXPECT_TRUE(framesLate >= 4);
+    timer.addDroppedFrames(framesLate);
+    EXPECT_EQ( framesLate, timer.getDroppedFrames() );
+
+    ///The following frames are on schedule again: presented every 50ms
+    TimeLapse playback;
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ( 0, timer.waitUntilNextFrameIsDue() );
+    }
+    EXPECT_TRUE(playback.getTimeSinceCreation() >= 0.15);
+
+    ///The dropped frames are reported along with the frame rate
+    while (receiver.count == 0) {
+        timer.addDroppedFrames( timer.waitUntilNextFrameIsDue() );
+        ASSERT_TRUE(playback.getTimeSinceCreation() < 10.);
+    }
+    EXPECT_TRUE(receiver.droppedFrames >= framesLate);
+    EXPECT_TRUE( receiver.droppedFrames <= timer.getDroppedFrames() );
+    EXPECT_DOUBLE_EQ( 20., receiver.desiredFps );
+    EXPECT_TRUE(receiver.actualFps > 0.);
+
+    ///Enabling the realtime mode again restarts the schedule and the count
+    timer.setRealtimeEnabled(true);
+    EXPECT_EQ( 0, timer.getDroppedFrames() );
+    waitSeconds(0.2);
+    EXPECT_EQ( 0, timer.waitUntilNextFrameIsDue() );
+}
+
+TEST(Timer, NotRealtimeNeverDrops)
+{
+    Timer timer;
+
+    timer.setDesiredFrameRate(20.);
+    EXPECT_FALSE( timer.isRealtimeEnabled() );
+    EXPECT_EQ( 0, timer.waitUntilNextFrameIsDue() );
+    waitSeconds(0.275);
+    EXPECT_EQ( 0, timer.waitUntilNextFrameIsDue() );
+    EXPECT_EQ( 0, timer.getDroppedFrames() );
+}
+
+#include "Timer_Test.moc"
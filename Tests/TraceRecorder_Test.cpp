@@ -0,0 +1,208 @@
+/* ***** BEGIN LICENSE BLOCK *****
+ * This file is part of Natron <http://www.natron.fr/>,
+ * Copyright (C) 2016 INRIA and Alexandre Gauthier-Foichat
+ *
+ * Natron is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Natron is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Natron.  If not, see <http://www.gnu.org/licenses/gpl-2.0.html>
+ * ***** END LICENSE BLOCK ***** */
+
+// ***** BEGIN PYTHON BLOCK *****
+// from <https://docs.python.org/3/c-api/intro.html#include-files>:
+// "Since Python may define some pre-processor definitions which affect the standard headers on some systems, you must include Python.h before any standard headers are included."
+#include <Python.h>
+// ***** END PYTHON BLOCK *****
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include <QThread>
+
+#include "Engine/TraceRecorder.h"
+
+NATRON_NAMESPACE_USING
+
+static std::string
+readFile(const std::string & path)
+{
+    std::ifstream ifs( path.c_str() );
+    std::stringstream ss;
+
+    ss << ifs.rdbuf();
+
+    return ss.str();
+}
+
+static std::vector<std::string>
+getEventLines(const std::string & trace)
+{
+    std::vector<std::string> lines;
+    std::istringstream iss(trace);
+    std::string line;
+
+    while ( std::getline(iss, line) ) {
+        if ( line.find("\"ph\":\"X\"") != std::string::npos ) {
+            lines.push_back(line);
+        }
+    }
+
+    return lines;
+}
+
+static int
+getIntField(const std::string & event,
+            const std::string & field)
+{
+    std::size_t pos = event.find("\"" + field + "\":");
+
+    return pos == std::string::npos ? -1 : std::atoi( event.c_str() + pos + field.size() + 3 );
+}
+
+/**
+ * @brief Records events whose start time is their index and whose detail is a single letter repeated as many times as
+ * the duration of the event, so that an event exported while it was being overwritten can be told apart.
+ **/
+class TraceRecorderThread
+    : public QThread
+{
+public:
+
+    TraceRecorderThread(char letter,
+                        int eventsCount)
+        : QThread()
+        , _letter(letter)
+        , _eventsCount(eventsCount)
+    {
+    }
+
+private:
+
+    virtual void run() OVERRIDE FINAL
+    {
+        for (int i = 0; i < _eventsCount; ++i) {
+            int length = i % (NATRON_TRACE_DETAIL_SIZE - 1) + 1;
+            TraceRecorder::addEvent( "TraceRecorderTest", "Test", i, length, std::string(length, _letter) );
+        }
+    }
+
+    char _letter;
+    int _eventsCount;
+};
+
+TEST(TraceRecorder, RecordAndExport)
+{
+    std::string path("TraceRecorderTest.json");
+    std::string error;
+
+    TraceRecorder::setEnabled(true);
+    TraceRecorder::clear();
+    {
+        TraceScope scope("TraceRecorderScope", "Test");
+    }
+    TraceRecorder::addEvent( "TraceRecorderEvent", "Test", 10, 5, std::string("a \"quoted\"\\name\n") );
+    TraceRecorder::addEvent( "TraceRecorderEvent", "Test", 20, 5, std::string(NATRON_TRACE_DETAIL_SIZE * 2, 'x') );
+    TraceRecorder::setEnabled(false);
+
+    ASSERT_TRUE( TraceRecorder::writeChromeTrace(path, &error) );
+    std::string trace = readFile(path);
+    EXPECT_EQ( 0U, trace.find("{\"traceEvents\":[") );
+    EXPECT_TRUE( trace.find("\"displayTimeUnit\":\"ms\"}") != std::string::npos );
+
+    std::vector<std::string> events = getEventLines(trace);
+    ASSERT_EQ( 3U, events.size() );
+    EXPECT_TRUE( events[0].find("\"name\":\"TraceRecorderScope\"") != std::string::npos );
+    EXPECT_TRUE( events[0].find("\"args\"") == std::string::npos );
+    EXPECT_TRUE( events[1].find("\"ts\":10,\"dur\":5") != std::string::npos );
+    EXPECT_TRUE( events[1].find("\"detail\":\"a \\\"quoted\\\"\\\\name\\u000a\"") != std::string::npos );
+    ///The detail is truncated
+    EXPECT_TRUE( events[2].find("\"detail\":\"" + std::string(NATRON_TRACE_DETAIL_SIZE - 1, 'x') + "\"") != std::string::npos );
+
+    ///Cleared events are not exported
+    TraceRecorder::clear();
+    ASSERT_TRUE( TraceRecorder::writeChromeTrace(path, &error) );
+    EXPECT_TRUE( getEventLines( readFile(path) ).empty() );
+
+    std::remove( path.c_str() );
+}
+
+TEST(TraceRecorder, ExportWhileRecording)
+{
+    const int threadsCount = 4;
+    const int eventsCount = NATRON_TRACE_EVENTS_PER_THREAD * 4;
+    std::string path("TraceRecorderTestConcurrent.json");
+    std::string error;
+
+    TraceRecorder::setEnabled(true);
+    TraceRecorder::clear();
+
+    std::vector<TraceRecorderThread*> threads;
+    for (int i = 0; i < threadsCount; ++i) {
+        threads.push_back( new TraceRecorderThread('a' + i, eventsCount) );
+        threads.back()->start();
+    }
+
+    ///Export while the ring buffers wrap around: every event exported must be one that was fully written
+    bool running = true;
+    int exportsCount = 0;
+    while (running || exportsCount == 0) {
+        running = false;
+        for (int i = 0; i < threadsCount; ++i) {
+            running |= threads[i]->isRunning();
+        }
+        ASSERT_TRUE( TraceRecorder::writeChromeTrace(path, &error) );
+        ++exportsCount;
+
+        std::vector<std::string> events = getEventLines( readFile(path) );
+        EXPECT_TRUE( events.size() <= (std::size_t)threadsCount * NATRON_TRACE_EVENTS_PER_THREAD );
+        std::map<int, int> lastStartTimes;
+        for (std::size_t i = 0; i < events.size(); ++i) {
+            ///The events of a thread are exported in order, the ones overwritten meanwhile are left out
+            int tid = getIntField(events[i], "tid");
+            int startTime = getIntField(events[i], "ts");
+            std::map<int, int>::iterator last = lastStartTimes.find(tid);
+            if ( last != lastStartTimes.end() ) {
+                ASSERT_TRUE(startTime > last->second);
+            }
+            lastStartTimes[tid] = startTime;
+
+            int duration = getIntField(events[i], "dur");
+            std::size_t detailPos = events[i].find("\"detail\":\"");
+            ASSERT_TRUE(detailPos != std::string::npos);
+            std::size_t detailStart = detailPos + 10;
+            std::size_t detailEnd = events[i].find('"', detailStart);
+            ASSERT_TRUE(detailEnd != std::string::npos);
+            std::string detail = events[i].substr(detailStart, detailEnd - detailStart);
+            ASSERT_EQ( (std::size_t)duration, detail.size() );
+            EXPECT_EQ( std::string(detail.size(), detail[0]), detail );
+        }
+    }
+
+    for (int i = 0; i < threadsCount; ++i) {
+        threads[i]->wait();
+        delete threads[i];
+    }
+    TraceRecorder::setEnabled(false);
+
+    ///Once recording finished, the last events of each thread are all there
+    ASSERT_TRUE( TraceRecorder::writeChromeTrace(path, &error) );
+    EXPECT_EQ( (std::size_t)threadsCount * NATRON_TRACE_EVENTS_PER_THREAD, getEventLines( readFile(path) ).size() );
+
+    TraceRecorder::clear();
+    std::remove( path.c_str() );
+}
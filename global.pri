@@ -265,6 +265,8 @@ unix {
              LIBS +=  $$system(pkg-config --variable=libdir cairo)/libcairo.a
          }
          LIBS += -ldl
+         # shm_open, used by the shared frame channel
+         LIBS += -lrt
          QMAKE_LFLAGS += '-Wl,-rpath,\'\$$ORIGIN/../lib\',-z,origin'
      } else {
          cairo:     PKGCONFIG += cairo